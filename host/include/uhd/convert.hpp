@@ -75,6 +75,9 @@ namespace uhd{ namespace convert{
     //! Implement equality_comparable interface
     UHD_API bool operator==(const id_type &, const id_type &);
 
+    //! Hash an ID, so it can be used as a key in hashed containers
+    UHD_API size_t hash_value(const id_type &);
+
     /*!
      * Register a converter function.
      *
@@ -63,6 +63,25 @@ public:
         const device_filter_t filter
     );
 
+    /*!
+     * Register a device into the discovery and factory system.
+     *
+     * Discovery calls the finders of devices registered with concurrent_find
+     * at the same time, e.g. for devices found over the network. All other
+     * finders, e.g. those which enumerate USB devices, run one after another.
+     *
+     * \param find a function that discovers devices
+     * \param make a factory function that makes a device
+     * \param filter include only USRP devices, clock devices, or both
+     * \param concurrent_find true if find may run along with other finders
+     */
+    static void register_device(
+        const find_t &find,
+        const make_t &make,
+        const device_filter_t filter,
+        const bool concurrent_find
+    );
+
     /*!
      * \brief Find devices attached to the host.
      *
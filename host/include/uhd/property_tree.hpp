@@ -75,6 +75,7 @@ namespace uhd{
  */
 template <typename T> class property : boost::noncopyable{
 public:
+    typedef boost::shared_ptr<property<T> > sptr;
     typedef boost::function<void(const T &)> subscriber_type;
     typedef boost::function<T(void)> publisher_type;
     typedef boost::function<T(const T &)> coercer_type;
@@ -243,15 +244,33 @@ public:
         const fs_path &path,
         coerce_mode_t coerce_mode = AUTO_COERCE);
 
-    //! Get access to a property in the tree
+    /*!
+     * Get access to a property in the tree.
+     * Properties removed from the tree are kept until the tree is destroyed,
+     * so the reference stays valid even if another thread removes the path.
+     * \param path the path of the property
+     * \return a reference to the property
+     * \throws uhd::lookup_error if the path does not exist
+     */
     template <typename T> property<T> &access(const fs_path &path);
 
+    /*!
+     * Get a handle to a property in the tree.
+     * The path is looked up once, so getting and setting the property
+     * through the handle involves no further string or tree operations.
+     * The handle keeps the property alive even if it is removed from the tree.
+     * \param path the path of the property
+     * \return a shared pointer to the property
+     * \throws uhd::lookup_error if the path does not exist
+     */
+    template <typename T> typename property<T>::sptr get_handle(const fs_path &path);
+
 private:
     //! Internal create property with wild-card type
     virtual void _create(const fs_path &path, const boost::shared_ptr<void> &prop) = 0;
 
     //! Internal access property with wild-card type
-    virtual boost::shared_ptr<void> &_access(const fs_path &path) const = 0;
+    virtual boost::shared_ptr<void> _access(const fs_path &path) const = 0;
 
 };
 
@@ -23,6 +23,7 @@
 #include <uhd/types/device_addr.hpp>
 #include <uhd/types/stream_cmd.hpp>
 #include <uhd/types/ref_vector.hpp>
+#include <uhd/transport/zero_copy.hpp>
 #include <boost/utility.hpp>
 #include <boost/shared_ptr.hpp>
 #include <vector>
@@ -161,6 +162,66 @@ struct UHD_API stream_args_t{
     std::vector<size_t> channels;
 };
 
+/*!
+ * Received samples which are still held in the buffers of the transport.
+ * See rx_streamer::recv_zero_copy() for details.
+ */
+struct UHD_API rx_zero_copy_buffs_t{
+
+    //! Make an empty set of buffers
+    rx_zero_copy_buffs_t(void);
+
+    /*!
+     * Read-only pointers to the samples, one per channel.
+     * The samples are in the over-the-wire format and byte order,
+     * which is given by the format member.
+     */
+    std::vector<const void *> buffs;
+
+    //! The number of samples behind each pointer
+    size_t nsamps_per_buff;
+
+    /*!
+     * The format of the samples, as the input format of a converter.
+     * Example: "sc16_item32_le" for sc16 samples in little endian words.
+     */
+    std::string format;
+
+    //! The transport buffers that hold the samples, one per channel
+    std::vector<transport::managed_recv_buffer::sptr> managed_buffs;
+
+    /*!
+     * Give the buffers back to the transport.
+     * The pointers are invalid after this call.
+     */
+    void release(void);
+};
+
+/*!
+ * Statistics of the alignment of the channels of an RX streamer.
+ * See rx_streamer::get_alignment_stats() for details.
+ */
+struct UHD_API rx_alignment_stats_t{
+
+    //! Make statistics with all counts at zero
+    rx_alignment_stats_t(void);
+
+    //! The number of times the channels were aligned again
+    size_t num_alignments;
+
+    //! The number of times a newer packet moved the alignment time
+    size_t num_restarts;
+
+    //! The number of packets dropped to align the channels
+    size_t num_dropped_packets;
+
+    //! The number of times the alignment failed
+    size_t num_failures;
+
+    //! The largest offset between the channels in ticks of the device clock
+    long long max_offset_ticks;
+};
+
 /*!
  * The RX streamer is the host interface to receiving samples.
  * It represents the layer between the samples on the host
@@ -235,6 +296,102 @@ public:
      * \param stream_cmd the stream command to issue
      */
     virtual void issue_stream_cmd(const stream_cmd_t &stream_cmd) = 0;
+
+    /*!
+     * Receive one packet per channel without copying the samples.
+     *
+     * Instead of converting the samples into the buffers of the caller,
+     * this call hands out pointers into the buffers of the transport.
+     * It still aligns the channels and reports overflows, sequence
+     * errors and timeouts in the metadata like recv() does.
+     * When recv() left the remainder of a packet, this call returns the
+     * remainder, and flags the metadata as a fragment.
+     *
+     * The buffers from the previous call are released on entry.
+     * Call release() on them earlier, or swap them into other storage
+     * to hold on to them longer. The transport only has a limited number
+     * of receive frames (see the num_recv_frames device argument):
+     * holding on to all of them stalls the stream and causes overflows.
+     *
+     * Not all streamers support this call: streamers which interleave
+     * channels into one buffer and some older devices throw
+     * uhd::not_implemented_error.
+     *
+     * \param buffs the buffers to fill with pointers to the samples
+     * \param metadata data to fill describing the buffers
+     * \param timeout the timeout in seconds to wait for a packet
+     * \return the number of samples per channel or 0 on error
+     */
+    virtual size_t recv_zero_copy(
+        rx_zero_copy_buffs_t &buffs,
+        rx_metadata_t &metadata,
+        const double timeout = 0.1
+    );
+
+    /*!
+     * Get the statistics of the alignment of the channels.
+     *
+     * The channels are misaligned when their packets do not have the
+     * same timestamps, e.g. after a lost packet or a stream restart.
+     * The receive calls then drop packets until the channels line up
+     * again, and count them in these statistics. Like recv(), this call
+     * is not thread-safe.
+     *
+     * Not all streamers support this call: some older devices throw
+     * uhd::not_implemented_error.
+     *
+     * \return the statistics since the streamer was made
+     */
+    virtual rx_alignment_stats_t get_alignment_stats(void) const;
+
+    /*!
+     * Get a file descriptor which is readable when samples are available,
+     * so that one thread can wait for many streamers with poll(), select()
+     * or epoll, and only receive from the ready ones.
+     *
+     * The descriptor is readable when a receive call with a timeout of
+     * zero may return samples or metadata, e.g. an overflow. A readable
+     * descriptor does not promise samples: receive with a timeout of zero
+     * and wait again when it times out. The streamer owns the descriptor,
+     * do not read from or close it. Like recv(), this call is not
+     * thread-safe.
+     *
+     * Not all streamers support this call: streamers on transports
+     * without a descriptor, like PCIe and USB, throw
+     * uhd::not_implemented_error.
+     *
+     * \return the descriptor, which stays valid while the streamer lives
+     */
+    virtual int get_fd(void);
+};
+
+/*!
+ * Transmit buffers which the application fills in place.
+ * See tx_streamer::get_zero_copy_buffs() for details.
+ */
+struct UHD_API tx_zero_copy_buffs_t{
+
+    //! Make an empty set of buffers
+    tx_zero_copy_buffs_t(void);
+
+    /*!
+     * Writable pointers to the room for samples, one per channel.
+     * The samples are written in the over-the-wire format and byte order,
+     * which is given by the format member.
+     */
+    std::vector<void *> buffs;
+
+    //! The maximum number of samples behind each pointer
+    size_t nsamps_per_buff;
+
+    /*!
+     * The format of the samples, as the output format of a converter.
+     * Example: "sc16_item32_le" for sc16 samples in little endian words.
+     */
+    std::string format;
+
+    //! The transport buffers that hold the samples, one per channel
+    std::vector<transport::managed_send_buffer::sptr> managed_buffs;
 };
 
 /*!
@@ -294,6 +451,85 @@ public:
     virtual bool recv_async_msg(
         async_metadata_t &async_metadata, double timeout = 0.1
     ) = 0;
+
+    /*!
+     * Get transport buffers to write the samples of one packet into.
+     *
+     * Instead of converting the samples of the caller into the buffers
+     * of the transport, the caller writes the samples in place, and
+     * sends them with send_zero_copy(). The buffers count against flow
+     * control like the ones send() uses, so this call blocks while the
+     * device has no room for another packet.
+     *
+     * An application may hold several sets of buffers at once and fill
+     * them ahead of time. The transport only has a limited number of
+     * send frames (see the num_send_frames device argument), and the
+     * packets go out in the order in which they are sent. Buffers which
+     * are not sent must be given back with release_zero_copy_buffs():
+     * dropping them sends their frames as they are. The buffers already
+     * in the given set are given back on entry.
+     *
+     * Not all streamers support this call: streamers which interleave
+     * channels from one buffer and some older devices throw
+     * uhd::not_implemented_error.
+     *
+     * \param buffs the buffers to fill with pointers to the room for samples
+     * \param timeout the timeout in seconds to wait for the buffers
+     * \return the room per channel in number of samples, or 0 on timeout
+     */
+    virtual size_t get_zero_copy_buffs(
+        tx_zero_copy_buffs_t &buffs,
+        const double timeout = 0.1
+    );
+
+    /*!
+     * Send buffers from get_zero_copy_buffs() as one packet per channel.
+     *
+     * The streamer fills in the packet headers, sequence numbers and
+     * timestamps like send() does. Packets with a time spec have a longer
+     * header, so their samples are moved before they are sent.
+     * The buffers are released by this call.
+     *
+     * \param buffs the buffers with the samples
+     * \param nsamps_per_buff the number of samples to send, per buffer
+     * \param metadata data describing the buffer's contents
+     * \return the number of samples sent
+     */
+    virtual size_t send_zero_copy(
+        tx_zero_copy_buffs_t &buffs,
+        const size_t nsamps_per_buff,
+        const tx_metadata_t &metadata
+    );
+
+    /*!
+     * Give buffers from get_zero_copy_buffs() back without sending them.
+     * The streamer keeps them, uncommitted, for the next packets of their
+     * channels, so that they still count against flow control and the
+     * device gets no empty packets. The pointers are invalid after this call.
+     * \param buffs the buffers to give back, cleared by this call
+     */
+    virtual void release_zero_copy_buffs(tx_zero_copy_buffs_t &buffs);
+
+    /*!
+     * Get a file descriptor which is readable when the streamer may make
+     * progress, so that one thread can wait for many streamers with
+     * poll(), select() or epoll.
+     *
+     * The descriptor is readable when the device may have room for
+     * another packet, or when an asynchronous message is queued. Wait on
+     * it only after a send call or recv_async_msg() timed out. A readable
+     * descriptor does not promise either: retry both with a timeout of
+     * zero and wait again when they time out. The streamer owns the
+     * descriptor, do not read from or close it. Call this from the thread
+     * which sends.
+     *
+     * Not all streamers support this call: streamers on transports
+     * without a descriptor, like PCIe and USB, throw
+     * uhd::not_implemented_error.
+     *
+     * \return the descriptor, which stays valid while the streamer lives
+     */
+    virtual int get_fd(void);
 };
 
 } //namespace uhd
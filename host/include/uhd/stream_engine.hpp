@@ -0,0 +1,182 @@
+//
+// Copyright 2016 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef INCLUDED_UHD_STREAM_ENGINE_HPP
+#define INCLUDED_UHD_STREAM_ENGINE_HPP
+
+#include <uhd/config.hpp>
+#include <uhd/stream.hpp>
+#include <uhd/types/metadata.hpp>
+#include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/utility.hpp>
+#include <string>
+#include <vector>
+
+namespace uhd{
+
+/*!
+ * The RX stream engine receives from an RX streamer in a thread of its own
+ * and hands the samples to a callback, so that applications do not need a
+ * receive loop of their own.
+ *
+ * The engine receives into the buffers of a pool. The callback gets a
+ * reference to the buffer, and may hold on to it after it returns, e.g.
+ * to pass it to another thread. The buffer goes back to the pool when the
+ * last reference is dropped. When the application holds all buffers, the
+ * engine either waits for one to return, or receives and drops the
+ * samples, see backpressure_type.
+ *
+ * Errors reported in the receive metadata, like overflows and timeouts,
+ * go to a second callback. The engine does not issue stream commands.
+ *
+ * Without a data callback, the engine queues the buffers instead, and the
+ * application takes them with pop_buff(). The file descriptor from
+ * get_fd() is readable while buffers are queued, so that an application
+ * can wait for many engines with poll(), select() or epoll.
+ *
+ * \code{.cpp}
+ * void handle_samps(uhd::rx_stream_engine::buffer_sptr buff){
+ *     // buff->buffs[0] holds buff->nsamps_per_buff samples of channel 0
+ * }
+ *
+ * uhd::rx_stream_engine::args_type args;
+ * args.cpu = 2; // receive on the third CPU
+ * uhd::rx_stream_engine::sptr engine = uhd::rx_stream_engine::make(
+ *     rx_stream, "fc32", &handle_samps, uhd::rx_stream_engine::event_callback_type(), args
+ * );
+ * rx_stream->issue_stream_cmd(uhd::stream_cmd_t::STREAM_MODE_START_CONTINUOUS);
+ * \endcode
+ */
+class UHD_API rx_stream_engine : boost::noncopyable{
+public:
+    typedef boost::shared_ptr<rx_stream_engine> sptr;
+
+    //! Samples received into one buffer of the pool
+    struct UHD_API buffer_type{
+        //! Pointers to the samples in the host format, one per channel
+        std::vector<void *> buffs;
+
+        //! The number of samples behind each pointer
+        size_t nsamps_per_buff;
+
+        //! The metadata of the receive call
+        rx_metadata_t metadata;
+    };
+
+    //! A buffer of the pool, which returns when the last reference is dropped
+    typedef boost::shared_ptr<buffer_type> buffer_sptr;
+
+    //! Callback for received samples, called from the thread of the engine
+    typedef boost::function<void(buffer_sptr)> data_callback_type;
+
+    //! Callback for metadata with an error code, called from the thread of the engine
+    typedef boost::function<void(const rx_metadata_t &)> event_callback_type;
+
+    //! What the engine does when the application holds all buffers of the pool
+    enum backpressure_type{
+        //! Wait for a buffer to return, the device overflows when this takes too long
+        BACKPRESSURE_BLOCK,
+        //! Keep receiving and drop the samples, see get_num_dropped_samps()
+        BACKPRESSURE_DROP
+    };
+
+    //! Settings of the engine
+    struct UHD_API args_type{
+        args_type(void);
+
+        //! The number of samples per buffer, 0 for the maximum of one packet
+        size_t nsamps_per_buff;
+
+        //! The number of buffers in the pool
+        size_t num_buffs;
+
+        //! Return a buffer after each packet, or only when it is full
+        bool one_packet;
+
+        //! The timeout of each receive call in seconds
+        double timeout;
+
+        //! What to do when the application holds all buffers
+        backpressure_type backpressure;
+
+        //! The CPU to pin the thread of the engine to, -1 to not pin it
+        int cpu;
+
+        //! The scheduling priority of the thread, see set_thread_priority()
+        float priority;
+
+        //! Use realtime scheduling for the thread
+        bool realtime;
+    };
+
+    /*!
+     * Make a new engine, which starts receiving right away.
+     * The thread of the engine stops when the engine is destroyed.
+     * An exception thrown by the streamer or a callback stops it as well,
+     * and pop_buff() throws it once the queued buffers are taken.
+     * \param streamer the streamer to receive from
+     * \param cpu_format the host format of the streamer, e.g. "fc32"
+     * \param data_callback the callback for received samples, empty to queue them
+     * \param event_callback the callback for errors, may be empty
+     * \param args the settings of the engine
+     * \return a new engine
+     */
+    static sptr make(
+        rx_streamer::sptr streamer,
+        const std::string &cpu_format,
+        const data_callback_type &data_callback,
+        const event_callback_type &event_callback = event_callback_type(),
+        const args_type &args = args_type()
+    );
+
+    virtual ~rx_stream_engine(void) = 0;
+
+    //! Get the number of samples per channel handed to the application
+    virtual size_t get_num_recvd_samps(void) const = 0;
+
+    //! Get the number of samples per channel dropped for lack of buffers
+    virtual size_t get_num_dropped_samps(void) const = 0;
+
+    /*!
+     * Take the next queued buffer, when the engine has no data callback.
+     *
+     * Without an event callback, metadata with an error code is queued as
+     * a buffer without samples, except for timeouts. Like the buffers with
+     * samples, these come from a pool of args_type::num_buffs; an event
+     * which finds the application holding all of them is dropped.
+     *
+     * \param buff the buffer to fill in
+     * \param timeout the timeout in seconds to wait for a buffer
+     * \return true when buff is valid, false for timeout
+     * \throw the exception which stopped the engine, once no buffers are queued
+     */
+    virtual bool pop_buff(buffer_sptr &buff, const double timeout = 0.1) = 0;
+
+    /*!
+     * Get a file descriptor which is readable while buffers are queued.
+     * Only poll the descriptor, reading from it is up to the engine.
+     * The descriptor is valid for the lifetime of the engine.
+     * \return the file descriptor
+     * \throw uhd::not_implemented_error on systems without it
+     */
+    virtual int get_fd(void) = 0;
+};
+
+} //namespace uhd
+
+#endif /* INCLUDED_UHD_STREAM_ENGINE_HPP */
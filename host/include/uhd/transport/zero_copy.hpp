@@ -200,6 +200,17 @@ namespace uhd{ namespace transport{
          */
         virtual size_t get_send_frame_size(void) const = 0;
 
+        /*!
+         * Get a file descriptor which is readable when a receive buffer
+         * is available, e.g. the socket of the transport.
+         * It can be waited on with poll(), select() or epoll.
+         * \return the descriptor, or -1 when the transport has none
+         */
+        virtual int get_recv_fd(void) const
+        {
+            return -1;
+        }
+
     };
 
 }} //namespace
@@ -19,13 +19,101 @@
 #define INCLUDED_UHD_TYPES_DICT_HPP
 
 #include <uhd/config.hpp>
+#include <boost/functional/hash.hpp>
+#include <boost/mpl/or.hpp>
+#include <boost/type_traits/integral_constant.hpp>
+#include <boost/type_traits/is_arithmetic.hpp>
+#include <boost/type_traits/is_enum.hpp>
+#include <boost/type_traits/is_pointer.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/utility/enable_if.hpp>
+#include <string>
 #include <vector>
 #include <list>
 
 namespace uhd{
 
+    /*!
+     * Whether a uhd::dict indexes keys of this type in a hash table.
+     * True for arithmetic types, enums, pointers and std::string.
+     * Other key types which provide a hash_value() overload can opt in
+     * by specializing this template to derive from boost::true_type.
+     * Dictionaries with any other key type are searched linearly.
+     */
+    template <typename Key>
+    struct dict_key_hashable : boost::integral_constant<bool, boost::mpl::or_<
+        boost::is_arithmetic<Key>, boost::is_enum<Key>, boost::is_pointer<Key>
+    >::value>{};
+
+    template <>
+    struct dict_key_hashable<std::string> : boost::true_type{};
+
+    /*!
+     * The hash function used to index the keys of a uhd::dict.
+     * Enums are hashed by value, any other hashable key type must be
+     * hashable with boost::hash (i.e. provide a hash_value() overload).
+     */
+    template <typename Key, typename Enable = void>
+    struct dict_hash : boost::hash<Key>{};
+
+    template <typename Key>
+    struct dict_hash<Key, typename boost::enable_if<boost::is_enum<Key> >::type>{
+        std::size_t operator()(const Key &key) const{
+            return boost::hash<long>()(long(key));
+        }
+    };
+
+    /*!
+     * The hash index of a uhd::dict: maps keys to iterators into the
+     * item list. This is an implementation detail of uhd::dict.
+     */
+    template <typename Key, typename Iter, bool Hashable = dict_key_hashable<Key>::value>
+    class dict_index{
+    public:
+        static const bool enabled = true;
+
+        bool empty(void) const{ return _index.empty(); }
+        std::size_t size(void) const{ return _index.size(); }
+        void clear(void){ _index.clear(); }
+        //! Insert a key, an existing entry for the key is kept
+        void insert(const Key &key, Iter it){ _index.insert(std::make_pair(key, it)); }
+        void erase(const Key &key){ _index.erase(key); }
+        bool find(const Key &key, Iter &it) const{
+            typename index_t::const_iterator i = _index.find(key);
+            if (i == _index.end()) return false;
+            it = i->second;
+            return true;
+        }
+
+    private:
+        typedef boost::unordered_map<Key, Iter, dict_hash<Key> > index_t;
+        index_t _index;
+    };
+
+    //! The index of a uhd::dict whose keys are not hashable stays empty
+    template <typename Key, typename Iter>
+    class dict_index<Key, Iter, false>{
+    public:
+        static const bool enabled = false;
+
+        bool empty(void) const{ return true; }
+        std::size_t size(void) const{ return 0; }
+        void clear(void){}
+        void insert(const Key &, Iter){}
+        void erase(const Key &){}
+        bool find(const Key &, Iter &) const{ return false; }
+    };
+
     /*!
      * A templated dictionary class with a python-like interface.
+     *
+     * Items are kept in insertion order. Once a dictionary holds more
+     * than a few items, hashable keys (see uhd::dict_key_hashable) are
+     * also indexed in a hash table so that lookups take constant time.
+     * References to values stay valid until their item is removed.
+     *
+     * The Key type must be comparable with operator==. Hashable keys
+     * which compare equal must hash equally.
      */
     template <typename Key, typename Val> class dict{
     public:
@@ -34,6 +122,19 @@ namespace uhd{
          */
         dict(void);
 
+        /*!
+         * Copy constructor: the copy gets its own index.
+         * \param other the dictionary to copy
+         */
+        dict(const dict<Key, Val> &other);
+
+        /*!
+         * Assignment: this dictionary gets its own index.
+         * \param other the dictionary to copy
+         * \return a reference to this dictionary
+         */
+        dict<Key, Val> &operator=(const dict<Key, Val> &other);
+
         /*!
          * Input iterator constructor:
          * Makes boost::assign::map_list_of work.
@@ -136,7 +237,18 @@ namespace uhd{
 
     private:
         typedef std::pair<Key, Val> pair_t;
-        std::list<pair_t> _map; //private container
+        typedef std::list<pair_t> list_t;
+        typedef dict_index<Key, typename list_t::iterator> index_t;
+
+        //! Dictionaries up to this size are searched linearly
+        static const std::size_t INDEX_THRESHOLD = 8;
+
+        typename list_t::iterator _find(const Key &key);
+        typename list_t::const_iterator _find(const Key &key) const;
+        void _reindex(void);
+
+        list_t _map;    //private container, in insertion order
+        index_t _index; //iterators into _map by key, empty below the threshold
     };
 
 } //namespace uhd
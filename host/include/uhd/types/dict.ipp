@@ -50,7 +50,23 @@ namespace uhd{
     dict<Key, Val>::dict(InputIterator first, InputIterator last):
         _map(first, last)
     {
-        /* NOP */
+        _reindex();
+    }
+
+    template <typename Key, typename Val>
+    dict<Key, Val>::dict(const dict<Key, Val> &other):
+        _map(other._map)
+    {
+        _reindex();
+    }
+
+    template <typename Key, typename Val>
+    dict<Key, Val> &dict<Key, Val>::operator=(const dict<Key, Val> &other){
+        if (this != &other){
+            _map = other._map;
+            _reindex();
+        }
+        return *this;
     }
 
     template <typename Key, typename Val>
@@ -61,6 +77,7 @@ namespace uhd{
     template <typename Key, typename Val>
     std::vector<Key> dict<Key, Val>::keys(void) const{
         std::vector<Key> keys;
+        keys.reserve(_map.size());
         BOOST_FOREACH(const pair_t &p, _map){
             keys.push_back(p.first);
         }
@@ -70,6 +87,7 @@ namespace uhd{
     template <typename Key, typename Val>
     std::vector<Val> dict<Key, Val>::vals(void) const{
         std::vector<Val> vals;
+        vals.reserve(_map.size());
         BOOST_FOREACH(const pair_t &p, _map){
             vals.push_back(p.second);
         }
@@ -78,25 +96,20 @@ namespace uhd{
 
     template <typename Key, typename Val>
     bool dict<Key, Val>::has_key(const Key &key) const{
-        BOOST_FOREACH(const pair_t &p, _map){
-            if (p.first == key) return true;
-        }
-        return false;
+        return _find(key) != _map.end();
     }
 
     template <typename Key, typename Val>
     const Val &dict<Key, Val>::get(const Key &key, const Val &other) const{
-        BOOST_FOREACH(const pair_t &p, _map){
-            if (p.first == key) return p.second;
-        }
+        typename list_t::const_iterator it = _find(key);
+        if (it != _map.end()) return it->second;
         return other;
     }
 
     template <typename Key, typename Val>
     const Val &dict<Key, Val>::get(const Key &key) const{
-        BOOST_FOREACH(const pair_t &p, _map){
-            if (p.first == key) return p.second;
-        }
+        typename list_t::const_iterator it = _find(key);
+        if (it != _map.end()) return it->second;
         throw key_not_found<Key, Val>(key);
     }
 
@@ -107,32 +120,61 @@ namespace uhd{
 
     template <typename Key, typename Val>
     const Val &dict<Key, Val>::operator[](const Key &key) const{
-        BOOST_FOREACH(const pair_t &p, _map){
-            if (p.first == key) return p.second;
-        }
-        throw key_not_found<Key, Val>(key);
+        return this->get(key);
     }
 
     template <typename Key, typename Val>
     Val &dict<Key, Val>::operator[](const Key &key){
-        BOOST_FOREACH(pair_t &p, _map){
-            if (p.first == key) return p.second;
-        }
+        typename list_t::iterator it = _find(key);
+        if (it != _map.end()) return it->second;
         _map.push_back(std::make_pair(key, Val()));
+        if (not _index.empty()){
+            _index.insert(key, --_map.end());
+        } else if (index_t::enabled and _map.size() > INDEX_THRESHOLD){
+            _reindex();
+        }
         return _map.back().second;
     }
 
     template <typename Key, typename Val>
     Val dict<Key, Val>::pop(const Key &key){
-        typename std::list<pair_t>::iterator it;
+        typename list_t::iterator it = _find(key);
+        if (it == _map.end()) throw key_not_found<Key, Val>(key);
+        Val val = it->second;
+        if (not _index.empty()) _index.erase(key);
+        _map.erase(it);
+        if (_map.size() <= INDEX_THRESHOLD) _index.clear();
+        //a duplicate key from an iterator range takes over the index entry
+        else if (index_t::enabled and _index.size() != _map.size()) _reindex();
+        return val;
+    }
+
+    template <typename Key, typename Val>
+    typename dict<Key, Val>::list_t::iterator dict<Key, Val>::_find(const Key &key){
+        typename list_t::iterator it;
+        if (not _index.empty()){
+            return _index.find(key, it)? it : _map.end();
+        }
         for (it = _map.begin(); it != _map.end(); it++){
-            if (it->first == key){
-                Val val = it->second;
-                _map.erase(it);
-                return val;
-            }
+            if (it->first == key) break;
+        }
+        return it;
+    }
+
+    template <typename Key, typename Val>
+    typename dict<Key, Val>::list_t::const_iterator dict<Key, Val>::_find(const Key &key) const{
+        return const_cast<dict<Key, Val> *>(this)->_find(key);
+    }
+
+    template <typename Key, typename Val>
+    void dict<Key, Val>::_reindex(void){
+        _index.clear();
+        if (not index_t::enabled or _map.size() <= INDEX_THRESHOLD) return;
+        typename list_t::iterator it;
+        for (it = _map.begin(); it != _map.end(); it++){
+            //like a linear search, the first of duplicate keys wins
+            _index.insert(it->first, it);
         }
-        throw key_not_found<Key, Val>(key);
     }
 
     template <typename Key, typename Val>
@@ -20,6 +20,7 @@
 
 #include <uhd/config.hpp>
 #include <uhd/types/time_spec.hpp>
+#include <uhd/types/time_ticks.hpp>
 #include <stdint.h>
 #include <string>
 
@@ -49,6 +50,7 @@ namespace uhd{
             end_of_burst = false;
             error_code = ERROR_CODE_NONE;
             out_of_sequence = false;
+            time_ticks = time_ticks_t();
         }
 
         //! Has time specification?
@@ -119,6 +121,18 @@ namespace uhd{
         //! Out of sequence.  The transport has either dropped a packet or received data out of order.
         bool out_of_sequence;
 
+        /*!
+         * Time of the first sample in ticks of the device clock.
+         * When a sample is a whole number of ticks, this is the exact
+         * time which time_spec was converted from. Otherwise, the time
+         * of samples after the start of a packet is rounded to the
+         * nearest tick, and time_spec is kept separately, so the two
+         * may differ by up to half a tick.
+         * It is valid when has_time_spec is true and the samples came
+         * from a streamer; otherwise it is zero ticks.
+         */
+        time_ticks_t time_ticks;
+
         /*!
          * Convert a rx_metadata_t into a pretty print string.
          *
@@ -0,0 +1,111 @@
+//
+// Copyright 2016 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef INCLUDED_UHD_TYPES_TIME_TICKS_HPP
+#define INCLUDED_UHD_TYPES_TIME_TICKS_HPP
+
+#include <uhd/config.hpp>
+#include <uhd/types/time_spec.hpp>
+#include <boost/operators.hpp>
+
+namespace uhd{
+
+    /*!
+     * A time_ticks_t holds a time as an integer count of clock ticks.
+     * The rate of the clock is a ratio of two integers.
+     *
+     * Unlike a time_spec_t, which stores fractional seconds in floating
+     * point, a time_ticks_t is exact: adding ticks to it never rounds,
+     * no matter how far the count is from zero. Conversion to a
+     * time_spec_t happens only in to_time_spec().
+     */
+    class UHD_API time_ticks_t : boost::totally_ordered<time_ticks_t>{
+    public:
+
+        //! Create a time of zero ticks of a 1 Hz clock
+        time_ticks_t(void);
+
+        /*!
+         * Create a time_ticks_t from a tick count and an exact tick rate.
+         * \param ticks an integer count of ticks
+         * \param rate_num the numerator of the ticks per second
+         * \param rate_den the denominator of the ticks per second
+         */
+        time_ticks_t(long long ticks, long long rate_num, long long rate_den = 1);
+
+        /*!
+         * Create a time_ticks_t from a tick count and a tick rate.
+         * The rate is turned into the nearest ratio of integers,
+         * e.g. 200e6/3 becomes 200000000/3.
+         * \param ticks an integer count of ticks
+         * \param tick_rate the number of ticks per second
+         */
+        static time_ticks_t from_tick_rate(long long ticks, double tick_rate);
+
+        //! Get the integer count of ticks
+        long long get_ticks(void) const;
+
+        //! Get the numerator of the ticks per second
+        long long get_rate_num(void) const;
+
+        //! Get the denominator of the ticks per second
+        long long get_rate_den(void) const;
+
+        //! Get the number of ticks per second
+        double get_tick_rate(void) const;
+
+        /*!
+         * Convert the time into a time_spec_t.
+         * The whole seconds are exact, the fractional seconds are
+         * rounded to double precision.
+         * \return the time as a time_spec_t
+         */
+        time_spec_t to_time_spec(void) const;
+
+        //! Add a count of ticks
+        time_ticks_t &operator+=(long long ticks);
+
+    //private time storage details
+    private: long long _ticks, _rate_num, _rate_den;
+    };
+
+    //! Implement equality_comparable interface
+    UHD_API bool operator==(const time_ticks_t &, const time_ticks_t &);
+
+    //! Implement less_than_comparable interface
+    UHD_API bool operator<(const time_ticks_t &, const time_ticks_t &);
+
+    UHD_INLINE long long time_ticks_t::get_ticks(void) const{
+        return this->_ticks;
+    }
+
+    UHD_INLINE long long time_ticks_t::get_rate_num(void) const{
+        return this->_rate_num;
+    }
+
+    UHD_INLINE long long time_ticks_t::get_rate_den(void) const{
+        return this->_rate_den;
+    }
+
+    UHD_INLINE time_ticks_t &time_ticks_t::operator+=(long long ticks){
+        this->_ticks += ticks;
+        return *this;
+    }
+
+} //namespace uhd
+
+#endif /* INCLUDED_UHD_TYPES_TIME_TICKS_HPP */
@@ -31,7 +31,18 @@
  *
  * The logger enables UHD library code to easily log events into a file.
  * Log entries are time-stamped and stored with file, line, and function.
- * Each call to the UHD_LOG macros is synchronous and thread-safe.
+ * Each call to the UHD_LOG macros is thread-safe and does not block on
+ * file I/O: entries are queued and written to the file in batches by a
+ * background thread. Call uhd::_log::flush() to write out all queued
+ * entries (this also happens on exit and for error messages). Queued
+ * entries are also written out when the process is ended by an uncaught
+ * exception or a crash signal (SIGSEGV, SIGABRT, SIGFPE, SIGILL, SIGBUS).
+ * The queue is a preallocated ring: if it overflows, entries are dropped
+ * and the number of dropped entries is recorded in the log file. Entries
+ * longer than 4 kB are truncated.
+ *
+ * When the verbosity of a log statement is below the log level, the
+ * statement is skipped entirely, including its insertion operands.
  *
  * The log file can be found in the path <temp-directory>/uhd.log,
  * where <temp-directory> is the user or system's temporary directory.
@@ -57,6 +68,8 @@
  * Usage: UHD_LOGV(very_rarely) << "the log message" << std::endl;
  */
 #define UHD_LOGV(verbosity) \
+    (not uhd::_log::log::enabled(uhd::_log::verbosity))? (void) 0 : \
+    uhd::_log::log_voidify() & \
     uhd::_log::log(uhd::_log::verbosity, __FILE__, __LINE__, BOOST_CURRENT_FUNCTION)
 
 /*!
@@ -91,6 +104,9 @@ namespace uhd{ namespace _log{
 
         ~log(void);
 
+        //! Will a message of this verbosity be recorded?
+        static bool enabled(const verbosity_t verbosity);
+
         // Macro for overloading insertion operators to avoid costly
         // conversion of types if not logging.
         #define INSERTION_OVERLOAD(x)   log& operator<< (x)             \
@@ -113,6 +129,17 @@ namespace uhd{ namespace _log{
         bool _log_it;
     };
 
+    //! Turns a log statement into a void expression (used by UHD_LOGV)
+    struct log_voidify {
+        void operator&(const log &) {}
+    };
+
+    /*!
+     * Write out all queued log entries and wait until they are in the file.
+     * Safe to call from error and crash handlers.
+     */
+    UHD_API void flush(void);
+
 }} //namespace uhd::_log
 
 #endif /* INCLUDED_UHD_UTILS_LOG_HPP */
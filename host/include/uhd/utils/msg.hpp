@@ -64,6 +64,31 @@ namespace uhd{ namespace msg{
      */
     UHD_API void register_handler(const handler_t &handler);
 
+    /*!
+     * Post a fast-path event from a streaming thread, such as
+     * 'O' (overflow), 'U' (underflow), 'L' (late command),
+     * 'S' (sequence error) or 'D' (dropped packet).
+     *
+     * This call never blocks: the event is counted and handed to the
+     * message handler as a fastpath message by a background thread,
+     * batched with the other events that arrived in the meantime.
+     * Events that arrive faster than they can be reported are counted
+     * but not passed to the handler. UHD_MSG(fastpath) messages of a
+     * single character take the same path.
+     * \param event the event character
+     */
+    UHD_API void post_fastpath(const char event);
+
+    /*!
+     * Get the number of times an event was posted in this process.
+     * \param event the event character
+     * \return the number of events, including unreported ones
+     */
+    UHD_API size_t get_fastpath_count(const char event);
+
+    //! Hand all pending fast-path events to the message handler now
+    UHD_API void flush_fastpath(void);
+
     //! Internal message object (called by UHD_MSG macro)
     class UHD_API _msg{
     public:
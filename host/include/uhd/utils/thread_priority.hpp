@@ -19,6 +19,7 @@
 #define INCLUDED_UHD_UTILS_THREAD_PRIORITY_HPP
 
 #include <uhd/config.hpp>
+#include <cstddef>
 
 namespace uhd{
 
@@ -53,6 +54,20 @@ namespace uhd{
         bool realtime = true
     );
 
+    /*!
+     * Pin the current thread to a CPU.
+     * \param cpu the index of the CPU to run on
+     * \throw exception on failure or when pinning is not supported
+     */
+    UHD_API void set_thread_affinity(const size_t cpu);
+
+    /*!
+     * Pin the current thread to a CPU.
+     * Same as set_thread_affinity but does not throw on failure.
+     * \return true on success, false on failure
+     */
+    UHD_API bool set_thread_affinity_safe(const size_t cpu);
+
 } //namespace uhd
 
 #endif /* INCLUDED_UHD_UTILS_THREAD_PRIORITY_HPP */
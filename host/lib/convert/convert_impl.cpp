@@ -23,6 +23,7 @@
 #include <stdint.h>
 #include <boost/format.hpp>
 #include <boost/foreach.hpp>
+#include <boost/functional/hash.hpp>
 #include <complex>
 
 using namespace uhd;
@@ -40,6 +41,15 @@ bool convert::operator==(const convert::id_type &lhs, const convert::id_type &rh
     ;
 }
 
+size_t convert::hash_value(const convert::id_type &id){
+    size_t seed = 0;
+    boost::hash_combine(seed, id.input_format);
+    boost::hash_combine(seed, id.num_inputs);
+    boost::hash_combine(seed, id.output_format);
+    boost::hash_combine(seed, id.num_outputs);
+    return seed;
+}
+
 std::string convert::id_type::to_pp_string(void) const{
     return str(boost::format(
         "conversion ID\n"
@@ -67,6 +77,10 @@ std::string convert::id_type::to_string(void) const{
 /***********************************************************************
  * Setup the table registry
  **********************************************************************/
+namespace uhd{
+    template <> struct dict_key_hashable<convert::id_type> : boost::true_type{};
+}
+
 typedef uhd::dict<convert::id_type, uhd::dict<convert::priority_type, convert::function_type> > fcn_table_type;
 UHD_SINGLETON_FCN(fcn_table_type, get_table);
 
@@ -28,6 +28,9 @@
 #include <boost/functional/hash.hpp>
 #include <boost/tuple/tuple.hpp>
 #include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/bind.hpp>
+#include <set>
 
 using namespace uhd;
 
@@ -64,7 +67,7 @@ static size_t hash_device_addr(
 /***********************************************************************
  * Registration
  **********************************************************************/
-typedef boost::tuple<device::find_t, device::make_t, device::device_filter_t> dev_fcn_reg_t;
+typedef boost::tuple<device::find_t, device::make_t, device::device_filter_t, bool> dev_fcn_reg_t;
 
 // instantiate the device function registry container
 UHD_SINGLETON_FCN(std::vector<dev_fcn_reg_t>, get_dev_fcn_regs)
@@ -73,9 +76,18 @@ void device::register_device(
     const find_t &find,
     const make_t &make,
     const device_filter_t filter
+){
+    register_device(find, make, filter, false);
+}
+
+void device::register_device(
+    const find_t &find,
+    const make_t &make,
+    const device_filter_t filter,
+    const bool concurrent_find
 ){
     UHD_LOGV(always) << "registering device" << std::endl;
-    get_dev_fcn_regs().push_back(dev_fcn_reg_t(find, make, filter));
+    get_dev_fcn_regs().push_back(dev_fcn_reg_t(find, make, filter, concurrent_find));
 }
 
 device::~device(void){
@@ -85,28 +97,87 @@ device::~device(void){
 /***********************************************************************
  * Discover
  **********************************************************************/
+//! Call a finder, discovery errors are reported and result in no devices
+static void find_devices(
+    const device::find_t &find,
+    const device_addr_t &hint,
+    device_addrs_t &device_addrs
+){
+    try {
+        device_addrs = find(hint);
+    }
+    catch (const std::exception &e) {
+        UHD_MSG(error) << "Device discovery error: " << e.what() << std::endl;
+    }
+}
+
+/*!
+ * Call the finders of all registered device types that match the filter.
+ * The finders registered as concurrent, i.e. the network ones, run in
+ * threads of their own, so that discovery takes as long as the slowest
+ * of them rather than the sum of their timeouts. The other finders run
+ * one after another on the calling thread meanwhile: libusb and the
+ * USB devices do not cope with several enumerations at the same time.
+ * \param hint the device hint to pass to the finders
+ * \param filter the device type filter
+ * \return a list of (maker, discovered addresses), in registration order
+ */
+static std::vector<std::pair<device::make_t, device_addrs_t> > find_all_devices(
+    const device_addr_t &hint,
+    device::device_filter_t filter
+){
+    std::vector<std::pair<device::make_t, device_addrs_t> > results;
+    std::vector<dev_fcn_reg_t> regs;
+    BOOST_FOREACH(const dev_fcn_reg_t &fcn, get_dev_fcn_regs()) {
+        if (filter == device::ANY or fcn.get<2>() == filter) {
+            regs.push_back(fcn);
+            results.push_back(std::make_pair(fcn.get<1>(), device_addrs_t()));
+        }
+    }
+
+    size_t num_concurrent = 0;
+    BOOST_FOREACH(const dev_fcn_reg_t &fcn, regs) {
+        if (fcn.get<3>()) num_concurrent++;
+    }
+
+    boost::thread_group find_threads;
+    for (size_t i = 0; i < regs.size(); i++) {
+        if (not regs[i].get<3>() or num_concurrent < 2) continue;
+        find_threads.create_thread(boost::bind(
+            &find_devices, boost::cref(regs[i].get<0>()), boost::cref(hint), boost::ref(results[i].second)
+        ));
+    }
+    for (size_t i = 0; i < regs.size(); i++) {
+        if (regs[i].get<3>() and num_concurrent >= 2) continue;
+        find_devices(regs[i].get<0>(), hint, results[i].second);
+    }
+    find_threads.join_all();
+    return results;
+}
+
 device_addrs_t device::find(const device_addr_t &hint, device_filter_t filter){
     boost::mutex::scoped_lock lock(_device_mutex);
 
+    typedef std::pair<make_t, device_addrs_t> result_t;
     device_addrs_t device_addrs;
+    BOOST_FOREACH(const result_t &result, find_all_devices(hint, filter)) {
+        device_addrs.insert(
+            device_addrs.begin(),
+            result.second.begin(),
+            result.second.end()
+        );
+    }
 
-    BOOST_FOREACH(const dev_fcn_reg_t &fcn, get_dev_fcn_regs()) {
-        try {
-            if (filter == ANY or fcn.get<2>() == filter) {
-                device_addrs_t discovered_addrs = fcn.get<0>()(hint);
-                device_addrs.insert(
-                    device_addrs.begin(),
-                    discovered_addrs.begin(),
-                    discovered_addrs.end()
-                );
-            }
-        }
-        catch (const std::exception &e) {
-            UHD_MSG(error) << "Device discovery error: " << e.what() << std::endl;
+    //a device can be reported more than once, e.g. when it is reachable
+    //through several interfaces: only keep the first one
+    device_addrs_t unique_addrs;
+    std::set<std::string> seen;
+    BOOST_FOREACH(const device_addr_t &dev_addr, device_addrs) {
+        if (seen.insert(dev_addr.to_string()).second) {
+            unique_addrs.push_back(dev_addr);
         }
     }
-
-    return device_addrs;
+    return unique_addrs;
 }
 
 /***********************************************************************
@@ -118,18 +189,15 @@ device::sptr device::make(const device_addr_t &hint, device_filter_t filter, siz
     typedef boost::tuple<device_addr_t, make_t> dev_addr_make_t;
     std::vector<dev_addr_make_t> dev_addr_makers;
 
-    BOOST_FOREACH(const dev_fcn_reg_t &fcn, get_dev_fcn_regs()){
-        try{
-            if(filter == ANY or fcn.get<2>() == filter){
-                BOOST_FOREACH(device_addr_t dev_addr, fcn.get<0>()(hint)){
-                    //append the discovered address and its factory function
-                    dev_addr_makers.push_back(dev_addr_make_t(dev_addr, fcn.get<1>()));
-                }
+    typedef std::pair<make_t, device_addrs_t> result_t;
+    std::set<std::string> seen;
+    BOOST_FOREACH(const result_t &result, find_all_devices(hint, filter)){
+        BOOST_FOREACH(const device_addr_t &dev_addr, result.second){
+            //append the discovered address and its factory function
+            if (seen.insert(dev_addr.to_string()).second) {
+                dev_addr_makers.push_back(dev_addr_make_t(dev_addr, result.first));
             }
         }
-        catch(const std::exception &e){
-            UHD_MSG(error) << "Device discovery error: " << e.what() << std::endl;
-        }
     }
 
     //check that we found any devices
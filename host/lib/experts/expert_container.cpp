@@ -25,11 +25,14 @@
 #include <boost/make_shared.hpp>
 #include <boost/scoped_ptr.hpp>
 #include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
 #include <boost/thread.hpp>
 #include <boost/graph/graph_traits.hpp>
 #include <boost/graph/depth_first_search.hpp>
 #include <boost/graph/topological_sort.hpp>
 #include <boost/graph/adjacency_list.hpp>
+#include <algorithm>
+#include <vector>
 
 #ifdef UHD_EXPERT_LOGGING
 #define EX_LOG(depth, str) _log(depth, str)
@@ -51,9 +54,127 @@ typedef boost::adjacency_list<
 
 typedef std::map<std::string, expert_graph_t::vertex_descriptor> vertex_map_t;
 typedef std::list<expert_graph_t::vertex_descriptor>             node_queue_t;
+typedef std::vector<expert_graph_t::vertex_descriptor>           vertex_list_t;
 
 typedef boost::graph_traits<expert_graph_t>::edge_iterator       edge_iter;
 typedef boost::graph_traits<expert_graph_t>::vertex_iterator     vertex_iter;
+typedef boost::graph_traits<expert_graph_t>::adjacency_iterator  adjacency_iter;
+
+/*!
+ * A small pool of threads that resolves a batch of independent workers.
+ * The thread that submits a batch resolves workers too, so a pool with
+ * N threads resolves up to N+1 workers at the same time.
+ */
+class worker_pool : private boost::noncopyable
+{
+public:
+    typedef boost::shared_ptr<worker_pool> sptr;
+
+    worker_pool(const size_t num_threads):
+        _jobs(NULL), _next_job(0), _pending(0), _generation(0), _stop(false)
+    {
+        for (size_t i = 0; i < num_threads; i++) {
+            _threads.create_thread(boost::bind(&worker_pool::_thread_loop, this));
+        }
+    }
+
+    ~worker_pool()
+    {
+        {
+            boost::lock_guard<boost::mutex> lock(_mutex);
+            _stop = true;
+        }
+        _job_cond.notify_all();
+        _threads.join_all();
+    }
+
+    //Resolve all the nodes and wait for them to finish. If any of them failed,
+    //the error of the first failed node (in the order of the batch) is rethrown.
+    void resolve(const std::vector<dag_vertex_t*>& nodes)
+    {
+        {
+            boost::lock_guard<boost::mutex> lock(_mutex);
+            _jobs = &nodes;
+            _next_job = 0;
+            _pending = nodes.size();
+            _errors.assign(nodes.size(), error_t());
+            _generation++;
+        }
+        _job_cond.notify_all();
+        _run_jobs();
+
+        std::vector<error_t> errors;
+        {
+            boost::unique_lock<boost::mutex> lock(_mutex);
+            while (_pending > 0) {
+                _done_cond.wait(lock);
+            }
+            _jobs = NULL;
+            errors.swap(_errors);
+        }
+        BOOST_FOREACH(const error_t& error, errors) {
+            if (error) error->dynamic_throw();
+        }
+    }
+
+private:
+    typedef boost::shared_ptr<uhd::exception> error_t;
+
+    void _thread_loop()
+    {
+        size_t generation = 0;
+        boost::unique_lock<boost::mutex> lock(_mutex);
+        while (true) {
+            while (not _stop and _generation == generation) {
+                _job_cond.wait(lock);
+            }
+            if (_stop) return;
+            generation = _generation;
+            lock.unlock();
+            _run_jobs();
+            lock.lock();
+        }
+    }
+
+    void _run_jobs()
+    {
+        boost::unique_lock<boost::mutex> lock(_mutex);
+        while (_jobs != NULL and _next_job < _jobs->size()) {
+            const size_t index = _next_job++;
+            dag_vertex_t& node = *(*_jobs)[index];
+            lock.unlock();
+
+            //Exceptions cannot cross threads, so keep a copy for the submitter
+            error_t error;
+            try {
+                node.resolve();
+            } catch (const uhd::exception& ex) {
+                error.reset(ex.dynamic_clone());
+            } catch (const std::exception& ex) {
+                error.reset(new uhd::runtime_error(ex.what()));
+            } catch (...) {
+                error.reset(new uhd::runtime_error("Unknown error while resolving " + node.get_name()));
+            }
+
+            lock.lock();
+            _errors[index] = error;
+            if (--_pending == 0) {
+                _done_cond.notify_all();
+            }
+        }
+    }
+
+    boost::thread_group                 _threads;
+    boost::mutex                        _mutex;
+    boost::condition_variable           _job_cond;
+    boost::condition_variable           _done_cond;
+    const std::vector<dag_vertex_t*>*   _jobs;
+    size_t                              _next_job;
+    size_t                              _pending;
+    std::vector<error_t>                _errors;
+    size_t                              _generation;
+    bool                                _stop;
+};
 
 class expert_container_impl : public expert_container
 {
@@ -71,10 +192,24 @@ private:    //Visitor class for cycle detection algorithm
         private: std::vector<std::string>& _back_edges;
     };
 
+    //Orders vertices by their position in the topological sort
+    struct topological_order
+    {
+        topological_order(const std::vector<size_t>& rank): _rank(rank) {}
+
+        bool operator()(expert_graph_t::vertex_descriptor a, expert_graph_t::vertex_descriptor b) const {
+            return _rank[a] < _rank[b];
+        }
+        private: const std::vector<size_t>& _rank;
+    };
+
 public:
-    expert_container_impl(const std::string& name):
-        _name(name)
+    expert_container_impl(const std::string& name, const size_t max_parallel_workers):
+        _name(name), _topology_valid(false)
     {
+        if (max_parallel_workers > 1) {
+            _pool = boost::make_shared<worker_pool>(max_parallel_workers - 1);
+        }
     }
 
     ~expert_container_impl()
@@ -93,27 +228,42 @@ public:
         boost::lock_guard<boost::mutex> lock(_mutex);
         EX_LOG(0, str(boost::format("resolve_all(%s)") % (force?"force":"")));
         // Do a full resolve of the graph
-        _resolve_helper("", "", force);
+        _update_topology();
+        _resolve_helper(_sorted_nodes, std::vector<bool>(), force);
     }
 
-    void resolve_from(const std::string&)
+    void resolve_from(const std::string& node_name)
     {
         boost::lock_guard<boost::recursive_mutex> resolve_lock(_resolve_mutex);
         boost::lock_guard<boost::mutex> lock(_mutex);
-        EX_LOG(0, "resolve_from (overridden to resolve_all)");
-        // Do a full resolve of the graph
-        // Not optimizing the traversal using node_name to reduce experts complexity
-        _resolve_helper("", "", false);
+        EX_LOG(0, str(boost::format("resolve_from(%s)") % node_name));
+        _update_topology();
+
+        // Only the nodes downstream of a dirty data node can change: the one that
+        // was just written and any that were written without triggering a resolve
+        vertex_list_t roots(1, _lookup_vertex(node_name));
+        BOOST_FOREACH(const expert_graph_t::vertex_descriptor& v, _data_nodes) {
+            if (_get_vertex(v).is_dirty()) roots.push_back(v);
+        }
+        vertex_list_t subgraph;
+        std::vector<bool> in_subgraph;
+        _collect_subgraph(roots, true, subgraph, in_subgraph);
+        _resolve_helper(subgraph, in_subgraph, false);
     }
 
-    void resolve_to(const std::string&)
+    void resolve_to(const std::string& node_name)
     {
         boost::lock_guard<boost::recursive_mutex> resolve_lock(_resolve_mutex);
         boost::lock_guard<boost::mutex> lock(_mutex);
-        EX_LOG(0, "resolve_to (overridden to resolve_all)");
-        // Do a full resolve of the graph
-        // Not optimizing the traversal using node_name to reduce experts complexity
-        _resolve_helper("", "", false);
+        EX_LOG(0, str(boost::format("resolve_to(%s)") % node_name));
+        _update_topology();
+
+        // Only the nodes that the requested node depends on need to be resolved
+        vertex_list_t roots(1, _lookup_vertex(node_name));
+        vertex_list_t subgraph;
+        std::vector<bool> in_subgraph;
+        _collect_subgraph(roots, false, subgraph, in_subgraph);
+        _resolve_helper(subgraph, in_subgraph, false);
     }
 
     dag_vertex_t& retrieve(const std::string& name) const
@@ -304,6 +454,7 @@ protected:
         try {
             //Add a vertex in this graph for the data node
             expert_graph_t::vertex_descriptor gr_node = boost::add_vertex(data_node, _expert_dag);
+            _topology_valid = false;
             EX_LOG(1, str(boost::format("added vertex %s") % data_node->get_name()));
             _datanode_map.insert(vertex_map_t::value_type(data_node->get_name(), gr_node));
 
@@ -343,6 +494,7 @@ protected:
         try {
             //Add a vertex in this graph for the worker node
             expert_graph_t::vertex_descriptor gr_node = boost::add_vertex(worker, _expert_dag);
+            _topology_valid = false;
             EX_LOG(1, str(boost::format("added vertex %s") % worker->get_name()));
             _worker_map.insert(vertex_map_t::value_type(worker->get_name(), gr_node));
 
@@ -407,13 +559,24 @@ protected:
         // Release all nodes in the map
         _worker_map.clear();
         _datanode_map.clear();
+
+        // Release the cached topology
+        _topology_valid = false;
+        _sorted_nodes.clear();
+        _sort_rank.clear();
+        _level.clear();
+        _predecessors.clear();
+        _data_nodes.clear();
     }
 
 private:
-    void _resolve_helper(std::string start, std::string stop, bool force)
+    void _update_topology()
     {
+        if (_topology_valid) return;
+
         //Sort the graph topologically. This ensures that for all dependencies, the dependant
-        //is always after all of its dependencies.
+        //is always after all of its dependencies. The order only changes when nodes are added
+        //so it is cached along with the predecessors of every node.
         node_queue_t sorted_nodes;
         try {
             boost::topological_sort(_expert_dag, std::front_inserter(sorted_nodes));
@@ -430,33 +593,89 @@ private:
                                          "The following back-edges were found:" + edges);
             }
         }
-        if (sorted_nodes.empty()) return;
+        _sorted_nodes.assign(sorted_nodes.begin(), sorted_nodes.end());
 
-        //Determine the start and stop node. If one is not explicitly specified then
-        //resolve everything
-        expert_graph_t::vertex_descriptor start_vertex = sorted_nodes.front();
-        expert_graph_t::vertex_descriptor stop_vertex = sorted_nodes.back();
-        if (not start.empty()) start_vertex = _lookup_vertex(start);
-        if (not stop.empty()) stop_vertex = _lookup_vertex(stop);
-
-        //First Pass: Resolve all nodes if they are dirty, in a topological order
-        std::list<dag_vertex_t*> resolved_workers;
-        bool start_node_encountered = false;
-        for (node_queue_t::iterator node_iter = sorted_nodes.begin();
-             node_iter != sorted_nodes.end();
-             ++node_iter
+        const size_t num_vertices = boost::num_vertices(_expert_dag);
+        _predecessors.assign(num_vertices, vertex_list_t());
+        for (std::pair<edge_iter, edge_iter> ei = boost::edges(_expert_dag);
+             ei.first != ei.second;
+             ++ei.first
         ) {
-            //Determine if we are at or beyond the starting node
-            if (*node_iter == start_vertex) start_node_encountered = true;
+            _predecessors[boost::target(*(ei.first), _expert_dag)].push_back(
+                boost::source(*(ei.first), _expert_dag));
+        }
+
+        //The level of a node is the length of the longest path that leads to it.
+        //Nodes on the same level never depend on each other. To resolve them in
+        //batches, order the nodes by level which is also a topological order.
+        _level.assign(num_vertices, 0);
+        BOOST_FOREACH(const expert_graph_t::vertex_descriptor& v, _sorted_nodes) {
+            BOOST_FOREACH(const expert_graph_t::vertex_descriptor& p, _predecessors[v]) {
+                _level[v] = std::max(_level[v], _level[p] + 1);
+            }
+        }
+        if (_pool) {
+            std::stable_sort(_sorted_nodes.begin(), _sorted_nodes.end(), topological_order(_level));
+        }
 
-            //Only resolve if the starting node has passed
-            if (start_node_encountered) {
-                dag_vertex_t& node = _get_vertex(*node_iter);
-                std::string node_val;
+        _sort_rank.assign(num_vertices, 0);
+        for (size_t i = 0; i < _sorted_nodes.size(); i++) {
+            _sort_rank[_sorted_nodes[i]] = i;
+        }
+
+        _data_nodes.clear();
+        BOOST_FOREACH(const vertex_map_t::value_type& v, _datanode_map) {
+            _data_nodes.push_back(v.second);
+        }
+
+        _topology_valid = true;
+    }
+
+    void _collect_subgraph(
+        const vertex_list_t& roots,
+        bool downstream,
+        vertex_list_t& subgraph,
+        std::vector<bool>& in_subgraph
+    ) {
+        //Collect every node reachable from the roots by following the edges forward
+        //(downstream) or backward (upstream) and sort them topologically
+        in_subgraph.assign(boost::num_vertices(_expert_dag), false);
+        vertex_list_t pending(roots);
+        while (not pending.empty()) {
+            const expert_graph_t::vertex_descriptor v = pending.back();
+            pending.pop_back();
+            if (in_subgraph[v]) continue;
+            in_subgraph[v] = true;
+            subgraph.push_back(v);
+            if (downstream) {
+                for (std::pair<adjacency_iter, adjacency_iter> ai = boost::adjacent_vertices(v, _expert_dag);
+                     ai.first != ai.second;
+                     ++ai.first
+                ) {
+                    if (not in_subgraph[*ai.first]) pending.push_back(*ai.first);
+                }
+            } else {
+                BOOST_FOREACH(const expert_graph_t::vertex_descriptor& p, _predecessors[v]) {
+                    if (not in_subgraph[p]) pending.push_back(p);
+                }
+            }
+        }
+        std::sort(subgraph.begin(), subgraph.end(), topological_order(_sort_rank));
+    }
+
+    void _resolve_helper(const vertex_list_t& sorted_nodes, const std::vector<bool>& in_subgraph, bool force)
+    {
+        //First Pass: Resolve all nodes if they are dirty, in a topological order
+        vertex_list_t resolved_workers;
+        if (_pool) {
+            _resolve_levels(sorted_nodes, force, resolved_workers);
+        } else {
+            BOOST_FOREACH(const expert_graph_t::vertex_descriptor& v, sorted_nodes) {
+                dag_vertex_t& node = _get_vertex(v);
                 if (force or node.is_dirty()) {
                     node.resolve();
                     if (node.get_class() == CLASS_WORKER) {
-                        resolved_workers.push_back(&node);
+                        resolved_workers.push_back(v);
                     }
                     EX_LOG(1, str(boost::format("resolved node %s (%s) [%s]") %
                                     node.get_name() % (node.is_dirty()?"dirty":"clean") % node.to_string()));
@@ -465,20 +684,93 @@ private:
                                     node.get_name() % (node.is_dirty()?"dirty":"clean") % node.to_string()));
                 }
             }
+        }
 
-            //Determine if we are beyond the stop node
-            if (*node_iter == stop_vertex) break;
+        //Second Pass: Mark all the inputs of resolved workers clean. The policy is that a worker
+        //will mark all of its dependencies clean so after this step all data nodes that are not
+        //consumed by a worker will remain dirty (as they should because no one has consumed their
+        //value). If only part of the graph was resolved (in_subgraph is not empty), an input that
+        //is also read by a worker outside of that part stays dirty until that worker has run.
+        BOOST_FOREACH(const expert_graph_t::vertex_descriptor& worker, resolved_workers) {
+            BOOST_FOREACH(const expert_graph_t::vertex_descriptor& input, _predecessors[worker]) {
+                if (in_subgraph.empty() or _readers_in_subgraph(input, in_subgraph)) {
+                    _get_vertex(input).mark_clean();
+                }
+            }
+        }
+    }
+
+    void _resolve_levels(const vertex_list_t& sorted_nodes, bool force, vertex_list_t& resolved_workers)
+    {
+        //The nodes are sorted by level so each level is a contiguous range. All the dirty
+        //workers of a level are resolved concurrently, except for those that write a node
+        //that is also written by another worker of that level: they run afterwards.
+        std::vector<dag_vertex_t*> batch;
+        vertex_list_t deferred, written;
+        size_t begin = 0;
+        while (begin < sorted_nodes.size()) {
+            const size_t level = _level[sorted_nodes[begin]];
+            size_t end = begin;
+            batch.clear();
+            deferred.clear();
+            written.clear();
+            for (; end < sorted_nodes.size() and _level[sorted_nodes[end]] == level; end++) {
+                const expert_graph_t::vertex_descriptor v = sorted_nodes[end];
+                dag_vertex_t& node = _get_vertex(v);
+                if (not (force or node.is_dirty())) {
+                    EX_LOG(1, str(boost::format("skipped node %s (%s) [%s]") %
+                                    node.get_name() % (node.is_dirty()?"dirty":"clean") % node.to_string()));
+                } else if (node.get_class() != CLASS_WORKER) {
+                    node.resolve();
+                } else if (_claim_outputs(v, written)) {
+                    batch.push_back(&node);
+                    resolved_workers.push_back(v);
+                } else {
+                    deferred.push_back(v);
+                    resolved_workers.push_back(v);
+                }
+            }
+
+            if (batch.size() > 1) {
+                _pool->resolve(batch);
+            } else if (not batch.empty()) {
+                batch.front()->resolve();
+            }
+            BOOST_FOREACH(const expert_graph_t::vertex_descriptor& v, deferred) {
+                _get_vertex(v).resolve();
+            }
+            EX_LOG(1, str(boost::format("resolved %d workers on level %d (%d concurrently)") %
+                            (batch.size() + deferred.size()) % level % batch.size()));
+            begin = end;
+        }
+    }
+
+    bool _claim_outputs(expert_graph_t::vertex_descriptor worker, vertex_list_t& written) const
+    {
+        for (std::pair<adjacency_iter, adjacency_iter> ai = boost::adjacent_vertices(worker, _expert_dag);
+             ai.first != ai.second;
+             ++ai.first
+        ) {
+            if (std::find(written.begin(), written.end(), *ai.first) != written.end()) return false;
+        }
+        for (std::pair<adjacency_iter, adjacency_iter> ai = boost::adjacent_vertices(worker, _expert_dag);
+             ai.first != ai.second;
+             ++ai.first
+        ) {
+            written.push_back(*ai.first);
         }
+        return true;
+    }
 
-        //Second Pass: Mark all the workers clean. The policy is that a worker will mark all of
-        //its dependencies clean so after this step all data nodes that are not consumed by a worker
-        //will remain dirty (as they should because no one has consumed their value)
-        for (std::list<dag_vertex_t*>::iterator worker = resolved_workers.begin();
-             worker != resolved_workers.end();
-             ++worker
+    bool _readers_in_subgraph(expert_graph_t::vertex_descriptor node, const std::vector<bool>& in_subgraph) const
+    {
+        for (std::pair<adjacency_iter, adjacency_iter> ai = boost::adjacent_vertices(node, _expert_dag);
+             ai.first != ai.second;
+             ++ai.first
         ) {
-            (*worker)->mark_clean();
+            if (not in_subgraph[*ai.first]) return false;
         }
+        return true;
     }
 
     expert_graph_t::vertex_descriptor _lookup_vertex(const std::string& name) const
@@ -522,13 +814,20 @@ private:
     expert_graph_t          _expert_dag;        //The primary graph data structure as an adjacency list
     vertex_map_t            _worker_map;        //A map from vertex name to vertex descriptor for workers
     vertex_map_t            _datanode_map;      //A map from vertex name to vertex descriptor for data nodes
+    bool                    _topology_valid;    //The cached topology below matches the graph
+    vertex_list_t           _sorted_nodes;      //All vertices in topological order
+    std::vector<size_t>     _sort_rank;         //Position of each vertex in _sorted_nodes
+    std::vector<size_t>     _level;             //Length of the longest path to each vertex
+    std::vector<vertex_list_t> _predecessors;   //Vertices with an edge to each vertex
+    vertex_list_t           _data_nodes;        //All data node vertices
     boost::mutex            _mutex;
     boost::recursive_mutex  _resolve_mutex;
+    worker_pool::sptr       _pool;              //Resolves independent workers (NULL if disabled)
 };
 
-expert_container::sptr expert_container::make(const std::string& name)
+expert_container::sptr expert_container::make(const std::string& name, const size_t max_parallel_workers)
 {
-    return boost::make_shared<expert_container_impl>(name);
+    return boost::make_shared<expert_container_impl>(name, max_parallel_workers);
 }
 
 }}
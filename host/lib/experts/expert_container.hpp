@@ -63,6 +63,9 @@ namespace uhd { namespace experts {
         /*!
          * Resolves all the nodes that depend on the specified node.
          *
+         * Nodes that depend on other dirty data nodes (e.g. properties
+         * without auto-resolve that were written since the last resolve)
+         * are resolved as well. No other part of the graph is visited.
          * Dependency analysis is performed on the graph and nodes
          * are resolved in a topologically sorted order to ensure
          * that no nodes receive stale data.
@@ -81,6 +84,9 @@ namespace uhd { namespace experts {
         /*!
          * Resolves all the specified node and all of its dependencies.
          *
+         * Only the part of the graph upstream of the node is visited.
+         * Input data nodes that are also read by workers outside of that
+         * part stay dirty, so those workers still run on the next resolve.
          * Dependency analysis is performed on the graph and nodes
          * are resolved in a topologically sorted order to ensure
          * that no nodes receive stale data.
@@ -152,8 +158,11 @@ namespace uhd { namespace experts {
          * specified name.
          *
          * \param name Name of the container
+         * \param max_parallel_workers Maximum number of independent workers
+         *        that are resolved concurrently (1 resolves all workers on
+         *        the calling thread)
          */
-        static sptr make(const std::string& name);
+        static sptr make(const std::string& name, const size_t max_parallel_workers = 1);
 
         /*!
          * Returns a reference to the resolver mutex.
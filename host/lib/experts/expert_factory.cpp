@@ -19,9 +19,11 @@
 
 namespace uhd { namespace experts {
 
-expert_container::sptr expert_factory::create_container(const std::string& name)
-{
-    return expert_container::make(name);
+expert_container::sptr expert_factory::create_container(
+    const std::string& name,
+    const size_t max_parallel_workers
+) {
+    return expert_container::make(name, max_parallel_workers);
 }
 
 }}
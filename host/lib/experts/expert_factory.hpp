@@ -45,10 +45,22 @@ namespace uhd { namespace experts {
          * Creates an empty instance of expert_container with the
          * specified name.
          *
+         * Workers that do not depend on each other (e.g. the experts of
+         * two independent channels) can be resolved concurrently on a
+         * small thread pool owned by the container. Workers are still
+         * resolved in dependency order and a worker only runs if one of
+         * its inputs is dirty. Workers that write the same data node are
+         * never resolved concurrently, but any other state they share
+         * outside of the expert graph must be protected by a lock.
+         *
          * \param name Name of the container
+         * \param max_parallel_workers Maximum number of workers resolved
+         *        at the same time. The default (1) resolves all workers
+         *        sequentially on the calling thread.
          */
         static expert_container::sptr create_container(
-            const std::string& name
+            const std::string& name,
+            const size_t max_parallel_workers = 1
         );
 
         /*!
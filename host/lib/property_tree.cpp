@@ -16,10 +16,14 @@
 //
 
 #include <uhd/property_tree.hpp>
-#include <uhd/types/dict.hpp>
 #include <boost/foreach.hpp>
 #include <boost/thread/mutex.hpp>
+#include <boost/thread/shared_mutex.hpp>
+#include <boost/functional/hash.hpp>
 #include <boost/make_shared.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/unordered_map.hpp>
+#include <algorithm>
 #include <iostream>
 
 using namespace uhd;
@@ -73,6 +77,10 @@ fs_path uhd::operator/(const fs_path &lhs, size_t rhs)
 
 /***********************************************************************
  * Property tree implementation
+ *
+ * Lookups (exists, list, access) share the tree lock so that threads
+ * which poll unrelated properties do not serialize. Structural changes
+ * (create, remove) take the lock exclusively.
  **********************************************************************/
 class property_tree_impl : public uhd::property_tree{
 public:
@@ -85,7 +93,7 @@ public:
 
     sptr subtree(const fs_path &path_) const{
         const fs_path path = _root / path_;
-        boost::mutex::scoped_lock lock(_guts->mutex);
+        boost::shared_lock<boost::shared_mutex> lock(_guts->mutex);
 
         property_tree_impl *subtree = new property_tree_impl(path);
         subtree->_guts = this->_guts; //copy the guts sptr
@@ -94,66 +102,64 @@ public:
 
     void remove(const fs_path &path_){
         const fs_path path = _root / path_;
-        boost::mutex::scoped_lock lock(_guts->mutex);
+        boost::unique_lock<boost::shared_mutex> lock(_guts->mutex);
 
         node_type *parent = NULL;
         node_type *node = &_guts->root;
+        std::string leaf;
         BOOST_FOREACH(const std::string &name, path_tokenizer(path)){
-            if (not node->has_key(name)) throw_path_not_found(path);
+            node_type *child = node->child(name);
+            if (child == NULL) throw_path_not_found(path);
             parent = node;
-            node = &(*node)[name];
+            node = child;
+            leaf = name;
         }
         if (parent == NULL) throw uhd::runtime_error("Cannot uproot");
-        parent->pop(fs_path(path.leaf()));
+        //keep the removed branch, references from access() may still be in use
+        _guts->retired.push_back(parent->remove_child(leaf));
+
+        //the index may point into the removed branch, no lookup holds
+        //a shard lock while the tree lock is held exclusively
+        BOOST_FOREACH(index_shard_type &shard, _guts->index){
+            shard.index.clear();
+        }
     }
 
     bool exists(const fs_path &path_) const{
         const fs_path path = _root / path_;
-        boost::mutex::scoped_lock lock(_guts->mutex);
+        boost::shared_lock<boost::shared_mutex> lock(_guts->mutex);
 
-        node_type *node = &_guts->root;
-        BOOST_FOREACH(const std::string &name, path_tokenizer(path)){
-            if (not node->has_key(name)) return false;
-            node = &(*node)[name];
-        }
-        return true;
+        return _find(path) != NULL;
     }
 
     std::vector<std::string> list(const fs_path &path_) const{
         const fs_path path = _root / path_;
-        boost::mutex::scoped_lock lock(_guts->mutex);
+        boost::shared_lock<boost::shared_mutex> lock(_guts->mutex);
 
-        node_type *node = &_guts->root;
-        BOOST_FOREACH(const std::string &name, path_tokenizer(path)){
-            if (not node->has_key(name)) throw_path_not_found(path);
-            node = &(*node)[name];
-        }
-
-        return node->keys();
+        node_type *node = _find(path);
+        if (node == NULL) throw_path_not_found(path);
+        return node->names;
     }
 
     void _create(const fs_path &path_, const boost::shared_ptr<void> &prop){
         const fs_path path = _root / path_;
-        boost::mutex::scoped_lock lock(_guts->mutex);
+        boost::unique_lock<boost::shared_mutex> lock(_guts->mutex);
 
         node_type *node = &_guts->root;
         BOOST_FOREACH(const std::string &name, path_tokenizer(path)){
-            if (not node->has_key(name)) (*node)[name] = node_type();
-            node = &(*node)[name];
+            node_type *child = node->child(name);
+            node = (child == NULL)? node->add_child(name) : child;
         }
         if (node->prop.get() != NULL) throw uhd::runtime_error("Cannot create! Property already exists at: " + path);
         node->prop = prop;
     }
 
-    boost::shared_ptr<void> &_access(const fs_path &path_) const{
+    boost::shared_ptr<void> _access(const fs_path &path_) const{
         const fs_path path = _root / path_;
-        boost::mutex::scoped_lock lock(_guts->mutex);
+        boost::shared_lock<boost::shared_mutex> lock(_guts->mutex);
 
-        node_type *node = &_guts->root;
-        BOOST_FOREACH(const std::string &name, path_tokenizer(path)){
-            if (not node->has_key(name)) throw_path_not_found(path);
-            node = &(*node)[name];
-        }
+        node_type *node = _find(path);
+        if (node == NULL) throw_path_not_found(path);
         if (node->prop.get() == NULL) throw uhd::runtime_error("Cannot access! Property uninitialized at: " + path);
         return node->prop;
     }
@@ -164,16 +170,70 @@ private:
     }
 
     //basic structural node element
-    struct node_type : uhd::dict<std::string, node_type>{
+    struct node_type{
+        typedef boost::unordered_map<std::string, boost::shared_ptr<node_type> > children_type;
+
+        node_type *child(const std::string &name){
+            children_type::const_iterator it = children.find(name);
+            return (it == children.end())? NULL : it->second.get();
+        }
+
+        node_type *add_child(const std::string &name){
+            boost::shared_ptr<node_type> &child = children[name];
+            child = boost::make_shared<node_type>();
+            names.push_back(name);
+            return child.get();
+        }
+
+        boost::shared_ptr<node_type> remove_child(const std::string &name){
+            const children_type::iterator it = children.find(name);
+            const boost::shared_ptr<node_type> child = it->second;
+            children.erase(it);
+            names.erase(std::find(names.begin(), names.end(), name));
+            return child;
+        }
+
+        children_type children;         //child nodes by name
+        std::vector<std::string> names; //child names in the order of creation
         boost::shared_ptr<void> prop;
     };
 
+    //nodes by full path, filled in as paths are looked up. Concurrent
+    //lookups fill in the index, so it is split into shards with a lock each.
+    typedef boost::unordered_map<std::string, node_type *> path_index_type;
+    struct index_shard_type{
+        path_index_type index;
+        boost::mutex mutex;
+    };
+    static const size_t NUM_INDEX_SHARDS = 16;
+
     //tree guts which may be referenced in a subtree
     struct tree_guts_type{
         node_type root;
-        boost::mutex mutex;
+        index_shard_type index[NUM_INDEX_SHARDS];
+        boost::shared_mutex mutex;
+        std::vector<boost::shared_ptr<node_type> > retired; //removed branches
     };
 
+    //find the node at a path or return NULL, the caller holds the tree lock
+    node_type *_find(const fs_path &path) const{
+        index_shard_type &shard = _guts->index[boost::hash<std::string>()(path) % NUM_INDEX_SHARDS];
+        {
+            boost::mutex::scoped_lock lock(shard.mutex);
+            path_index_type::const_iterator it = shard.index.find(path);
+            if (it != shard.index.end()) return it->second;
+        }
+
+        node_type *node = &_guts->root;
+        BOOST_FOREACH(const std::string &name, path_tokenizer(path)){
+            node = node->child(name);
+            if (node == NULL) return NULL;
+        }
+        boost::mutex::scoped_lock lock(shard.mutex);
+        shard.index[path] = node;
+        return node;
+    }
+
     //members, the tree and root prefix
     boost::shared_ptr<tree_guts_type> _guts;
     const fs_path _root;
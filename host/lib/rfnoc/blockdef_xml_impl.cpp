@@ -20,6 +20,7 @@
 #include <uhd/rfnoc/blockdef.hpp>
 #include <uhd/utils/msg.hpp>
 #include <uhd/utils/paths.hpp>
+#include <uhd/utils/static.hpp>
 #include <boost/assign/list_of.hpp>
 #include <boost/foreach.hpp>
 #include <boost/format.hpp>
@@ -28,7 +29,11 @@
 #include <boost/filesystem/operations.hpp>
 #include <boost/property_tree/ptree.hpp>
 #include <boost/property_tree/xml_parser.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/unordered_map.hpp>
 #include <cstdlib>
+#include <ctime>
 
 using namespace uhd;
 using namespace uhd::rfnoc;
@@ -212,13 +217,11 @@ public:
         return (rhs.find(lhs) == 0);
     }
 
-    //! Open the file at filename and see if it's a block definition for the given NoC ID
-    static bool has_noc_id(uint64_t noc_id, const fs::path &filename)
+    //! See if a parsed file is a block definition for the given NoC ID
+    static bool has_noc_id(uint64_t noc_id, const pt::ptree &propt)
     {
-        pt::ptree propt;
         try {
-            read_xml(filename.string(), propt);
-            BOOST_FOREACH(pt::ptree::value_type &v, propt.get_child("nocblock.ids")) {
+            BOOST_FOREACH(const pt::ptree::value_type &v, propt.get_child("nocblock.ids")) {
                 if (v.first == "id" and match_noc_id(v.second.data(), noc_id)) {
                     return true;
                 }
@@ -230,12 +233,11 @@ public:
         return false;
     }
 
-    blockdef_xml_impl(const fs::path &filename, uint64_t noc_id, xml_repr_t type=DESCRIBES_BLOCK) :
+    blockdef_xml_impl(const fs::path &filename, const pt::ptree &propt, uint64_t noc_id, xml_repr_t type=DESCRIBES_BLOCK) :
         _type(type),
-        _noc_id(noc_id)
+        _noc_id(noc_id),
+        _pt(propt)
     {
-        //UHD_MSG(status) << "Reading XML file: " << filename.string().c_str() << std::endl;
-        read_xml(filename.string(), _pt);
         try {
             // Check key is valid
             get_key();
@@ -413,45 +415,123 @@ private:
 
 };
 
-blockdef::sptr blockdef::make_from_noc_id(uint64_t noc_id)
+/****************************************************************************
+ * The registry of block definitions
+ ****************************************************************************/
+/*!
+ * Process-wide index of the block definition files.
+ *
+ * The XML directories are scanned and every file is parsed once. Lookups
+ * are then answered from the parsed trees, and the file that matched a
+ * NoC ID is remembered. The index is rebuilt when the list of
+ * directories changes (e.g. UHD_RFNOC_DIR was set) or when a file is
+ * added to or removed from one of them (their modification time changes).
+ */
+class blockdef_registry
 {
-    std::vector<fs::path> paths = blockdef_xml_impl::get_xml_paths();
-    std::vector<fs::path> valid;
-
-    // Check if any of the paths exist
-    BOOST_FOREACH(const fs::path &base_path, paths) {
-        fs::path this_path = base_path / XML_BLOCKS_SUBDIR;
-        if (fs::exists(this_path) and fs::is_directory(this_path)) {
-            valid.push_back(this_path);
+public:
+    blockdef::sptr make_from_noc_id(uint64_t noc_id)
+    {
+        boost::mutex::scoped_lock lock(_mutex);
+        _update();
+
+        lookup_t::const_iterator it = _lookups.find(noc_id);
+        if (it == _lookups.end()) {
+            size_t match = _files.size();
+            for (size_t i = 0; i < _files.size(); i++) {
+                if (blockdef_xml_impl::has_noc_id(noc_id, *_files[i].propt)) {
+                    match = i;
+                    break;
+                }
+            }
+            it = _lookups.insert(std::make_pair(noc_id, match)).first;
+        }
+        if (it->second == _files.size()) {
+            return blockdef::sptr();
         }
+        const xml_file_t &file = _files[it->second];
+        return blockdef::sptr(new blockdef_xml_impl(file.path, *file.propt, noc_id));
     }
 
-    if (valid.empty())
+private:
+    struct xml_file_t
     {
-        throw uhd::assertion_error(
-            "Failed to find a valid XML path for RFNoC blocks.\n"
-            "Try setting the enviroment variable UHD_RFNOC_DIR "
-            "to the correct location"
-        );
-    }
+        fs::path path;
+        boost::shared_ptr<pt::ptree> propt;
+    };
 
-    // Iterate over all paths
-    BOOST_FOREACH(const fs::path &path, valid) {
-        // Iterate over all .xml files
-        fs::directory_iterator end_itr;
-        for (fs::directory_iterator i(path); i != end_itr; ++i) {
-            if (not fs::exists(*i) or fs::is_directory(*i) or fs::is_empty(*i)) {
-                continue;
-            }
-            if (i->path().filename().extension() != XML_EXTENSION) {
-                continue;
+    typedef std::vector<std::pair<fs::path, std::time_t> > dirs_t;
+    //! NoC ID -> index into _files, or _files.size() if there's no match
+    typedef boost::unordered_map<uint64_t, size_t> lookup_t;
+
+    //! Returns the block directories that exist, with their modification times
+    static dirs_t _get_dirs()
+    {
+        dirs_t dirs;
+        BOOST_FOREACH(const fs::path &base_path, blockdef_xml_impl::get_xml_paths()) {
+            fs::path this_path = base_path / XML_BLOCKS_SUBDIR;
+            if (fs::exists(this_path) and fs::is_directory(this_path)) {
+                dirs.push_back(std::make_pair(this_path, fs::last_write_time(this_path)));
             }
-            if (blockdef_xml_impl::has_noc_id(noc_id, i->path())) {
-                return blockdef::sptr(new blockdef_xml_impl(i->path(), noc_id));
+        }
+
+        if (dirs.empty())
+        {
+            throw uhd::assertion_error(
+                "Failed to find a valid XML path for RFNoC blocks.\n"
+                "Try setting the enviroment variable UHD_RFNOC_DIR "
+                "to the correct location"
+            );
+        }
+        return dirs;
+    }
+
+    //! Rebuild the index if the directories have changed since the last scan
+    void _update()
+    {
+        const dirs_t dirs = _get_dirs();
+        if (dirs == _dirs) {
+            return;
+        }
+        _files.clear();
+        _lookups.clear();
+
+        // Iterate over all paths
+        BOOST_FOREACH(const dirs_t::value_type &dir, dirs) {
+            // Iterate over all .xml files
+            fs::directory_iterator end_itr;
+            for (fs::directory_iterator i(dir.first); i != end_itr; ++i) {
+                if (not fs::exists(*i) or fs::is_directory(*i) or fs::is_empty(*i)) {
+                    continue;
+                }
+                if (i->path().filename().extension() != XML_EXTENSION) {
+                    continue;
+                }
+                xml_file_t file;
+                file.path = i->path();
+                file.propt = boost::make_shared<pt::ptree>();
+                try {
+                    read_xml(file.path.string(), *file.propt);
+                } catch (std::exception &e) {
+                    UHD_MSG(warning) << "blockdef: could not read " << file.path.string() << ": " << e.what() << std::endl;
+                    continue;
+                }
+                _files.push_back(file);
             }
         }
+        _dirs = dirs;
     }
 
-    return blockdef::sptr();
+    boost::mutex _mutex;
+    dirs_t _dirs;
+    std::vector<xml_file_t> _files;
+    lookup_t _lookups;
+};
+
+UHD_SINGLETON_FCN(blockdef_registry, get_blockdef_registry);
+
+blockdef::sptr blockdef::make_from_noc_id(uint64_t noc_id)
+{
+    return get_blockdef_registry().make_from_noc_id(noc_id);
 }
 // vim: sw=4 et:
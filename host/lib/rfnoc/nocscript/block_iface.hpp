@@ -86,6 +86,9 @@ class block_iface {
 
     //! Container for scoped variables
     std::map<std::string, expression_literal> _vars;
+
+    //! Expression trees of the code that was run before, by code
+    std::map<std::string, expression::sptr> _exprs;
 };
 
 }}} /* namespace uhd::rfnoc::nocscript */
@@ -143,11 +143,11 @@ bool expression_literal::to_bool() const
 {
     switch (_type) {
         case TYPE_INT:
-            return bool(boost::lexical_cast<int>(_val));
+            return bool(_int_val);
         case TYPE_STRING:
             return not _val.empty();
         case TYPE_DOUBLE:
-            return bool(boost::lexical_cast<double>(_val));
+            return bool(_double_val);
         case TYPE_BOOL:
             return _bool_val;
         case TYPE_INT_VECTOR:
@@ -352,6 +352,8 @@ void expression_function::add(expression::sptr new_expr)
 {
     expression_container::add(new_expr);
     _arg_types.push_back(new_expr->infer_type());
+    // The signature changed, so the function must be looked up again
+    _function.clear();
 }
 
 expression::type_t expression_function::infer_type() const
@@ -361,7 +363,10 @@ expression::type_t expression_function::infer_type() const
 
 expression_literal expression_function::eval()
 {
-    return _func_table->eval(_name, _arg_types, _sub_exprs);
+    if (_function.empty()) {
+        _function = _func_table->get_function(_name, _arg_types);
+    }
+    return _function(_sub_exprs);
 }
 
 
@@ -314,6 +314,9 @@ class expression_function : public expression_container
     expression::type_t infer_type() const;
 
     /*! Evaluate all arguments, then the function itself.
+     *
+     * The function is looked up in the function table on the first
+     * evaluation only; further evaluations call it directly.
      */
     expression_literal eval();
 
@@ -324,6 +327,8 @@ class expression_function : public expression_container
     std::string _name;
     const boost::shared_ptr<function_table> _func_table;
     std::vector<expression::type_t> _arg_types;
+    //! The function that matches _name and _arg_types, once it was looked up
+    boost::function<expression_literal(expr_list_type&)> _function;
 };
 
 
@@ -20,6 +20,7 @@
 #include <boost/bind.hpp>
 #include <boost/foreach.hpp>
 #include <boost/format.hpp>
+#include <boost/unordered_map.hpp>
 #include <map>
 
 using namespace uhd::rfnoc::nocscript;
@@ -36,8 +37,7 @@ class function_table_impl : public function_table
             : return_type(return_type_), function(function_)
         {};
     };
-    // Should be an unordered_map... sigh, we'll get to C++11 someday.
-    typedef std::map<std::string, std::map<expression_function::argtype_list_type, function_info> > table_type;
+    typedef boost::unordered_map<std::string, std::map<expression_function::argtype_list_type, function_info> > table_type;
 
     /************************************************************************
      * Structors
@@ -94,6 +94,20 @@ class function_table_impl : public function_table
         return _table[name][arg_types].function(arguments);
     }
 
+    function_ptr get_function(
+            const std::string &name,
+            const expression_function::argtype_list_type &arg_types
+    ) {
+        if (not function_exists(name, arg_types)) {
+            throw uhd::syntax_error(str(
+                        boost::format("Cannot eval() function %s, not a known signature")
+                        % expression_function::to_string(name, arg_types)
+            ));
+        }
+
+        return _table[name][arg_types].function;
+    }
+
     void register_function(
             const std::string &name,
             const function_table::function_ptr &ptr,
@@ -18,6 +18,7 @@
 #include "expression.hpp"
 #include <boost/shared_ptr.hpp>
 #include <boost/function.hpp>
+#include <boost/bind.hpp>
 #include <vector>
 
 #ifndef INCLUDED_LIBUHD_RFNOC_NOCSCRIPT_FUNCTABLE_HPP
@@ -72,6 +73,23 @@ class function_table
             expression_container::expr_list_type &arguments
     ) = 0;
 
+    /*! Get the function \p name with the argument types \p arg_types
+     *
+     * Calling the returned function object is equivalent to calling
+     * eval() with the same name and argument types, but skips the
+     * lookup. Expressions use this to resolve a function once.
+     *
+     * \returns The function object
+     * \throws uhd::syntax_error if no such function is found (or, with
+     *         this default implementation, once the function is called)
+     */
+    virtual function_ptr get_function(
+            const std::string &name,
+            const expression_function::argtype_list_type &arg_types
+    ) {
+        return boost::bind(&function_table::eval, this, name, arg_types, _1);
+    }
+
     /*! Register a new function
      *
      * \param name Name of the function (e.g. 'ADD')
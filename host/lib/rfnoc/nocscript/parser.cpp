@@ -22,8 +22,12 @@
 #include <boost/bind.hpp>
 #include <boost/assign.hpp>
 #include <boost/make_shared.hpp>
+#include <boost/foreach.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/unordered_map.hpp>
 #include <sstream>
 #include <stack>
+#include <vector>
 
 using namespace uhd::rfnoc::nocscript;
 namespace lex = boost::spirit::lex;
@@ -90,6 +94,86 @@ class parser_impl : public parser
         }
     };
 
+    //! A token as produced by the lexer, independent of the lexer type
+    struct cached_token
+    {
+        size_t token_id;
+        std::string token_value;
+        //! Offset of the first character after this token
+        size_t end;
+
+        size_t id() const { return token_id; }
+        const std::string &value() const { return token_value; }
+    };
+
+    //! The tokens of a piece of code
+    struct token_list
+    {
+        typedef boost::shared_ptr<const token_list> sptr;
+
+        std::vector<cached_token> tokens;
+        //! Offset where the lexer stopped, or std::string::npos if all code was tokenized
+        size_t error_pos;
+    };
+
+    //! Function object that stores the tokens found by lex::tokenize()
+    struct token_collector
+    {
+        typedef bool result_type;
+
+        template <typename Token>
+        bool operator()(Token const& t, const char *code, token_list &list) const
+        {
+            cached_token token;
+            token.token_id = t.id();
+            std::stringstream sstr;
+            sstr << t.value();
+            token.token_value = sstr.str();
+            token.end = t.value().end() - code;
+            list.tokens.push_back(token);
+            return true;
+        }
+    };
+
+    /*! Process-wide cache of tokenized code.
+     *
+     * Building the lexer's state machine and running it are the expensive
+     * parts of parsing. Every block that uses the same block definition
+     * runs the same scripts, so all parsers share the lexer and the
+     * tokens of every piece of code they have seen.
+     */
+    struct token_cache
+    {
+        boost::mutex mutex;
+        ns_lexer<lex::lexertl::lexer<> > lexer;
+        boost::unordered_map<std::string, token_list::sptr> lists;
+
+        token_list::sptr get_tokens(const std::string &code)
+        {
+            boost::mutex::scoped_lock lock(mutex);
+            token_list::sptr &cached = lists[code];
+            if (not cached) {
+                boost::shared_ptr<token_list> list = boost::make_shared<token_list>();
+                char const* first = code.c_str();
+                char const* last = &first[code.size()];
+                const bool r = lex::tokenize(
+                    first, last, // Iterators
+                    lexer, // Lexer
+                    boost::bind(token_collector(), _1, code.c_str(), boost::ref(*list)) // Function object
+                );
+                list->error_pos = r ? std::string::npos : size_t(first - code.c_str());
+                cached = list;
+            }
+            return cached;
+        }
+    };
+
+    static token_cache &get_token_cache()
+    {
+        static token_cache cache;
+        return cache;
+    }
+
   private:
     struct grammar_props
     {
@@ -317,21 +401,28 @@ class parser_impl : public parser
         grammar_props P(_ftable, _var_type_getter, _var_value_getter);
         int next_valid_state = grammar::VALID_EXPRESSION;
 
-        // Create a lexer instance
-        ns_lexer<lex::lexertl::lexer<> > lexer_functor;
-
-        // Tokenize the string
-        char const* first = code.c_str();
-        char const* last = &first[code.size()];
-        bool r = lex::tokenize(
-            first, last, // Iterators
-            lexer_functor, // Lexer
-            boost::bind(grammar(), _1, boost::ref(P), boost::ref(next_valid_state)) // Function object
-        );
+        // Tokenize the string, or get the tokens from the last time
+        // this code was parsed
+        token_list::sptr list = get_token_cache().get_tokens(code);
+
+        // Feed the tokens to the grammar until it fails
+        size_t stop_pos = code.size();
+        bool r = true;
+        BOOST_FOREACH(const cached_token &t, list->tokens) {
+            if (not grammar()(t, P, next_valid_state)) {
+                r = false;
+                stop_pos = t.end;
+                break;
+            }
+        }
+        if (r and list->error_pos != std::string::npos) {
+            r = false;
+            stop_pos = list->error_pos;
+        }
 
         // Check the parsing worked:
         if (not r or P.expr_stack.size() != 1) {
-            std::string rest(first, last);
+            std::string rest = code.substr(stop_pos);
             throw uhd::syntax_error(str(
                     boost::format("Parsing stopped at: %s\nError message: %s")
                     % rest % P.error
@@ -16,15 +16,85 @@
 //
 
 #include <uhd/stream.hpp>
+#include <uhd/exception.hpp>
 
 using namespace uhd;
 
+rx_zero_copy_buffs_t::rx_zero_copy_buffs_t(void):
+    nsamps_per_buff(0)
+{
+    //empty
+}
+
+void rx_zero_copy_buffs_t::release(void)
+{
+    buffs.clear();
+    managed_buffs.clear();
+    nsamps_per_buff = 0;
+}
+
+rx_alignment_stats_t::rx_alignment_stats_t(void):
+    num_alignments(0), num_restarts(0), num_dropped_packets(0),
+    num_failures(0), max_offset_ticks(0)
+{
+    //empty
+}
+
 rx_streamer::~rx_streamer(void)
 {
     //empty
 }
 
+size_t rx_streamer::recv_zero_copy(
+    rx_zero_copy_buffs_t &,
+    rx_metadata_t &,
+    const double
+){
+    throw uhd::not_implemented_error("this streamer does not support zero-copy receive");
+}
+
+rx_alignment_stats_t rx_streamer::get_alignment_stats(void) const
+{
+    throw uhd::not_implemented_error("this streamer does not keep alignment statistics");
+}
+
+int rx_streamer::get_fd(void)
+{
+    throw uhd::not_implemented_error("this streamer does not support file descriptors");
+}
+
+tx_zero_copy_buffs_t::tx_zero_copy_buffs_t(void):
+    nsamps_per_buff(0)
+{
+    //empty
+}
+
 tx_streamer::~tx_streamer(void)
 {
     //empty
 }
+
+size_t tx_streamer::get_zero_copy_buffs(
+    tx_zero_copy_buffs_t &,
+    const double
+){
+    throw uhd::not_implemented_error("this streamer does not support zero-copy send");
+}
+
+size_t tx_streamer::send_zero_copy(
+    tx_zero_copy_buffs_t &,
+    const size_t,
+    const tx_metadata_t &
+){
+    throw uhd::not_implemented_error("this streamer does not support zero-copy send");
+}
+
+void tx_streamer::release_zero_copy_buffs(tx_zero_copy_buffs_t &)
+{
+    throw uhd::not_implemented_error("this streamer does not support zero-copy send");
+}
+
+int tx_streamer::get_fd(void)
+{
+    throw uhd::not_implemented_error("this streamer does not support file descriptors");
+}
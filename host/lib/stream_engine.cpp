@@ -0,0 +1,313 @@
+//
+// Copyright 2016 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "transport/readiness_fd.hpp"
+#include <uhd/stream_engine.hpp>
+#include <uhd/convert.hpp>
+#include <uhd/exception.hpp>
+#include <uhd/utils/tasks.hpp>
+#include <uhd/utils/thread_priority.hpp>
+#include <boost/bind.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <deque>
+
+using namespace uhd;
+
+/***********************************************************************
+ * Buffer Pool
+ **********************************************************************/
+class rx_stream_engine_pool
+{
+public:
+    typedef boost::shared_ptr<rx_stream_engine_pool> sptr;
+
+    rx_stream_engine_pool(
+        const size_t num_buffs,
+        const size_t num_chans,
+        const size_t bytes_per_buff
+    ):
+        _mems(num_buffs, std::vector<char>(num_chans*bytes_per_buff)),
+        _buffs(num_buffs)
+    {
+        for (size_t i = 0; i < num_buffs; i++){
+            for (size_t ch = 0; ch < num_chans; ch++){
+                _buffs[i].buffs.push_back(&_mems[i][ch*bytes_per_buff]);
+            }
+            _free.push_back(&_buffs[i]);
+        }
+    }
+
+    /*!
+     * Take a buffer from the pool.
+     * \param sptr the pool itself, which the buffer keeps alive
+     * \param wait wait for a buffer to return when none are left
+     * \param timeout how long to wait in seconds
+     * \return the buffer, or empty when none are left
+     */
+    static rx_stream_engine::buffer_sptr get(sptr pool, const bool wait, const double timeout)
+    {
+        boost::mutex::scoped_lock lock(pool->_mutex);
+        if (wait and pool->_free.empty()){
+            pool->_cond.timed_wait(lock, boost::posix_time::microseconds(long(timeout*1e6)));
+        }
+        if (pool->_free.empty()) return rx_stream_engine::buffer_sptr();
+        rx_stream_engine::buffer_type *buff = pool->_free.back();
+        pool->_free.pop_back();
+        return rx_stream_engine::buffer_sptr(buff, boost::bind(&rx_stream_engine_pool::put, pool, _1));
+    }
+
+private:
+    void put(rx_stream_engine::buffer_type *buff)
+    {
+        boost::mutex::scoped_lock lock(_mutex);
+        _free.push_back(buff);
+        lock.unlock();
+        _cond.notify_one();
+    }
+
+    std::vector<std::vector<char> > _mems;
+    std::vector<rx_stream_engine::buffer_type> _buffs;
+    std::vector<rx_stream_engine::buffer_type *> _free;
+    boost::mutex _mutex;
+    boost::condition_variable _cond;
+};
+
+/***********************************************************************
+ * Engine Implementation
+ **********************************************************************/
+class rx_stream_engine_impl : public rx_stream_engine
+{
+public:
+    rx_stream_engine_impl(
+        rx_streamer::sptr streamer,
+        const std::string &cpu_format,
+        const data_callback_type &data_callback,
+        const event_callback_type &event_callback,
+        const args_type &args
+    ):
+        _streamer(streamer),
+        _data_callback(data_callback),
+        _event_callback(event_callback),
+        _args(args),
+        _nsamps_per_buff(args.nsamps_per_buff),
+        _started(false),
+        _num_recvd_samps(0),
+        _num_dropped_samps(0)
+    {
+        if (_args.num_buffs == 0){
+            throw uhd::value_error("rx_stream_engine needs at least one buffer");
+        }
+        if (_nsamps_per_buff == 0) _nsamps_per_buff = _streamer->get_max_num_samps();
+
+        //the pool, and a buffer to receive into when the pool is empty
+        const size_t bytes_per_buff = _nsamps_per_buff*convert::get_bytes_per_item(cpu_format);
+        const size_t num_chans = _streamer->get_num_channels();
+        _pool = boost::make_shared<rx_stream_engine_pool>(_args.num_buffs, num_chans, bytes_per_buff);
+        _event_pool = boost::make_shared<rx_stream_engine_pool>(_args.num_buffs, 0, 0);
+        _drop_mem.resize(num_chans*bytes_per_buff);
+        for (size_t ch = 0; ch < num_chans; ch++){
+            _drop_buffs.push_back(&_drop_mem[ch*bytes_per_buff]);
+        }
+
+        _task = task::make(boost::bind(&rx_stream_engine_impl::work, this));
+    }
+
+    ~rx_stream_engine_impl(void)
+    {
+        _task.reset(); //stop the thread before the members go away
+    }
+
+    size_t get_num_recvd_samps(void) const
+    {
+        boost::mutex::scoped_lock lock(_stats_mutex);
+        return _num_recvd_samps;
+    }
+
+    size_t get_num_dropped_samps(void) const
+    {
+        boost::mutex::scoped_lock lock(_stats_mutex);
+        return _num_dropped_samps;
+    }
+
+    bool pop_buff(buffer_sptr &buff, const double timeout)
+    {
+        boost::mutex::scoped_lock lock(_queue_mutex);
+        if (_queue.empty() and not _error){
+            _queue_cond.timed_wait(lock, boost::posix_time::microseconds(long(timeout*1e6)));
+        }
+        if (_queue.empty()){
+            if (_error) _error->dynamic_throw();
+            return false;
+        }
+        buff = _queue.front();
+        _queue.pop_front();
+        if (_queue.empty() and _fd and not _error) _fd->clear();
+        return true;
+    }
+
+    int get_fd(void)
+    {
+        boost::mutex::scoped_lock lock(_queue_mutex);
+        if (not _fd){
+            _fd = transport::readiness_fd::make();
+            if (not _queue.empty() or _error) _fd->set();
+        }
+        return _fd->get();
+    }
+
+private:
+    //! Receive once, and keep an exception for pop_buff() before the task stops
+    void work(void)
+    {
+        try{
+            receive();
+        }
+        catch(const uhd::exception &e){
+            set_error(boost::shared_ptr<uhd::exception>(e.dynamic_clone()));
+            throw;
+        }
+        catch(const std::exception &e){
+            set_error(boost::make_shared<uhd::runtime_error>(e.what()));
+            throw;
+        }
+    }
+
+    void receive(void)
+    {
+        if (not _started){
+            _started = true;
+            if (_args.cpu >= 0) set_thread_affinity_safe(size_t(_args.cpu));
+            if (_args.priority != 0.0 or _args.realtime){
+                set_thread_priority_safe(_args.priority, _args.realtime);
+            }
+        }
+
+        //get a buffer from the pool, or fall back to the one for dropped samples
+        const bool wait = (_args.backpressure == BACKPRESSURE_BLOCK);
+        buffer_sptr buff = rx_stream_engine_pool::get(_pool, wait, _args.timeout);
+        if (wait and not buff) return; //check for interruption and try again
+
+        rx_metadata_t metadata;
+        const size_t nsamps = _streamer->recv(
+            buff? buff->buffs : _drop_buffs, _nsamps_per_buff,
+            metadata, _args.timeout, _args.one_packet
+        );
+
+        if (metadata.error_code != rx_metadata_t::ERROR_CODE_NONE){
+            if (_event_callback) _event_callback(metadata);
+            else if (not _data_callback and metadata.error_code != rx_metadata_t::ERROR_CODE_TIMEOUT){
+                //queue the event as a buffer without samples,
+                //it is dropped while the application holds all of them
+                buffer_sptr event = rx_stream_engine_pool::get(_event_pool, false, 0.0);
+                if (event){
+                    event->nsamps_per_buff = 0;
+                    event->metadata = metadata;
+                    push_buff(event);
+                }
+            }
+        }
+        if (nsamps == 0) return;
+
+        {
+            boost::mutex::scoped_lock lock(_stats_mutex);
+            ((buff)? _num_recvd_samps : _num_dropped_samps) += nsamps;
+        }
+        if (not buff) return;
+
+        buff->nsamps_per_buff = nsamps;
+        buff->metadata = metadata;
+        if (_data_callback) _data_callback(buff);
+        else push_buff(buff);
+    }
+
+    void push_buff(buffer_sptr buff)
+    {
+        boost::mutex::scoped_lock lock(_queue_mutex);
+        _queue.push_back(buff);
+        if (_queue.size() == 1 and _fd) _fd->set();
+        lock.unlock();
+        _queue_cond.notify_one();
+    }
+
+    void set_error(boost::shared_ptr<uhd::exception> error)
+    {
+        boost::mutex::scoped_lock lock(_queue_mutex);
+        _error = error;
+        if (_fd) _fd->set();
+        lock.unlock();
+        _queue_cond.notify_all();
+    }
+
+    rx_streamer::sptr _streamer;
+    const data_callback_type _data_callback;
+    const event_callback_type _event_callback;
+    const args_type _args;
+    size_t _nsamps_per_buff;
+    bool _started;
+
+    rx_stream_engine_pool::sptr _pool;
+    rx_stream_engine_pool::sptr _event_pool;
+    std::vector<char> _drop_mem;
+    std::vector<void *> _drop_buffs;
+
+    boost::mutex _queue_mutex;
+    boost::condition_variable _queue_cond;
+    std::deque<buffer_sptr> _queue;
+    boost::shared_ptr<uhd::exception> _error;
+    transport::readiness_fd::sptr _fd;
+
+    mutable boost::mutex _stats_mutex;
+    size_t _num_recvd_samps;
+    size_t _num_dropped_samps;
+
+    task::sptr _task;
+};
+
+/***********************************************************************
+ * Factories
+ **********************************************************************/
+rx_stream_engine::args_type::args_type(void):
+    nsamps_per_buff(0),
+    num_buffs(16),
+    one_packet(true),
+    timeout(0.1),
+    backpressure(BACKPRESSURE_BLOCK),
+    cpu(-1),
+    priority(0.0),
+    realtime(false)
+{
+    /* NOP */
+}
+
+rx_stream_engine::~rx_stream_engine(void){
+    /* NOP */
+}
+
+rx_stream_engine::sptr rx_stream_engine::make(
+    rx_streamer::sptr streamer,
+    const std::string &cpu_format,
+    const data_callback_type &data_callback,
+    const event_callback_type &event_callback,
+    const args_type &args
+){
+    return sptr(new rx_stream_engine_impl(
+        streamer, cpu_format, data_callback, event_callback, args
+    ));
+}
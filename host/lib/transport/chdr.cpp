@@ -15,6 +15,7 @@
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 //
 
+#include "chdr_common.hpp"
 #include <uhd/transport/chdr.hpp>
 #include <uhd/utils/byteswap.hpp>
 #include <uhd/exception.hpp>
@@ -29,10 +30,7 @@
 #endif
 
 using namespace uhd::transport::vrt;
-
-static const uint32_t HDR_FLAG_TSF = (1 << 29);
-static const uint32_t HDR_FLAG_EOB = (1 << 28);
-static const uint32_t HDR_FLAG_ERROR = (1 << 28);
+using namespace uhd::transport::vrt::chdr;
 
 /***************************************************************************/
 /* Packing                                                                 */
@@ -102,81 +100,16 @@ void chdr::if_hdr_pack_le(
 /***************************************************************************/
 /* Unpacking                                                               */
 /***************************************************************************/
-UHD_INLINE void _hdr_unpack_chdr(
-        const uint32_t chdr,
-        if_packet_info_t &if_packet_info
-) {
-    // Set constant members
-    if_packet_info.link_type = if_packet_info_t::LINK_TYPE_CHDR;
-    if_packet_info.has_cid = false;
-    if_packet_info.has_sid = true;
-    if_packet_info.has_tsi = false;
-    if_packet_info.has_tlr = false;
-    if_packet_info.sob = false;
-
-    // Set configurable members
-    if_packet_info.has_tsf = (chdr & HDR_FLAG_TSF) > 0;
-    if_packet_info.packet_type = if_packet_info_t::packet_type_t((chdr >> 30) & 0x3);
-    if_packet_info.eob = (if_packet_info.packet_type == if_packet_info_t::PACKET_TYPE_DATA)
-                         && ((chdr & HDR_FLAG_EOB) > 0);
-    if_packet_info.error = (if_packet_info.packet_type == if_packet_info_t::PACKET_TYPE_RESP)
-                         && ((chdr & HDR_FLAG_ERROR) > 0);
-    if_packet_info.packet_count = (chdr >> 16) & 0xFFF;
-
-    // Set packet length variables
-    if (if_packet_info.has_tsf) {
-        if_packet_info.num_header_words32 = 4;
-    } else {
-        if_packet_info.num_header_words32 = 2;
-    }
-    size_t pkt_size_bytes = (chdr & 0xFFFF);
-    size_t pkt_size_word32 = (pkt_size_bytes / 4) + ((pkt_size_bytes % 4) ? 1 : 0);
-    // Check lengths match:
-    if (pkt_size_word32 < if_packet_info.num_header_words32) {
-        throw uhd::value_error("Bad CHDR or invalid packet length");
-    }
-    if (if_packet_info.num_packet_words32 < pkt_size_word32) {
-        throw uhd::value_error("Bad CHDR or packet fragment");
-    }
-    if_packet_info.num_payload_bytes = pkt_size_bytes - (4 * if_packet_info.num_header_words32);
-    if_packet_info.num_payload_words32 = pkt_size_word32 - if_packet_info.num_header_words32;
-}
-
 void chdr::if_hdr_unpack_be(
         const uint32_t *packet_buff,
         if_packet_info_t &if_packet_info
 ) {
-    // Read header and update if_packet_info
-    uint32_t chdr = BE_MACRO(packet_buff[0]);
-    _hdr_unpack_chdr(chdr, if_packet_info);
-
-    // Read SID
-    if_packet_info.sid = BE_MACRO(packet_buff[1]);
-
-    // Read time (has_tsf was updated earlier)
-    if (if_packet_info.has_tsf) {
-        if_packet_info.tsf = 0
-            | uint64_t(BE_MACRO(packet_buff[2])) << 32
-            | BE_MACRO(packet_buff[3]);
-    }
+    hdr_unpack<true>(packet_buff, if_packet_info);
 }
 
 void chdr::if_hdr_unpack_le(
         const uint32_t *packet_buff,
         if_packet_info_t &if_packet_info
 ) {
-    // Read header and update if_packet_info
-    uint32_t chdr = LE_MACRO(packet_buff[0]);
-    _hdr_unpack_chdr(chdr, if_packet_info);
-
-    // Read SID
-    if_packet_info.sid = LE_MACRO(packet_buff[1]);
-
-    // Read time (has_tsf was updated earlier)
-    if (if_packet_info.has_tsf) {
-        if_packet_info.tsf = 0
-            | uint64_t(LE_MACRO(packet_buff[2])) << 32
-            | LE_MACRO(packet_buff[3]);
-    }
+    hdr_unpack<false>(packet_buff, if_packet_info);
 }
-
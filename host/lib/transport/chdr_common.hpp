@@ -0,0 +1,107 @@
+//
+// Copyright 2014 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef INCLUDED_LIBUHD_TRANSPORT_CHDR_COMMON_HPP
+#define INCLUDED_LIBUHD_TRANSPORT_CHDR_COMMON_HPP
+
+#include <uhd/config.hpp>
+#include <uhd/transport/vrt_if_packet.hpp>
+#include <uhd/utils/byteswap.hpp>
+#include <uhd/exception.hpp>
+
+namespace uhd{ namespace transport{ namespace vrt{ namespace chdr{
+
+    static const uint32_t HDR_FLAG_TSF = (1 << 29);
+    static const uint32_t HDR_FLAG_EOB = (1 << 28);
+    static const uint32_t HDR_FLAG_ERROR = (1 << 28);
+
+    //! Convert a CHDR word in big (true) or little (false) endian to host order
+    template <bool big_endian>
+    UHD_INLINE uint32_t chdr_to_host(const uint32_t word){
+        return (big_endian)? uhd::ntohx(word) : uhd::wtohx(word);
+    }
+
+    /*!
+     * Translate the first CHDR header word into \p if_packet_info.
+     * The word is in host byte order.
+     */
+    UHD_INLINE void hdr_unpack_chdr(
+            const uint32_t chdr,
+            if_packet_info_t &if_packet_info
+    ) {
+        // Set constant members
+        if_packet_info.link_type = if_packet_info_t::LINK_TYPE_CHDR;
+        if_packet_info.has_cid = false;
+        if_packet_info.has_sid = true;
+        if_packet_info.has_tsi = false;
+        if_packet_info.has_tlr = false;
+        if_packet_info.sob = false;
+
+        // Set configurable members
+        if_packet_info.has_tsf = (chdr & HDR_FLAG_TSF) > 0;
+        if_packet_info.packet_type = if_packet_info_t::packet_type_t((chdr >> 30) & 0x3);
+        if_packet_info.eob = (if_packet_info.packet_type == if_packet_info_t::PACKET_TYPE_DATA)
+                             && ((chdr & HDR_FLAG_EOB) > 0);
+        if_packet_info.error = (if_packet_info.packet_type == if_packet_info_t::PACKET_TYPE_RESP)
+                             && ((chdr & HDR_FLAG_ERROR) > 0);
+        if_packet_info.packet_count = (chdr >> 16) & 0xFFF;
+
+        // Set packet length variables
+        if (if_packet_info.has_tsf) {
+            if_packet_info.num_header_words32 = 4;
+        } else {
+            if_packet_info.num_header_words32 = 2;
+        }
+        size_t pkt_size_bytes = (chdr & 0xFFFF);
+        size_t pkt_size_word32 = (pkt_size_bytes / 4) + ((pkt_size_bytes % 4) ? 1 : 0);
+        // Check lengths match:
+        if (pkt_size_word32 < if_packet_info.num_header_words32) {
+            throw uhd::value_error("Bad CHDR or invalid packet length");
+        }
+        if (if_packet_info.num_packet_words32 < pkt_size_word32) {
+            throw uhd::value_error("Bad CHDR or packet fragment");
+        }
+        if_packet_info.num_payload_bytes = pkt_size_bytes - (4 * if_packet_info.num_header_words32);
+        if_packet_info.num_payload_words32 = pkt_size_word32 - if_packet_info.num_header_words32;
+    }
+
+    /*!
+     * Unpack a CHDR header in big (true) or little (false) endian.
+     * Inline version of if_hdr_unpack_be() and if_hdr_unpack_le().
+     */
+    template <bool big_endian>
+    UHD_INLINE void hdr_unpack(
+            const uint32_t *packet_buff,
+            if_packet_info_t &if_packet_info
+    ) {
+        // Read header and update if_packet_info
+        hdr_unpack_chdr(chdr_to_host<big_endian>(packet_buff[0]), if_packet_info);
+
+        // Read SID
+        if_packet_info.sid = chdr_to_host<big_endian>(packet_buff[1]);
+
+        // Read time (has_tsf was updated earlier)
+        if (if_packet_info.has_tsf) {
+            if_packet_info.tsf = 0
+                | uint64_t(chdr_to_host<big_endian>(packet_buff[2])) << 32
+                | chdr_to_host<big_endian>(packet_buff[3]);
+        }
+    }
+
+}}}} //namespace uhd::transport::vrt::chdr
+
+#endif /* INCLUDED_LIBUHD_TRANSPORT_CHDR_COMMON_HPP */
@@ -0,0 +1,193 @@
+//
+// Copyright 2016 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "readiness_fd.hpp"
+#include <uhd/exception.hpp>
+#include <boost/make_shared.hpp>
+#include <algorithm>
+#include <vector>
+
+#if defined(HAVE_EVENTFD)
+    #include <sys/eventfd.h>
+    #include <unistd.h>
+#elif defined(HAVE_PIPE)
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+#if defined(HAVE_EPOLL)
+    #include <sys/epoll.h>
+#endif
+
+using namespace uhd;
+using namespace uhd::transport;
+
+readiness_fd::~readiness_fd(void){
+    /* NOP */
+}
+
+readiness_set::~readiness_set(void){
+    /* NOP */
+}
+
+/***********************************************************************
+ * Readiness File Descriptor:
+ * A descriptor which is readable while it is set
+ **********************************************************************/
+#if defined(HAVE_EVENTFD)
+class readiness_fd_impl : public readiness_fd
+{
+public:
+    readiness_fd_impl(void) : _fd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC))
+    {
+        if (_fd < 0) throw uhd::os_error("error in eventfd");
+    }
+
+    ~readiness_fd_impl(void)
+    {
+        ::close(_fd);
+    }
+
+    int get(void) const
+    {
+        return _fd;
+    }
+
+    void set(void)
+    {
+        const uint64_t one = 1;
+        if (::write(_fd, &one, sizeof(one)) < 0){
+            //the counter is already set
+        }
+    }
+
+    void clear(void)
+    {
+        uint64_t count;
+        if (::read(_fd, &count, sizeof(count)) < 0){
+            //the counter is already clear
+        }
+    }
+
+private:
+    const int _fd;
+};
+
+readiness_fd::sptr readiness_fd::make(void){
+    return boost::make_shared<readiness_fd_impl>();
+}
+#elif defined(HAVE_PIPE)
+class readiness_fd_impl : public readiness_fd
+{
+public:
+    readiness_fd_impl(void)
+    {
+        if (::pipe(_fds) != 0) throw uhd::os_error("error in pipe");
+        for (size_t i = 0; i < 2; i++){
+            ::fcntl(_fds[i], F_SETFL, ::fcntl(_fds[i], F_GETFL) | O_NONBLOCK);
+            ::fcntl(_fds[i], F_SETFD, FD_CLOEXEC);
+        }
+    }
+
+    ~readiness_fd_impl(void)
+    {
+        ::close(_fds[0]);
+        ::close(_fds[1]);
+    }
+
+    int get(void) const
+    {
+        return _fds[0];
+    }
+
+    void set(void)
+    {
+        const char one = 1;
+        if (::write(_fds[1], &one, sizeof(one)) < 0){
+            //the pipe is already readable
+        }
+    }
+
+    void clear(void)
+    {
+        char bytes[16];
+        while (::read(_fds[0], bytes, sizeof(bytes)) > 0){
+            //drain the pipe
+        }
+    }
+
+private:
+    int _fds[2];
+};
+
+readiness_fd::sptr readiness_fd::make(void){
+    return boost::make_shared<readiness_fd_impl>();
+}
+#else
+readiness_fd::sptr readiness_fd::make(void){
+    throw uhd::not_implemented_error("readiness file descriptors not implemented");
+}
+#endif
+
+/***********************************************************************
+ * Readiness Set:
+ * An epoll descriptor which is readable while a member is readable
+ **********************************************************************/
+#if defined(HAVE_EPOLL)
+class readiness_set_impl : public readiness_set
+{
+public:
+    readiness_set_impl(void) : _fd(epoll_create1(EPOLL_CLOEXEC))
+    {
+        if (_fd < 0) throw uhd::os_error("error in epoll_create1");
+    }
+
+    ~readiness_set_impl(void)
+    {
+        ::close(_fd);
+    }
+
+    int get(void) const
+    {
+        return _fd;
+    }
+
+    void add(const int fd)
+    {
+        if (std::find(_members.begin(), _members.end(), fd) != _members.end()) return;
+        epoll_event event = epoll_event();
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        if (epoll_ctl(_fd, EPOLL_CTL_ADD, fd, &event) != 0){
+            throw uhd::os_error("error in epoll_ctl");
+        }
+        _members.push_back(fd);
+    }
+
+private:
+    const int _fd;
+    std::vector<int> _members;
+};
+
+readiness_set::sptr readiness_set::make(void){
+    return boost::make_shared<readiness_set_impl>();
+}
+#else
+readiness_set::sptr readiness_set::make(void){
+    throw uhd::not_implemented_error("readiness sets not implemented");
+}
+#endif
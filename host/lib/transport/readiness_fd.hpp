@@ -0,0 +1,84 @@
+//
+// Copyright 2016 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef INCLUDED_LIBUHD_TRANSPORT_READINESS_FD_HPP
+#define INCLUDED_LIBUHD_TRANSPORT_READINESS_FD_HPP
+
+#include <uhd/config.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/utility.hpp>
+
+namespace uhd{ namespace transport{
+
+/*!
+ * A file descriptor which is readable while it is set,
+ * so that applications can wait for an event with poll(), select() or epoll.
+ * It is an eventfd where available, a non-blocking pipe otherwise.
+ */
+class UHD_API readiness_fd : boost::noncopyable{
+public:
+    typedef boost::shared_ptr<readiness_fd> sptr;
+
+    virtual ~readiness_fd(void) = 0;
+
+    /*!
+     * Make a new readiness descriptor, which is clear.
+     * Throws uhd::not_implemented_error on systems without support.
+     */
+    static sptr make(void);
+
+    //! Get the descriptor to wait on
+    virtual int get(void) const = 0;
+
+    //! Make the descriptor readable, it may be set already
+    virtual void set(void) = 0;
+
+    //! Make the descriptor unreadable, it may be clear already
+    virtual void clear(void) = 0;
+};
+
+/*!
+ * A file descriptor which is readable while any descriptor in a set is,
+ * e.g. the sockets of the transports of all channels of a streamer.
+ * It is an epoll descriptor, which can itself be waited on.
+ */
+class UHD_API readiness_set : boost::noncopyable{
+public:
+    typedef boost::shared_ptr<readiness_set> sptr;
+
+    virtual ~readiness_set(void) = 0;
+
+    /*!
+     * Make a new, empty readiness set.
+     * Throws uhd::not_implemented_error on systems without epoll.
+     */
+    static sptr make(void);
+
+    //! Get the descriptor to wait on
+    virtual int get(void) const = 0;
+
+    /*!
+     * Add a descriptor to the set, the set is readable while it is.
+     * Descriptors which are in the set already are not added again.
+     * \param fd the descriptor, which must stay open while in the set
+     */
+    virtual void add(const int fd) = 0;
+};
+
+}} //namespace
+
+#endif /* INCLUDED_LIBUHD_TRANSPORT_READINESS_FD_HPP */
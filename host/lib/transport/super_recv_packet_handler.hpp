@@ -19,6 +19,8 @@
 #define INCLUDED_LIBUHD_TRANSPORT_SUPER_RECV_PACKET_HANDLER_HPP
 
 #include "../rfnoc/rx_stream_terminator.hpp"
+#include "chdr_common.hpp"
+#include "readiness_fd.hpp"
 #include <uhd/config.hpp>
 #include <uhd/exception.hpp>
 #include <uhd/convert.hpp>
@@ -28,6 +30,7 @@
 #include <uhd/utils/byteswap.hpp>
 #include <uhd/types/metadata.hpp>
 #include <uhd/transport/vrt_if_packet.hpp>
+#include <uhd/transport/chdr.hpp>
 #include <uhd/transport/zero_copy.hpp>
 #include <boost/dynamic_bitset.hpp>
 #include <boost/foreach.hpp>
@@ -35,6 +38,8 @@
 #include <boost/format.hpp>
 #include <boost/bind.hpp>
 #include <boost/make_shared.hpp>
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <vector>
 
@@ -79,8 +84,12 @@ public:
      * \param size the number of transport channels
      */
     recv_packet_handler(const size_t size = 1):
+        _vrt_unpacker(NULL), _hdr_type(HDR_GENERIC),
+        _tick_rate(1.0), _samp_rate(1.0), _ticks_per_samp(1),
         _queue_error_for_next_call(false),
-        _buffers_infos_index(0)
+        _aligning(false),
+        _buffers_infos_index(0),
+        _pending(false)
     {
         #ifdef  ERROR_INJECT_DROPPED_PACKETS
         recvd_packets = 0;
@@ -96,10 +105,13 @@ public:
 
     //! Resize the number of transport channels
     void resize(const size_t size){
-        if (this->size() == size) return;
-        _props.resize(size);
-        //re-initialize all buffers infos by re-creating the vector
-        _buffers_infos = std::vector<buffers_info_type>(4, buffers_info_type(size));
+        if (this->size() != size){
+            _props.resize(size);
+            //re-initialize all buffers infos by re-creating the vector
+            _buffers_infos = std::vector<buffers_info_type>(4, buffers_info_type(size));
+            _ready.reset();
+        }
+        update_recv_path();
     }
 
     //! Get the channel width of this handler
@@ -111,6 +123,11 @@ public:
     void set_vrt_unpacker(const vrt_unpacker_type &vrt_unpacker, const size_t header_offset_words32 = 0){
         _vrt_unpacker = vrt_unpacker;
         _header_offset_words32 = header_offset_words32;
+        //the CHDR unpackers are inlined on the receive paths
+        if (vrt_unpacker == &vrt::chdr::if_hdr_unpack_be) _hdr_type = HDR_CHDR_BE;
+        else if (vrt_unpacker == &vrt::chdr::if_hdr_unpack_le) _hdr_type = HDR_CHDR_LE;
+        else _hdr_type = HDR_GENERIC;
+        update_recv_path();
     }
 
     ////////////////// RFNOC ///////////////////////////
@@ -149,14 +166,22 @@ public:
         _alignment_failure_threshold = threshold*this->size();
     }
 
+    //! Get the statistics of the alignment of the channels
+    const uhd::rx_alignment_stats_t &get_alignment_stats(void) const{
+        return _alignment_stats;
+    }
+
     //! Set the rate of ticks per second
     void set_tick_rate(const double rate){
         _tick_rate = rate;
+        _time_ticks_zero = time_ticks_t::from_tick_rate(0, rate);
+        update_ticks_per_samp();
     }
 
     //! Set the rate of samples per second
     void set_samp_rate(const double rate){
         _samp_rate = rate;
+        update_ticks_per_samp();
     }
 
     /*!
@@ -169,6 +194,23 @@ public:
             while (get_buff(0.0)) {};
         }
         _props.at(xport_chan).get_buff = get_buff;
+        _props.at(xport_chan).xport.reset();
+    }
+
+    /*!
+     * Set the transport to get managed buffers from.
+     * The receive paths call the transport directly,
+     * instead of through a getter function.
+     * \param xport_chan which transport channel
+     * \param xport the transport
+     */
+    void set_xport_chan_recv_xport(const size_t xport_chan, zero_copy_if::sptr xport, const bool flush = false){
+        if (flush){
+            while (xport->get_recv_buff(0.0)) {};
+        }
+        _props.at(xport_chan).get_buff = get_buff_type();
+        _props.at(xport_chan).xport = xport;
+        _ready.reset();
     }
 
     /*!
@@ -178,9 +220,35 @@ public:
     void flush_all(const double timeout = 0.0)
     {
         _flush_all(timeout);
+        update_pending_fd();
         return;
     }
 
+    /*!
+     * Get a descriptor which is readable when samples are available:
+     * it waits on the descriptors of the transports, and on one which is
+     * readable while the handler holds samples or metadata for the next call.
+     * Throws uhd::not_implemented_error when a transport has no descriptor.
+     */
+    int get_fd(void)
+    {
+        if (not _ready){
+            readiness_set::sptr ready = readiness_set::make();
+            for (size_t i = 0; i < _props.size(); i++){
+                const int fd = (_props[i].xport)? _props[i].xport->get_recv_fd() : -1;
+                if (fd < 0){
+                    throw uhd::not_implemented_error("the transports of this streamer have no file descriptors");
+                }
+                ready->add(fd);
+            }
+            if (not _pending_fd) _pending_fd = readiness_fd::make();
+            ready->add(_pending_fd->get());
+            _ready = ready;
+            update_pending_fd();
+        }
+        return _ready->get();
+    }
+
     /*!
      * Set the function to handle flow control
      * \param xport_chan which transport channel
@@ -197,6 +265,7 @@ public:
     //! Set the conversion routine for all channels
     void set_converter(const uhd::convert::id_type &id){
         _num_outputs = id.num_outputs;
+        _otw_format = id.input_format;
         _converter = uhd::convert::get_converter(id)();
         this->set_scale_factor(1/32767.); //update after setting converter
         _bytes_per_otw_item = uhd::convert::get_bytes_per_item(id.input_format);
@@ -238,7 +307,7 @@ public:
     /*******************************************************************
      * Receive:
      * The entry point for the fast-path receive calls.
-     * Dispatch into combinations of single packet receive calls.
+     * Dispatch into the receive path for the channel count.
      ******************************************************************/
     UHD_INLINE size_t recv(
         const uhd::rx_streamer::buffs_type &buffs,
@@ -246,6 +315,102 @@ public:
         uhd::rx_metadata_t &metadata,
         const double timeout,
         const bool one_packet
+    ){
+        const size_t nsamps = (this->*_recv_path)(buffs, nsamps_per_buff, metadata, timeout, one_packet);
+        set_time_spec(metadata);
+        update_pending_fd();
+        return nsamps;
+    }
+
+    /*******************************************************************
+     * Receive zero-copy:
+     * Hand out the aligned buffers (or what recv() left of them)
+     * without conversion, the caller releases them.
+     ******************************************************************/
+    size_t recv_zero_copy(
+        uhd::rx_zero_copy_buffs_t &buffs,
+        uhd::rx_metadata_t &metadata,
+        const double timeout
+    ){
+        buffs.release();
+        if (_num_outputs != 1){
+            throw uhd::not_implemented_error("zero-copy receive into interleaved buffers");
+        }
+
+        //handle metadata queued from a previous receive
+        if (_queue_error_for_next_call){
+            _queue_error_for_next_call = false;
+            metadata = _queue_metadata;
+            set_time_spec(metadata);
+            if (_queue_metadata.error_code != rx_metadata_t::ERROR_CODE_TIMEOUT){
+                update_pending_fd();
+                return 0;
+            }
+        }
+
+        //get the next buffer if the current one has expired
+        if (get_curr_buffer_info().data_bytes_to_copy == 0)
+        {
+            //perform receive with alignment logic
+            (this->*_get_aligned_buffs_path)(timeout);
+        }
+
+        buffers_info_type &info = get_curr_buffer_info();
+        metadata = info.metadata;
+
+        //interpolate the time spec (useful when this is a fragment)
+        if (info.fragment_offset_in_samps != 0){
+            advance_time(metadata, info.fragment_offset_in_samps);
+        }
+        metadata.more_fragments = false;
+        metadata.fragment_offset = info.fragment_offset_in_samps;
+        set_time_spec(metadata);
+
+        const size_t nsamps = info.data_bytes_to_copy/_bytes_per_otw_item;
+        if (nsamps == 0){
+            update_pending_fd();
+            return 0;
+        }
+
+        //move the buffers out of the handler, the copy pointers stay
+        //where recv() left them
+        buffs.buffs.resize(this->size());
+        buffs.managed_buffs.resize(this->size());
+        for (size_t i = 0; i < this->size(); i++){
+            buffs.buffs[i] = info[i].copy_buff;
+            buffs.managed_buffs[i].swap(info[i].buff);
+            info[i].copy_buff = NULL;
+        }
+        buffs.nsamps_per_buff = nsamps;
+        buffs.format = _otw_format;
+
+        info.data_bytes_to_copy = 0;
+        info.fragment_offset_in_samps += nsamps;
+        update_pending_fd();
+        return nsamps;
+    }
+
+private:
+    //! The kinds of headers, the CHDR ones are unpacked inline
+    enum hdr_type{
+        HDR_GENERIC, //calls the vrt unpacker
+        HDR_CHDR_BE,
+        HDR_CHDR_LE
+    };
+
+    /*******************************************************************
+     * Receive path:
+     * The body of recv() for N channels, or for any number when N is 0,
+     * and for the kind of header H.
+     * Dispatch into combinations of single packet receive calls.
+     ******************************************************************/
+    template <size_t N, hdr_type H>
+    size_t recv_path(
+        const uhd::rx_streamer::buffs_type &buffs,
+        const size_t nsamps_per_buff,
+        uhd::rx_metadata_t &metadata,
+        const double timeout,
+        const bool one_packet
     ){
         //handle metadata queued from a previous receive
         if (_queue_error_for_next_call){
@@ -256,7 +421,7 @@ public:
             if (_queue_metadata.error_code != rx_metadata_t::ERROR_CODE_TIMEOUT) return 0;
         }
 
-        size_t accum_num_samps = recv_one_packet(
+        size_t accum_num_samps = recv_one_packet<N, H>(
             buffs, nsamps_per_buff, metadata, timeout
         );
 
@@ -274,7 +439,7 @@ public:
 
         //loop until buffer is filled or error code
         while(accum_num_samps < nsamps_per_buff){
-            size_t num_samps = recv_one_packet(
+            size_t num_samps = recv_one_packet<N, H>(
                 buffs, nsamps_per_buff - accum_num_samps, _queue_metadata,
                 timeout, accum_num_samps*_bytes_per_cpu_item
             );
@@ -298,12 +463,52 @@ public:
         return accum_num_samps;
     }
 
-private:
+    typedef size_t (recv_packet_handler::*recv_path_type)(
+        const uhd::rx_streamer::buffs_type &, const size_t,
+        uhd::rx_metadata_t &, const double, const bool
+    );
+    typedef void (recv_packet_handler::*get_aligned_buffs_path_type)(double);
+
+    //! Choose the receive path for the channel count and the header:
+    //! 1, 2 and 4 channels have specialized paths, others the generic one
+    void update_recv_path(void){
+        switch (this->size()){
+        case 1: set_recv_path<1>(); break;
+        case 2: set_recv_path<2>(); break;
+        case 4: set_recv_path<4>(); break;
+        default: use_recv_path<0, HDR_GENERIC>(); break;
+        }
+    }
+
+    //! Use the receive path for N channels and the kind of header
+    template <size_t N>
+    void set_recv_path(void){
+        switch (_hdr_type){
+        case HDR_CHDR_BE: use_recv_path<N, HDR_CHDR_BE>(); break;
+        case HDR_CHDR_LE: use_recv_path<N, HDR_CHDR_LE>(); break;
+        default: use_recv_path<N, HDR_GENERIC>(); break;
+        }
+    }
+
+    //! Use the receive path for N channels, or the generic one for 0
+    template <size_t N, hdr_type H>
+    void use_recv_path(void){
+        _recv_path = &recv_packet_handler::recv_path<N, H>;
+        _get_aligned_buffs_path = &recv_packet_handler::get_aligned_buffs<N, H>;
+    }
+
+    recv_path_type _recv_path;
+    get_aligned_buffs_path_type _get_aligned_buffs_path;
     vrt_unpacker_type _vrt_unpacker;
+    hdr_type _hdr_type;
     size_t _header_offset_words32;
     double _tick_rate, _samp_rate;
+    time_ticks_t _time_ticks_zero; //zero ticks at the tick rate
+    long long _ticks_per_samp; //0 unless the ratio of the rates is an integer
     bool _queue_error_for_next_call;
     size_t _alignment_failure_threshold;
+    uhd::rx_alignment_stats_t _alignment_stats;
+    bool _aligning;
     rx_metadata_t _queue_metadata;
     struct xport_chan_props_type{
         xport_chan_props_type(void):
@@ -312,6 +517,7 @@ private:
             fc_update_window(0)
         {}
         get_buff_type get_buff;
+        zero_copy_if::sptr xport; //called directly instead of get_buff when set
         issue_stream_cmd_type issue_stream_cmd;
         size_t packet_count;
         handle_overflow_type handle_overflow;
@@ -324,23 +530,27 @@ private:
     };
     std::vector<xport_chan_props_type> _props;
     size_t _num_outputs;
+    std::string _otw_format; //handed out with zero-copy buffers
     size_t _bytes_per_otw_item; //used in conversion
     size_t _bytes_per_cpu_item; //used in conversion
     uhd::convert::converter::sptr _converter; //used in conversion
 
     //! information stored for a received buffer
     struct per_buffer_info_type{
+        per_buffer_info_type(void):
+            vrt_hdr(NULL), time(0), copy_buff(NULL)
+        {/* NOP */}
         void reset()
         {
             buff.reset();
             vrt_hdr = NULL;
-            time = time_spec_t(0.0);
+            time = 0;
             copy_buff = NULL;
         }
         managed_recv_buffer::sptr buff;
         const uint32_t *vrt_hdr;
         vrt::if_packet_info_t ifpi;
-        time_spec_t time;
+        long long time; //in ticks
         const char *copy_buff;
     };
 
@@ -349,6 +559,8 @@ private:
         buffers_info_type(const size_t size):
             std::vector<per_buffer_info_type>(size),
             indexes_todo(size, true),
+            indexes_todo_mask(all_indexes_mask(size)),
+            alignment_time(0),
             alignment_time_valid(false),
             data_bytes_to_copy(0),
             fragment_offset_in_samps(0)
@@ -356,7 +568,8 @@ private:
         void reset()
         {
             indexes_todo.set();
-            alignment_time = time_spec_t(0.0);
+            indexes_todo_mask = all_indexes_mask(size());
+            alignment_time = 0;
             alignment_time_valid = false;
             data_bytes_to_copy = 0;
             fragment_offset_in_samps = 0;
@@ -364,8 +577,55 @@ private:
             for (size_t i = 0; i < size(); i++)
                 at(i).reset();
         }
-        boost::dynamic_bitset<> indexes_todo; //used in alignment logic
-        time_spec_t alignment_time; //used in alignment logic
+        static uint32_t all_indexes_mask(const size_t size)
+        {
+            return (size < 32)? ((uint32_t(1) << size) - 1) : ~uint32_t(0);
+        }
+
+        //! Mark all indexes to do, using the mask on the paths for N channels
+        template <size_t N> void set_all_todo(void)
+        {
+            if (N) indexes_todo_mask = all_indexes_mask(N);
+            else indexes_todo.set();
+        }
+
+        //! Mark an index as done
+        template <size_t N> void reset_todo(const size_t index)
+        {
+            if (N) indexes_todo_mask &= ~(uint32_t(1) << index);
+            else indexes_todo.reset(index);
+        }
+
+        //! Are any indexes left to do?
+        template <size_t N> bool any_todo(void) const
+        {
+            return (N)? indexes_todo_mask != 0 : indexes_todo.any();
+        }
+
+        //! Get the number of indexes left to do
+        template <size_t N> size_t num_todo(void) const
+        {
+            if (N == 0) return indexes_todo.count();
+            size_t num = 0;
+            for (size_t i = 0; i < N; i++){
+                if (indexes_todo_mask & (uint32_t(1) << i)) num++;
+            }
+            return num;
+        }
+
+        //! Get the first index left to do
+        template <size_t N> size_t first_todo(void) const
+        {
+            if (N == 0) return indexes_todo.find_first();
+            for (size_t i = 0; i < N; i++){
+                if (indexes_todo_mask & (uint32_t(1) << i)) return i;
+            }
+            return N;
+        }
+
+        boost::dynamic_bitset<> indexes_todo; //used in alignment logic (generic path)
+        uint32_t indexes_todo_mask; //used in alignment logic (paths for N channels)
+        long long alignment_time; //used in alignment logic, in ticks
         bool alignment_time_valid; //used in alignment logic
         size_t data_bytes_to_copy; //keeps track of state
         size_t fragment_offset_in_samps; //keeps track of state
@@ -395,12 +655,88 @@ private:
 
     uhd::rfnoc::rx_stream_terminator::sptr _terminator;
 
+    //! The descriptors handed out by get_fd(), made when requested
+    readiness_set::sptr _ready;
+    readiness_fd::sptr _pending_fd;
+    bool _pending;
+
+    void update_ticks_per_samp(void)
+    {
+        const double ticks_per_samp = _tick_rate/_samp_rate;
+        _ticks_per_samp = (ticks_per_samp >= 1.0 and ticks_per_samp == double((long long)(ticks_per_samp)))?
+            (long long)(ticks_per_samp) : 0;
+    }
+
+    //! Set the time of the metadata from a count of ticks
+    UHD_INLINE void set_time(rx_metadata_t &metadata, const long long ticks)
+    {
+        metadata.time_ticks = _time_ticks_zero;
+        metadata.time_ticks += ticks;
+        if (_ticks_per_samp == 0) metadata.time_spec = time_spec_t::from_ticks(ticks, _tick_rate);
+    }
+
+    //! Advance the time of the metadata by a number of samples
+    UHD_INLINE void advance_time(rx_metadata_t &metadata, const size_t nsamps)
+    {
+        //exact when a sample is a whole number of ticks,
+        //otherwise the ticks are rounded but the time spec is not
+        if (_ticks_per_samp != 0){
+            metadata.time_ticks += (long long)(nsamps)*_ticks_per_samp;
+        }
+        else{
+            metadata.time_ticks += (long long)(std::floor(nsamps*_tick_rate/_samp_rate + 0.5));
+            metadata.time_spec += time_spec_t::from_ticks(nsamps, _samp_rate);
+        }
+    }
+
+    //! Make the pending descriptor readable while samples or metadata are held
+    UHD_INLINE void update_pending_fd(void)
+    {
+        if (not _pending_fd) return;
+        //a queued timeout is not handed out, the next call receives instead
+        const bool pending = get_curr_buffer_info().data_bytes_to_copy != 0 or (_queue_error_for_next_call
+            and _queue_metadata.error_code != rx_metadata_t::ERROR_CODE_TIMEOUT);
+        if (pending == _pending) return;
+        if (pending) _pending_fd->set();
+        else _pending_fd->clear();
+        _pending = pending;
+    }
+
+    //! Convert the ticks of metadata which is handed out into its time spec
+    UHD_INLINE void set_time_spec(rx_metadata_t &metadata) const
+    {
+        //when a sample is not a whole number of ticks,
+        //set_time() and advance_time() keep the time spec instead
+        if (_ticks_per_samp != 0){
+            metadata.time_spec = time_spec_t::from_ticks(metadata.time_ticks.get_ticks(), _tick_rate);
+        }
+    }
+
+    //! Get a single packet from the transport of a channel
+    UHD_INLINE managed_recv_buffer::sptr get_recv_buff(const size_t index, const double timeout)
+    {
+        const xport_chan_props_type &props = _props[index];
+        return (props.xport)? props.xport->get_recv_buff(timeout) : props.get_buff(timeout);
+    }
+
+    //! Unpack a header, the CHDR headers inline
+    template <hdr_type H>
+    UHD_INLINE void unpack_hdr(const uint32_t *vrt_hdr, vrt::if_packet_info_t &ifpi)
+    {
+        switch (H){
+        case HDR_CHDR_BE: vrt::chdr::hdr_unpack<true>(vrt_hdr, ifpi); break;
+        case HDR_CHDR_LE: vrt::chdr::hdr_unpack<false>(vrt_hdr, ifpi); break;
+        default: _vrt_unpacker(vrt_hdr, ifpi); break;
+        }
+    }
+
     /*******************************************************************
      * Get and process a single packet from the transport:
      * Receive a single packet at the given index.
      * Extract all the relevant info and store.
      * Check the info to determine the return code.
      ******************************************************************/
+    template <hdr_type H>
     UHD_INLINE packet_type get_and_process_single_packet(
         const size_t index,
         per_buffer_info_type &prev_buffer_info,
@@ -409,7 +745,7 @@ private:
     ){
         //get a single packet from the transport layer
         managed_recv_buffer::sptr &buff = curr_buffer_info.buff;
-        buff = _props[index].get_buff(timeout);
+        buff = get_recv_buff(index, timeout);
         if (buff.get() == NULL) return PACKET_TIMEOUT_ERROR;
 
         #ifdef  ERROR_INJECT_DROPPED_PACKETS
@@ -417,7 +753,7 @@ private:
         {
             recvd_packets = 0;
             buff.reset();
-            buff = _props[index].get_buff(timeout);
+            buff = get_recv_buff(index, timeout);
             if (buff.get() == NULL) return PACKET_TIMEOUT_ERROR;
         }
         #endif
@@ -432,8 +768,8 @@ private:
         per_buffer_info_type &info = curr_buffer_info;
         info.ifpi.num_packet_words32 = num_packet_words32 - _header_offset_words32;
         info.vrt_hdr = buff->cast<const uint32_t *>() + _header_offset_words32;
-        _vrt_unpacker(info.vrt_hdr, info.ifpi);
-        info.time = time_spec_t::from_ticks(info.ifpi.tsf, _tick_rate); //assumes has_tsf is true
+        unpack_hdr<H>(info.vrt_hdr, info.ifpi);
+        info.time = (long long)(info.ifpi.tsf); //assumes has_tsf is true
         info.copy_buff = reinterpret_cast<const char *>(info.vrt_hdr + info.ifpi.num_header_words32);
 
         //handle flow control
@@ -497,7 +833,7 @@ private:
                 {
                     // call into get_and_process_single_packet()
                     // to make sure flow control is handled
-                    if (get_and_process_single_packet(
+                    if (get_and_process_single_packet<HDR_GENERIC>(
                             i,
                             prev_buffer_info,
                             curr_buffer_info,
@@ -513,6 +849,7 @@ private:
      * Alignment check:
      * Check the received packet for alignment and mark accordingly.
      ******************************************************************/
+    template <size_t N>
     UHD_INLINE void alignment_check(
         const size_t index, buffers_info_type &info
     ){
@@ -520,22 +857,49 @@ private:
         //  use this index's time as the alignment time
         //  reset the indexes list and remove this index
         if (not info.alignment_time_valid or info[index].time > info.alignment_time){
+            //the channels done so far are behind by the offset:
+            //their packets are dropped, so free them right away
+            if (info.alignment_time_valid){
+                const size_t nchans = (N)? N : this->size();
+                note_misalignment(info[index].time - info.alignment_time, nchans - info.template num_todo<N>());
+                _alignment_stats.num_restarts++;
+                for (size_t i = 0; i < nchans; i++){
+                    if (i != index) info[i].buff.reset();
+                }
+            }
             info.alignment_time_valid = true;
             info.alignment_time = info[index].time;
-            info.indexes_todo.set();
-            info.indexes_todo.reset(index);
+            info.template set_all_todo<N>();
+            info.template reset_todo<N>(index);
             info.data_bytes_to_copy = info[index].ifpi.num_payload_bytes;
         }
 
         //if the sequence id matches:
         //  remove this index from the list and continue
         else if (info[index].time == info.alignment_time){
-            info.indexes_todo.reset(index);
+            info.template reset_todo<N>(index);
         }
 
         //if the sequence id is older:
-        //  continue with the same index to try again
-        //else if (info[index].time < info.alignment_time)...
+        //  continue with the same index to try again,
+        //  it stays the first index to do until it caught up
+        else{
+            note_misalignment(info.alignment_time - info[index].time, 1);
+        }
+    }
+
+    //! Account for packets dropped to align the channels
+    void note_misalignment(const long long offset_ticks, const size_t num_dropped){
+        _aligning = true;
+        _alignment_stats.num_dropped_packets += num_dropped;
+        _alignment_stats.max_offset_ticks = std::max(_alignment_stats.max_offset_ticks, offset_ticks);
+    }
+
+    //! Account for the end of an alignment, when the channels were misaligned
+    void end_alignment(const bool success){
+        if (success) _alignment_stats.num_alignments++;
+        else _alignment_stats.num_failures++;
+        _aligning = false;
     }
 
     /*******************************************************************
@@ -543,7 +907,10 @@ private:
      * Iterate through each index and try to accumulate aligned buffers.
      * Handle all of the edge cases like inline messages and errors.
      * The logic will throw out older packets until it finds a match.
+     * N is the number of channels, or 0 for the generic path,
+     * H is the kind of header.
      ******************************************************************/
+    template <size_t N, hdr_type H>
     UHD_INLINE void get_aligned_buffs(double timeout){
 
         get_prev_buffer_info().reset(); // no longer need the previous info - reset it for future use
@@ -559,15 +926,15 @@ private:
         // - Handle the packet type yielded by the receive.
         // - Check the timestamps for alignment conditions.
         size_t iterations = 0;
-        while (curr_info.indexes_todo.any()){
+        while (curr_info.template any_todo<N>()){
 
             //get the index to process for this iteration
-            const size_t index = curr_info.indexes_todo.find_first();
+            const size_t index = curr_info.template first_todo<N>();
             packet_type packet;
 
             //receive a single packet from the transport
             try{
-                packet = get_and_process_single_packet(
+                packet = get_and_process_single_packet<H>(
                     index, prev_info[index], curr_info[index], timeout
                 );
             }
@@ -584,7 +951,7 @@ private:
 
             switch(packet){
             case PACKET_IF_DATA:
-                alignment_check(index, curr_info);
+                alignment_check<N>(index, curr_info);
                 break;
 
             case PACKET_TIMESTAMP_ERROR:
@@ -595,13 +962,13 @@ private:
                 if (curr_info.alignment_time_valid and curr_info.alignment_time != curr_info[index].time){
                     curr_info.alignment_time_valid = false;
                 }
-                alignment_check(index, curr_info);
+                alignment_check<N>(index, curr_info);
                 break;
 
             case PACKET_INLINE_MESSAGE:
                 std::swap(curr_info, next_info); //save progress from curr -> next
                 curr_info.metadata.has_time_spec = next_info[index].ifpi.has_tsf;
-                curr_info.metadata.time_spec = next_info[index].time;
+                set_time(curr_info.metadata, next_info[index].time);
                 curr_info.metadata.error_code = rx_metadata_t::error_code_t(get_context_code(next_info[index].vrt_hdr, next_info[index].ifpi));
                 if (curr_info.metadata.error_code == rx_metadata_t::ERROR_CODE_OVERFLOW){
                     // Not sending flow control would cause timeouts due to source flow control locking up.
@@ -614,7 +981,7 @@ private:
                     rx_metadata_t metadata = curr_info.metadata;
                     _props[index].handle_overflow();
                     curr_info.metadata = metadata;
-                    UHD_MSG(fastpath) << "O";
+                    uhd::msg::post_fastpath('O');
                 }
                 curr_info[index].buff.reset();
                 curr_info[index].copy_buff = NULL;
@@ -629,14 +996,16 @@ private:
                 return;
 
             case PACKET_SEQUENCE_ERROR:
-                alignment_check(index, curr_info);
+                alignment_check<N>(index, curr_info);
                 std::swap(curr_info, next_info); //save progress from curr -> next
                 curr_info.metadata.has_time_spec = prev_info.metadata.has_time_spec;
-                curr_info.metadata.time_spec = prev_info.metadata.time_spec + time_spec_t::from_ticks(
-                    prev_info[index].ifpi.num_payload_words32*sizeof(uint32_t)/_bytes_per_otw_item, _samp_rate);
+                curr_info.metadata.time_spec = prev_info.metadata.time_spec;
+                curr_info.metadata.time_ticks = prev_info.metadata.time_ticks;
+                advance_time(curr_info.metadata,
+                    prev_info[index].ifpi.num_payload_words32*sizeof(uint32_t)/_bytes_per_otw_item);
                 curr_info.metadata.out_of_sequence = true;
                 curr_info.metadata.error_code = rx_metadata_t::ERROR_CODE_OVERFLOW;
-                UHD_MSG(fastpath) << "D";
+                uhd::msg::post_fastpath('D');
                 return;
 
             }
@@ -650,21 +1019,26 @@ private:
                 ) % iterations << std::endl;
                 std::swap(curr_info, next_info); //save progress from curr -> next
                 curr_info.metadata.error_code = rx_metadata_t::ERROR_CODE_ALIGNMENT;
+                end_alignment(false);
                 _props[index].handle_overflow();
                 return;
             }
 
         }
 
-        //set the metadata from the buffer information at index zero
-        curr_info.metadata.has_time_spec = curr_info[0].ifpi.has_tsf;
-        curr_info.metadata.time_spec = curr_info[0].time;
-        curr_info.metadata.more_fragments = false;
-        curr_info.metadata.fragment_offset = 0;
-        curr_info.metadata.start_of_burst = curr_info[0].ifpi.sob;
-        curr_info.metadata.end_of_burst = curr_info[0].ifpi.eob;
-        curr_info.metadata.error_code = rx_metadata_t::ERROR_CODE_NONE;
+        if (_aligning) end_alignment(true);
+        set_aligned_metadata(curr_info);
+    }
 
+    //! Set the metadata from the buffer information at index zero
+    UHD_INLINE void set_aligned_metadata(buffers_info_type &info){
+        info.metadata.has_time_spec = info[0].ifpi.has_tsf;
+        set_time(info.metadata, info[0].time);
+        info.metadata.more_fragments = false;
+        info.metadata.fragment_offset = 0;
+        info.metadata.start_of_burst = info[0].ifpi.sob;
+        info.metadata.end_of_burst = info[0].ifpi.eob;
+        info.metadata.error_code = rx_metadata_t::ERROR_CODE_NONE;
     }
 
     /*******************************************************************
@@ -673,6 +1047,7 @@ private:
      * When no fragments are available, call the get aligned buffers.
      * Then copy-convert available data into the user's IO buffers.
      ******************************************************************/
+    template <size_t N, hdr_type H>
     UHD_INLINE size_t recv_one_packet(
         const uhd::rx_streamer::buffs_type &buffs,
         const size_t nsamps_per_buff,
@@ -684,14 +1059,16 @@ private:
         if (get_curr_buffer_info().data_bytes_to_copy == 0)
         {
             //perform receive with alignment logic
-            get_aligned_buffs(timeout);
+            get_aligned_buffs<N, H>(timeout);
         }
 
         buffers_info_type &info = get_curr_buffer_info();
         metadata = info.metadata;
 
         //interpolate the time spec (useful when this is a fragment)
-        metadata.time_spec += time_spec_t::from_ticks(info.fragment_offset_in_samps, _samp_rate);
+        if (info.fragment_offset_in_samps != 0){
+            advance_time(metadata, info.fragment_offset_in_samps);
+        }
 
         //extract the number of samples available to copy
         const size_t nsamps_available = info.data_bytes_to_copy/_bytes_per_otw_item;
@@ -706,7 +1083,8 @@ private:
         _convert_bytes_to_copy = bytes_to_copy;
 
         //perform N channels of conversion
-        for (size_t i = 0; i < this->size(); i++) {
+        const size_t nchans = (N)? N : this->size();
+        for (size_t i = 0; i < nchans; i++) {
             convert_to_out_buff(i);
         }
 
@@ -798,6 +1176,7 @@ private:
             bool dbg_print_directly = true
         )
     {
+        set_time_spec(metadata);
         // Initialize a struct with all available data. It can return a formatted string with all infos if wanted.
         dbg_recv_stat_t data(boost::get_system_time().time_of_day().total_microseconds(),
                 nsamps_per_buff,
@@ -846,6 +1225,24 @@ public:
         return recv_packet_handler::recv(buffs, nsamps_per_buff, metadata, timeout, one_packet);
     }
 
+    size_t recv_zero_copy(
+        rx_zero_copy_buffs_t &buffs,
+        uhd::rx_metadata_t &metadata,
+        const double timeout
+    ){
+        return recv_packet_handler::recv_zero_copy(buffs, metadata, timeout);
+    }
+
+    rx_alignment_stats_t get_alignment_stats(void) const
+    {
+        return recv_packet_handler::get_alignment_stats();
+    }
+
+    int get_fd(void)
+    {
+        return recv_packet_handler::get_fd();
+    }
+
     void issue_stream_cmd(const stream_cmd_t &stream_cmd)
     {
         return recv_packet_handler::issue_stream_cmd(stream_cmd);
@@ -19,6 +19,7 @@
 #define INCLUDED_LIBUHD_TRANSPORT_SUPER_SEND_PACKET_HANDLER_HPP
 
 #include "../rfnoc/tx_stream_terminator.hpp"
+#include "readiness_fd.hpp"
 #include <uhd/config.hpp>
 #include <uhd/exception.hpp>
 #include <uhd/convert.hpp>
@@ -28,11 +29,14 @@
 #include <uhd/utils/byteswap.hpp>
 #include <uhd/types/metadata.hpp>
 #include <uhd/transport/vrt_if_packet.hpp>
+#include <uhd/transport/chdr.hpp>
 #include <uhd/transport/zero_copy.hpp>
 #include <boost/thread/thread.hpp>
 #include <boost/thread/thread_time.hpp>
 #include <boost/foreach.hpp>
 #include <boost/function.hpp>
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 #include <vector>
 
@@ -60,6 +64,7 @@ class send_packet_handler{
 public:
     typedef boost::function<managed_send_buffer::sptr(double)> get_buff_type;
     typedef boost::function<bool(uhd::async_metadata_t &, const double)> async_receiver_type;
+    typedef boost::function<int(void)> get_fd_type;
     typedef void(*vrt_packer_type)(uint32_t *, vrt::if_packet_info_t &);
     //typedef boost::function<void(uint32_t *, vrt::if_packet_info_t &)> vrt_packer_type;
 
@@ -68,6 +73,8 @@ public:
      * \param size the number of transport channels
      */
     send_packet_handler(const size_t size = 1):
+        _header_template(HEADER_TEMPLATE_NONE),
+        _tick_rate(1.0), _samp_rate(1.0), _ticks_per_samp(1),
         _next_packet_seq(0), _cached_metadata(false)
     {
         this->set_enable_trailer(true);
@@ -95,12 +102,21 @@ public:
     void set_vrt_packer(const vrt_packer_type &vrt_packer, const size_t header_offset_words32 = 0){
         _vrt_packer = vrt_packer;
         _header_offset_words32 = header_offset_words32;
+
+        //CHDR headers are patched from a template in steady state
+        if (vrt_packer == &vrt::chdr::if_hdr_pack_be) _header_template = HEADER_TEMPLATE_CHDR_BE;
+        else if (vrt_packer == &vrt::chdr::if_hdr_pack_le) _header_template = HEADER_TEMPLATE_CHDR_LE;
+        else _header_template = HEADER_TEMPLATE_NONE;
+        for (size_t i = 0; i < _props.size(); i++){
+            _props[i].header.num_header_words32 = 0;
+        }
     }
 
     //! Set the stream ID for a specific channel (or no SID)
     void set_xport_chan_sid(const size_t xport_chan, const bool has_sid, const uint32_t sid = 0){
         _props.at(xport_chan).has_sid = has_sid;
         _props.at(xport_chan).sid = sid;
+        _props.at(xport_chan).header.num_header_words32 = 0;
     }
 
     ///////// RFNOC ///////////////////
@@ -132,11 +148,13 @@ public:
     //! Set the rate of ticks per second
     void set_tick_rate(const double rate){
         _tick_rate = rate;
+        update_ticks_per_samp();
     }
 
     //! Set the rate of samples per second
     void set_samp_rate(const double rate){
         _samp_rate = rate;
+        update_ticks_per_samp();
     }
 
     /*!
@@ -148,9 +166,21 @@ public:
         _props.at(xport_chan).get_buff = get_buff;
     }
 
+    /*!
+     * Set the function to get a descriptor, which is readable when
+     * the transport may have room for another packet.
+     * \param xport_chan which transport channel
+     * \param get_fd the getter function, called by get_fd()
+     */
+    void set_xport_chan_get_fd(const size_t xport_chan, const get_fd_type &get_fd){
+        _props.at(xport_chan).get_fd = get_fd;
+        _ready.reset();
+    }
+
     //! Set the conversion routine for all channels
     void set_converter(const uhd::convert::id_type &id){
         _num_inputs = id.num_inputs;
+        _otw_format = id.output_format;
         _converter = uhd::convert::get_converter(id)();
         this->set_scale_factor(32767.); //update after setting converter
         _bytes_per_otw_item = uhd::convert::get_bytes_per_item(id.output_format);
@@ -177,15 +207,58 @@ public:
         _async_receiver = async_receiver;
     }
 
+    /*!
+     * Set the descriptor which is readable while async messages are queued.
+     * The device sets it when it queues a message for the async receiver,
+     * recv_async_msg() clears it when the queue may be empty.
+     */
+    void set_async_fd(readiness_fd::sptr async_fd)
+    {
+        _async_fd = async_fd;
+        _ready.reset();
+    }
+
     //! Overload call to get async metadata
     bool recv_async_msg(
         uhd::async_metadata_t &async_metadata, double timeout = 0.1
     ){
-        if (_async_receiver) return _async_receiver(async_metadata, timeout);
+        if (_async_receiver){
+            //clear before the pop, so that a message queued meanwhile sets it again
+            if (_async_fd) _async_fd->clear();
+            if (not _async_receiver(async_metadata, timeout)) return false;
+            if (_async_fd) _async_fd->set(); //more messages may be queued
+            return true;
+        }
         boost::this_thread::sleep(boost::posix_time::microseconds(long(timeout*1e6)));
         return false;
     }
 
+    /*!
+     * Get a descriptor which is readable when a send may make progress
+     * or async messages are queued: it waits on the descriptors of the
+     * transports and on the one for async messages.
+     * Throws uhd::not_implemented_error when one of them is missing.
+     */
+    int get_fd(void)
+    {
+        if (not _ready){
+            if (not _async_fd){
+                throw uhd::not_implemented_error("this streamer has no file descriptor for async messages");
+            }
+            readiness_set::sptr ready = readiness_set::make();
+            for (size_t i = 0; i < _props.size(); i++){
+                const int fd = (_props[i].get_fd)? _props[i].get_fd() : -1;
+                if (fd < 0){
+                    throw uhd::not_implemented_error("the transports of this streamer have no file descriptors");
+                }
+                ready->add(fd);
+            }
+            ready->add(_async_fd->get());
+            _ready = ready;
+        }
+        return _ready->get();
+    }
+
     /*******************************************************************
      * Send:
      * The entry point for the fast-path send calls.
@@ -199,32 +272,7 @@ public:
     ){
         //translate the metadata to vrt if packet info
         vrt::if_packet_info_t if_packet_info;
-        if_packet_info.packet_type = vrt::if_packet_info_t::PACKET_TYPE_DATA;
-        //if_packet_info.has_sid = false; //set per channel
-        if_packet_info.has_cid = false;
-        if_packet_info.has_tlr = _has_tlr;
-        if_packet_info.has_tsi = false;
-        if_packet_info.has_tsf = metadata.has_time_spec;
-        if_packet_info.tsf     = metadata.time_spec.to_ticks(_tick_rate);
-        if_packet_info.sob     = metadata.start_of_burst;
-        if_packet_info.eob     = metadata.end_of_burst;
-
-        /*
-         * Metadata is cached when we get a send requesting a start of burst with no samples.
-         * It is applied here on the next call to send() that actually has samples to send.
-         */
-        if (_cached_metadata && nsamps_per_buff != 0)
-        {
-            // If the new metada has a time_spec, do not use the cached time_spec.
-            if (!metadata.has_time_spec)
-            {
-                if_packet_info.has_tsf = _metadata_cache.has_time_spec;
-                if_packet_info.tsf     = _metadata_cache.time_spec.to_ticks(_tick_rate);
-            }
-            if_packet_info.sob     = _metadata_cache.start_of_burst;
-            if_packet_info.eob     = _metadata_cache.end_of_burst;
-            _cached_metadata = false;
-        }
+        metadata_to_if_packet_info(metadata, nsamps_per_buff, if_packet_info);
 
         if (nsamps_per_buff <= _max_samples_per_packet){
 
@@ -275,8 +323,13 @@ public:
             if (num_samps_sent == 0) return total_num_samps_sent;
 
             //setup metadata for the next fragment
-            const time_spec_t time_spec = metadata.time_spec + time_spec_t::from_ticks(total_num_samps_sent, _samp_rate);
-            if_packet_info.tsf = time_spec.to_ticks(_tick_rate);
+            if (_ticks_per_samp != 0){
+                if_packet_info.tsf += num_samps_sent*_ticks_per_samp;
+            }
+            else{
+                const time_spec_t time_spec = metadata.time_spec + time_spec_t::from_ticks(total_num_samps_sent, _samp_rate);
+                if_packet_info.tsf = time_spec.to_ticks(_tick_rate);
+            }
             if_packet_info.sob = false;
 
         }
@@ -293,20 +346,209 @@ public:
 		return nsamps_sent;
     }
 
+    /*******************************************************************
+     * Zero-copy send:
+     * Hand out transport buffers for the caller to fill in place,
+     * then fill in the headers and commit them as one packet.
+     ******************************************************************/
+    size_t get_zero_copy_buffs(
+        uhd::tx_zero_copy_buffs_t &buffs,
+        const double timeout
+    ){
+        if (_num_inputs != 1){
+            throw uhd::not_implemented_error("zero-copy send from interleaved buffers");
+        }
+
+        //buffers which the caller did not send are taken again below
+        this->release_zero_copy_buffs(buffs);
+
+        //get a buffer for each channel or timeout,
+        //starting with those which were not sent
+        buffs.managed_buffs.resize(this->size());
+        for (size_t i = 0; i < this->size(); i++){
+            managed_send_buffer::sptr &buff = buffs.managed_buffs[i];
+            buff.swap(_props[i].buff);
+            if (not buff) buff = get_chan_buff(_props[i], timeout);
+            if (buff) continue;
+
+            //timeout: keep the buffers for the next call
+            this->release_zero_copy_buffs(buffs);
+            return 0;
+        }
+
+        //the samples go after a header without a timestamp
+        vrt::if_packet_info_t if_packet_info;
+        if_packet_info.has_tsf = false;
+        buffs.buffs.resize(this->size());
+        for (size_t i = 0; i < this->size(); i++){
+            buffs.buffs[i] = buffs.managed_buffs[i]->cast<uint32_t *>() + _header_offset_words32
+                + get_num_header_words32(i, if_packet_info);
+        }
+        buffs.nsamps_per_buff = _max_samples_per_packet;
+        buffs.format = _otw_format;
+        return buffs.nsamps_per_buff;
+    }
+
+    void release_zero_copy_buffs(uhd::tx_zero_copy_buffs_t &buffs){
+        //keep the buffers without committing them,
+        //so that they go out with the next packets of their channels
+        for (size_t i = 0; i < buffs.managed_buffs.size() and i < this->size(); i++){
+            managed_send_buffer::sptr &buff = buffs.managed_buffs[i];
+            if (not buff) continue;
+            xport_chan_props_type &props = _props[i];
+            const bool kept = (buff == props.buff) or std::find(
+                props.unsent_buffs.begin(), props.unsent_buffs.end(), buff
+            ) != props.unsent_buffs.end();
+            if (kept) buff.reset(); //a copy of a set which was given back already
+            else if (not props.buff) props.buff.swap(buff);
+            else{
+                props.unsent_buffs.push_back(buff);
+                buff.reset();
+            }
+        }
+        clear_zero_copy_buffs(buffs);
+    }
+
+    size_t send_zero_copy(
+        uhd::tx_zero_copy_buffs_t &buffs,
+        const size_t nsamps_per_buff,
+        const uhd::tx_metadata_t &metadata
+    ){
+        if (buffs.managed_buffs.size() != this->size() or buffs.buffs.size() != this->size()){
+            throw uhd::value_error("zero-copy send needs a buffer for each channel");
+        }
+        if (nsamps_per_buff > buffs.nsamps_per_buff){
+            throw uhd::value_error("zero-copy send of more samples than the buffers hold");
+        }
+
+        //translate the metadata to vrt if packet info
+        vrt::if_packet_info_t if_packet_info;
+        metadata_to_if_packet_info(metadata, nsamps_per_buff, if_packet_info);
+
+        size_t nsamps_to_send = nsamps_per_buff;
+
+        //TODO remove this code when sample counts of zero are supported by hardware
+        #ifndef SSPH_DONT_PAD_TO_ONE
+            if (nsamps_per_buff == 0)
+            {
+                //like send(): cache a start of burst for the next packet,
+                //the caller keeps the buffers to fill them
+                if (metadata.start_of_burst)
+                {
+                    _metadata_cache = metadata;
+                    _cached_metadata = true;
+                    return 0;
+                }
+
+                //other packets without samples carry a single zero sample
+                for (size_t i = 0; i < this->size(); i++){
+                    std::memset(buffs.buffs[i], 0, _bytes_per_otw_item);
+                }
+                nsamps_to_send = 1;
+            }
+        #endif
+
+        //load the rest of the if_packet_info in here
+        if_packet_info.num_payload_bytes = nsamps_to_send*_bytes_per_otw_item;
+        if_packet_info.num_payload_words32 = (if_packet_info.num_payload_bytes + 3/*round up*/)/sizeof(uint32_t);
+        if_packet_info.packet_count = _next_packet_seq;
+
+        for (size_t i = 0; i < this->size(); i++){
+            managed_send_buffer::sptr &buff = buffs.managed_buffs[i];
+            uint32_t *otw_mem = buff->cast<uint32_t *>() + _header_offset_words32;
+
+            //move the samples when the header is not the one they were placed after
+            const uint32_t *samps = static_cast<const uint32_t *>(buffs.buffs[i]);
+            const size_t num_header_words32 = get_num_header_words32(i, if_packet_info);
+            if (samps != otw_mem + num_header_words32){
+                std::memmove(otw_mem + num_header_words32, samps, if_packet_info.num_payload_bytes);
+            }
+
+            //pack metadata into a vrt header
+            pack_header(i, otw_mem, if_packet_info);
+
+            //commit the samples to the zero-copy interface
+            const size_t num_vita_words32 = _header_offset_words32+if_packet_info.num_packet_words32;
+            buff->commit(num_vita_words32*sizeof(uint32_t));
+            buff.reset(); //effectively a release
+        }
+
+        _next_packet_seq++; //increment sequence after commits
+        clear_zero_copy_buffs(buffs);
+        return nsamps_per_buff;
+    }
+
 private:
 
+    /*!
+     * Translate the metadata of a send into vrt if packet info.
+     * Metadata is cached when a send requests a start of burst with no
+     * samples. It is applied here on the next send with samples to send.
+     */
+    UHD_INLINE void metadata_to_if_packet_info(
+        const uhd::tx_metadata_t &metadata,
+        const size_t nsamps_per_buff,
+        vrt::if_packet_info_t &if_packet_info
+    ){
+        if_packet_info.packet_type = vrt::if_packet_info_t::PACKET_TYPE_DATA;
+        //if_packet_info.has_sid = false; //set per channel
+        if_packet_info.has_cid = false;
+        if_packet_info.has_tlr = _has_tlr;
+        if_packet_info.has_tsi = false;
+        if_packet_info.has_tsf = metadata.has_time_spec;
+        if_packet_info.tsf     = (metadata.has_time_spec)? metadata.time_spec.to_ticks(_tick_rate) : 0;
+        if_packet_info.sob     = metadata.start_of_burst;
+        if_packet_info.eob     = metadata.end_of_burst;
+
+        if (_cached_metadata && nsamps_per_buff != 0)
+        {
+            // If the new metada has a time_spec, do not use the cached time_spec.
+            if (!metadata.has_time_spec)
+            {
+                if_packet_info.has_tsf = _metadata_cache.has_time_spec;
+                if_packet_info.tsf     = (_metadata_cache.has_time_spec)? _metadata_cache.time_spec.to_ticks(_tick_rate) : 0;
+            }
+            if_packet_info.sob     = _metadata_cache.start_of_burst;
+            if_packet_info.eob     = _metadata_cache.end_of_burst;
+            _cached_metadata = false;
+        }
+    }
+
     vrt_packer_type _vrt_packer;
     size_t _header_offset_words32;
+
+    //! the header formats which can be patched from a template
+    enum header_template_type{
+        HEADER_TEMPLATE_NONE,
+        HEADER_TEMPLATE_CHDR_BE,
+        HEADER_TEMPLATE_CHDR_LE
+    } _header_template;
+
+    //! the header of the last packet, without sequence number and time
+    struct header_template_info_type{
+        header_template_info_type(void):num_header_words32(0){}
+        uint32_t words[vrt::chdr::max_if_hdr_words64*2];
+        size_t num_header_words32; //0 when there is no template
+        size_t num_packet_words32;
+        size_t num_payload_bytes;
+        bool has_tsf;
+    };
+
     double _tick_rate, _samp_rate;
+    uint64_t _ticks_per_samp; //0 unless the ratio of the rates is an integer
     struct xport_chan_props_type{
         xport_chan_props_type(void):has_sid(false),sid(0){}
         get_buff_type get_buff;
+        get_fd_type get_fd;
         bool has_sid;
         uint32_t sid;
         managed_send_buffer::sptr buff;
+        std::vector<managed_send_buffer::sptr> unsent_buffs; //given back by zero-copy send
+        header_template_info_type header;
     };
     std::vector<xport_chan_props_type> _props;
     size_t _num_inputs;
+    std::string _otw_format; //handed out with zero-copy buffers
     size_t _bytes_per_otw_item; //used in conversion
     size_t _bytes_per_cpu_item; //used in conversion
     uhd::convert::converter::sptr _converter; //used in conversion
@@ -315,6 +557,8 @@ private:
     size_t _next_packet_seq;
     bool _has_tlr;
     async_receiver_type _async_receiver;
+    readiness_fd::sptr _async_fd;
+    readiness_set::sptr _ready; //made when the descriptor is requested
     bool _cached_metadata;
     uhd::tx_metadata_t _metadata_cache;
 
@@ -365,6 +609,103 @@ private:
 
 #endif
 
+    //! Get a buffer given back by zero-copy send, or a new one
+    UHD_INLINE managed_send_buffer::sptr get_chan_buff(
+        xport_chan_props_type &props, const double timeout
+    ){
+        if (props.unsent_buffs.empty()) return props.get_buff(timeout);
+        managed_send_buffer::sptr buff;
+        buff.swap(props.unsent_buffs.back());
+        props.unsent_buffs.pop_back();
+        return buff;
+    }
+
+    static void clear_zero_copy_buffs(uhd::tx_zero_copy_buffs_t &buffs)
+    {
+        buffs.buffs.clear();
+        buffs.managed_buffs.clear();
+        buffs.nsamps_per_buff = 0;
+    }
+
+    void update_ticks_per_samp(void)
+    {
+        const double ticks_per_samp = _tick_rate/_samp_rate;
+        _ticks_per_samp = (ticks_per_samp >= 1.0 and ticks_per_samp == double(uint64_t(ticks_per_samp)))?
+            uint64_t(ticks_per_samp) : 0;
+    }
+
+    //! Convert a header word to the byte order of the template
+    UHD_INLINE uint32_t to_template_order(const uint32_t word) const
+    {
+        return (_header_template == HEADER_TEMPLATE_CHDR_BE)? uhd::htonx(word) : uhd::htowx(word);
+    }
+
+    /*******************************************************************
+     * Pack a header:
+     * Packets in the middle of a burst with the same length and time
+     * flag as the previous one patch the sequence number and the time
+     * into the template of that header. Others pack the whole header.
+     * Like the packers, set the header and packet lengths in the info.
+     ******************************************************************/
+    UHD_INLINE void pack_header(
+        const size_t index,
+        uint32_t *otw_mem,
+        vrt::if_packet_info_t &if_packet_info
+    ){
+        header_template_info_type &header = _props[index].header;
+        if (
+            header.num_header_words32 != 0 and
+            not if_packet_info.sob and not if_packet_info.eob and
+            header.has_tsf == if_packet_info.has_tsf and
+            header.num_payload_bytes == if_packet_info.num_payload_bytes
+        ){
+            otw_mem[0] = header.words[0] | to_template_order(uint32_t(if_packet_info.packet_count & 0xfff) << 16);
+            otw_mem[1] = header.words[1];
+            if (header.has_tsf){
+                otw_mem[2] = to_template_order(uint32_t(if_packet_info.tsf >> 32));
+                otw_mem[3] = to_template_order(uint32_t(if_packet_info.tsf >> 0));
+            }
+            if_packet_info.num_header_words32 = header.num_header_words32;
+            if_packet_info.num_packet_words32 = header.num_packet_words32;
+            return;
+        }
+
+        vrt::if_packet_info_t hdr_info = if_packet_info;
+        hdr_info.has_sid = _props[index].has_sid;
+        hdr_info.sid = _props[index].sid;
+        _vrt_packer(otw_mem, hdr_info);
+        if_packet_info.num_header_words32 = hdr_info.num_header_words32;
+        if_packet_info.num_packet_words32 = hdr_info.num_packet_words32;
+
+        //keep the header as the template for the packets which follow
+        header.num_header_words32 = 0;
+        if (_header_template != HEADER_TEMPLATE_NONE and not hdr_info.sob and not hdr_info.eob){
+            header.words[0] = otw_mem[0] & ~to_template_order(0xfff << 16);
+            header.words[1] = otw_mem[1];
+            header.num_header_words32 = hdr_info.num_header_words32;
+            header.num_packet_words32 = hdr_info.num_packet_words32;
+            header.num_payload_bytes = hdr_info.num_payload_bytes;
+            header.has_tsf = hdr_info.has_tsf;
+        }
+    }
+
+    //! Get the length of the header a channel's packets would get
+    size_t get_num_header_words32(const size_t index, const vrt::if_packet_info_t &if_packet_info)
+    {
+        vrt::if_packet_info_t hdr_info = if_packet_info;
+        hdr_info.packet_type = vrt::if_packet_info_t::PACKET_TYPE_DATA;
+        hdr_info.has_cid = false;
+        hdr_info.has_tlr = _has_tlr;
+        hdr_info.has_tsi = false;
+        hdr_info.has_sid = _props[index].has_sid;
+        hdr_info.sid = _props[index].sid;
+        hdr_info.num_payload_bytes = 0;
+        hdr_info.num_payload_words32 = 0;
+        uint32_t hdr[vrt::max_if_hdr_words32 + 1/*tlr*/];
+        _vrt_packer(hdr, hdr_info);
+        return hdr_info.num_header_words32;
+    }
+
     /*******************************************************************
      * Send a single packet:
      ******************************************************************/
@@ -383,7 +724,7 @@ private:
 
         //get a buffer for each channel or timeout
         BOOST_FOREACH(xport_chan_props_type &props, _props){
-            if (not props.buff) props.buff = props.get_buff(timeout);
+            if (not props.buff) props.buff = get_chan_buff(props, timeout);
             if (not props.buff) return 0; //timeout
         }
 
@@ -413,7 +754,7 @@ private:
     {
         //shortcut references to local data structures
         managed_send_buffer::sptr &buff = _props[index].buff;
-        vrt::if_packet_info_t if_packet_info = *_convert_if_packet_info;
+        vrt::if_packet_info_t &if_packet_info = *_convert_if_packet_info;
         const tx_streamer::buffs_type &buffs = *_convert_buffs;
 
         //fill IO buffs with pointers into the output buffer
@@ -426,9 +767,7 @@ private:
 
         //pack metadata into a vrt header
         uint32_t *otw_mem = buff->cast<uint32_t *>() + _header_offset_words32;
-        if_packet_info.has_sid = _props[index].has_sid;
-        if_packet_info.sid = _props[index].sid;
-        _vrt_packer(otw_mem, if_packet_info);
+        pack_header(index, otw_mem, if_packet_info);
         otw_mem += if_packet_info.num_header_words32;
 
         //perform the conversion operation
@@ -472,12 +811,35 @@ public:
         return send_packet_handler::send(buffs, nsamps_per_buff, metadata, timeout);
     }
 
+    size_t get_zero_copy_buffs(
+        tx_zero_copy_buffs_t &buffs,
+        const double timeout
+    ){
+        return send_packet_handler::get_zero_copy_buffs(buffs, timeout);
+    }
+
+    size_t send_zero_copy(
+        tx_zero_copy_buffs_t &buffs,
+        const size_t nsamps_per_buff,
+        const uhd::tx_metadata_t &metadata
+    ){
+        return send_packet_handler::send_zero_copy(buffs, nsamps_per_buff, metadata);
+    }
+
+    void release_zero_copy_buffs(tx_zero_copy_buffs_t &buffs){
+        send_packet_handler::release_zero_copy_buffs(buffs);
+    }
+
     bool recv_async_msg(
         uhd::async_metadata_t &async_metadata, double timeout = 0.1
     ){
         return send_packet_handler::recv_async_msg(async_metadata, timeout);
     }
 
+    int get_fd(void){
+        return send_packet_handler::get_fd();
+    }
+
 private:
     size_t _max_num_samps;
 };
@@ -245,6 +245,9 @@ public:
     size_t get_num_send_frames(void) const {return _num_send_frames;}
     size_t get_send_frame_size(void) const {return _send_frame_size;}
 
+    //the datagrams wait in the socket until a receive buffer is requested
+    int get_recv_fd(void) const {return _sock_fd;}
+
 private:
     //memory management -> buffers and fifos
     const size_t _recv_frame_size, _num_recv_frames;
@@ -0,0 +1,108 @@
+//
+// Copyright 2016 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <uhd/types/time_ticks.hpp>
+#include <uhd/exception.hpp>
+#include <boost/math/common_factor_rt.hpp> //gcd
+#include <cmath>
+
+using namespace uhd;
+
+//! The largest denominator of a tick rate made from a double
+static const long long MAX_RATE_DEN = 1 << 20;
+
+/***********************************************************************
+ * Time ticks constructors
+ **********************************************************************/
+time_ticks_t::time_ticks_t(void):
+    _ticks(0), _rate_num(1), _rate_den(1)
+{
+    /* NOP */
+}
+
+time_ticks_t::time_ticks_t(long long ticks, long long rate_num, long long rate_den):
+    _ticks(ticks)
+{
+    if (rate_num <= 0 or rate_den <= 0){
+        throw uhd::value_error("time_ticks_t needs a positive tick rate");
+    }
+    const long long gcd = boost::math::gcd(rate_num, rate_den);
+    _rate_num = rate_num/gcd;
+    _rate_den = rate_den/gcd;
+}
+
+time_ticks_t time_ticks_t::from_tick_rate(long long ticks, double tick_rate){
+    if (not (tick_rate > 0.0)){
+        throw uhd::value_error("time_ticks_t needs a positive tick rate");
+    }
+
+    //expand the rate into a continued fraction until it is exact
+    //in double precision or the denominator gets too large
+    long long num_prev = 1, den_prev = 0;
+    long long num = (long long)(std::floor(tick_rate)), den = 1;
+    double rest = tick_rate - std::floor(tick_rate);
+    while (rest > 0.0 and std::fabs(double(num)/den - tick_rate) > tick_rate*1e-15){
+        rest = 1.0/rest;
+        const long long term = (long long)(std::floor(rest));
+        rest -= term;
+        const long long num_next = term*num + num_prev;
+        const long long den_next = term*den + den_prev;
+        if (den_next > MAX_RATE_DEN) break;
+        num_prev = num; den_prev = den;
+        num = num_next; den = den_next;
+    }
+    return time_ticks_t(ticks, num, den);
+}
+
+/***********************************************************************
+ * Time ticks accessors
+ **********************************************************************/
+double time_ticks_t::get_tick_rate(void) const{
+    return double(_rate_num)/_rate_den;
+}
+
+time_spec_t time_ticks_t::to_time_spec(void) const{
+    //seconds = ticks*den/num, divided first so that it cannot overflow
+    long long full_ticks = _ticks/_rate_num;
+    long long rest_ticks = _ticks%_rate_num;
+    if (rest_ticks < 0){
+        full_ticks -= 1;
+        rest_ticks += _rate_num;
+    }
+    const long long rest = rest_ticks*_rate_den;
+    return time_spec_t(
+        time_t(full_ticks*_rate_den + rest/_rate_num),
+        double(rest%_rate_num)/_rate_num
+    );
+}
+
+/***********************************************************************
+ * Time ticks comparison
+ **********************************************************************/
+bool uhd::operator==(const time_ticks_t &lhs, const time_ticks_t &rhs){
+    if (lhs.get_rate_num() == rhs.get_rate_num() and lhs.get_rate_den() == rhs.get_rate_den()){
+        return lhs.get_ticks() == rhs.get_ticks();
+    }
+    return lhs.to_time_spec() == rhs.to_time_spec();
+}
+
+bool uhd::operator<(const time_ticks_t &lhs, const time_ticks_t &rhs){
+    if (lhs.get_rate_num() == rhs.get_rate_num() and lhs.get_rate_den() == rhs.get_rate_den()){
+        return lhs.get_ticks() < rhs.get_ticks();
+    }
+    return lhs.to_time_spec() < rhs.to_time_spec();
+}
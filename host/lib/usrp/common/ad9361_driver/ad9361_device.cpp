@@ -101,6 +101,39 @@ const double ad9361_device_t::AD9361_RECOMMENDED_MAX_BANDWIDTH = 56e6;
 const double ad9361_device_t::DEFAULT_RX_FREQ = 800e6;
 const double ad9361_device_t::DEFAULT_TX_FREQ = 850e6;
 
+/* Maximum number of master clock rates whose derived clock configuration
+ * is kept. */
+static const size_t AD9361_CLOCK_CONFIG_CACHE_SIZE = 32;
+
+/* Interval between reads of a status register while waiting for a
+ * calibration to complete or a PLL to lock. */
+static const long AD9361_STATUS_POLL_INTERVAL_US = 20;
+
+/* Poll a status register until (reg & mask) == value.
+ *
+ * Returns false if the status was not reached within timeout seconds.
+ * The time spent waiting is recorded under the name of the step, see
+ * get_step_timing(). */
+bool ad9361_device_t::_poll_status(const std::string &step, uint32_t reg, uint8_t mask, uint8_t value, double timeout)
+{
+    const boost::posix_time::ptime start_time = boost::posix_time::microsec_clock::universal_time();
+    const boost::posix_time::ptime exit_time = start_time + boost::posix_time::microseconds(long(timeout * 1e6));
+    boost::posix_time::ptime now;
+    bool done = false;
+    while (true) {
+        done = ((_io_iface->peek8(reg) & mask) == value);
+        now = boost::posix_time::microsec_clock::universal_time();
+        if (done or now > exit_time) break;
+        boost::this_thread::sleep(boost::posix_time::microseconds(AD9361_STATUS_POLL_INTERVAL_US));
+    }
+
+    const double elapsed = (now - start_time).total_microseconds() / 1e6;
+    _step_timing[step] = elapsed;
+    UHD_LOGV(often) << boost::format("[ad9361_device_t] %s %s after %.3f ms")
+            % step % (done ? "completed" : "timed out") % (elapsed * 1e3) << std::endl;
+    return done;
+}
+
 /* Program either the RX or TX FIR filter.
  *
  * The process is the same for both filters, but the function must be told
@@ -187,6 +220,11 @@ void ad9361_device_t::_setup_rx_fir(size_t num_taps, int32_t decimation)
     if (not (decimation == 1 or decimation == 2 or decimation == 4)) {
         throw uhd::runtime_error("[ad9361_device_t] Invalid Rx FIR decimation.");
     }
+    /* The same tap set is still loaded, e.g. after switching back to a rate
+     * with the same decimation and number of taps. */
+    if (_rx_fir_config == std::make_pair(num_taps, decimation)) {
+        return;
+    }
     boost::scoped_array<uint16_t> coeffs(new uint16_t[num_taps]);
     for (size_t i = 0; i < num_taps; i++) {
         switch (num_taps) {
@@ -208,6 +246,7 @@ void ad9361_device_t::_setup_rx_fir(size_t num_taps, int32_t decimation)
     }
 
     _program_fir_filter(RX, CHAIN_BOTH, num_taps, coeffs.get());
+    _rx_fir_config = std::make_pair(num_taps, decimation);
 }
 
 /* Program the TX FIR Filter. */
@@ -219,6 +258,9 @@ void ad9361_device_t::_setup_tx_fir(size_t num_taps, int32_t interpolation)
     if (interpolation == 1 and num_taps > 64) {
         throw uhd::runtime_error("[ad9361_device_t] Too many Tx FIR taps for interpolation value.");
     }
+    if (_tx_fir_config == std::make_pair(num_taps, interpolation)) {
+        return;
+    }
     boost::scoped_array<uint16_t> coeffs(new uint16_t[num_taps]);
     for (size_t i = 0; i < num_taps; i++) {
         switch (num_taps) {
@@ -240,6 +282,7 @@ void ad9361_device_t::_setup_tx_fir(size_t num_taps, int32_t interpolation)
     }
 
     _program_fir_filter(TX, CHAIN_BOTH, num_taps, coeffs.get());
+    _tx_fir_config = std::make_pair(num_taps, interpolation);
 }
 
 /***********************************************************************
@@ -260,14 +303,8 @@ void ad9361_device_t::_calibrate_lock_bbpll()
     _io_iface->poke8(0x04d, 0x05);
 
     /* Wait for BBPLL lock. */
-    size_t count = 0;
-    while (!(_io_iface->peek8(0x05e) & 0x80)) {
-        if (count > 1000) {
-            throw uhd::runtime_error("[ad9361_device_t] BBPLL not locked");
-            break;
-        }
-        count++;
-        boost::this_thread::sleep(boost::posix_time::milliseconds(2));
+    if (not _poll_status("BBPLL lock", 0x05e, 0x80, 0x80, 2.0)) {
+        throw uhd::runtime_error("[ad9361_device_t] BBPLL not locked");
     }
 }
 
@@ -284,28 +321,16 @@ void ad9361_device_t::_calibrate_synth_charge_pumps()
     }
 
     /* Calibrate the RX synthesizer charge pump. */
-    size_t count = 0;
     _io_iface->poke8(0x23d, 0x04);
-    while (!(_io_iface->peek8(0x244) & 0x80)) {
-        if (count > 5) {
-            throw uhd::runtime_error("[ad9361_device_t] RX charge pump cal failure");
-            break;
-        }
-        count++;
-        boost::this_thread::sleep(boost::posix_time::milliseconds(1));
+    if (not _poll_status("RX charge pump cal", 0x244, 0x80, 0x80, 0.006)) {
+        throw uhd::runtime_error("[ad9361_device_t] RX charge pump cal failure");
     }
     _io_iface->poke8(0x23d, 0x00);
 
     /* Calibrate the TX synthesizer charge pump. */
-    count = 0;
     _io_iface->poke8(0x27d, 0x04);
-    while (!(_io_iface->peek8(0x284) & 0x80)) {
-        if (count > 5) {
-            throw uhd::runtime_error("[ad9361_device_t] TX charge pump cal failure");
-            break;
-        }
-        count++;
-        boost::this_thread::sleep(boost::posix_time::milliseconds(1));
+    if (not _poll_status("TX charge pump cal", 0x284, 0x80, 0x80, 0.006)) {
+        throw uhd::runtime_error("[ad9361_device_t] TX charge pump cal failure");
     }
     _io_iface->poke8(0x27d, 0x00);
 }
@@ -358,15 +383,9 @@ double ad9361_device_t::_calibrate_baseband_rx_analog_filter(double req_rfbw)
     _io_iface->poke8(0x1e3, 0x02);
 
     /* Run the calibration! */
-    size_t count = 0;
     _io_iface->poke8(0x016, 0x80);
-    while (_io_iface->peek8(0x016) & 0x80) {
-        if (count > 100) {
-            throw uhd::runtime_error("[ad9361_device_t] RX baseband filter cal FAILURE");
-            break;
-        }
-        count++;
-        boost::this_thread::sleep(boost::posix_time::milliseconds(1));
+    if (not _poll_status("RX baseband filter cal", 0x016, 0x80, 0x00, 0.1)) {
+        throw uhd::runtime_error("[ad9361_device_t] RX baseband filter cal FAILURE");
     }
 
     /* Disable RX1 & RX2 filter tuners. */
@@ -414,16 +433,9 @@ double ad9361_device_t::_calibrate_baseband_tx_analog_filter(double req_rfbw)
     _io_iface->poke8(0x0ca, 0x22);
 
     /* Calibrate! */
-    size_t count = 0;
     _io_iface->poke8(0x016, 0x40);
-    while (_io_iface->peek8(0x016) & 0x40) {
-        if (count > 100) {
-            throw uhd::runtime_error("[ad9361_device_t] TX baseband filter cal FAILURE");
-            break;
-        }
-
-        count++;
-        boost::this_thread::sleep(boost::posix_time::milliseconds(1));
+    if (not _poll_status("TX baseband filter cal", 0x016, 0x40, 0x00, 0.1)) {
+        throw uhd::runtime_error("[ad9361_device_t] TX baseband filter cal FAILURE");
     }
 
     /* Disable the filter tuner. */
@@ -735,15 +747,9 @@ void ad9361_device_t::_calibrate_baseband_dc_offset()
     _io_iface->poke8(0x194, 0x01); // More calibration settings
 
     /* Start that calibration, baby. */
-    size_t count = 0;
     _io_iface->poke8(0x016, 0x01);
-    while (_io_iface->peek8(0x016) & 0x01) {
-        if (count > 100) {
-            throw uhd::runtime_error("[ad9361_device_t] Baseband DC Offset Calibration Failure");
-            break;
-        }
-        count++;
-        boost::this_thread::sleep(boost::posix_time::milliseconds(5));
+    if (not _poll_status("baseband DC offset cal", 0x016, 0x01, 0x00, 0.5)) {
+        throw uhd::runtime_error("[ad9361_device_t] Baseband DC Offset Calibration Failure");
     }
 }
 
@@ -768,15 +774,9 @@ void ad9361_device_t::_calibrate_rf_dc_offset()
     _io_iface->poke8(0x189, 0x30);
 
     /* Run the calibration! */
-    size_t count = 0;
     _io_iface->poke8(0x016, 0x02);
-    while (_io_iface->peek8(0x016) & 0x02) {
-        if (count > 200) {
-            throw uhd::runtime_error("[ad9361_device_t] RF DC Offset Calibration Failure");
-            break;
-        }
-        count++;
-        boost::this_thread::sleep(boost::posix_time::milliseconds(50));
+    if (not _poll_status("RF DC offset cal", 0x016, 0x02, 0x00, 10.0)) {
+        throw uhd::runtime_error("[ad9361_device_t] RF DC Offset Calibration Failure");
     }
 
     _io_iface->poke8(0x18b, 0x8d); // Enable RF DC tracking
@@ -819,15 +819,9 @@ void ad9361_device_t::_calibrate_rx_quadrature()
     double current_tx_freq = _tx_freq;
     _tune_helper(TX, _rx_freq + _rx_bb_lp_bw / 2.0);
 
-    size_t count = 0;
     _io_iface->poke8(0x016, 0x20);
-    while (_io_iface->peek8(0x016) & 0x20) {
-        if (count > 1000) {
-            throw uhd::runtime_error("[ad9361_device_t] Rx Quadrature Calibration Failure");
-            break;
-        }
-        count++;
-        boost::this_thread::sleep(boost::posix_time::milliseconds(5));
+    if (not _poll_status("RX quadrature cal", 0x016, 0x20, 0x00, 5.0)) {
+        throw uhd::runtime_error("[ad9361_device_t] Rx Quadrature Calibration Failure");
     }
 
     _io_iface->poke8(0x057, 0x30); // Re-enable Tx mixers
@@ -887,15 +881,9 @@ void ad9361_device_t::_tx_quadrature_cal_routine() {
     _io_iface->poke8(0x0ae, 0x00); // Cal LPF gain index (split mode)
 
     /* Now, calibrate the TX quadrature! */
-    size_t count = 0;
     _io_iface->poke8(0x016, 0x10);
-    while (_io_iface->peek8(0x016) & 0x10) {
-        if (count > 100) {
-            throw uhd::runtime_error("[ad9361_device_t] TX Quadrature Calibration Failure");
-            break;
-        }
-        count++;
-        boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+    if (not _poll_status("TX quadrature cal", 0x016, 0x10, 0x00, 1.0)) {
+        throw uhd::runtime_error("[ad9361_device_t] TX Quadrature Calibration Failure");
     }
 }
 
@@ -1162,21 +1150,14 @@ void ad9361_device_t::_setup_synth(direction_t direction, double vcorate)
 }
 
 
-/* Tune the baseband VCO.
+/* Derive the baseband VCO settings for an ADC clock rate.
  *
- * This clock signal is what gets fed to the ADCs and DACs. This function is
- * not exported outside of this file, and is invoked based on the rate
- * fed to the public set_clock_rate function. */
-double ad9361_device_t::_tune_bbvco(const double rate)
+ * This clock signal is what gets fed to the ADCs and DACs. The result is
+ * programmed by _tune_bbvco(), and is stored with the clock configuration
+ * of the master clock rate it was derived for. */
+ad9361_device_t::bbpll_config_t ad9361_device_t::_derive_bbpll_config(const double rate)
 {
-    UHD_LOG << boost::format("[ad9361_device_t::_tune_bbvco] rate=%.10f\n") % rate;
-
-    /* Let's not re-tune to the same frequency over and over... */
-    if (freq_is_nearly_equal(rate, _req_coreclk)) {
-        return _adcclock_freq;
-    }
-
-    _req_coreclk = rate;
+    UHD_LOG << boost::format("[ad9361_device_t::_derive_bbpll_config] rate=%.10f\n") % rate;
 
     const double fref = 40e6;
     const int modulus = 2088960;
@@ -1195,15 +1176,15 @@ double ad9361_device_t::_tune_bbvco(const double rate)
             break;
     }
     if (i == 7)
-        throw uhd::runtime_error("[ad9361_device_t] _tune_bbvco: wrong vcorate");
+        throw uhd::runtime_error("[ad9361_device_t] _derive_bbpll_config: wrong vcorate");
 
-    UHD_LOG << boost::format("[ad9361_device_t::_tune_bbvco] vcodiv=%d vcorate=%.10f\n") % vcodiv % vcorate;
+    UHD_LOG << boost::format("[ad9361_device_t::_derive_bbpll_config] vcodiv=%d vcorate=%.10f\n") % vcodiv % vcorate;
     /* Fo = Fref * (Nint + Nfrac / mod) */
     int nint = static_cast<int>(vcorate / fref);
-    UHD_LOG << boost::format("[ad9361_device_t::_tune_bbvco] (nint)=%.10f\n") % (vcorate / fref);
+    UHD_LOG << boost::format("[ad9361_device_t::_derive_bbpll_config] (nint)=%.10f\n") % (vcorate / fref);
     int nfrac = static_cast<int>(boost::math::round(((vcorate / fref) - (double) nint) * (double) modulus));
-    UHD_LOG << boost::format("[ad9361_device_t::_tune_bbvco] (nfrac)=%.10f\n") % (((vcorate / fref) - (double) nint) * (double) modulus);
-    UHD_LOG << boost::format("[ad9361_device_t::_tune_bbvco] nint=%d nfrac=%d\n") % nint % nfrac;
+    UHD_LOG << boost::format("[ad9361_device_t::_derive_bbpll_config] (nfrac)=%.10f\n") % (((vcorate / fref) - (double) nint) * (double) modulus);
+    UHD_LOG << boost::format("[ad9361_device_t::_derive_bbpll_config] nint=%d nfrac=%d\n") % nint % nfrac;
     double actual_vcorate = fref
             * ((double) nint + ((double) nfrac / (double) modulus));
 
@@ -1211,28 +1192,48 @@ double ad9361_device_t::_tune_bbvco(const double rate)
     const double icp_baseline = 150e-6;
     const double freq_baseline = 1280e6;
     double icp = icp_baseline * (actual_vcorate / freq_baseline);
-    int icp_reg = static_cast<int>(icp / 25e-6) - 1;
 
-    _io_iface->poke8(0x045, 0x00);            // REFCLK / 1 to BBPLL
-    _io_iface->poke8(0x046, icp_reg & 0x3F);  // CP current
-    _io_iface->poke8(0x048, 0xe8);            // BBPLL loop filters
-    _io_iface->poke8(0x049, 0x5b);            // BBPLL loop filters
-    _io_iface->poke8(0x04a, 0x35);            // BBPLL loop filters
+    bbpll_config_t config;
+    config.coreclk = rate;
+    config.vcodiv_sel = i;
+    config.nint = nint;
+    config.nfrac = nfrac;
+    config.icp_reg = static_cast<int>(icp / 25e-6) - 1;
+    config.bbpll_freq = actual_vcorate;
+    config.adcclock_freq = (actual_vcorate / vcodiv);
+    return config;
+}
+
+/* Program and lock the BBPLL with previously derived settings. */
+double ad9361_device_t::_tune_bbvco(const bbpll_config_t &config)
+{
+    /* Let's not re-tune to the same frequency over and over... */
+    if (freq_is_nearly_equal(config.coreclk, _req_coreclk)) {
+        return _adcclock_freq;
+    }
+
+    _req_coreclk = config.coreclk;
+
+    _io_iface->poke8(0x045, 0x00);                   // REFCLK / 1 to BBPLL
+    _io_iface->poke8(0x046, config.icp_reg & 0x3F);  // CP current
+    _io_iface->poke8(0x048, 0xe8);                   // BBPLL loop filters
+    _io_iface->poke8(0x049, 0x5b);                   // BBPLL loop filters
+    _io_iface->poke8(0x04a, 0x35);                   // BBPLL loop filters
 
     _io_iface->poke8(0x04b, 0xe0);
-    _io_iface->poke8(0x04e, 0x10);            // Max accuracy
+    _io_iface->poke8(0x04e, 0x10);                   // Max accuracy
 
-    _io_iface->poke8(0x043, nfrac & 0xFF);         // Nfrac[7:0]
-    _io_iface->poke8(0x042, (nfrac >> 8) & 0xFF);  // Nfrac[15:8]
-    _io_iface->poke8(0x041, (nfrac >> 16) & 0xFF); // Nfrac[23:16]
-    _io_iface->poke8(0x044, nint);                 // Nint
+    _io_iface->poke8(0x043, config.nfrac & 0xFF);         // Nfrac[7:0]
+    _io_iface->poke8(0x042, (config.nfrac >> 8) & 0xFF);  // Nfrac[15:8]
+    _io_iface->poke8(0x041, (config.nfrac >> 16) & 0xFF); // Nfrac[23:16]
+    _io_iface->poke8(0x044, config.nint);                 // Nint
 
     _calibrate_lock_bbpll();
 
-    _regs.bbpll = (_regs.bbpll & 0xF8) | i;
+    _regs.bbpll = (_regs.bbpll & 0xF8) | config.vcodiv_sel;
 
-    _bbpll_freq = actual_vcorate;
-    _adcclock_freq = (actual_vcorate / vcodiv);
+    _bbpll_freq = config.bbpll_freq;
+    _adcclock_freq = config.adcclock_freq;
 
     return _adcclock_freq;
 }
@@ -1318,8 +1319,7 @@ double ad9361_device_t::_tune_helper(direction_t direction, const double value)
         _io_iface->poke8(0x005, _regs.vcodivs);
 
         /* Lock the PLL! */
-        boost::this_thread::sleep(boost::posix_time::milliseconds(2));
-        if ((_io_iface->peek8(0x247) & 0x02) == 0) {
+        if (not _poll_status("RX PLL lock", 0x247, 0x02, 0x02, 0.002)) {
             throw uhd::runtime_error("[ad9361_device_t] RX PLL NOT LOCKED");
         }
 
@@ -1359,8 +1359,7 @@ double ad9361_device_t::_tune_helper(direction_t direction, const double value)
         _io_iface->poke8(0x005, _regs.vcodivs);
 
         /* Lock the PLL! */
-        boost::this_thread::sleep(boost::posix_time::milliseconds(2));
-        if ((_io_iface->peek8(0x287) & 0x02) == 0) {
+        if (not _poll_status("TX PLL lock", 0x287, 0x02, 0x02, 0.002)) {
             throw uhd::runtime_error("[ad9361_device_t] TX PLL NOT LOCKED");
         }
 
@@ -1370,127 +1369,111 @@ double ad9361_device_t::_tune_helper(direction_t direction, const double value)
     }
 }
 
-/* Configure the various clock / sample rates in the RX and TX chains.
+/* Derive the clock configuration for a master clock rate.
  *
- * Functionally, this function configures AD9361's RX and TX rates. For
- * a requested TX & RX rate, it sets the interpolation & decimation filters,
- * and tunes the VCO that feeds the ADCs and DACs.
+ * For a requested TX & RX rate, this selects the interpolation & decimation
+ * filters, the BBPLL settings for the VCO that feeds the ADCs and DACs, and
+ * the FIR tap sets. Nothing is written to the chip here, so the result can
+ * be cached and re-applied when switching back to the same rate.
  */
-double ad9361_device_t::_setup_rates(const double rate)
+ad9361_device_t::clock_config_t ad9361_device_t::_derive_clock_config(const double rate)
 {
-    /* If we make it into this function, then we are tuning to a new rate.
-     * Store the new rate. */
-    _req_clock_rate = rate;
-    UHD_LOG << boost::format("[ad9361_device_t::_setup_rates] rate=%.6d\n") % rate;
-
-    /* Set the decimation and interpolation values in the RX and TX chains.
-     * This also switches filters in / out. Note that all transmitters and
-     * receivers have to be turned on for the calibration portion of
-     * bring-up, and then they will be switched out to reflect the actual
-     * user-requested antenna selections. */
+    /* Select the decimation and interpolation values in the RX and TX
+     * chains, with all chains enabled for calibration. */
+    clock_config_t config;
     int divfactor = 0;
-    _tfir_factor = 0;
-    _rfir_factor = 0;
+    int32_t tfir_factor = 0;
+    int32_t rfir_factor = 0;
 
     if (rate < 0.33e6) {
         // RX1 + RX2 enabled, 3, 2, 2, 4
-        _regs.rxfilt = B8(11101111);
+        config.rxfilt = B8(11101111);
 
         // TX1 + TX2 enabled, 3, 2, 2, 4
-        _regs.txfilt = B8(11101111);
+        config.txfilt = B8(11101111);
 
         divfactor = 48;
-        _tfir_factor = 4;
-        _rfir_factor = 4;
+        tfir_factor = 4;
+        rfir_factor = 4;
     } else if (rate < 0.66e6) {
         // RX1 + RX2 enabled, 2, 2, 2, 4
-        _regs.rxfilt = B8(11011111);
+        config.rxfilt = B8(11011111);
 
         // TX1 + TX2 enabled, 2, 2, 2, 4
-        _regs.txfilt = B8(11011111);
+        config.txfilt = B8(11011111);
 
         divfactor = 32;
-        _tfir_factor = 4;
-        _rfir_factor = 4;
+        tfir_factor = 4;
+        rfir_factor = 4;
     } else if (rate <= 20e6) {
         // RX1 + RX2 enabled, 2, 2, 2, 2
-        _regs.rxfilt = B8(11011110);
+        config.rxfilt = B8(11011110);
 
         // TX1 + TX2 enabled, 2, 2, 2, 2
-        _regs.txfilt = B8(11011110);
+        config.txfilt = B8(11011110);
 
         divfactor = 16;
-        _tfir_factor = 2;
-        _rfir_factor = 2;
+        tfir_factor = 2;
+        rfir_factor = 2;
     } else if ((rate > 20e6) && (rate < 23e6)) {
         // RX1 + RX2 enabled, 3, 2, 2, 2
-        _regs.rxfilt = B8(11101110);
+        config.rxfilt = B8(11101110);
 
         // TX1 + TX2 enabled, 3, 1, 2, 2
-        _regs.txfilt = B8(11100110);
+        config.txfilt = B8(11100110);
 
         divfactor = 24;
-        _tfir_factor = 2;
-        _rfir_factor = 2;
+        tfir_factor = 2;
+        rfir_factor = 2;
     } else if ((rate >= 23e6) && (rate < 41e6)) {
         // RX1 + RX2 enabled, 2, 2, 2, 2
-        _regs.rxfilt = B8(11011110);
+        config.rxfilt = B8(11011110);
 
         // TX1 + TX2 enabled, 1, 2, 2, 2
-        _regs.txfilt = B8(11001110);
+        config.txfilt = B8(11001110);
 
         divfactor = 16;
-        _tfir_factor = 2;
-        _rfir_factor = 2;
+        tfir_factor = 2;
+        rfir_factor = 2;
     } else if ((rate >= 41e6) && (rate <= 58e6)) {
         // RX1 + RX2 enabled, 3, 1, 2, 2
-        _regs.rxfilt = B8(11100110);
+        config.rxfilt = B8(11100110);
 
         // TX1 + TX2 enabled, 3, 1, 1, 2
-        _regs.txfilt = B8(11100010);
+        config.txfilt = B8(11100010);
 
         divfactor = 12;
-        _tfir_factor = 2;
-        _rfir_factor = 2;
+        tfir_factor = 2;
+        rfir_factor = 2;
     } else if ((rate > 58e6) && (rate <= 61.44e6)) {
         // RX1 + RX2 enabled, 2, 1, 2, 2
-        _regs.rxfilt = B8(11010110);
+        config.rxfilt = B8(11010110);
 
         // TX1 + TX2 enabled, 2, 1, 1, 2
-        _regs.txfilt = B8(11010010);
+        config.txfilt = B8(11010010);
 
         divfactor = 8;
-        _tfir_factor = 2;
-        _rfir_factor = 2;
+        tfir_factor = 2;
+        rfir_factor = 2;
     } else {
         // should never get in here
-        throw uhd::runtime_error("[ad9361_device_t] [_setup_rates] INVALID_CODE_PATH");
+        throw uhd::runtime_error("[ad9361_device_t] [_derive_clock_config] INVALID_CODE_PATH");
     }
 
-    UHD_LOG << boost::format("[ad9361_device_t::_setup_rates] divfactor=%d\n") % divfactor;
+    UHD_LOG << boost::format("[ad9361_device_t::_derive_clock_config] divfactor=%d\n") % divfactor;
 
-    /* Tune the BBPLL to get the ADC and DAC clocks. */
-    const double adcclk = _tune_bbvco(rate * divfactor);
-    double dacclk = adcclk;
+    config.divfactor = divfactor;
+    config.tfir_factor = tfir_factor;
+    config.rfir_factor = rfir_factor;
+
+    /* Derive the BBPLL settings for the ADC and DAC clocks. */
+    config.bbpll = _derive_bbpll_config(rate * divfactor);
+    const double adcclk = config.bbpll.adcclock_freq;
 
     /* The DAC clock must be <= 336e6, and is either the ADC clock or 1/2 the
      * ADC clock.*/
-    if (adcclk > 336e6) {
-        /* Make the DAC clock = ADC/2 */
-        _regs.bbpll = _regs.bbpll | 0x08;
-        dacclk = adcclk / 2.0;
-    } else {
-        _regs.bbpll = _regs.bbpll & 0xF7;
-    }
-
-    /* Set the dividers / interpolators in AD9361. */
-    _io_iface->poke8(0x002, _regs.txfilt);
-    _io_iface->poke8(0x003, _regs.rxfilt);
-    _io_iface->poke8(0x004, _regs.inputsel);
-    _io_iface->poke8(0x00A, _regs.bbpll);
-
-    UHD_LOG << boost::format("[ad9361_device_t::_setup_rates] adcclk=%f\n") % adcclk;
-    _baseband_bw = (adcclk / divfactor);
+    config.dac_clk_div2 = (adcclk > 336e6);
+    const double dacclk = config.dac_clk_div2 ? (adcclk / 2.0) : adcclk;
 
     /*
      The Tx & Rx FIR calculate 16 taps per clock cycle. This limits the number of available taps to the ratio of DAC_CLK/ADC_CLK
@@ -1502,15 +1485,74 @@ double ad9361_device_t::_setup_rates(const double rate)
      */
     const size_t max_tx_taps = std::min<size_t>(
             std::min<size_t>((16 * (int)((dacclk / rate) + 0.5)), 128),
-            (_tfir_factor == 1) ? 64 : 128);
+            (tfir_factor == 1) ? 64 : 128);
     const size_t max_rx_taps = std::min<size_t>((16 * (size_t)((adcclk / rate) + 0.5)),
             128);
 
-    const size_t num_tx_taps = get_num_taps(max_tx_taps);
-    const size_t num_rx_taps = get_num_taps(max_rx_taps);
+    config.num_tx_taps = get_num_taps(max_tx_taps);
+    config.num_rx_taps = get_num_taps(max_rx_taps);
+
+    return config;
+}
+
+/* Configure the various clock / sample rates in the RX and TX chains.
+ *
+ * Functionally, this function configures AD9361's RX and TX rates. For
+ * a requested TX & RX rate, it sets the interpolation & decimation filters,
+ * and tunes the VCO that feeds the ADCs and DACs.
+ */
+double ad9361_device_t::_setup_rates(const double rate)
+{
+    /* If we make it into this function, then we are tuning to a new rate.
+     * Store the new rate. */
+    _req_clock_rate = rate;
+    UHD_LOG << boost::format("[ad9361_device_t::_setup_rates] rate=%.6d\n") % rate;
+
+    /* Applications tend to switch among a handful of rates, so the derived
+     * configuration is kept for every rate that has been requested. */
+    clock_config_cache_t::const_iterator cached = _clock_config_cache.find(rate);
+    if (cached == _clock_config_cache.end()) {
+        if (_clock_config_cache.size() >= AD9361_CLOCK_CONFIG_CACHE_SIZE) {
+            _clock_config_cache.clear();
+        }
+        cached = _clock_config_cache.insert(
+                clock_config_cache_t::value_type(rate, _derive_clock_config(rate))).first;
+    } else {
+        UHD_LOG << "[ad9361_device_t::_setup_rates] using cached clock configuration\n";
+    }
+    const clock_config_t &config = cached->second;
 
-    _setup_tx_fir(num_tx_taps,_tfir_factor);
-    _setup_rx_fir(num_rx_taps,_rfir_factor);
+    /* Set the decimation and interpolation values in the RX and TX chains.
+     * This also switches filters in / out. Note that all transmitters and
+     * receivers have to be turned on for the calibration portion of
+     * bring-up, and then they will be switched out to reflect the actual
+     * user-requested antenna selections. */
+    _regs.rxfilt = config.rxfilt;
+    _regs.txfilt = config.txfilt;
+    _tfir_factor = config.tfir_factor;
+    _rfir_factor = config.rfir_factor;
+
+    /* Tune the BBPLL to get the ADC and DAC clocks. */
+    const double adcclk = _tune_bbvco(config.bbpll);
+
+    if (config.dac_clk_div2) {
+        /* Make the DAC clock = ADC/2 */
+        _regs.bbpll = _regs.bbpll | 0x08;
+    } else {
+        _regs.bbpll = _regs.bbpll & 0xF7;
+    }
+
+    /* Set the dividers / interpolators in AD9361. */
+    _io_iface->poke8(0x002, _regs.txfilt);
+    _io_iface->poke8(0x003, _regs.rxfilt);
+    _io_iface->poke8(0x004, _regs.inputsel);
+    _io_iface->poke8(0x00A, _regs.bbpll);
+
+    UHD_LOG << boost::format("[ad9361_device_t::_setup_rates] adcclk=%f\n") % adcclk;
+    _baseband_bw = (adcclk / config.divfactor);
+
+    _setup_tx_fir(config.num_tx_taps, _tfir_factor);
+    _setup_rx_fir(config.num_rx_taps, _rfir_factor);
 
     return _baseband_bw;
 }
@@ -1559,6 +1601,11 @@ void ad9361_device_t::initialize()
     _tx_sec_lp_bw = 0;
     _rx_bb_lp_bw = 0;
     _tx_bb_lp_bw = 0;
+    /* The reset below clears the FIR tap sets and filter calibrations. */
+    _rx_fir_config = std::make_pair(0, 0);
+    _tx_fir_config = std::make_pair(0, 0);
+    _rx_bw_cal = bw_filter_cal_t();
+    _tx_bw_cal = bw_filter_cal_t();
 
     /* Reset the device. */
     _io_iface->poke8(0x000, 0x01);
@@ -1706,7 +1753,7 @@ void ad9361_device_t::initialize()
     _io_iface->poke8(0x015, 0x04); // dual synth mode, synth en ctrl en
     _io_iface->poke8(0x014, 0x05); // use SPI for TXNRX ctrl, to ALERT, TX on
     _io_iface->poke8(0x013, 0x01); // enable ENSM
-    boost::this_thread::sleep(boost::posix_time::milliseconds(1));
+    _poll_status("ENSM to ALERT", 0x017, 0x0F, 0x05, 0.001); // state is checked by the charge pump cal
 
     _calibrate_synth_charge_pumps();
 
@@ -1816,7 +1863,7 @@ double ad9361_device_t::set_clock_rate(const double req_rate)
     case 0x05:
         /* We are in the ALERT state. */
         _io_iface->poke8(0x014, 0x21);
-        boost::this_thread::sleep(boost::posix_time::milliseconds(5));
+        _poll_status("ENSM to FDD", 0x017, 0x0F, 0x0A, 0.005);
         _io_iface->poke8(0x014, 0x00);
         break;
 
@@ -1846,7 +1893,7 @@ double ad9361_device_t::set_clock_rate(const double req_rate)
     _io_iface->poke8(0x015, 0x04); //dual synth mode, synth en ctrl en
     _io_iface->poke8(0x014, 0x05); //use SPI for TXNRX ctrl, to ALERT, TX on
     _io_iface->poke8(0x013, 0x01); //enable ENSM
-    boost::this_thread::sleep(boost::posix_time::milliseconds(1));
+    _poll_status("ENSM to ALERT", 0x017, 0x0F, 0x05, 0.001); // state is checked by the charge pump cal
 
     _calibrate_synth_charge_pumps();
 
@@ -2196,16 +2243,9 @@ double ad9361_device_t::_get_temperature(const double cal_offset, const double t
     _io_iface->poke8(0x00B, 0); //set offset to 0
 
     _io_iface->poke8(0x00C, 0x01); //start reading, clears bit 0x00C[1]
-    boost::posix_time::ptime start_time = boost::posix_time::microsec_clock::local_time();
-    boost::posix_time::time_duration elapsed;
     //wait for valid data (toggle of bit 1 in 0x00C)
-    while(((_io_iface->peek8(0x00C) >> 1) & 0x01) == 0) {
-        boost::this_thread::sleep(boost::posix_time::microseconds(100));
-        elapsed = boost::posix_time::microsec_clock::local_time() - start_time;
-        if(elapsed.total_milliseconds() > (timeout*1000))
-        {
-            throw uhd::runtime_error("[ad9361_device_t] timeout while reading temperature");
-        }
+    if (not _poll_status("temperature read", 0x00C, 0x02, 0x02, timeout)) {
+        throw uhd::runtime_error("[ad9361_device_t] timeout while reading temperature");
     }
     _io_iface->poke8(0x00C, 0x00); //clear read flag
 
@@ -2360,6 +2400,12 @@ void ad9361_device_t::set_agc_mode(chain_t chain, gain_mode_t gain_mode)
     }
 }
 
+ad9361_device_t::step_timing_t ad9361_device_t::get_step_timing()
+{
+    boost::lock_guard<boost::recursive_mutex> lock(_mutex);
+    return _step_timing;
+}
+
 std::vector<std::string> ad9361_device_t::get_filter_names(direction_t direction)
 {
     std::vector<std::string> ret;
@@ -2419,6 +2465,17 @@ double ad9361_device_t::set_bw_filter(direction_t direction, const double rf_bw)
     //both low pass filters are programmed to the same bw. However, their cutoffs will differ.
     //Together they should create the requested bb bw.
     double set_analog_bb_bw = 0;
+
+    /* Skip the calibration if the filters still hold the result for the same
+     * bandwidth at the same clock rate, e.g. when the bandwidth is set for
+     * each channel in turn. */
+    bw_filter_cal_t &last_cal = (direction == RX) ? _rx_bw_cal : _tx_bw_cal;
+    if (last_cal.valid and last_cal.rf_bw == rf_bw
+            and last_cal.bbpll_freq == _bbpll_freq and last_cal.baseband_bw == _baseband_bw) {
+        set_analog_bb_bw = (direction == RX) ? _rx_analog_bw : _tx_analog_bw;
+        return (2.0 * set_analog_bb_bw);
+    }
+
     if(direction == RX)
     {
         _rx_bb_lp_bw = _calibrate_baseband_rx_analog_filter(rf_bw); //returns bb bw
@@ -2431,6 +2488,10 @@ double ad9361_device_t::set_bw_filter(direction_t direction, const double rf_bw)
         _tx_analog_bw = _tx_bb_lp_bw;
         set_analog_bb_bw = _tx_analog_bw;
     }
+    last_cal.valid = true;
+    last_cal.rf_bw = rf_bw;
+    last_cal.bbpll_freq = _bbpll_freq;
+    last_cal.baseband_bw = _baseband_bw;
     return (2.0 * set_analog_bb_bw);
 }
 
@@ -2446,6 +2507,11 @@ void ad9361_device_t::_set_fir_taps(direction_t direction, chain_t chain, const
             coeffs[i] = uint16_t(taps[i]);
         }
         _program_fir_filter(direction, chain, num_taps_avail, coeffs.get());
+        if (direction == RX) {
+            _rx_fir_config = std::make_pair(0, 0);
+        } else {
+            _tx_fir_config = std::make_pair(0, 0);
+        }
     } else if(num_taps < num_taps_avail){
         throw uhd::runtime_error("ad9361_device_t::_set_fir_taps not enough coefficients.");
     } else {
@@ -2817,10 +2883,12 @@ void ad9361_device_t::_set_filter_lp_bb(direction_t direction, filter_info_base:
     double bw = lpf->get_cutoff();
     if(direction == RX)
     {
+        _rx_bw_cal.valid = false;
         //remember: this function takes rf bw as its input and calibrated to 1.4 x the given value
         _rx_bb_lp_bw = _calibrate_baseband_rx_analog_filter(2 * bw / 1.4); //returns bb bw
 
     } else {
+        _tx_bw_cal.valid = false;
         //remember: this function takes rf bw as its input and calibrates to 1.6 x the given value
         _tx_bb_lp_bw = _calibrate_baseband_tx_analog_filter(2 * bw / 1.6);
     }
@@ -2832,10 +2900,12 @@ void ad9361_device_t::_set_filter_lp_tia_sec(direction_t direction, filter_info_
     double bw = lpf->get_cutoff();
     if(direction == RX)
     {
+        _rx_bw_cal.valid = false;
         //remember: this function takes rf bw as its input and calibrated to 2.5 x the given value
         _rx_tia_lp_bw = _calibrate_rx_TIAs(2 * bw / 2.5); //returns bb bw
 
     } else {
+        _tx_bw_cal.valid = false;
         //remember: this function takes rf bw as its input and calibrates to 5 x the given value
         _tx_sec_lp_bw = _calibrate_secondary_tx_filter(2 * bw / 5);
     }
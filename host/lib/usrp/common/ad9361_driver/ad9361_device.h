@@ -45,6 +45,7 @@ public:
         _req_coreclk(0.0), _rx_bbf_tunediv(0), _curr_gain_table(0),
         _rx1_gain(0.0), _rx2_gain(0.0), _tx1_gain(0.0), _tx2_gain(0.0),
         _tfir_factor(0), _rfir_factor(0),
+        _rx_fir_config(0, 0), _tx_fir_config(0, 0),
         _rx1_agc_mode(GAIN_MODE_MANUAL), _rx2_agc_mode(GAIN_MODE_MANUAL),
         _rx1_agc_enable(false), _rx2_agc_enable(false),
         _use_dc_offset_tracking(false), _use_iq_balance_tracking(false)
@@ -165,6 +166,11 @@ public:
 
     std::vector<std::string> get_filter_names(direction_t direction);
 
+    /* Duration (in seconds) of the most recent run of each status-polled
+     * step (calibrations, PLL locks, ENSM transitions), keyed by step name. */
+    typedef std::map<std::string, double> step_timing_t;
+    step_timing_t get_step_timing();
+
     //Constants
     static const double AD9361_MAX_GAIN;
     static const double AD9361_MAX_CLOCK_RATE;
@@ -174,6 +180,44 @@ public:
     static const double DEFAULT_RX_FREQ;
     static const double DEFAULT_TX_FREQ;
 
+private:    //Types
+    //! BBPLL settings derived for one ADC clock rate
+    struct bbpll_config_t
+    {
+        double  coreclk;
+        int     vcodiv_sel;
+        int     nint;
+        int     nfrac;
+        int     icp_reg;
+        double  bbpll_freq;
+        double  adcclock_freq;
+    };
+
+    //! Divider chain, BBPLL and FIR setup derived for one master clock rate
+    struct clock_config_t
+    {
+        uint8_t         rxfilt;
+        uint8_t         txfilt;
+        int             divfactor;
+        int32_t         tfir_factor;
+        int32_t         rfir_factor;
+        bbpll_config_t  bbpll;
+        bool            dac_clk_div2;
+        size_t          num_tx_taps;
+        size_t          num_rx_taps;
+    };
+    typedef std::map<double, clock_config_t> clock_config_cache_t;
+
+    //! Inputs of the last analog filter calibration of one direction
+    struct bw_filter_cal_t
+    {
+        bw_filter_cal_t() : valid(false), bbpll_freq(0.0), baseband_bw(0.0), rf_bw(0.0) {}
+        bool    valid;
+        double  bbpll_freq;
+        double  baseband_bw;
+        double  rf_bw;
+    };
+
 private:    //Methods
     void _program_fir_filter(direction_t direction, int num_taps, uint16_t *coeffs);
     void _setup_tx_fir(size_t num_taps, int32_t interpolation);
@@ -197,9 +241,11 @@ private:    //Methods
     void _program_gain_table();
     void _setup_gain_control(bool use_agc);
     void _setup_synth(direction_t direction, double vcorate);
-    double _tune_bbvco(const double rate);
+    bbpll_config_t _derive_bbpll_config(const double rate);
+    double _tune_bbvco(const bbpll_config_t &config);
     void _reprogram_gains();
     double _tune_helper(direction_t direction, const double value);
+    clock_config_t _derive_clock_config(const double rate);
     double _setup_rates(const double rate);
     double _get_temperature(const double cal_offset, const double timeout = 0.1);
     void _configure_bb_dc_tracking();
@@ -219,6 +265,7 @@ private:    //Methods
     void _set_filter_fir(direction_t direction, chain_t channel, filter_info_base::sptr filter);
     void _set_filter_lp_bb(direction_t direction, filter_info_base::sptr filter);
     void _set_filter_lp_tia_sec(direction_t direction, filter_info_base::sptr filter);
+    bool _poll_status(const std::string &step, uint32_t reg, uint8_t mask, uint8_t value, double timeout);
 
 private:    //Members
     struct chip_regs_t
@@ -273,10 +320,18 @@ private:    //Members
     double              _rx1_gain, _rx2_gain, _tx1_gain, _tx2_gain;
     int32_t      _tfir_factor;
     int32_t      _rfir_factor;
+    //! (number of taps, decimation/interpolation) of the FIR tap set currently
+    //  loaded into the chip, so identical tap sets are not reprogrammed
+    std::pair<size_t, int32_t>  _rx_fir_config, _tx_fir_config;
+    //! Clock configurations derived so far, keyed by requested master clock rate
+    clock_config_cache_t        _clock_config_cache;
+    bw_filter_cal_t             _rx_bw_cal, _tx_bw_cal;
     gain_mode_t         _rx1_agc_mode, _rx2_agc_mode;
     bool                _rx1_agc_enable, _rx2_agc_enable;
     //Register soft-copies
     chip_regs_t         _regs;
+    //Instrumentation
+    step_timing_t       _step_timing;
     //Synchronization
     boost::recursive_mutex  _mutex;
     bool _use_dc_offset_tracking;
@@ -25,7 +25,9 @@
 #include <boost/function.hpp>
 #include <boost/thread.hpp>
 #include <boost/math/special_functions/round.hpp>
+#include <boost/foreach.hpp>
 #include <vector>
+#include "settings_cache.hpp"
 #include "adf4350_regs.hpp"
 #include "adf4351_regs.hpp"
 
@@ -66,6 +68,16 @@ public:
 
     virtual double set_frequency(double target_freq, bool int_n_mode, bool flush = false) = 0;
 
+    /*!
+     * Compute and cache the divider settings for a list of frequencies
+     * so that later calls to set_frequency() with the same frequencies and
+     * the current reference/prescaler/feedback settings skip the search.
+     */
+    virtual void prime_frequency_cache(const std::vector<double> &freqs, bool int_n_mode) = 0;
+
+    //! Drop the cached divider settings of all synthesizers of this type
+    virtual void clear_frequency_cache(void) = 0;
+
     virtual void commit(void) = 0;
 };
 
@@ -148,18 +160,171 @@ public:
     }
 
     double set_frequency(double target_freq, bool int_n_mode, bool flush = false)
+    {
+        uhd::range_t rf_divider_range = _get_rfdiv_range();
+        uhd::range_t int_range = get_int_range();
+
+        //Divider search, or its cached result for identical inputs
+        const tune_settings_t s = _get_tune_settings(target_freq, int_n_mode);
+        const double actual_freq = s.actual_freq;
+
+        _regs.frac_12_bit            = s.FRAC;
+        _regs.int_16_bit             = s.N;
+        _regs.mod_12_bit             = s.MOD;
+        _regs.clock_divider_12_bit   = s.clock_div;
+        _regs.feedback_select        = _fb_after_divider ?
+                                        adf435x_regs_t::FEEDBACK_SELECT_DIVIDED :
+                                        adf435x_regs_t::FEEDBACK_SELECT_FUNDAMENTAL;
+        _regs.clock_div_mode         = _fb_after_divider ?
+                                        adf435x_regs_t::CLOCK_DIV_MODE_RESYNC_ENABLE :
+                                        adf435x_regs_t::CLOCK_DIV_MODE_FAST_LOCK;
+        _regs.r_counter_10_bit       = s.R;
+        _regs.reference_divide_by_2  = s.T ?
+                                        adf435x_regs_t::REFERENCE_DIVIDE_BY_2_ENABLED :
+                                        adf435x_regs_t::REFERENCE_DIVIDE_BY_2_DISABLED;
+        _regs.reference_doubler      = s.D ?
+                                        adf435x_regs_t::REFERENCE_DOUBLER_ENABLED :
+                                        adf435x_regs_t::REFERENCE_DOUBLER_DISABLED;
+        _regs.band_select_clock_div  = uint8_t(s.BS);
+        _regs.rf_divider_select      = static_cast<typename adf435x_regs_t::rf_divider_select_t>(_get_rfdiv_setting(s.RFdiv));
+        _regs.ldf                    = int_n_mode ?
+                                        adf435x_regs_t::LDF_INT_N :
+                                        adf435x_regs_t::LDF_FRAC_N;
+
+        std::string tuning_str = (int_n_mode) ? "Integer-N" : "Fractional";
+        UHD_LOGV(often)
+            << boost::format("ADF 435X Frequencies (MHz): REQUESTED=%0.9f, ACTUAL=%0.9f"
+            ) % (target_freq/1e6) % (actual_freq/1e6) << std::endl
+            << boost::format("ADF 435X Intermediates (MHz): Feedback=%0.2f, VCO=%0.2f, PFD=%0.2f, BAND=%0.2f, REF=%0.2f"
+            ) % (s.feedback_freq/1e6) % (s.vco_freq/1e6) % (s.pfd_freq/1e6) % (s.pfd_freq/s.BS/1e6) % (_reference_freq/1e6) << std::endl
+            << boost::format("ADF 435X Tuning: %s") % tuning_str.c_str() << std::endl
+            << boost::format("ADF 435X Settings: R=%d, BS=%d, N=%d, FRAC=%d, MOD=%d, T=%d, D=%d, RFdiv=%d"
+            ) % s.R % s.BS % s.N % s.FRAC % s.MOD % s.T % s.D % s.RFdiv << std::endl;
+
+        UHD_ASSERT_THROW((_regs.frac_12_bit          & ((uint16_t)~0xFFF)) == 0);
+        UHD_ASSERT_THROW((_regs.mod_12_bit           & ((uint16_t)~0xFFF)) == 0);
+        UHD_ASSERT_THROW((_regs.clock_divider_12_bit & ((uint16_t)~0xFFF)) == 0);
+        UHD_ASSERT_THROW((_regs.r_counter_10_bit     & ((uint16_t)~0x3FF)) == 0);
+
+        UHD_ASSERT_THROW(s.vco_freq >= VCO_FREQ_MIN and s.vco_freq <= VCO_FREQ_MAX);
+        UHD_ASSERT_THROW(s.RFdiv >= static_cast<uint16_t>(rf_divider_range.start()));
+        UHD_ASSERT_THROW(s.RFdiv <= static_cast<uint16_t>(rf_divider_range.stop()));
+        UHD_ASSERT_THROW(_regs.int_16_bit >= static_cast<uint16_t>(int_range.start()));
+        UHD_ASSERT_THROW(_regs.int_16_bit <= static_cast<uint16_t>(int_range.stop()));
+
+        if (flush) commit();
+        return actual_freq;
+    }
+
+    void prime_frequency_cache(const std::vector<double> &freqs, bool int_n_mode)
+    {
+        get_int_range(); //throws if the prescaler is not set yet
+        BOOST_FOREACH(const double freq, freqs) {
+            _get_tune_settings(freq, int_n_mode);
+        }
+    }
+
+    void clear_frequency_cache(void)
+    {
+        _get_tune_cache().clear();
+    }
+
+    void commit()
+    {
+        //reset counters
+        _regs.counter_reset = adf435x_regs_t::COUNTER_RESET_ENABLED;
+        std::vector<uint32_t> regs;
+        regs.push_back(_regs.get_reg(uint32_t(2)));
+        _write_fn(regs);
+        _regs.counter_reset = adf435x_regs_t::COUNTER_RESET_DISABLED;
+
+        //write the registers
+        //correct power-up sequence to write registers (5, 4, 3, 2, 1, 0)
+        regs.clear();
+        for (int addr = 5; addr >= 0; addr--) {
+            regs.push_back(_regs.get_reg(uint32_t(addr)));
+        }
+        _write_fn(regs);
+    }
+
+protected:
+    static const double VCO_FREQ_MIN;
+    static const double VCO_FREQ_MAX;
+
+    //! Inputs to the divider search, used as the tune cache key
+    struct tune_key_t
+    {
+        double target_freq;
+        double reference_freq;
+        bool   int_n_mode;
+        bool   fb_after_divider;
+        int    N_min;
+
+        bool operator==(const tune_key_t &rhs) const
+        {
+            return target_freq == rhs.target_freq
+                and reference_freq == rhs.reference_freq
+                and int_n_mode == rhs.int_n_mode
+                and fb_after_divider == rhs.fb_after_divider
+                and N_min == rhs.N_min;
+        }
+
+        friend size_t hash_value(const tune_key_t &key)
+        {
+            size_t seed = 0;
+            boost::hash_combine(seed, key.target_freq);
+            boost::hash_combine(seed, key.reference_freq);
+            boost::hash_combine(seed, key.int_n_mode);
+            boost::hash_combine(seed, key.fb_after_divider);
+            boost::hash_combine(seed, key.N_min);
+            return seed;
+        }
+    };
+
+    //! Results of the divider search
+    struct tune_settings_t
+    {
+        uint16_t R, BS, N, FRAC, MOD, RFdiv, clock_div;
+        bool     D, T;
+        double   vco_freq, feedback_freq, pfd_freq, actual_freq;
+    };
+
+    typedef uhd::usrp::settings_cache<tune_key_t, tune_settings_t> tune_cache_t;
+
+    //! One cache per chip type, shared by all instances
+    static tune_cache_t& _get_tune_cache()
+    {
+        static tune_cache_t cache;
+        return cache;
+    }
+
+    tune_settings_t _get_tune_settings(double target_freq, bool int_n_mode)
+    {
+        tune_key_t key;
+        key.target_freq      = target_freq;
+        key.reference_freq   = _reference_freq;
+        key.int_n_mode       = int_n_mode;
+        key.fb_after_divider = _fb_after_divider;
+        key.N_min            = _N_min;
+
+        tune_settings_t s;
+        if (not _get_tune_cache().lookup(key, s)) {
+            s = _compute_tune_settings(key);
+            _get_tune_cache().store(key, s);
+        }
+        return s;
+    }
+
+    tune_settings_t _compute_tune_settings(const tune_key_t &key)
     {
         static const double REF_DOUBLER_THRESH_FREQ = 12.5e6;
         static const double PFD_FREQ_MAX            = 25.0e6;
         static const double BAND_SEL_FREQ_MAX       = 100e3;
-        static const double VCO_FREQ_MIN            = 2.2e9;
-        static const double VCO_FREQ_MAX            = 4.4e9;
 
-        //Default invalid value for actual_freq
-        double actual_freq = 0;
-
-        uhd::range_t rf_divider_range = _get_rfdiv_range();
-        uhd::range_t int_range = get_int_range();
+        const double target_freq = key.target_freq;
+        const double reference_freq = key.reference_freq;
+        const uhd::range_t rf_divider_range = _get_rfdiv_range();
+        const uhd::range_t int_range(key.N_min, 4095);
 
         double pfd_freq = 0;
         uint16_t R = 0, BS = 0, N = 0, FRAC = 0, MOD = 0;
@@ -167,7 +332,7 @@ public:
         bool D = false, T = false;
 
         //Reference doubler for 50% duty cycle
-        D = (_reference_freq <= REF_DOUBLER_THRESH_FREQ);
+        D = (reference_freq <= REF_DOUBLER_THRESH_FREQ);
 
         //increase RF divider until acceptable VCO frequency
         double vco_freq = target_freq;
@@ -192,11 +357,11 @@ public:
          *    N = f_vco/f_pfd - FRAC/MOD = f_vco*((R*(T+1))/(f_ref*(1+D))) - FRAC/MOD
          * f_actual = f_vco/RFdiv)
          */
-        double feedback_freq = _fb_after_divider ? target_freq : vco_freq;
+        double feedback_freq = key.fb_after_divider ? target_freq : vco_freq;
 
         for(R = 1; R <= 1023; R+=1){
             //PFD input frequency = f_ref/R ... ignoring Reference doubler/divide-by-2 (D & T)
-            pfd_freq = _reference_freq*(D?2:1)/(R*(T?2:1));
+            pfd_freq = reference_freq*(D?2:1)/(R*(T?2:1));
 
             //keep the PFD frequency at or below 25MHz (Loop Filter Bandwidth)
             if (pfd_freq > PFD_FREQ_MAX) continue;
@@ -218,7 +383,7 @@ public:
         //Fractional-N calculation
         MOD = 4095; //max fractional accuracy
         FRAC = static_cast<uint16_t>(boost::math::round((feedback_freq/pfd_freq - N)*MOD));
-        if (int_n_mode) {
+        if (key.int_n_mode) {
             if (FRAC > (MOD / 2)) { //Round integer such that actual freq is closest to target
                 N++;
             }
@@ -236,81 +401,31 @@ public:
         static const double PHASE_RESYNC_TIME = 400e-6;
 
         //If feedback after divider, then compensation for the divider is pulled into the INT value
-        int rf_div_compensation = _fb_after_divider ? 1 : RFdiv;
+        int rf_div_compensation = key.fb_after_divider ? 1 : RFdiv;
+
+        tune_settings_t s;
+        s.R             = R;
+        s.BS            = BS;
+        s.N             = N;
+        s.FRAC          = FRAC;
+        s.MOD           = MOD;
+        s.RFdiv         = RFdiv;
+        s.clock_div     = std::max<uint16_t>(1, uint16_t(std::ceil(PHASE_RESYNC_TIME*pfd_freq/MOD)));
+        s.D             = D;
+        s.T             = T;
+        s.vco_freq      = vco_freq;
+        s.feedback_freq = feedback_freq;
+        s.pfd_freq      = pfd_freq;
 
         //Compute the actual frequency in terms of _reference_freq, N, FRAC, MOD, D, R and T.
-        actual_freq = (
+        s.actual_freq = (
             double((N + (double(FRAC)/double(MOD))) *
-            (_reference_freq*(D?2:1)/(R*(T?2:1))))
+            (reference_freq*(D?2:1)/(R*(T?2:1))))
         ) / rf_div_compensation;
 
-        _regs.frac_12_bit            = FRAC;
-        _regs.int_16_bit             = N;
-        _regs.mod_12_bit             = MOD;
-        _regs.clock_divider_12_bit   = std::max<uint16_t>(1, uint16_t(std::ceil(PHASE_RESYNC_TIME*pfd_freq/MOD)));
-        _regs.feedback_select        = _fb_after_divider ?
-                                        adf435x_regs_t::FEEDBACK_SELECT_DIVIDED :
-                                        adf435x_regs_t::FEEDBACK_SELECT_FUNDAMENTAL;
-        _regs.clock_div_mode         = _fb_after_divider ?
-                                        adf435x_regs_t::CLOCK_DIV_MODE_RESYNC_ENABLE :
-                                        adf435x_regs_t::CLOCK_DIV_MODE_FAST_LOCK;
-        _regs.r_counter_10_bit       = R;
-        _regs.reference_divide_by_2  = T ?
-                                        adf435x_regs_t::REFERENCE_DIVIDE_BY_2_ENABLED :
-                                        adf435x_regs_t::REFERENCE_DIVIDE_BY_2_DISABLED;
-        _regs.reference_doubler      = D ?
-                                        adf435x_regs_t::REFERENCE_DOUBLER_ENABLED :
-                                        adf435x_regs_t::REFERENCE_DOUBLER_DISABLED;
-        _regs.band_select_clock_div  = uint8_t(BS);
-        _regs.rf_divider_select      = static_cast<typename adf435x_regs_t::rf_divider_select_t>(_get_rfdiv_setting(RFdiv));
-        _regs.ldf                    = int_n_mode ?
-                                        adf435x_regs_t::LDF_INT_N :
-                                        adf435x_regs_t::LDF_FRAC_N;
-
-        std::string tuning_str = (int_n_mode) ? "Integer-N" : "Fractional";
-        UHD_LOGV(often)
-            << boost::format("ADF 435X Frequencies (MHz): REQUESTED=%0.9f, ACTUAL=%0.9f"
-            ) % (target_freq/1e6) % (actual_freq/1e6) << std::endl
-            << boost::format("ADF 435X Intermediates (MHz): Feedback=%0.2f, VCO=%0.2f, PFD=%0.2f, BAND=%0.2f, REF=%0.2f"
-            ) % (feedback_freq/1e6) % (vco_freq/1e6) % (pfd_freq/1e6) % (pfd_freq/BS/1e6) % (_reference_freq/1e6) << std::endl
-            << boost::format("ADF 435X Tuning: %s") % tuning_str.c_str() << std::endl
-            << boost::format("ADF 435X Settings: R=%d, BS=%d, N=%d, FRAC=%d, MOD=%d, T=%d, D=%d, RFdiv=%d"
-            ) % R % BS % N % FRAC % MOD % T % D % RFdiv << std::endl;
-
-        UHD_ASSERT_THROW((_regs.frac_12_bit          & ((uint16_t)~0xFFF)) == 0);
-        UHD_ASSERT_THROW((_regs.mod_12_bit           & ((uint16_t)~0xFFF)) == 0);
-        UHD_ASSERT_THROW((_regs.clock_divider_12_bit & ((uint16_t)~0xFFF)) == 0);
-        UHD_ASSERT_THROW((_regs.r_counter_10_bit     & ((uint16_t)~0x3FF)) == 0);
-
-        UHD_ASSERT_THROW(vco_freq >= VCO_FREQ_MIN and vco_freq <= VCO_FREQ_MAX);
-        UHD_ASSERT_THROW(RFdiv >= static_cast<uint16_t>(rf_divider_range.start()));
-        UHD_ASSERT_THROW(RFdiv <= static_cast<uint16_t>(rf_divider_range.stop()));
-        UHD_ASSERT_THROW(_regs.int_16_bit >= static_cast<uint16_t>(int_range.start()));
-        UHD_ASSERT_THROW(_regs.int_16_bit <= static_cast<uint16_t>(int_range.stop()));
-
-        if (flush) commit();
-        return actual_freq;
+        return s;
     }
 
-    void commit()
-    {
-        //reset counters
-        _regs.counter_reset = adf435x_regs_t::COUNTER_RESET_ENABLED;
-        std::vector<uint32_t> regs;
-        regs.push_back(_regs.get_reg(uint32_t(2)));
-        _write_fn(regs);
-        _regs.counter_reset = adf435x_regs_t::COUNTER_RESET_DISABLED;
-
-        //write the registers
-        //correct power-up sequence to write registers (5, 4, 3, 2, 1, 0)
-        regs.clear();
-        for (int addr = 5; addr >= 0; addr--) {
-            regs.push_back(_regs.get_reg(uint32_t(addr)));
-        }
-        _write_fn(regs);
-    }
-
-protected:
     uhd::range_t _get_rfdiv_range();
     int _get_rfdiv_setting(uint16_t div);
 
@@ -321,6 +436,12 @@ protected:
     int             _N_min;
 };
 
+template <typename adf435x_regs_t>
+const double adf435x_impl<adf435x_regs_t>::VCO_FREQ_MIN = 2.2e9;
+
+template <typename adf435x_regs_t>
+const double adf435x_impl<adf435x_regs_t>::VCO_FREQ_MAX = 4.4e9;
+
 template <>
 inline uhd::range_t adf435x_impl<adf4350_regs_t>::_get_rfdiv_range()
 {
@@ -17,9 +17,11 @@
 
 #include "adf5355.hpp"
 #include "adf5355_regs.hpp"
+#include "settings_cache.hpp"
 #include <uhd/utils/math.hpp>
 #include <boost/math/common_factor_rt.hpp> //gcd
 #include <boost/thread.hpp>
+#include <boost/foreach.hpp>
 
 using namespace uhd;
 
@@ -51,6 +53,112 @@ static const uint32_t ADF5355_MAX_MOD2       = 16383;
 static const uint32_t ADF5355_MAX_FRAC2      = 16383;
 //static const uint16_t ADF5355_MIN_INT_PRESCALER_89 = 75;
 
+//! Inputs to the divider computation, used as the tune cache key
+struct adf5355_tune_key_t
+{
+    double target_freq;
+    double pfd_freq;
+    double freq_resolution;
+    bool   fb_after_divider;
+
+    bool operator==(const adf5355_tune_key_t &rhs) const
+    {
+        return target_freq == rhs.target_freq
+            and pfd_freq == rhs.pfd_freq
+            and freq_resolution == rhs.freq_resolution
+            and fb_after_divider == rhs.fb_after_divider;
+    }
+};
+
+static size_t hash_value(const adf5355_tune_key_t &key)
+{
+    size_t seed = 0;
+    boost::hash_combine(seed, key.target_freq);
+    boost::hash_combine(seed, key.pfd_freq);
+    boost::hash_combine(seed, key.freq_resolution);
+    boost::hash_combine(seed, key.fb_after_divider);
+    return seed;
+}
+
+//! Results of the divider computation
+struct adf5355_tune_settings_t
+{
+    adf5355_regs_t::rf_divider_select_t rf_divider_select;
+    uint16_t INT;
+    uint32_t FRAC1;
+    uint16_t FRAC2;
+    uint16_t MOD2;
+    double   coerced_out_freq;
+};
+
+typedef uhd::usrp::settings_cache<adf5355_tune_key_t, adf5355_tune_settings_t> adf5355_tune_cache_t;
+
+//! Shared by all ADF5355 instances
+static adf5355_tune_cache_t& get_tune_cache(void)
+{
+    static adf5355_tune_cache_t cache;
+    return cache;
+}
+
+static adf5355_tune_settings_t compute_tune_settings(const adf5355_tune_key_t &key)
+{
+    const double target_freq = key.target_freq;
+    const double freq_resolution = key.freq_resolution;
+    const double pfd_freq = key.pfd_freq;
+
+    adf5355_tune_settings_t s;
+
+    /* Calculate target VCOout frequency */
+    //Increase RF divider until acceptable VCO frequency
+    double target_vco_freq = target_freq;
+    uint32_t rf_divider = 1;
+    while (target_vco_freq < ADF5355_MIN_VCO_FREQ && rf_divider < 64) {
+        target_vco_freq *= 2;
+        rf_divider *= 2;
+    }
+
+    switch (rf_divider) {
+        case 1:  s.rf_divider_select = adf5355_regs_t::RF_DIVIDER_SELECT_DIV1;  break;
+        case 2:  s.rf_divider_select = adf5355_regs_t::RF_DIVIDER_SELECT_DIV2;  break;
+        case 4:  s.rf_divider_select = adf5355_regs_t::RF_DIVIDER_SELECT_DIV4;  break;
+        case 8:  s.rf_divider_select = adf5355_regs_t::RF_DIVIDER_SELECT_DIV8;  break;
+        case 16: s.rf_divider_select = adf5355_regs_t::RF_DIVIDER_SELECT_DIV16; break;
+        case 32: s.rf_divider_select = adf5355_regs_t::RF_DIVIDER_SELECT_DIV32; break;
+        case 64: s.rf_divider_select = adf5355_regs_t::RF_DIVIDER_SELECT_DIV64; break;
+        default: UHD_THROW_INVALID_CODE_PATH();
+    }
+
+    //Compute fractional PLL params
+    double prescaler_input_freq = target_vco_freq;
+    if (key.fb_after_divider) {
+        prescaler_input_freq /= rf_divider;
+    }
+
+    double N = prescaler_input_freq / pfd_freq;
+    uint16_t INT = static_cast<uint16_t>(floor(N));
+    uint32_t FRAC1 = static_cast<uint32_t>(floor((N - INT) * ADF5355_MOD1));
+    double residue = (N - INT) * ADF5355_MOD1 - FRAC1;
+
+    double gcd = boost::math::gcd(static_cast<int>(pfd_freq), static_cast<int>(freq_resolution));
+    uint16_t MOD2 = static_cast<uint16_t>(std::min(floor(pfd_freq / gcd), static_cast<double>(ADF5355_MAX_MOD2)));
+    uint16_t FRAC2 = static_cast<uint16_t>(std::min(ceil(residue * MOD2), static_cast<double>(ADF5355_MAX_FRAC2)));
+
+    double coerced_vco_freq = pfd_freq * (
+        todbl(INT) + (
+            (todbl(FRAC1) +
+                (todbl(FRAC2) / todbl(MOD2)))
+            / todbl(ADF5355_MOD1)
+        )
+    );
+
+    s.INT = INT;
+    s.FRAC1 = FRAC1;
+    s.FRAC2 = FRAC2;
+    s.MOD2 = MOD2;
+    s.coerced_out_freq = coerced_vco_freq / rf_divider;
+    return s;
+}
+
 class adf5355_impl : public adf5355_iface
 {
 public:
@@ -226,63 +334,17 @@ public:
 
     double set_frequency(double target_freq, double freq_resolution, bool flush = false)
     {
-        if (target_freq > ADF5355_MAX_OUT_FREQ or target_freq < ADF5355_MIN_OUT_FREQ) {
-            throw uhd::runtime_error("requested frequency out of range.");
-        }
-        if ((uint32_t) freq_resolution == 0) {
-            throw uhd::runtime_error("requested resolution cannot be less than 1.");
-        }
+        _check_frequency(target_freq, freq_resolution);
 
-        /* Calculate target VCOout frequency */
-        //Increase RF divider until acceptable VCO frequency
-        double target_vco_freq = target_freq;
-        uint32_t rf_divider = 1;
-        while (target_vco_freq < ADF5355_MIN_VCO_FREQ && rf_divider < 64) {
-            target_vco_freq *= 2;
-            rf_divider *= 2;
-        }
-
-        switch (rf_divider) {
-            case 1:  _regs.rf_divider_select = adf5355_regs_t::RF_DIVIDER_SELECT_DIV1;  break;
-            case 2:  _regs.rf_divider_select = adf5355_regs_t::RF_DIVIDER_SELECT_DIV2;  break;
-            case 4:  _regs.rf_divider_select = adf5355_regs_t::RF_DIVIDER_SELECT_DIV4;  break;
-            case 8:  _regs.rf_divider_select = adf5355_regs_t::RF_DIVIDER_SELECT_DIV8;  break;
-            case 16: _regs.rf_divider_select = adf5355_regs_t::RF_DIVIDER_SELECT_DIV16; break;
-            case 32: _regs.rf_divider_select = adf5355_regs_t::RF_DIVIDER_SELECT_DIV32; break;
-            case 64: _regs.rf_divider_select = adf5355_regs_t::RF_DIVIDER_SELECT_DIV64; break;
-            default: UHD_THROW_INVALID_CODE_PATH();
-        }
-
-        //Compute fractional PLL params
-        double prescaler_input_freq = target_vco_freq;
-        if (_fb_after_divider) {
-            prescaler_input_freq /= rf_divider;
-        }
-
-        double N = prescaler_input_freq / _pfd_freq;
-        uint16_t INT = static_cast<uint16_t>(floor(N));
-        uint32_t FRAC1 = static_cast<uint32_t>(floor((N - INT) * ADF5355_MOD1));
-        double residue = (N - INT) * ADF5355_MOD1 - FRAC1;
-
-        double gcd = boost::math::gcd(static_cast<int>(_pfd_freq), static_cast<int>(freq_resolution));
-        uint16_t MOD2 = static_cast<uint16_t>(std::min(floor(_pfd_freq / gcd), static_cast<double>(ADF5355_MAX_MOD2)));
-        uint16_t FRAC2 = static_cast<uint16_t>(std::min(ceil(residue * MOD2), static_cast<double>(ADF5355_MAX_FRAC2)));
-
-        double coerced_vco_freq = _pfd_freq * (
-            todbl(INT) + (
-                (todbl(FRAC1) +
-                    (todbl(FRAC2) / todbl(MOD2)))
-                / todbl(ADF5355_MOD1)
-            )
-        );
-
-        double coerced_out_freq = coerced_vco_freq / rf_divider;
+        //Divider computation, or its cached result for identical inputs
+        const adf5355_tune_settings_t s = _get_tune_settings(target_freq, freq_resolution);
 
         /* Update registers */
-        _regs.int_16_bit = INT;
-        _regs.frac1_24_bit = FRAC1;
-        _regs.frac2_14_bit = FRAC2;
-        _regs.mod2_14_bit = MOD2;
+        _regs.rf_divider_select = s.rf_divider_select;
+        _regs.int_16_bit = s.INT;
+        _regs.frac1_24_bit = s.FRAC1;
+        _regs.frac2_14_bit = s.FRAC2;
+        _regs.mod2_14_bit = s.MOD2;
         _regs.phase_24_bit = 0;
 
 /*
@@ -304,7 +366,20 @@ public:
 */
 
         if (flush) commit();
-        return coerced_out_freq;
+        return s.coerced_out_freq;
+    }
+
+    void prime_frequency_cache(const std::vector<double> &freqs, double freq_resolution)
+    {
+        BOOST_FOREACH(const double freq, freqs) {
+            _check_frequency(freq, freq_resolution);
+            _get_tune_settings(freq, freq_resolution);
+        }
+    }
+
+    void clear_frequency_cache(void)
+    {
+        get_tune_cache().clear();
     }
 
     void commit()
@@ -336,6 +411,33 @@ public:
         }
     }
 
+private: //Methods
+    void _check_frequency(double target_freq, double freq_resolution)
+    {
+        if (target_freq > ADF5355_MAX_OUT_FREQ or target_freq < ADF5355_MIN_OUT_FREQ) {
+            throw uhd::runtime_error("requested frequency out of range.");
+        }
+        if ((uint32_t) freq_resolution == 0) {
+            throw uhd::runtime_error("requested resolution cannot be less than 1.");
+        }
+    }
+
+    adf5355_tune_settings_t _get_tune_settings(double target_freq, double freq_resolution)
+    {
+        adf5355_tune_key_t key;
+        key.target_freq = target_freq;
+        key.pfd_freq = _pfd_freq;
+        key.freq_resolution = freq_resolution;
+        key.fb_after_divider = _fb_after_divider;
+
+        adf5355_tune_settings_t s;
+        if (not get_tune_cache().lookup(key, s)) {
+            s = compute_tune_settings(key);
+            get_tune_cache().store(key, s);
+        }
+        return s;
+    }
+
 private: //Members
     typedef std::vector<uint32_t> addr_vtr_t;
 
@@ -52,6 +52,16 @@ public:
 
     virtual double set_frequency(double target_freq, double freq_resolution, bool flush = false) = 0;
 
+    /*!
+     * Compute and cache the divider settings for a list of frequencies
+     * so that later calls to set_frequency() with the same frequencies,
+     * resolution and the current reference settings skip the computation.
+     */
+    virtual void prime_frequency_cache(const std::vector<double> &freqs, double freq_resolution) = 0;
+
+    //! Drop the cached divider settings of all ADF5355 synthesizers
+    virtual void clear_frequency_cache(void) = 0;
+
     virtual void commit(void) = 0;
 };
 
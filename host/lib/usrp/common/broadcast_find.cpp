@@ -0,0 +1,88 @@
+//
+// Copyright 2016 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "broadcast_find.hpp"
+#include <uhd/exception.hpp>
+#include <uhd/transport/if_addrs.hpp>
+#include <boost/asio/ip/address_v4.hpp>
+#include <boost/foreach.hpp>
+#include <boost/bind.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/thread.hpp>
+
+using namespace uhd;
+using namespace uhd::transport;
+
+//! The result of a finder call: either devices or the exception it threw
+struct find_result_t{
+    device_addrs_t addrs;
+    boost::shared_ptr<uhd::exception> error;
+};
+
+static void find_on_interface(
+    const device::find_t &find,
+    const device_addr_t &hint,
+    find_result_t &result
+){
+    try{
+        result.addrs = find(hint);
+    }
+    catch(const uhd::exception &e){
+        result.error.reset(e.dynamic_clone());
+    }
+    catch(const std::exception &e){
+        result.error.reset(new uhd::runtime_error(e.what()));
+    }
+}
+
+std::vector<device_addrs_t> uhd::usrp::find_on_all_interfaces(
+    const device_addr_t &hint,
+    const device::find_t &find
+){
+    //create a hint with the broadcast address of each interface
+    std::vector<device_addr_t> hints;
+    BOOST_FOREACH(const if_addrs_t &if_addrs, get_if_addrs()){
+        //avoid the loopback device
+        if (if_addrs.inet == boost::asio::ip::address_v4::loopback().to_string()) continue;
+
+        device_addr_t new_hint = hint;
+        new_hint["addr"] = if_addrs.bcast;
+        hints.push_back(new_hint);
+    }
+
+    //call discover with each hint
+    std::vector<find_result_t> results(hints.size());
+    if (hints.size() == 1){
+        find_on_interface(find, hints[0], results[0]);
+    }
+    else{
+        boost::thread_group find_threads;
+        for (size_t i = 0; i < hints.size(); i++){
+            find_threads.create_thread(boost::bind(
+                &find_on_interface, boost::cref(find), boost::cref(hints[i]), boost::ref(results[i])
+            ));
+        }
+        find_threads.join_all();
+    }
+
+    std::vector<device_addrs_t> addrs;
+    BOOST_FOREACH(const find_result_t &result, results){
+        if (result.error) result.error->dynamic_throw();
+        addrs.push_back(result.addrs);
+    }
+    return addrs;
+}
@@ -0,0 +1,51 @@
+//
+// Copyright 2016 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef INCLUDED_LIBUHD_USRP_COMMON_BROADCAST_FIND_HPP
+#define INCLUDED_LIBUHD_USRP_COMMON_BROADCAST_FIND_HPP
+
+#include <uhd/config.hpp>
+#include <uhd/device.hpp>
+#include <uhd/types/device_addr.hpp>
+#include <vector>
+
+namespace uhd{ namespace usrp{
+
+    /*!
+     * Discover networked devices on every interface of the host.
+     *
+     * The finder is called once per network interface (except the
+     * loopback interface), with the "addr" key of the hint set to the
+     * interface's broadcast address. The calls run concurrently, so
+     * discovery takes as long as the slowest interface rather than the
+     * sum of the timeouts of all interfaces.
+     *
+     * If a call throws, the exception is rethrown once all calls have
+     * returned.
+     *
+     * \param hint the device hint, without an address
+     * \param find the finder to call, typically the caller itself
+     * \return the devices found on each interface, in interface order
+     */
+    std::vector<device_addrs_t> find_on_all_interfaces(
+        const device_addr_t &hint,
+        const device::find_t &find
+    );
+
+}} //namespace uhd::usrp
+
+#endif /* INCLUDED_LIBUHD_USRP_COMMON_BROADCAST_FIND_HPP */
@@ -0,0 +1,356 @@
+//
+// Copyright 2016 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "eeprom_cache.hpp"
+#include <uhd/exception.hpp>
+#include <uhd/utils/log.hpp>
+#include <uhd/utils/paths.hpp>
+#include <boost/enable_shared_from_this.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/format.hpp>
+#include <boost/interprocess/sync/file_lock.hpp>
+#include <boost/interprocess/sync/scoped_lock.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <fstream>
+#include <map>
+
+using namespace uhd;
+using namespace uhd::usrp;
+namespace fs = boost::filesystem;
+namespace ip = boost::interprocess;
+
+/***********************************************************************
+ * Helper Functions
+ **********************************************************************/
+static std::string to_hex(const byte_vector_t &bytes)
+{
+    static const char digits[] = "0123456789abcdef";
+    std::string hex;
+    hex.reserve(bytes.size() * 2);
+    for (size_t i = 0; i < bytes.size(); i++){
+        hex += digits[bytes[i] >> 4];
+        hex += digits[bytes[i] & 0xf];
+    }
+    return hex;
+}
+
+static int from_hex_digit(const char digit)
+{
+    if (digit >= '0' and digit <= '9') return digit - '0';
+    if (digit >= 'a' and digit <= 'f') return digit - 'a' + 10;
+    return -1;
+}
+
+static bool from_hex(const std::string &hex, byte_vector_t &bytes)
+{
+    if (hex.size() % 2) return false;
+    bytes.resize(hex.size() / 2);
+    for (size_t i = 0; i < bytes.size(); i++){
+        const int hi = from_hex_digit(hex[2*i]);
+        const int lo = from_hex_digit(hex[2*i + 1]);
+        if (hi < 0 or lo < 0) return false;
+        bytes[i] = uint8_t((hi << 4) | lo);
+    }
+    return true;
+}
+
+/***********************************************************************
+ * Cache Implementation
+ **********************************************************************/
+class eeprom_cache_impl :
+    public eeprom_cache, public boost::enable_shared_from_this<eeprom_cache_impl>
+{
+public:
+    typedef std::map<std::string, byte_vector_t> entries_t;
+
+    eeprom_cache_impl(const std::string &path):
+        _path(path)
+    {
+        /* NOP */
+    }
+
+    i2c_iface::sptr make_iface(
+        i2c_iface::sptr iface,
+        const std::string &tag,
+        const size_t num_id_bytes,
+        const size_t checksum_offset,
+        const mode_t mode
+    );
+
+    bool lookup(const std::string &key, byte_vector_t &bytes)
+    {
+        boost::mutex::scoped_lock lock(_mutex);
+        const entries_t entries = load();
+        entries_t::const_iterator it = entries.find(key);
+        if (it == entries.end()) return false;
+        bytes = it->second;
+        return true;
+    }
+
+    void store(const std::string &key, const byte_vector_t &bytes)
+    {
+        boost::mutex::scoped_lock lock(_mutex);
+        boost::scoped_ptr<ip::file_lock> file_lock(lock_file());
+        if (not file_lock) return;
+        ip::scoped_lock<ip::file_lock> file_guard(*file_lock);
+        entries_t entries = load();
+        entries[key] = bytes;
+        save(entries);
+    }
+
+    void invalidate(const std::string &tag)
+    {
+        boost::mutex::scoped_lock lock(_mutex);
+        boost::scoped_ptr<ip::file_lock> file_lock(lock_file());
+        if (not file_lock) return;
+        ip::scoped_lock<ip::file_lock> file_guard(*file_lock);
+        entries_t entries = load();
+        const std::string prefix = tag + "|";
+        entries_t::iterator it = entries.lower_bound(prefix);
+        if (it == entries.end() or it->first.compare(0, prefix.size(), prefix) != 0) return;
+        while (it != entries.end() and it->first.compare(0, prefix.size(), prefix) == 0){
+            entries.erase(it++);
+        }
+        save(entries);
+    }
+
+    void clear(void)
+    {
+        boost::mutex::scoped_lock lock(_mutex);
+        boost::scoped_ptr<ip::file_lock> file_lock(lock_file());
+        if (not file_lock) return;
+        ip::scoped_lock<ip::file_lock> file_guard(*file_lock);
+        boost::system::error_code ec;
+        fs::remove(fs::path(_path), ec);
+    }
+
+    size_t size(void)
+    {
+        boost::mutex::scoped_lock lock(_mutex);
+        return load().size();
+    }
+
+private:
+    /*!
+     * Read the entries from the cache file, the caller holds the mutex.
+     * The file is read on every access, so that changes made by other
+     * processes are seen. It is replaced atomically, so reading it needs
+     * no file lock.
+     */
+    entries_t load(void) const
+    {
+        //one entry per line: the key, a tab and the contents in hex
+        entries_t entries;
+        std::ifstream file(_path.c_str());
+        std::string line;
+        while (std::getline(file, line)){
+            const size_t sep = line.rfind('\t');
+            if (sep == std::string::npos) continue;
+            byte_vector_t bytes;
+            if (not from_hex(line.substr(sep + 1), bytes)) continue;
+            entries[line.substr(0, sep)] = bytes;
+        }
+        return entries;
+    }
+
+    /*!
+     * Make the lock which serializes changes to the cache file between
+     * processes, or return NULL if the cache directory is not writable.
+     * A change holds the lock from reading the file until it is replaced,
+     * so no process overwrites the changes of another one.
+     */
+    ip::file_lock *lock_file(void) const
+    {
+        const fs::path path(_path);
+        const std::string lock_path = _path + ".lock";
+        try{
+            if (path.has_parent_path()) fs::create_directories(path.parent_path());
+            std::ofstream lock_file(lock_path.c_str(), std::ofstream::app);
+            return new ip::file_lock(lock_path.c_str());
+        }
+        catch (const std::exception &e){
+            UHD_LOG << "Cannot lock the EEPROM cache " << _path << ": " << e.what() << std::endl;
+            return NULL;
+        }
+    }
+
+    //! Replace the cache file with the entries, the caller holds the file lock
+    void save(const entries_t &entries) const
+    {
+        //write a new file and move it over the old one, so that other
+        //processes never read a partially written cache
+        const fs::path path(_path);
+        fs::path tmp_path;
+        try{
+            tmp_path = fs::unique_path(path.string() + ".%%%%%%%%");
+            std::ofstream file(tmp_path.string().c_str());
+            for (entries_t::const_iterator it = entries.begin(); it != entries.end(); ++it){
+                file << it->first << '\t' << to_hex(it->second) << '\n';
+            }
+            file.close();
+            if (not file) throw uhd::os_error("write failed");
+            fs::rename(tmp_path, path);
+        }
+        catch (const std::exception &e){
+            UHD_LOG << "Cannot update the EEPROM cache " << _path << ": " << e.what() << std::endl;
+            boost::system::error_code ec;
+            if (not tmp_path.empty()) fs::remove(tmp_path, ec);
+        }
+    }
+
+    const std::string _path;
+    boost::mutex _mutex;
+};
+
+/***********************************************************************
+ * Caching I2C Interface
+ **********************************************************************/
+class eeprom_cache_iface : public i2c_iface
+{
+public:
+    eeprom_cache_iface(
+        boost::shared_ptr<eeprom_cache_impl> cache,
+        i2c_iface::sptr iface,
+        const std::string &tag,
+        const size_t num_id_bytes,
+        const size_t checksum_offset,
+        const eeprom_cache::mode_t mode
+    ):
+        _cache(cache), _iface(iface), _tag(tag),
+        _num_id_bytes(num_id_bytes), _checksum_offset(checksum_offset), _mode(mode)
+    {
+        /* NOP */
+    }
+
+    void write_i2c(uint16_t addr, const byte_vector_t &buf)
+    {
+        _iface->write_i2c(addr, buf);
+    }
+
+    byte_vector_t read_i2c(uint16_t addr, size_t num_bytes)
+    {
+        return _iface->read_i2c(addr, num_bytes);
+    }
+
+    void write_eeprom(uint16_t addr, uint16_t offset, const byte_vector_t &buf)
+    {
+        _cache->invalidate(_tag);
+        _iface->write_eeprom(addr, offset, buf);
+    }
+
+    byte_vector_t read_eeprom(uint16_t addr, uint16_t offset, size_t num_bytes)
+    {
+        //only bytes covered by the checksum are cached, and only reads
+        //longer than the bytes which validate the cached contents
+        if (
+            _mode == eeprom_cache::CACHE_OFF
+            or offset + num_bytes > _checksum_offset + 1
+            or num_bytes <= _num_id_bytes + 1
+        ){
+            return _iface->read_eeprom(addr, offset, num_bytes);
+        }
+
+        //the identifying bytes and the checksum are always read from the EEPROM
+        byte_vector_t check = _iface->read_eeprom(addr, 0, _num_id_bytes);
+        const byte_vector_t checksum = _iface->read_eeprom(addr, uint16_t(_checksum_offset), 1);
+        if (check.size() != _num_id_bytes or checksum.size() != 1){
+            return _iface->read_eeprom(addr, offset, num_bytes);
+        }
+        check.push_back(checksum.front());
+
+        const std::string key = str(boost::format("%s|%02x|%u|%u|%s")
+            % _tag % addr % offset % num_bytes % to_hex(check)
+        );
+        byte_vector_t bytes;
+        if (_mode == eeprom_cache::CACHE_ON and _cache->lookup(key, bytes)){
+            return bytes;
+        }
+
+        //read the whole range at once: interfaces which read in words
+        //cannot start in the middle of one, and only cache contents which
+        //agree with the bytes of the key they overlap
+        bytes = _iface->read_eeprom(addr, offset, num_bytes);
+        if (bytes.size() == num_bytes and matches(check, offset, bytes)){
+            _cache->store(key, bytes);
+        }
+        return bytes;
+    }
+
+private:
+    //! True if the bytes read at an offset agree with the identifying bytes and checksum
+    bool matches(const byte_vector_t &check, const size_t offset, const byte_vector_t &bytes) const
+    {
+        for (size_t i = 0; i < check.size(); i++){
+            const size_t pos = (i < _num_id_bytes)? i : _checksum_offset;
+            if (pos < offset or pos >= offset + bytes.size()) continue;
+            if (bytes[pos - offset] != check[i]) return false;
+        }
+        return true;
+    }
+
+    boost::shared_ptr<eeprom_cache_impl> _cache;
+    i2c_iface::sptr _iface;
+    const std::string _tag;
+    const size_t _num_id_bytes;
+    const size_t _checksum_offset;
+    const eeprom_cache::mode_t _mode;
+};
+
+i2c_iface::sptr eeprom_cache_impl::make_iface(
+    i2c_iface::sptr iface,
+    const std::string &tag,
+    const size_t num_id_bytes,
+    const size_t checksum_offset,
+    const mode_t mode
+){
+    return boost::make_shared<eeprom_cache_iface>(
+        shared_from_this(), iface, tag, num_id_bytes, checksum_offset, mode
+    );
+}
+
+/***********************************************************************
+ * Factories
+ **********************************************************************/
+eeprom_cache::~eeprom_cache(void){
+    /* NOP */
+}
+
+eeprom_cache::mode_t eeprom_cache::get_mode(const device_addr_t &args){
+    if (not args.has_key("eeprom_cache")) return CACHE_OFF;
+    const std::string mode = args["eeprom_cache"];
+    if (mode.empty() or mode == "on") return CACHE_ON;
+    if (mode == "off") return CACHE_OFF;
+    if (mode == "refresh") return CACHE_REFRESH;
+    throw uhd::value_error("Invalid eeprom_cache mode (expected on, off or refresh): " + mode);
+}
+
+eeprom_cache::sptr eeprom_cache::make(const std::string &path){
+    return boost::make_shared<eeprom_cache_impl>(path);
+}
+
+static eeprom_cache::sptr make_user_eeprom_cache(void){
+    return eeprom_cache::make(
+        (fs::path(uhd::get_app_path()) / ".uhd" / "cache" / "eeprom").string()
+    );
+}
+
+eeprom_cache::sptr eeprom_cache::get(void){
+    static eeprom_cache::sptr cache = make_user_eeprom_cache();
+    return cache;
+}
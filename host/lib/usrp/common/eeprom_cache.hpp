@@ -0,0 +1,111 @@
+//
+// Copyright 2016 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef INCLUDED_LIBUHD_USRP_COMMON_EEPROM_CACHE_HPP
+#define INCLUDED_LIBUHD_USRP_COMMON_EEPROM_CACHE_HPP
+
+#include <uhd/config.hpp>
+#include <uhd/types/device_addr.hpp>
+#include <uhd/types/serial.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <string>
+
+namespace uhd{ namespace usrp{
+
+    /*!
+     * An on-disk cache of EEPROM contents, so that devices do not have to
+     * read them over a slow bus every time they are opened.
+     *
+     * Only EEPROMs with a checksum byte are cached. Cached contents are
+     * keyed by a tag, which names the device type and the firmware and FPGA
+     * images it runs, by the location of the read, by the first bytes of
+     * the contents, which identify the board, and by the checksum. A cached
+     * read still reads the identifying bytes and the checksum from the
+     * EEPROM, and only returns cached contents when they match, so contents
+     * changed by another host or tool are read again.
+     *
+     * The cache file is read on every access and changed under a file lock,
+     * so that processes which share it do not undo each other's changes.
+     *
+     * The cache is opt-in, with the "eeprom_cache" device argument:
+     * "eeprom_cache" or "eeprom_cache=on" uses cached contents,
+     * "eeprom_cache=refresh" reads all contents from the EEPROMs and
+     * replaces the cached ones, "eeprom_cache=off" disables the cache.
+     */
+    class eeprom_cache : boost::noncopyable{
+    public:
+        typedef boost::shared_ptr<eeprom_cache> sptr;
+
+        enum mode_t{
+            //! Read from the EEPROMs, writes still invalidate cached contents
+            CACHE_OFF,
+            //! Use cached contents when they match
+            CACHE_ON,
+            //! Read from the EEPROMs and replace cached contents
+            CACHE_REFRESH
+        };
+
+        /*!
+         * Get the mode the device arguments ask for.
+         * \throws uhd::value_error if the mode is not on, off or refresh
+         */
+        static mode_t get_mode(const device_addr_t &args);
+
+        //! Get the cache of this user, stored in the UHD application directory
+        static sptr get(void);
+
+        //! Make a cache stored in the given file
+        static sptr make(const std::string &path);
+
+        virtual ~eeprom_cache(void) = 0;
+
+        /*!
+         * Make an interface that serves the EEPROM reads of another one
+         * from this cache. All other calls are passed on, and EEPROM
+         * writes invalidate the cached contents of the tag. Only reads of
+         * bytes covered by the checksum are cached, reads of no more than
+         * the identifying bytes and the checksum always go to the EEPROM.
+         * \param iface the interface to the bus with the EEPROMs
+         * \param tag names the device type and its firmware and FPGA images
+         * \param num_id_bytes the number of leading bytes that identify the board
+         * \param checksum_offset the offset of the checksum byte, which covers
+         *        all bytes before it
+         * \param mode how reads use the cache
+         * \return a new i2c interface
+         */
+        virtual i2c_iface::sptr make_iface(
+            i2c_iface::sptr iface,
+            const std::string &tag,
+            const size_t num_id_bytes,
+            const size_t checksum_offset,
+            const mode_t mode
+        ) = 0;
+
+        //! Drop all cached contents of a tag
+        virtual void invalidate(const std::string &tag) = 0;
+
+        //! Drop all cached contents
+        virtual void clear(void) = 0;
+
+        //! Number of cached contents
+        virtual size_t size(void) = 0;
+    };
+
+}} //namespace uhd::usrp
+
+#endif /* INCLUDED_LIBUHD_USRP_COMMON_EEPROM_CACHE_HPP */
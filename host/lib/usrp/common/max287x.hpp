@@ -28,8 +28,10 @@
 #include <boost/function.hpp>
 #include <boost/thread.hpp>
 #include <boost/math/special_functions/round.hpp>
+#include <boost/foreach.hpp>
 #include <stdint.h>
 #include <vector>
+#include "settings_cache.hpp"
 #include "max2870_regs.hpp"
 #include "max2871_regs.hpp"
 
@@ -156,6 +158,26 @@ public:
                 double target_pfd_freq,
                 bool is_int_n) = 0;
 
+    /**
+     * Drop the cached divider settings of all synthesizers of this type.
+     */
+    virtual void clear_frequency_cache(void) = 0;
+
+    /**
+     * Compute and cache the divider settings for a list of frequencies
+     * so later calls to set_frequency() with the same arguments skip
+     * the divider search.
+     * @param freqs target frequencies
+     * @param ref_freq reference frequency
+     * @param target_pfd_freq target phase detector frequency
+     * @param is_int_n enable integer-N tuning
+     */
+    virtual void prime_frequency_cache(
+                const std::vector<double> &freqs,
+                double ref_freq,
+                double target_pfd_freq,
+                bool is_int_n) = 0;
+
     /**
      * Set output power
      * @param power output power
@@ -244,6 +266,12 @@ public:
         double ref_freq,
         double target_pfd_freq,
         bool is_int_n);
+    virtual void prime_frequency_cache(
+        const std::vector<double> &freqs,
+        double ref_freq,
+        double target_pfd_freq,
+        bool is_int_n);
+    virtual void clear_frequency_cache(void);
     virtual void set_output_power(output_power_t power);
     virtual void set_ld_pin_mode(ld_pin_mode_t mode);
     virtual void set_muxout_mode(muxout_mode_t mode);
@@ -258,6 +286,63 @@ public:
     virtual void config_for_sync(bool enable);
 
 protected:
+    //! Inputs to the divider search, used as the tune cache key
+    struct tune_key_t
+    {
+        double target_freq;
+        double ref_freq;
+        double target_pfd_freq;
+        bool is_int_n;
+        bool feedback_divided;
+
+        bool operator==(const tune_key_t &rhs) const
+        {
+            return target_freq == rhs.target_freq
+                and ref_freq == rhs.ref_freq
+                and target_pfd_freq == rhs.target_pfd_freq
+                and is_int_n == rhs.is_int_n
+                and feedback_divided == rhs.feedback_divided;
+        }
+
+        friend size_t hash_value(const tune_key_t &key)
+        {
+            size_t seed = 0;
+            boost::hash_combine(seed, key.target_freq);
+            boost::hash_combine(seed, key.ref_freq);
+            boost::hash_combine(seed, key.target_pfd_freq);
+            boost::hash_combine(seed, key.is_int_n);
+            boost::hash_combine(seed, key.feedback_divided);
+            return seed;
+        }
+    };
+
+    //! Results of the divider search
+    struct tune_settings_t
+    {
+        int T, D, R, BS, N, FRAC, MOD, RFdiv, fb_divisor;
+        double vco_freq, pfd_freq, actual_freq;
+    };
+
+    typedef uhd::usrp::settings_cache<tune_key_t, tune_settings_t> tune_cache_t;
+
+    //! One cache per chip type, shared by all instances
+    static tune_cache_t& _get_tune_cache();
+
+    /**
+     * Whether the feedback path is taken after the output divider
+     * when tuning to the given frequency.
+     * @param target_freq target frequency
+     */
+    virtual bool _is_feedback_divided(double target_freq);
+
+    tune_settings_t _get_tune_settings(
+        double target_freq,
+        double ref_freq,
+        double target_pfd_freq,
+        bool is_int_n);
+
+    static tune_settings_t _compute_tune_settings(const tune_key_t &key);
+
     max287x_regs_t _regs;
     bool _can_sync;
     bool _config_for_sync;
@@ -283,7 +368,7 @@ public:
         bool is_int_n)
     {
         _regs.cpoc = is_int_n ? max2870_regs_t::CPOC_ENABLED : max2870_regs_t::CPOC_DISABLED;
-        _regs.feedback_select = target_freq >= 3.0e9 ?
+        _regs.feedback_select = _is_feedback_divided(target_freq) ?
             max2870_regs_t::FEEDBACK_SELECT_DIVIDED :
             max2870_regs_t::FEEDBACK_SELECT_FUNDAMENTAL;
 
@@ -295,6 +380,12 @@ public:
         _write_all_regs = true;
         max287x<max2870_regs_t>::commit();
     }
+
+protected:
+    bool _is_feedback_divided(double target_freq)
+    {
+        return target_freq >= 3.0e9;
+    }
 };
 
 /**
@@ -453,6 +544,12 @@ public:
             _can_sync = false;
         }
     }
+
+protected:
+    bool _is_feedback_divided(double)
+    {
+        return true;
+    }
 };
 
 
@@ -536,17 +633,136 @@ double max287x<max287x_regs_t>::set_frequency(
         (64,  max287x_regs_t::RF_DIVIDER_SELECT_DIV64)
         (128, max287x_regs_t::RF_DIVIDER_SELECT_DIV128);
 
+    static const uhd::range_t clock_div_range(1,4095,1);
+
+    //Divider search, or its cached result for identical inputs
+    const tune_settings_t s = _get_tune_settings(target_freq, ref_freq, target_pfd_freq, is_int_n);
+
+    UHD_LOGV(rarely)
+        << boost::format("MAX287x: Intermediates: ref=%0.2f, outdiv=%f, fbdiv=%f"
+            ) % ref_freq % double(s.RFdiv*2) % double(s.N + double(s.FRAC)/double(s.MOD)) << std::endl
+        << boost::format("MAX287x: tune: R=%d, BS=%d, N=%d, FRAC=%d, MOD=%d, T=%d, D=%d, RFdiv=%d, type=%s"
+            ) % s.R % s.BS % s.N % s.FRAC % s.MOD % s.T % s.D % s.RFdiv % ((is_int_n) ? "Integer-N" : "Fractional") << std::endl
+        << boost::format("MAX287x: Frequencies (MHz): REQ=%0.2f, ACT=%0.2f, VCO=%0.2f, PFD=%0.2f, BAND=%0.2f"
+            ) % (target_freq/1e6) % (s.actual_freq/1e6) % (s.vco_freq/1e6) % (s.pfd_freq/1e6) % (s.pfd_freq/s.BS/1e6) << std::endl;
+
+    //load the register values
+    _regs.rf_output_enable = max287x_regs_t::RF_OUTPUT_ENABLE_ENABLED;
+
+    if(is_int_n) {
+        _regs.cpl = max287x_regs_t::CPL_DISABLED;
+        _regs.ldf = max287x_regs_t::LDF_INT_N;
+        _regs.int_n_mode = max287x_regs_t::INT_N_MODE_INT_N;
+    } else {
+        _regs.cpl = max287x_regs_t::CPL_ENABLED;
+        _regs.ldf = max287x_regs_t::LDF_FRAC_N;
+        _regs.int_n_mode = max287x_regs_t::INT_N_MODE_FRAC_N;
+    }
+
+    _regs.lds = s.pfd_freq <= 32e6 ? max287x_regs_t::LDS_SLOW : max287x_regs_t::LDS_FAST;
+
+    _regs.frac_12_bit = s.FRAC;
+    _regs.int_16_bit = s.N;
+    _regs.mod_12_bit = s.MOD;
+    _regs.clock_divider_12_bit = std::max(int(clock_div_range.start()), int(std::ceil(400e-6*s.pfd_freq/s.MOD)));
+    UHD_ASSERT_THROW(_regs.clock_divider_12_bit <= clock_div_range.stop());
+    _regs.r_counter_10_bit = s.R;
+    _regs.reference_divide_by_2 = s.T ?
+        max287x_regs_t::REFERENCE_DIVIDE_BY_2_ENABLED :
+        max287x_regs_t::REFERENCE_DIVIDE_BY_2_DISABLED;
+    _regs.reference_doubler = s.D ?
+        max287x_regs_t::REFERENCE_DOUBLER_ENABLED :
+        max287x_regs_t::REFERENCE_DOUBLER_DISABLED;
+    _regs.band_select_clock_div = s.BS & 0xFF;
+    _regs.bs_msb = (s.BS & 0x300) >> 8;
+    UHD_ASSERT_THROW(rfdivsel_to_enum.has_key(s.RFdiv));
+    _regs.rf_divider_select = rfdivsel_to_enum[s.RFdiv];
+
+    if (_regs.clock_div_mode == max287x_regs_t::CLOCK_DIV_MODE_FAST_LOCK)
+    {
+        // Charge pump current needs to be set to lowest value in fast lock mode
+        _regs.charge_pump_current = max287x_regs_t::CHARGE_PUMP_CURRENT_0_32MA;
+        // Make sure the register containing the charge pump current is written
+        _write_all_regs = true;
+    }
+
+    return s.actual_freq;
+}
+
+template <typename max287x_regs_t>
+void max287x<max287x_regs_t>::prime_frequency_cache(
+    const std::vector<double> &freqs,
+    double ref_freq,
+    double target_pfd_freq,
+    bool is_int_n)
+{
+    BOOST_FOREACH(const double freq, freqs)
+    {
+        _get_tune_settings(freq, ref_freq, target_pfd_freq, is_int_n);
+    }
+}
+
+template <typename max287x_regs_t>
+void max287x<max287x_regs_t>::clear_frequency_cache(void)
+{
+    _get_tune_cache().clear();
+}
+
+template <typename max287x_regs_t>
+typename max287x<max287x_regs_t>::tune_cache_t& max287x<max287x_regs_t>::_get_tune_cache()
+{
+    static tune_cache_t cache;
+    return cache;
+}
+
+template <typename max287x_regs_t>
+bool max287x<max287x_regs_t>::_is_feedback_divided(double)
+{
+    return (_regs.feedback_select == max287x_regs_t::FEEDBACK_SELECT_DIVIDED);
+}
+
+template <typename max287x_regs_t>
+typename max287x<max287x_regs_t>::tune_settings_t max287x<max287x_regs_t>::_get_tune_settings(
+    double target_freq,
+    double ref_freq,
+    double target_pfd_freq,
+    bool is_int_n)
+{
+    tune_key_t key;
+    key.target_freq = target_freq;
+    key.ref_freq = ref_freq;
+    key.target_pfd_freq = target_pfd_freq;
+    key.is_int_n = is_int_n;
+    key.feedback_divided = _is_feedback_divided(target_freq);
+
+    tune_settings_t s;
+    if (not _get_tune_cache().lookup(key, s))
+    {
+        s = _compute_tune_settings(key);
+        _get_tune_cache().store(key, s);
+    }
+    return s;
+}
+
+template <typename max287x_regs_t>
+typename max287x<max287x_regs_t>::tune_settings_t max287x<max287x_regs_t>::_compute_tune_settings(
+    const tune_key_t &key)
+{
     //map mode setting to valid integer divider (N) values
     static const uhd::range_t int_n_mode_div_range(16,65535,1);
     static const uhd::range_t frac_n_mode_div_range(19,4091,1);
 
     //other ranges and constants from MAX287X datasheets
-    static const uhd::range_t clock_div_range(1,4095,1);
     static const uhd::range_t r_range(1,1023,1);
     static const double MIN_VCO_FREQ = 3e9;
     static const double BS_FREQ = 50e3;
     static const int MAX_BS_VALUE = 1023;
 
+    const double target_freq = key.target_freq;
+    const double ref_freq = key.ref_freq;
+    const double target_pfd_freq = key.target_pfd_freq;
+    const bool is_int_n = key.is_int_n;
+
     int T = 0;
     int D = ref_freq <= 10.0e6 ? 1 : 0;
     int R = 0;
@@ -556,7 +772,7 @@ double max287x<max287x_regs_t>::set_frequency(
     int MOD = 4095;
     int RFdiv = 1;
     double pfd_freq = target_pfd_freq;
-    bool feedback_divided = (_regs.feedback_select == max287x_regs_t::FEEDBACK_SELECT_DIVIDED);
+    bool feedback_divided = key.feedback_divided;
 
     //increase RF divider until acceptable VCO frequency (MIN freq for MAX287x VCO is 3GHz)
     UHD_ASSERT_THROW(target_freq > 0);
@@ -635,58 +851,23 @@ double max287x<max287x_regs_t>::set_frequency(
         R /= 2;
     }
 
-    //actual frequency calculation
-    double actual_freq = double((N + (double(FRAC)/double(MOD)))*ref_freq*(1+int(D))/(R*(1+int(T)))) * fb_divisor / RFdiv;
-
-    UHD_LOGV(rarely)
-        << boost::format("MAX287x: Intermediates: ref=%0.2f, outdiv=%f, fbdiv=%f"
-            ) % ref_freq % double(RFdiv*2) % double(N + double(FRAC)/double(MOD)) << std::endl
-        << boost::format("MAX287x: tune: R=%d, BS=%d, N=%d, FRAC=%d, MOD=%d, T=%d, D=%d, RFdiv=%d, type=%s"
-            ) % R % BS % N % FRAC % MOD % T % D % RFdiv % ((is_int_n) ? "Integer-N" : "Fractional") << std::endl
-        << boost::format("MAX287x: Frequencies (MHz): REQ=%0.2f, ACT=%0.2f, VCO=%0.2f, PFD=%0.2f, BAND=%0.2f"
-            ) % (target_freq/1e6) % (actual_freq/1e6) % (vco_freq/1e6) % (pfd_freq/1e6) % (pfd_freq/BS/1e6) << std::endl;
-
-    //load the register values
-    _regs.rf_output_enable = max287x_regs_t::RF_OUTPUT_ENABLE_ENABLED;
-
-    if(is_int_n) {
-        _regs.cpl = max287x_regs_t::CPL_DISABLED;
-        _regs.ldf = max287x_regs_t::LDF_INT_N;
-        _regs.int_n_mode = max287x_regs_t::INT_N_MODE_INT_N;
-    } else {
-        _regs.cpl = max287x_regs_t::CPL_ENABLED;
-        _regs.ldf = max287x_regs_t::LDF_FRAC_N;
-        _regs.int_n_mode = max287x_regs_t::INT_N_MODE_FRAC_N;
-    }
-
-    _regs.lds = pfd_freq <= 32e6 ? max287x_regs_t::LDS_SLOW : max287x_regs_t::LDS_FAST;
+    tune_settings_t s;
+    s.T = T;
+    s.D = D;
+    s.R = R;
+    s.BS = BS;
+    s.N = N;
+    s.FRAC = FRAC;
+    s.MOD = MOD;
+    s.RFdiv = RFdiv;
+    s.fb_divisor = fb_divisor;
+    s.vco_freq = vco_freq;
+    s.pfd_freq = pfd_freq;
 
-    _regs.frac_12_bit = FRAC;
-    _regs.int_16_bit = N;
-    _regs.mod_12_bit = MOD;
-    _regs.clock_divider_12_bit = std::max(int(clock_div_range.start()), int(std::ceil(400e-6*pfd_freq/MOD)));
-    UHD_ASSERT_THROW(_regs.clock_divider_12_bit <= clock_div_range.stop());
-    _regs.r_counter_10_bit = R;
-    _regs.reference_divide_by_2 = T ?
-        max287x_regs_t::REFERENCE_DIVIDE_BY_2_ENABLED :
-        max287x_regs_t::REFERENCE_DIVIDE_BY_2_DISABLED;
-    _regs.reference_doubler = D ?
-        max287x_regs_t::REFERENCE_DOUBLER_ENABLED :
-        max287x_regs_t::REFERENCE_DOUBLER_DISABLED;
-    _regs.band_select_clock_div = BS & 0xFF;
-    _regs.bs_msb = (BS & 0x300) >> 8;
-    UHD_ASSERT_THROW(rfdivsel_to_enum.has_key(RFdiv));
-    _regs.rf_divider_select = rfdivsel_to_enum[RFdiv];
-
-    if (_regs.clock_div_mode == max287x_regs_t::CLOCK_DIV_MODE_FAST_LOCK)
-    {
-        // Charge pump current needs to be set to lowest value in fast lock mode
-        _regs.charge_pump_current = max287x_regs_t::CHARGE_PUMP_CURRENT_0_32MA;
-        // Make sure the register containing the charge pump current is written
-        _write_all_regs = true;
-    }
+    //actual frequency calculation
+    s.actual_freq = double((N + (double(FRAC)/double(MOD)))*ref_freq*(1+int(D))/(R*(1+int(T)))) * fb_divisor / RFdiv;
 
-    return actual_freq;
+    return s;
 }
 
 template <typename max287x_regs_t>
@@ -0,0 +1,84 @@
+//
+// Copyright 2016 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef INCLUDED_LIBUHD_USRP_COMMON_MBOARD_SETUP_HPP
+#define INCLUDED_LIBUHD_USRP_COMMON_MBOARD_SETUP_HPP
+
+#include <uhd/exception.hpp>
+#include <uhd/types/device_addr.hpp>
+#include <boost/bind.hpp>
+#include <boost/foreach.hpp>
+#include <boost/function.hpp>
+#include <boost/ref.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/thread.hpp>
+#include <exception>
+#include <vector>
+
+namespace uhd { namespace usrp {
+
+    //! A setup step for one motherboard: motherboard index and its arguments
+    typedef boost::function<void(const size_t, const device_addr_t &)> mb_setup_t;
+
+    //! Run a setup step for one motherboard, keeping the exception it threw
+    static inline void setup_mboard(
+        const mb_setup_t &setup,
+        const size_t mb_i,
+        const device_addr_t &dev_addr,
+        boost::shared_ptr<uhd::exception> &error
+    ){
+        try {
+            setup(mb_i, dev_addr);
+        }
+        catch (const uhd::exception &e) {
+            error.reset(e.dynamic_clone());
+        }
+        catch (const std::exception &e) {
+            error.reset(new uhd::runtime_error(e.what()));
+        }
+    }
+
+    /*!
+     * Run a setup step for all motherboards at the same time, so that their
+     * clock lock and calibration waits overlap. If any of them fails, the
+     * error of the first failing motherboard is thrown once all are done.
+     * A single motherboard is set up in the calling thread.
+     */
+    static inline void setup_mboards(const mb_setup_t &setup, const device_addrs_t &device_args)
+    {
+        if (device_args.size() == 1) {
+            setup(0, device_args[0]);
+            return;
+        }
+
+        std::vector<boost::shared_ptr<uhd::exception> > errors(device_args.size());
+        boost::thread_group setup_threads;
+        for (size_t i = 0; i < device_args.size(); i++) {
+            setup_threads.create_thread(boost::bind(
+                &setup_mboard, boost::cref(setup), i, boost::cref(device_args[i]), boost::ref(errors[i])
+            ));
+        }
+        setup_threads.join_all();
+
+        BOOST_FOREACH(const boost::shared_ptr<uhd::exception> &error, errors) {
+            if (error) error->dynamic_throw();
+        }
+    }
+
+}} //namespace uhd::usrp
+
+#endif /* INCLUDED_LIBUHD_USRP_COMMON_MBOARD_SETUP_HPP */
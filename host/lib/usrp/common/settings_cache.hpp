@@ -0,0 +1,150 @@
+//
+// Copyright 2016 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef INCLUDED_LIBUHD_USRP_COMMON_SETTINGS_CACHE_HPP
+#define INCLUDED_LIBUHD_USRP_COMMON_SETTINGS_CACHE_HPP
+
+#include <boost/noncopyable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/functional/hash.hpp>
+#include <list>
+#include <utility>
+#include <stddef.h>
+
+namespace uhd { namespace usrp {
+
+    /*!
+     * A bounded, thread-safe cache of computed chip settings.
+     *
+     * Drivers that derive register values from a search over dividers
+     * (synthesizers, clock trees) can memoize the result of that search
+     * here, keyed by all of the inputs that went into it. When the cache
+     * is full, the least recently used entry is dropped.
+     *
+     * The key type must be hashable with boost::hash (i.e. provide a
+     * hash_value() overload) and comparable with operator==.
+     */
+    template <typename key_t, typename settings_t>
+    class settings_cache : boost::noncopyable
+    {
+    public:
+        static const size_t DEFAULT_CAPACITY = 4096;
+
+        settings_cache(const size_t capacity = DEFAULT_CAPACITY) :
+            _capacity(capacity), _hits(0), _misses(0)
+        {
+            /* NOP */
+        }
+
+        /*!
+         * Look up the settings for a key.
+         * \param key the inputs to the computation
+         * \param settings filled in on a hit, untouched otherwise
+         * \return true if the key was found in the cache
+         */
+        bool lookup(const key_t &key, settings_t &settings)
+        {
+            boost::mutex::scoped_lock lock(_mutex);
+            typename index_t::iterator it = _index.find(key);
+            if (it == _index.end()) {
+                _misses++;
+                return false;
+            }
+            //move the entry to the front of the usage list
+            _entries.splice(_entries.begin(), _entries, it->second);
+            settings = it->second->second;
+            _hits++;
+            return true;
+        }
+
+        /*!
+         * Store the settings computed for a key.
+         * An existing entry for the same key is replaced.
+         */
+        void store(const key_t &key, const settings_t &settings)
+        {
+            boost::mutex::scoped_lock lock(_mutex);
+            if (_capacity == 0) return;
+            typename index_t::iterator it = _index.find(key);
+            if (it != _index.end()) {
+                it->second->second = settings;
+                _entries.splice(_entries.begin(), _entries, it->second);
+                return;
+            }
+            if (_index.size() >= _capacity) {
+                _index.erase(_entries.back().first);
+                _entries.pop_back();
+            }
+            _entries.push_front(std::make_pair(key, settings));
+            _index[key] = _entries.begin();
+        }
+
+        //! Drop all entries and reset the statistics
+        void clear(void)
+        {
+            boost::mutex::scoped_lock lock(_mutex);
+            _index.clear();
+            _entries.clear();
+            _hits = 0;
+            _misses = 0;
+        }
+
+        //! Change the maximum number of entries, evicting as needed
+        void set_capacity(const size_t capacity)
+        {
+            boost::mutex::scoped_lock lock(_mutex);
+            _capacity = capacity;
+            while (_index.size() > _capacity) {
+                _index.erase(_entries.back().first);
+                _entries.pop_back();
+            }
+        }
+
+        size_t size(void)
+        {
+            boost::mutex::scoped_lock lock(_mutex);
+            return _index.size();
+        }
+
+        size_t get_hits(void)
+        {
+            boost::mutex::scoped_lock lock(_mutex);
+            return _hits;
+        }
+
+        size_t get_misses(void)
+        {
+            boost::mutex::scoped_lock lock(_mutex);
+            return _misses;
+        }
+
+    private:
+        typedef std::list<std::pair<key_t, settings_t> > entries_t;
+        typedef boost::unordered_map<key_t, typename entries_t::iterator, boost::hash<key_t> > index_t;
+
+        boost::mutex _mutex;
+        size_t       _capacity;
+        entries_t    _entries;
+        index_t      _index;
+        size_t       _hits;
+        size_t       _misses;
+    };
+
+}} //namespace uhd::usrp
+
+#endif /* INCLUDED_LIBUHD_USRP_COMMON_SETTINGS_CACHE_HPP */
@@ -28,6 +28,7 @@
 #include <boost/bind.hpp>
 #include <boost/foreach.hpp>
 #include <boost/assign/list_of.hpp>
+#include <boost/functional/hash.hpp>
 
 using namespace uhd;
 using namespace uhd::usrp;
@@ -80,6 +81,23 @@ bool operator==(const dboard_key_t &lhs, const dboard_key_t &rhs){
     return false;
 }
 
+size_t hash_value(const dboard_key_t &key){
+    size_t seed = 0;
+    boost::hash_combine(seed, key.is_xcvr());
+    if (key.is_xcvr()){
+        boost::hash_combine(seed, key.rx_id().to_uint16());
+        boost::hash_combine(seed, key.tx_id().to_uint16());
+    }
+    else{
+        boost::hash_combine(seed, key.xx_id().to_uint16());
+    }
+    return seed;
+}
+
+namespace uhd{
+    template <> struct dict_key_hashable<dboard_key_t> : boost::true_type{};
+}
+
 /***********************************************************************
  * storage and registering for dboards
  **********************************************************************/
@@ -27,6 +27,7 @@
 #include "../common/async_packet_handler.hpp"
 #include "../../transport/super_recv_packet_handler.hpp"
 #include "../../transport/super_send_packet_handler.hpp"
+#include "../../transport/readiness_fd.hpp"
 #include "../../rfnoc/rx_stream_terminator.hpp"
 #include "../../rfnoc/tx_stream_terminator.hpp"
 #include <uhd/rfnoc/rate_node_ctrl.hpp>
@@ -309,6 +310,8 @@ struct tx_fc_cache_t
 
     size_t last_seq_ack;
     size_t space;
+    readiness_fd::sptr space_fd; //readable while there is space, when requested
+    readiness_set::sptr ready; //space or a flow control message, when requested
 };
 
 /*! Return the size of the flow control window in packets.
@@ -348,6 +351,7 @@ static bool tx_flow_ctrl(
         {
             // All is good - packet will be sent
             fc_cache->space--;
+            if (fc_cache->space == 0 and fc_cache->space_fd) fc_cache->space_fd->clear();
             return true;
         }
 
@@ -379,11 +383,35 @@ static bool tx_flow_ctrl(
 			size_t seq_ack = endian_conv(packet_buff[if_packet_info.num_header_words32+1]);
 			fc_cache->space += (seq_ack - fc_cache->last_seq_ack) & HW_SEQ_NUM_MASK;
 			fc_cache->last_seq_ack = seq_ack;
+			if (fc_cache->space and fc_cache->space_fd) fc_cache->space_fd->set();
 		}
     }
     return false;
 }
 
+/*! Get a descriptor which is readable when there may be room for a packet:
+ *  while there is space, or when a flow control message arrived on the
+ *  receive side of the data transport.
+ *  Made when the streamer's descriptor is requested, by the sending thread.
+ */
+static int get_tx_fd(
+    boost::shared_ptr<tx_fc_cache_t> fc_cache,
+    zero_copy_if::sptr data_recv_xport
+) {
+    if (not fc_cache->ready)
+    {
+        const int fd = data_recv_xport->get_recv_fd();
+        if (fd < 0) return -1;
+        readiness_set::sptr ready = readiness_set::make();
+        ready->add(fd);
+        fc_cache->space_fd = readiness_fd::make();
+        if (fc_cache->space) fc_cache->space_fd->set();
+        ready->add(fc_cache->space_fd->get());
+        fc_cache->ready = ready;
+    }
+    return fc_cache->ready->get();
+}
+
 /***********************************************************************
  * TX Async Message Functions
  **********************************************************************/
@@ -393,6 +421,7 @@ struct async_tx_info_t
     size_t device_channel;
     boost::shared_ptr<device3_impl::async_md_type> async_queue;
     boost::shared_ptr<device3_impl::async_md_type> old_async_queue;
+    readiness_fd::sptr async_fd; //readable while async_queue has messages
 };
 
 /*! Handle incoming messages.
@@ -460,6 +489,7 @@ static void handle_tx_async_msgs(
         UHD_MSG(error) << "Unexpected flow control message found in async message handling" << std::endl;
     } else {
         async_info->async_queue->push_with_pop_on_full(metadata);
+        if (async_info->async_fd) async_info->async_fd->set();
         metadata.channel = async_info->device_channel;
         async_info->old_async_queue->push_with_pop_on_full(metadata);
         standard_async_msg_prints(metadata);
@@ -610,11 +640,11 @@ rx_streamer::sptr device3_impl::get_rx_stream(const stream_args_t &args_)
                 block_port
         );
 
-        //Give the streamer a functor to get the recv_buffer
-        //bind requires a zero_copy_if::sptr to add a streamer->xport lifetime dependency
-        my_streamer->set_xport_chan_get_buff(
+        //Give the streamer the transport to get the recv_buffer from
+        //holding the zero_copy_if::sptr adds a streamer->xport lifetime dependency
+        my_streamer->set_xport_chan_recv_xport(
             stream_i,
-            boost::bind(&zero_copy_if::get_recv_buff, xport.recv, _1),
+            xport.recv,
             true /*flush*/
         );
 
@@ -732,6 +762,13 @@ tx_streamer::sptr device3_impl::get_tx_stream(const uhd::stream_args_t &args_)
 
     //shared async queue for all channels in streamer
     boost::shared_ptr<async_md_type> async_md(new async_md_type(1000/*messages deep*/));
+    //and the descriptor which is readable while it has messages
+    readiness_fd::sptr async_fd;
+    try {
+        async_fd = readiness_fd::make();
+    } catch (const uhd::not_implemented_error &) {
+        //the streamer has no descriptor on this system
+    }
 
     // II. Iterate over all channels
     boost::shared_ptr<device3_send_packet_streamer> my_streamer;
@@ -829,6 +866,7 @@ tx_streamer::sptr device3_impl::get_tx_stream(const uhd::stream_args_t &args_)
         async_tx_info->device_channel = mb_index;
         async_tx_info->async_queue = async_md;
         async_tx_info->old_async_queue = _async_md;
+        async_tx_info->async_fd = async_fd;
 
         boost::function<double(void)> tick_rate_retriever = boost::bind(
                 &rfnoc::tick_node_ctrl::get_tick_rate,
@@ -897,10 +935,16 @@ tx_streamer::sptr device3_impl::get_tx_stream(const uhd::stream_args_t &args_)
             stream_i,
             boost::bind(&zero_copy_if::get_send_buff, my_streamer->_xport.send, _1)
         );
+        //Give the streamer a functor to get the descriptor for the flow control
+        my_streamer->set_xport_chan_get_fd(
+            stream_i,
+            boost::bind(&get_tx_fd, fc_cache, my_streamer->_xport.recv)
+        );
         //Give the streamer a functor handled received async messages
         my_streamer->set_async_receiver(
             boost::bind(&async_md_type::pop_with_timed_wait, async_md, _1, _2)
         );
+        my_streamer->set_async_fd(async_fd);
         my_streamer->set_xport_chan_sid(stream_i, true, xport.send_sid);
         // CHDR does not support trailers
         my_streamer->set_enable_trailer(false);
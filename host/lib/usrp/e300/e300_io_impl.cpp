@@ -490,9 +490,9 @@ rx_streamer::sptr e300_impl::get_rx_stream(const uhd::stream_args_t &args_)
         perif.framer->configure_flow_control(fc_window);
         boost::shared_ptr<e300_rx_fc_cache_t> fc_cache(new e300_rx_fc_cache_t());
 
-        my_streamer->set_xport_chan_get_buff(stream_i, boost::bind(
-            &zero_copy_if::get_recv_buff, data_xports.recv, _1
-        ), true /*flush*/);
+        my_streamer->set_xport_chan_recv_xport(stream_i,
+            data_xports.recv, true /*flush*/
+        );
         my_streamer->set_overflow_handler(stream_i,
             boost::bind(&e300_impl::_handle_overflow, this, boost::ref(perif),
             boost::weak_ptr<uhd::rx_streamer>(my_streamer))
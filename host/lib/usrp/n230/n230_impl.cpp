@@ -19,6 +19,7 @@
 
 #include "usrp3_fw_ctrl_iface.hpp"
 #include "validate_subdev_spec.hpp"
+#include "broadcast_find.hpp"
 #include <uhd/utils/static.hpp>
 #include <uhd/transport/if_addrs.hpp>
 #include <uhd/transport/udp_zero_copy.hpp>
@@ -58,7 +59,7 @@ namespace asio = boost::asio;
 //----------------------------------------------------------
 UHD_STATIC_BLOCK(register_n230_device)
 {
-    device::register_device(&n230_impl::n230_find, &n230_impl::n230_make, device::USRP);
+    device::register_device(&n230_impl::n230_find, &n230_impl::n230_make, device::USRP, true);
 }
 
 //----------------------------------------------------------
@@ -98,16 +99,8 @@ uhd::device_addrs_t n230_impl::n230_find(const uhd::device_addr_t &multi_dev_hin
 
     //if no address was specified, send a broadcast on each interface
     if (not hint.has_key("addr")) {
-        BOOST_FOREACH(const if_addrs_t &if_addrs, get_if_addrs()) {
-            //avoid the loopback device
-            if (if_addrs.inet == asio::ip::address_v4::loopback().to_string()) continue;
-
-            //create a new hint with this broadcast address
-            device_addr_t new_hint = hint;
-            new_hint["addr"] = if_addrs.bcast;
-
-            //call discover with the new hint and append results
-            device_addrs_t new_n230_addrs = n230_find(new_hint);
+        BOOST_FOREACH(const device_addrs_t &new_n230_addrs, find_on_all_interfaces(hint, &n230_find)) {
+            //append results
             n230_addrs.insert(n230_addrs.begin(),
                 new_n230_addrs.begin(), new_n230_addrs.end()
             );
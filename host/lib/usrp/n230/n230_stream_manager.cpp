@@ -130,9 +130,9 @@ rx_streamer::sptr n230_stream_manager::get_rx_stream(const uhd::stream_args_t &a
 
         //Give the streamer a functor to get the recv_buffer
         //bind requires a zero_copy_if::sptr to add a streamer->xport lifetime dependency
-        my_streamer->set_xport_chan_get_buff(
+        my_streamer->set_xport_chan_recv_xport(
             stream_i,
-            boost::bind(&zero_copy_if::get_recv_buff, xport, _1),
+            xport,
             true /*flush*/
         );
 
@@ -305,12 +305,12 @@ void usrp1_impl::vandal_conquest_loop(void){
         if (_tx_enabled and underflow){
             async_metadata.time_spec = _soft_time_ctrl->get_time();
             _soft_time_ctrl->get_async_queue().push_with_pop_on_full(async_metadata);
-            UHD_MSG(fastpath) << "U";
+            uhd::msg::post_fastpath('U');
         }
         if (_rx_enabled and overflow){
             inline_metadata.time_spec = _soft_time_ctrl->get_time();
             _soft_time_ctrl->get_inline_queue().push_with_pop_on_full(inline_metadata);
-            UHD_MSG(fastpath) << "O";
+            uhd::msg::post_fastpath('O');
         }
 
         boost::this_thread::sleep(boost::posix_time::milliseconds(50));
@@ -642,9 +642,7 @@ rx_streamer::sptr usrp1_impl::get_rx_stream(const uhd::stream_args_t &args_){
     //init some streamer stuff
     my_streamer->set_tick_rate(_master_clock_rate);
     my_streamer->set_vrt_unpacker(&usrp1_bs_vrt_unpacker);
-    my_streamer->set_xport_chan_get_buff(0, boost::bind(
-        &uhd::transport::zero_copy_if::get_recv_buff, _io_impl->data_transport, _1
-    ));
+    my_streamer->set_xport_chan_recv_xport(0, _io_impl->data_transport);
 
     //set the converter
     uhd::convert::id_type id;
@@ -18,6 +18,7 @@
 #include "usrp2_impl.hpp"
 #include "fw_common.h"
 #include "apply_corrections.hpp"
+#include "broadcast_find.hpp"
 #include <uhd/utils/log.hpp>
 #include <uhd/utils/msg.hpp>
 #include <uhd/exception.hpp>
@@ -81,16 +82,8 @@ device_addrs_t usrp2_find(const device_addr_t &hint_){
 
     //if no address was specified, send a broadcast on each interface
     if (not hint.has_key("addr")){
-        BOOST_FOREACH(const if_addrs_t &if_addrs, get_if_addrs()){
-            //avoid the loopback device
-            if (if_addrs.inet == asio::ip::address_v4::loopback().to_string()) continue;
-
-            //create a new hint with this broadcast address
-            device_addr_t new_hint = hint;
-            new_hint["addr"] = if_addrs.bcast;
-
-            //call discover with the new hint and append results
-            device_addrs_t new_usrp2_addrs = usrp2_find(new_hint);
+        BOOST_FOREACH(const device_addrs_t &new_usrp2_addrs, find_on_all_interfaces(hint, &usrp2_find)){
+            //append results
             usrp2_addrs.insert(usrp2_addrs.begin(),
                 new_usrp2_addrs.begin(), new_usrp2_addrs.end()
             );
@@ -200,7 +193,7 @@ static device::sptr usrp2_make(const device_addr_t &device_addr){
 }
 
 UHD_STATIC_BLOCK(register_usrp2_device){
-    device::register_device(&usrp2_find, &usrp2_make, device::USRP);
+    device::register_device(&usrp2_find, &usrp2_make, device::USRP, true);
 }
 
 /***********************************************************************
@@ -20,6 +20,9 @@
 #include "x310_lvbitx.hpp"
 #include "x300_mb_eeprom.hpp"
 #include "apply_corrections.hpp"
+#include "broadcast_find.hpp"
+#include "eeprom_cache.hpp"
+#include "mboard_setup.hpp"
 #include <boost/algorithm/string.hpp>
 #include <boost/asio.hpp>
 #include <uhd/utils/static.hpp>
@@ -31,7 +34,10 @@
 #include <boost/foreach.hpp>
 #include <boost/bind.hpp>
 #include <boost/make_shared.hpp>
+#include <boost/function.hpp>
 #include <boost/functional/hash.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/thread.hpp>
 #include <boost/assign/list_of.hpp>
 #include <uhd/transport/udp_zero_copy.hpp>
 #include <uhd/transport/udp_constants.hpp>
@@ -41,6 +47,7 @@
 #include <uhd/utils/platform.hpp>
 #include <uhd/types/sid.hpp>
 #include <fstream>
+#include <limits>
 
 #define NIUSRPRIO_DEFAULT_RPC_PORT "5444"
 
@@ -80,6 +87,39 @@ static std::string get_fpga_option(wb_iface::sptr zpu_ctrl) {
     return option;
 }
 
+/***********************************************************************
+ * EEPROM cache
+ **********************************************************************/
+//! Leading bytes of a daughterboard EEPROM, up to the end of the serial
+static const size_t X300_DB_EEPROM_ID_LEN = 18;
+//! Offset of the daughterboard EEPROM checksum, which covers all bytes before it
+static const size_t X300_DB_EEPROM_CHECKSUM_OFFSET = 0x1f;
+
+//! Name the images on a motherboard, cached EEPROM contents are only used with the same ones
+static std::string get_eeprom_cache_tag(wb_iface::sptr zpu_ctrl)
+{
+    return str(boost::format("X300 fw=%08x fpga=%08x hash=%08x")
+        % zpu_ctrl->peek32(SR_ADDR(X300_FW_SHMEM_BASE, X300_FW_SHMEM_COMPAT_NUM))
+        % zpu_ctrl->peek32(SR_ADDR(SET0_BASE, ZPU_RB_COMPAT_NUM))
+        % zpu_ctrl->peek32(SR_ADDR(SET0_BASE, ZPU_RB_GIT_HASH))
+    );
+}
+
+//! Serve the daughterboard EEPROM reads of an interface from the EEPROM cache, as the
+//! device arguments ask. The motherboard EEPROM has no checksum and is not cached.
+static i2c_iface::sptr make_db_eeprom_cache_iface(
+    i2c_iface::sptr iface,
+    wb_iface::sptr zpu_ctrl,
+    const device_addr_t &args
+){
+    const eeprom_cache::mode_t mode = eeprom_cache::get_mode(args);
+    if (mode == eeprom_cache::CACHE_OFF) return iface;
+    return eeprom_cache::get()->make_iface(
+        iface, get_eeprom_cache_tag(zpu_ctrl),
+        X300_DB_EEPROM_ID_LEN, X300_DB_EEPROM_CHECKSUM_OFFSET, mode
+    );
+}
+
 /***********************************************************************
  * Discovery over the udp and pcie transport
  **********************************************************************/
@@ -217,7 +257,7 @@ static device_addrs_t x300_find_pcie(const device_addr_t &hint, bool explicit_qu
 
             //Hold on to the registry mutex as long as zpu_ctrl is alive
             //to prevent any use by different threads while enumerating
-            boost::mutex::scoped_lock(pcie_zpu_iface_registry_mutex);
+            boost::mutex::scoped_lock lock(pcie_zpu_iface_registry_mutex);
 
             if (get_pcie_zpu_iface_registry().has_key(resource_d)) {
                 zpu_ctrl = get_pcie_zpu_iface_registry()[resource_d].lock();
@@ -322,17 +362,8 @@ device_addrs_t x300_find(const device_addr_t &hint_)
     if (!hint.has_key("resource"))
     {
         //otherwise, no address was specified, send a broadcast on each interface
-        BOOST_FOREACH(const if_addrs_t &if_addrs, get_if_addrs())
+        BOOST_FOREACH(device_addrs_t new_addrs, find_on_all_interfaces(hint, &x300_find))
         {
-            //avoid the loopback device
-            if (if_addrs.inet == asio::ip::address_v4::loopback().to_string()) continue;
-
-            //create a new hint with this broadcast address
-            device_addr_t new_hint = hint;
-            new_hint["addr"] = if_addrs.bcast;
-
-            //call discover with the new hint and append results
-            device_addrs_t new_addrs = x300_find(new_hint);
             //if we are looking for a serial, only add the one device with a matching serial
             if (hint.has_key("serial")) {
                 bool found_serial = false; //signal to break out of the interface loop
@@ -367,7 +398,7 @@ static device::sptr x300_make(const device_addr_t &device_addr)
 
 UHD_STATIC_BLOCK(register_x300_device)
 {
-    device::register_device(&x300_find, &x300_make, device::USRP);
+    device::register_device(&x300_find, &x300_make, device::USRP, true);
 }
 
 static void x300_load_fw(wb_iface::sptr fw_reg_ctrl, const std::string &file_name)
@@ -395,6 +426,9 @@ static void x300_load_fw(wb_iface::sptr fw_reg_ctrl, const std::string &file_nam
     UHD_MSG(status) << " done!" << std::endl;
 }
 
+/***********************************************************************
+ * Structors
+ **********************************************************************/
 x300_impl::x300_impl(const uhd::device_addr_t &dev_addr) 
     : device3_impl()
     , _sid_framer(0)
@@ -403,12 +437,20 @@ x300_impl::x300_impl(const uhd::device_addr_t &dev_addr)
     _ignore_cal_file = dev_addr.has_key("ignore-cal-file");
     _tree->create<std::string>("/name").set("X-Series Device");
 
+    _max_frame_sizes.recv_frame_size = std::numeric_limits<size_t>::max();
+    _max_frame_sizes.send_frame_size = std::numeric_limits<size_t>::max();
+
     const device_addrs_t device_args = separate_device_addr(dev_addr);
     _mb.resize(device_args.size());
+
+    //The motherboards are brought up concurrently, except for the block
+    //enumeration: it allocates the SIDs and block IDs in motherboard order.
+    setup_mboards(boost::bind(&x300_impl::setup_mb, this, _1, _2), device_args);
     for (size_t i = 0; i < device_args.size(); i++)
     {
-        this->setup_mb(i, device_args[i]);
+        this->setup_rfnoc_blocks(i, device_args[i]);
     }
+    setup_mboards(boost::bind(&x300_impl::setup_radios, this, _1, _2), device_args);
 }
 
 void x300_impl::mboard_members_t::discover_eth(
@@ -618,12 +660,13 @@ void x300_impl::setup_mb(const size_t mb_i, const uhd::device_addr_t &dev_addr)
         #endif
 
         // Detect the frame size on the path to the USRP
+        frame_size_t max_frame_sizes = req_max_frame_size;
         try {
             frame_size_t pri_frame_sizes = determine_max_frame_size(
                 eth_addrs.at(0), req_max_frame_size
             );
 
-            _max_frame_sizes = pri_frame_sizes;
+            max_frame_sizes = pri_frame_sizes;
             if (eth_addrs.size() > 1) {
                 frame_size_t sec_frame_sizes = determine_max_frame_size(
                     eth_addrs.at(1), req_max_frame_size
@@ -631,12 +674,12 @@ void x300_impl::setup_mb(const size_t mb_i, const uhd::device_addr_t &dev_addr)
 
                 // Choose the minimum of the max frame sizes
                 // to ensure we don't exceed any one of the links' MTU
-                _max_frame_sizes.recv_frame_size = std::min(
+                max_frame_sizes.recv_frame_size = std::min(
                     pri_frame_sizes.recv_frame_size,
                     sec_frame_sizes.recv_frame_size
                 );
 
-                _max_frame_sizes.send_frame_size = std::min(
+                max_frame_sizes.send_frame_size = std::min(
                     pri_frame_sizes.send_frame_size,
                     sec_frame_sizes.send_frame_size
                 );
@@ -646,11 +689,11 @@ void x300_impl::setup_mb(const size_t mb_i, const uhd::device_addr_t &dev_addr)
         }
 
         if ((mb.recv_args.has_key("recv_frame_size"))
-                && (req_max_frame_size.recv_frame_size > _max_frame_sizes.recv_frame_size)) {
+                && (req_max_frame_size.recv_frame_size > max_frame_sizes.recv_frame_size)) {
             UHD_MSG(warning)
                 << boost::format("You requested a receive frame size of (%lu) but your NIC's max frame size is (%lu).")
                 % req_max_frame_size.recv_frame_size
-                % _max_frame_sizes.recv_frame_size
+                % max_frame_sizes.recv_frame_size
                 << std::endl
                 << boost::format("Please verify your NIC's MTU setting using '%s' or set the recv_frame_size argument appropriately.")
                 % mtu_tool << std::endl
@@ -659,11 +702,11 @@ void x300_impl::setup_mb(const size_t mb_i, const uhd::device_addr_t &dev_addr)
         }
 
         if ((mb.recv_args.has_key("send_frame_size"))
-                && (req_max_frame_size.send_frame_size > _max_frame_sizes.send_frame_size)) {
+                && (req_max_frame_size.send_frame_size > max_frame_sizes.send_frame_size)) {
             UHD_MSG(warning)
                 << boost::format("You requested a send frame size of (%lu) but your NIC's max frame size is (%lu).")
                 % req_max_frame_size.send_frame_size
-                % _max_frame_sizes.send_frame_size
+                % max_frame_sizes.send_frame_size
                 << std::endl
                 << boost::format("Please verify your NIC's MTU setting using '%s' or set the send_frame_size argument appropriately.")
                 % mtu_tool << std::endl
@@ -671,15 +714,27 @@ void x300_impl::setup_mb(const size_t mb_i, const uhd::device_addr_t &dev_addr)
                 << std::endl;
         }
 
-        _tree->create<size_t>(mb_path / "mtu/recv").set(_max_frame_sizes.recv_frame_size);
-        _tree->create<size_t>(mb_path / "mtu/send").set(std::min(_max_frame_sizes.send_frame_size, X300_ETH_DATA_FRAME_MAX_TX_SIZE));
+        //Streams may go to any of the motherboards, so they use frame
+        //sizes that are supported by all links
+        {
+            boost::mutex::scoped_lock lock(_max_frame_sizes_mutex);
+            _max_frame_sizes.recv_frame_size = std::min(
+                _max_frame_sizes.recv_frame_size, max_frame_sizes.recv_frame_size
+            );
+            _max_frame_sizes.send_frame_size = std::min(
+                _max_frame_sizes.send_frame_size, max_frame_sizes.send_frame_size
+            );
+        }
+
+        _tree->create<size_t>(mb_path / "mtu/recv").set(max_frame_sizes.recv_frame_size);
+        _tree->create<size_t>(mb_path / "mtu/send").set(std::min(max_frame_sizes.send_frame_size, X300_ETH_DATA_FRAME_MAX_TX_SIZE));
         _tree->create<double>(mb_path / "link_max_rate").set(X300_MAX_RATE_10GIGE);
     }
 
     //create basic communication
     UHD_MSG(status) << "Setup basic communication..." << std::endl;
     if (mb.xport_path == "nirio") {
-        boost::mutex::scoped_lock(pcie_zpu_iface_registry_mutex);
+        boost::mutex::scoped_lock lock(pcie_zpu_iface_registry_mutex);
         if (get_pcie_zpu_iface_registry().has_key(mb.get_pri_eth().addr)) {
             throw uhd::assertion_error("Someone else has a ZPU transport to the device open. Internal error!");
         } else {
@@ -958,6 +1013,11 @@ void x300_impl::setup_mb(const size_t mb_i, const uhd::device_addr_t &dev_addr)
     ////////////////////////////////////////////////////////////////////
     _tree->create<sensor_value_t>(mb_path / "sensors" / "ref_locked")
         .set_publisher(boost::bind(&x300_impl::get_ref_locked, this, mb));
+}
+
+void x300_impl::setup_rfnoc_blocks(const size_t mb_i, const uhd::device_addr_t &dev_addr)
+{
+    mboard_members_t &mb = _mb[mb_i];
 
     //////////////// RFNOC /////////////////
     const size_t n_rfnoc_blocks = mb.zpu_ctrl->peek32(SR_ADDR(SET0_BASE, ZPU_RB_NUM_CE));
@@ -970,6 +1030,11 @@ void x300_impl::setup_mb(const size_t mb_i, const uhd::device_addr_t &dev_addr)
         mb.if_pkt_is_big_endian ? ENDIANNESS_BIG : ENDIANNESS_LITTLE
     );
     //////////////// RFNOC /////////////////
+}
+
+void x300_impl::setup_radios(const size_t mb_i, const uhd::device_addr_t &dev_addr)
+{
+    mboard_members_t &mb = _mb[mb_i];
 
     // If we have a radio, we must configure its codec control:
     const std::string radio_blockid_hint = str(boost::format("%d/Radio") % mb_i);
@@ -981,11 +1046,12 @@ void x300_impl::setup_mb(const size_t mb_i, const uhd::device_addr_t &dev_addr)
             radio_ids.resize(2);
         }
 
+        const i2c_iface::sptr db_i2c = make_db_eeprom_cache_iface(mb.zpu_i2c, mb.zpu_ctrl, dev_addr);
         BOOST_FOREACH(const rfnoc::block_id_t &id, radio_ids) {
             rfnoc::x300_radio_ctrl_impl::sptr radio(get_block_ctrl<rfnoc::x300_radio_ctrl_impl>(id));
             mb.radios.push_back(radio);
             radio->setup_radio(
-                    mb.zpu_i2c,
+                    db_i2c,
                     mb.clock,
                     dev_addr.has_key("ignore-cal-file"),
                     dev_addr.has_key("self_cal_adc_delay")
@@ -1034,7 +1100,7 @@ x300_impl::~x300_impl(void)
             //kill the claimer task and unclaim the device
             mb.claimer_task.reset();
             {   //Critical section
-                boost::mutex::scoped_lock(pcie_zpu_iface_registry_mutex);
+                boost::mutex::scoped_lock lock(pcie_zpu_iface_registry_mutex);
                 release(mb.zpu_ctrl);
                 //If the process is killed, the entire registry will disappear so we
                 //don't need to worry about unclean shutdowns here.
@@ -1331,6 +1397,7 @@ uhd::sid_t x300_impl::allocate_sid(
         const uint32_t src_addr,
         const uint32_t src_dst
 ) {
+    boost::mutex::scoped_lock lock(_sid_mutex);
     uhd::sid_t sid = address;
     sid.set_src_addr(src_addr);
     sid.set_src_endpoint(_sid_framer);
@@ -29,6 +29,7 @@
 #include <uhd/transport/udp_simple.hpp> //mtu
 #include "i2c_core_100_wb32.hpp"
 #include <boost/weak_ptr.hpp>
+#include <boost/thread/mutex.hpp>
 #include <uhd/usrp/gps_ctrl.hpp>
 #include <uhd/transport/nirio/niusrprio_session.h>
 #include <uhd/transport/vrt_if_packet.hpp>
@@ -128,6 +129,8 @@ public:
 
     x300_impl(const uhd::device_addr_t &);
     void setup_mb(const size_t which, const uhd::device_addr_t &);
+    void setup_rfnoc_blocks(const size_t which, const uhd::device_addr_t &);
+    void setup_radios(const size_t which, const uhd::device_addr_t &);
     ~x300_impl(void);
 
     // device claim functions
@@ -221,6 +224,7 @@ private:
     void claimer_loop(uhd::wb_iface::sptr);
 
     size_t _sid_framer;
+    boost::mutex _sid_mutex;
 
     uhd::sid_t allocate_sid(
         mboard_members_t &mb,
@@ -238,7 +242,9 @@ private:
         size_t recv_frame_size;
         size_t send_frame_size;
     };
+    //! Smallest frame sizes supported by the links to all motherboards
     frame_size_t _max_frame_sizes;
+    boost::mutex _max_frame_sizes_mutex;
 
     /*!
      * Automatically determine the maximum frame size available by sending a UDP packet
@@ -150,7 +150,8 @@ public:
             for (size_t word = offset / 4; bytes_read < num_bytes; word++)
             {
                 uint32_t value = byteswap(_wb->peek32(X300_FW_SHMEM_ADDR(X300_FW_SHMEM_IDENT + word)));
-                for (size_t byte = offset % 4; byte < 4 and bytes_read < num_bytes; byte++)
+                // Only the first word starts in the middle
+                for (size_t byte = (bytes_read == 0)? offset % 4 : 0; byte < 4 and bytes_read < num_bytes; byte++)
                 {
                     bytes.push_back(uint8_t((value >> (byte * 8)) & 0xff));
                     bytes_read++;
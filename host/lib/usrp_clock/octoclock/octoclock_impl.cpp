@@ -180,7 +180,7 @@ device::sptr octoclock_make(const device_addr_t &device_addr){
 }
 
 UHD_STATIC_BLOCK(register_octoclock_device){
-    device::register_device(&octoclock_find, &octoclock_make, device::CLOCK);
+    device::register_device(&octoclock_find, &octoclock_make, device::CLOCK, true);
 }
 
 /***********************************************************************
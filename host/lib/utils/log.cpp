@@ -22,27 +22,86 @@
 #include <boost/filesystem.hpp>
 #include <boost/format.hpp>
 #include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
 #include <boost/date_time/posix_time/posix_time.hpp>
 #include <boost/thread/locks.hpp>
 #include <boost/interprocess/sync/file_lock.hpp>
+#include <boost/scoped_array.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/bind.hpp>
+#include <uhd/utils/atomic.hpp>
+#include <algorithm>
+#include <cstring>
 #include <fstream>
+#include <exception>
+#include <csignal>
+#include <cstdlib>
 #include <cctype>
+#include <fcntl.h>
+#ifdef UHD_PLATFORM_WIN32
+    #include <io.h>
+#else
+    #include <unistd.h>
+#endif
 
 namespace fs = boost::filesystem;
 namespace pt = boost::posix_time;
 namespace ip = boost::interprocess;
 
+//! Number of slots in the ring, a power of two
+static const uint32_t LOG_RING_SLOTS = 1024;
+
+//! Number of bytes of an entry held by one slot
+static const size_t LOG_SLOT_BYTES = 256;
+
+//! Number of slots one entry may take, longer entries are truncated
+static const uint32_t LOG_MAX_SLOTS_PER_ENTRY = 16;
+
+//! How long the writer thread sleeps when there is nothing to write
+static const long LOG_WRITER_IDLE_MS = 10;
+
 /***********************************************************************
  * Global resources for the logger
+ *
+ * Entries are copied into a preallocated ring of fixed-size slots by the
+ * logging threads and written to the file in batches by a writer thread,
+ * so that a thread that logs never waits for the file or the file lock.
+ * Queueing an entry allocates nothing, only formatting it does.
+ *
+ * An entry takes consecutive slots, which a logging thread claims by
+ * advancing the head with a compare-and-swap. The sequence number of a
+ * slot tells whether it is free for the current lap of the ring, written,
+ * or still being written, so that the writer thread takes the entries in
+ * the order in which they were claimed.
+ *
+ * When the process crashes, a signal handler writes out the entries that
+ * are still queued using only async-signal-safe calls.
  **********************************************************************/
+struct log_slot_type{
+    uhd::atomic_uint32_t seq;
+    uint32_t len;
+    char text[LOG_SLOT_BYTES];
+};
+
 class log_resource_type{
 public:
     uhd::_log::verbosity_t level;
 
     log_resource_type(void){
 
+        //all slots are free for the first lap
+        _ring.reset(new log_slot_type[LOG_RING_SLOTS]);
+        for (uint32_t i = 0; i < LOG_RING_SLOTS; i++){
+            _ring[i].seq.write(i);
+        }
+        _tail = 0;
+
+        _log_path = (fs::path(uhd::get_tmp_path()) / "uhd.log").string();
+
         //file lock pointer must be null
         _file_lock = NULL;
+        _dropped_reported = 0;
+        _failed = false;
 
         //set the default log level
         level = uhd::_log::never;
@@ -58,24 +117,162 @@ public:
     }
 
     ~log_resource_type(void){
-        boost::lock_guard<boost::mutex> lock(_mutex);
+        if (_writer_thread.get() != NULL){
+            _writer_thread->interrupt();
+            _writer_thread->join();
+        }
+        this->drain(true);
+        boost::lock_guard<boost::mutex> lock(_write_mutex);
         _file_stream.close();
         if (_file_lock != NULL) delete _file_lock;
     }
 
+    //! Queue an entry for the writer thread, never blocks
     void log_to_file(const std::string &log_msg){
-        boost::lock_guard<boost::mutex> lock(_mutex);
-        if (_file_lock == NULL){
-            const std::string log_path = (fs::path(uhd::get_tmp_path()) / "uhd.log").string();
-            _file_stream.open(log_path.c_str(), std::fstream::out | std::fstream::app);
-            _file_lock = new ip::file_lock(log_path.c_str());
+        if (_writer_started.read() == 0 and _writer_started.cas(1, 0) == 0){
+            this->_start_writer();
+        }
+
+        //claim enough consecutive slots, or drop the entry when the ring is full
+        const size_t len = std::min(log_msg.size(), LOG_SLOT_BYTES*LOG_MAX_SLOTS_PER_ENTRY);
+        const uint32_t num_slots = std::max<uint32_t>(1, uint32_t((len + LOG_SLOT_BYTES - 1)/LOG_SLOT_BYTES));
+        uint32_t pos;
+        while (true){
+            pos = _head.read();
+            const uint32_t last = pos + num_slots - 1;
+            const int32_t diff = int32_t(_ring[last % LOG_RING_SLOTS].seq.read() - last);
+            if (diff < 0){
+                _dropped.inc();
+                return;
+            }
+            if (diff == 0 and _head.cas(pos + num_slots, pos) == pos) break;
+        }
+
+        //fill the slots and hand them to the writer thread
+        for (uint32_t i = 0; i < num_slots; i++){
+            log_slot_type &slot = _ring[(pos + i) % LOG_RING_SLOTS];
+            const size_t offset = i*LOG_SLOT_BYTES;
+            slot.len = uint32_t(std::min(LOG_SLOT_BYTES, len - offset));
+            std::memcpy(slot.text, log_msg.data() + offset, slot.len);
+            slot.seq.write(pos + i + 1);
         }
-        _file_lock->lock();
-        _file_stream << log_msg << std::flush;
-        _file_lock->unlock();
     }
 
+    /*!
+     * Write all queued entries to the file in one batch.
+     * \param wait false to give up if another thread is writing
+     * \return true if entries were written
+     */
+    bool drain(const bool wait){
+        std::string error;
+        bool written = false;
+        {
+            boost::unique_lock<boost::mutex> lock(_write_mutex, boost::defer_lock);
+            if (wait) lock.lock();
+            else if (not lock.try_lock()) return false;
+
+            std::string batch;
+            while (true){
+                log_slot_type &slot = _ring[_tail % LOG_RING_SLOTS];
+                if (slot.seq.read() != _tail + 1) break;
+                batch.append(slot.text, slot.len);
+                slot.seq.write(_tail + LOG_RING_SLOTS);
+                _tail++;
+            }
+            const uint32_t dropped = _dropped.read();
+            if (dropped != _dropped_reported){
+                batch += str(boost::format("\n-- %u log entries were dropped\n") % (dropped - _dropped_reported));
+                _dropped_reported = dropped;
+            }
+            if (batch.empty() or _failed) return false;
+
+            try{
+                if (_file_lock == NULL){
+                    _file_stream.open(_log_path.c_str(), std::fstream::out | std::fstream::app);
+                    _file_lock = new ip::file_lock(_log_path.c_str());
+                }
+                _file_lock->lock();
+                _file_stream << batch << std::flush;
+                _file_lock->unlock();
+                written = true;
+            }
+            catch(const std::exception &e){
+                _failed = true;
+                error = e.what();
+            }
+        }
+        if (not error.empty()){
+            /*!
+             * Critical behavior below.
+             * The following steps must happen in order to avoid a lock-up condition.
+             * This is because the message facility will call into the logging facility.
+             * Therefore we must disable the logger (level = never) before messaging,
+             * and the write lock must have been released.
+             */
+            level = uhd::_log::never;
+            UHD_MSG(error)
+                << "Logging failed: " << error << std::endl
+                << "Logging has been disabled for this process" << std::endl
+            ;
+        }
+        return written;
+    }
+
+    /*!
+     * Write the queued entries from a crash signal handler.
+     * Takes no locks, allocates nothing and leaves the ring as it is.
+     */
+    void drain_on_crash(void){
+        #ifdef UHD_PLATFORM_WIN32
+        const int fd = ::_open(_log_path.c_str(), _O_WRONLY | _O_APPEND | _O_CREAT, _S_IREAD | _S_IWRITE);
+        #else
+        const int fd = ::open(_log_path.c_str(), O_WRONLY | O_APPEND | O_CREAT, 0644);
+        #endif
+        if (fd < 0) return;
+        for (uint32_t tail = _tail; ; tail++){
+            log_slot_type &slot = _ring[tail % LOG_RING_SLOTS];
+            if (slot.seq.read() != tail + 1) break;
+            #ifdef UHD_PLATFORM_WIN32
+            if (::_write(fd, slot.text, slot.len) < 0) break;
+            #else
+            if (::write(fd, slot.text, slot.len) < 0) break;
+            #endif
+        }
+        #ifdef UHD_PLATFORM_WIN32
+        ::_close(fd);
+        #else
+        ::close(fd);
+        #endif
+    }
+
+    //! Install the crash and terminate handlers, called once at load time
+    static void install_crash_handlers(void);
+
 private:
+    void _start_writer(void){
+        _writer_thread.reset(new boost::thread(boost::bind(&log_resource_type::_run_writer, this)));
+    }
+
+    void _run_writer(void){
+        try{
+            while (true){
+                if (not this->drain(true)){
+                    boost::this_thread::sleep(pt::milliseconds(LOG_WRITER_IDLE_MS));
+                }
+            }
+        }
+        catch(const boost::thread_interrupted &){
+            /* NOP */
+        }
+    }
+
+    //! Write out what was logged before an uncaught exception ends the process
+    static void _terminate_handler(void);
+    static std::terminate_handler _prev_terminate_handler;
+
+    //! Write out what was logged before a crash signal ends the process
+    static void _signal_handler(int signum);
+
     //! set the log level from a string that is either a digit or an enum name
     void _set_log_level(const std::string &log_level_str){
         const uhd::_log::verbosity_t log_level_num = uhd::_log::verbosity_t(log_level_str[0]-'0');
@@ -92,14 +289,90 @@ private:
         if_lls_equal(never);
     }
 
+    //queued entries and the thread that writes them:
+    boost::scoped_array<log_slot_type> _ring;
+    uhd::atomic_uint32_t _head;
+    uint32_t _tail;
+    uhd::atomic_uint32_t _dropped;
+    uint32_t _dropped_reported;
+    bool _failed;
+    uhd::atomic_uint32_t _writer_started;
+    boost::scoped_ptr<boost::thread> _writer_thread;
+
     //file stream and lock:
+    std::string _log_path;
     std::ofstream _file_stream;
     ip::file_lock *_file_lock;
-    boost::mutex _mutex;
+    boost::mutex _write_mutex;
 };
 
 UHD_SINGLETON_FCN(log_resource_type, log_rs);
 
+std::terminate_handler log_resource_type::_prev_terminate_handler = NULL;
+
+void log_resource_type::_terminate_handler(void){
+    try{
+        log_rs().drain(false);
+    }
+    catch(...){
+        /* NOP */
+    }
+    if (_prev_terminate_handler != NULL) _prev_terminate_handler();
+    std::abort();
+}
+
+//! The crash signals and the handlers which were installed before ours
+struct log_crash_signal_type{
+    int signum;
+    void (*prev_handler)(int);
+};
+
+static log_crash_signal_type log_crash_signals[] = {
+    {SIGSEGV, SIG_DFL},
+    {SIGABRT, SIG_DFL},
+    {SIGFPE, SIG_DFL},
+    {SIGILL, SIG_DFL},
+    #ifdef SIGBUS
+    {SIGBUS, SIG_DFL},
+    #endif
+};
+
+static const size_t NUM_LOG_CRASH_SIGNALS = sizeof(log_crash_signals)/sizeof(log_crash_signals[0]);
+
+void log_resource_type::_signal_handler(int signum){
+    log_rs().drain_on_crash();
+
+    //hand the signal on to the previous handler, or the default action
+    for (size_t i = 0; i < NUM_LOG_CRASH_SIGNALS; i++){
+        if (log_crash_signals[i].signum != signum) continue;
+        std::signal(signum, log_crash_signals[i].prev_handler);
+        std::raise(signum);
+        return;
+    }
+}
+
+void log_resource_type::install_crash_handlers(void){
+    for (size_t i = 0; i < NUM_LOG_CRASH_SIGNALS; i++){
+        void (*prev_handler)(int) = std::signal(log_crash_signals[i].signum, &log_resource_type::_signal_handler);
+        if (prev_handler != SIG_ERR) log_crash_signals[i].prev_handler = prev_handler;
+    }
+    _prev_terminate_handler = std::set_terminate(&log_resource_type::_terminate_handler);
+}
+
+/*!
+ * Install the crash handlers when the library is loaded, so that they are
+ * installed once, before the application installs its own handlers, and
+ * only when logging is enabled.
+ */
+UHD_STATIC_BLOCK(log_install_crash_handlers){
+    if (log_rs().level == uhd::_log::never) return;
+    log_resource_type::install_crash_handlers();
+}
+
+void uhd::_log::flush(void){
+    log_rs().drain(true);
+}
+
 /***********************************************************************
  * The logger object implementation
  **********************************************************************/
@@ -122,7 +395,7 @@ uhd::_log::log::log(
     const std::string &function
     )
 {
-    _log_it = (verbosity >= log_rs().level);
+    _log_it = enabled(verbosity);
     if (_log_it)
     {
         const std::string time = pt::to_simple_string(pt::microsec_clock::local_time());
@@ -146,20 +419,10 @@ uhd::_log::log::~log(void)
         return;
 
     _ss << std::endl;
-    try{
-        log_rs().log_to_file(_ss.str());
-    }
-    catch(const std::exception &e){
-        /*!
-         * Critical behavior below.
-         * The following steps must happen in order to avoid a lock-up condition.
-         * This is because the message facility will call into the logging facility.
-         * Therefore we must disable the logger (level = never) before messaging.
-         */
-        log_rs().level = never;
-        UHD_MSG(error)
-            << "Logging failed: " << e.what() << std::endl
-            << "Logging has been disabled for this process" << std::endl
-        ;
-    }
+    log_rs().log_to_file(_ss.str());
+}
+
+bool uhd::_log::log::enabled(const verbosity_t verbosity)
+{
+    return verbosity >= log_rs().level;
 }
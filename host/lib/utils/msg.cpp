@@ -18,7 +18,12 @@
 #include <uhd/utils/msg.hpp>
 #include <uhd/utils/log.hpp>
 #include <uhd/utils/static.hpp>
+#include <uhd/utils/atomic.hpp>
 #include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/lockfree/queue.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/bind.hpp>
 #include <boost/foreach.hpp>
 #include <boost/tokenizer.hpp>
 #include <sstream>
@@ -78,9 +83,8 @@ void uhd::msg::register_handler(const handler_t &handler){
     msg_rs().handler = handler;
 }
 
+//! Called with msg_rs().mutex held, so output from different threads is not interleaved
 static void default_msg_handler(uhd::msg::type_t type, const std::string &msg){
-    static boost::mutex msg_mutex;
-    boost::mutex::scoped_lock lock(msg_mutex);
     switch(type){
     case uhd::msg::fastpath:
         std::cerr << msg << std::flush;
@@ -99,6 +103,7 @@ static void default_msg_handler(uhd::msg::type_t type, const std::string &msg){
     case uhd::msg::error:
         msg_to_cerr("UHD Error", msg);
         UHD_LOG << "Error message" << std::endl << msg;
+        uhd::_log::flush();
         break;
     }
 }
@@ -107,6 +112,100 @@ UHD_STATIC_BLOCK(msg_register_default_handler){
     uhd::msg::register_handler(&default_msg_handler);
 }
 
+/***********************************************************************
+ * Fast-path events
+ *
+ * Events are posted by the streaming threads when they detect an
+ * overflow, underflow, etc. They are counted and pushed into a bounded
+ * lock-free queue, and a printer thread hands them to the message
+ * handler. A streaming thread never blocks on the handler or the
+ * terminal while it recovers from the condition it reports.
+ **********************************************************************/
+//! Number of events that can be pending before they are dropped
+static const size_t FASTPATH_QUEUE_SIZE = 1024;
+
+//! How often the printer thread hands pending events to the handler
+static const long FASTPATH_PERIOD_MS = 10;
+
+//! Rate limit: events beyond this number per period are counted but not reported
+static const size_t FASTPATH_MAX_PER_PERIOD = 100;
+
+class fastpath_resource_type{
+public:
+    ~fastpath_resource_type(void){
+        if (_printer_thread.get() != NULL){
+            _printer_thread->interrupt();
+            _printer_thread->join();
+        }
+        this->drain(false);
+    }
+
+    //! Count and queue an event, never blocks
+    void post(const char event){
+        if (_printer_started.read() == 0 and _printer_started.cas(1, 0) == 0){
+            _printer_thread.reset(new boost::thread(boost::bind(&fastpath_resource_type::_run_printer, this)));
+        }
+        _counts[(unsigned char)event].inc();
+        _queue.bounded_push(event);
+    }
+
+    size_t get_count(const char event){
+        return _counts[(unsigned char)event].read();
+    }
+
+    /*!
+     * Hand the pending events to the message handler in one message.
+     * \param limit true to apply the rate limit
+     */
+    void drain(const bool limit){
+        boost::mutex::scoped_lock drain_lock(_drain_mutex);
+        std::string msg;
+        size_t num_events = 0;
+        char event;
+        while (_queue.pop(event)){
+            if (not limit or num_events < FASTPATH_MAX_PER_PERIOD) msg += event;
+            num_events++;
+        }
+        if (not msg.empty()){
+            boost::mutex::scoped_lock lock(msg_rs().mutex);
+            msg_rs().handler(uhd::msg::fastpath, msg);
+        }
+    }
+
+private:
+    void _run_printer(void){
+        try{
+            while (true){
+                this->drain(true);
+                boost::this_thread::sleep(boost::posix_time::milliseconds(FASTPATH_PERIOD_MS));
+            }
+        }
+        catch(const boost::thread_interrupted &){
+            /* NOP */
+        }
+    }
+
+    boost::lockfree::queue<char, boost::lockfree::capacity<FASTPATH_QUEUE_SIZE> > _queue;
+    uhd::atomic_uint32_t _counts[256];
+    boost::mutex _drain_mutex;
+    uhd::atomic_uint32_t _printer_started;
+    boost::scoped_ptr<boost::thread> _printer_thread;
+};
+
+UHD_SINGLETON_FCN(fastpath_resource_type, fastpath_rs);
+
+void uhd::msg::post_fastpath(const char event){
+    fastpath_rs().post(event);
+}
+
+size_t uhd::msg::get_fastpath_count(const char event){
+    return fastpath_rs().get_count(event);
+}
+
+void uhd::msg::flush_fastpath(void){
+    fastpath_rs().drain(false);
+}
+
 /***********************************************************************
  * The message object implementation
  **********************************************************************/
@@ -121,6 +220,14 @@ uhd::msg::_msg::_msg(const type_t type){
 }
 
 uhd::msg::_msg::~_msg(void){
+    //single event characters take the non-blocking path
+    if (_impl->type == fastpath){
+        const std::string msg = _impl->ss.str();
+        if (msg.size() == 1){
+            fastpath_rs().post(msg[0]);
+            return;
+        }
+    }
     boost::mutex::scoped_lock lock(msg_rs().mutex);
     msg_rs().handler(_impl->type, _impl->ss.str());
 }
@@ -35,6 +35,19 @@ bool uhd::set_thread_priority_safe(float priority, bool realtime){
     }
 }
 
+bool uhd::set_thread_affinity_safe(const size_t cpu){
+    try{
+        set_thread_affinity(cpu);
+        return true;
+    }catch(const std::exception &e){
+        UHD_MSG(warning) << boost::format(
+            "Unable to pin the thread to CPU %u. Performance may be negatively affected.\n"
+            "%s\n"
+        ) % cpu % e.what();
+        return false;
+    }
+}
+
 static void check_priority_range(float priority){
     if (priority > +1.0 or priority < -1.0)
         throw uhd::value_error("priority out of range [-1.0, +1.0]");
@@ -68,6 +81,19 @@ static void check_priority_range(float priority){
     }
 #endif /* HAVE_PTHREAD_SETSCHEDPARAM */
 
+#ifdef HAVE_PTHREAD_SETAFFINITY_NP
+    #include <pthread.h>
+
+    void uhd::set_thread_affinity(const size_t cpu){
+        if (cpu >= CPU_SETSIZE) throw uhd::value_error("CPU index out of range");
+        cpu_set_t cpu_set;
+        CPU_ZERO(&cpu_set);
+        CPU_SET(cpu, &cpu_set);
+        int ret = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set);
+        if (ret != 0) throw uhd::os_error("error in pthread_setaffinity_np");
+    }
+#endif /* HAVE_PTHREAD_SETAFFINITY_NP */
+
 /***********************************************************************
  * Windows API to set priority
  **********************************************************************/
@@ -97,6 +123,12 @@ static void check_priority_range(float priority){
         if (SetThreadPriority(GetCurrentThread(), priorities[pri_index]) == 0)
             throw uhd::os_error("error in SetThreadPriority");
     }
+
+    void uhd::set_thread_affinity(const size_t cpu){
+        if (cpu >= sizeof(DWORD_PTR)*8) throw uhd::value_error("CPU index out of range");
+        if (SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << cpu) == 0)
+            throw uhd::os_error("error in SetThreadAffinityMask");
+    }
 #endif /* HAVE_WIN_SETTHREADPRIORITY */
 
 /***********************************************************************
@@ -108,3 +140,9 @@ static void check_priority_range(float priority){
     }
 
 #endif /* HAVE_THREAD_PRIO_DUMMY */
+
+#ifdef HAVE_THREAD_AFFINITY_DUMMY
+    void uhd::set_thread_affinity(const size_t){
+        throw uhd::not_implemented_error("set thread affinity not implemented");
+    }
+#endif /* HAVE_THREAD_AFFINITY_DUMMY */
@@ -0,0 +1,222 @@
+//
+// Copyright 2016 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <boost/test/unit_test.hpp>
+#include "ad9361_device.h"
+#include <uhd/exception.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/foreach.hpp>
+#include <boost/format.hpp>
+#include <boost/make_shared.hpp>
+#include <iostream>
+#include <map>
+
+using namespace uhd::usrp;
+
+/***********************************************************************
+ * Mock AD9361: a register file with self-clearing calibration bits
+ **********************************************************************/
+class mock_ad9361_params : public ad9361_params
+{
+public:
+    double get_band_edge(frequency_band_t band) {
+        switch (band) {
+            case AD9361_RX_BAND0:   return 2.2e9;
+            case AD9361_RX_BAND1:   return 4.0e9;
+            case AD9361_TX_BAND0:   return 2.5e9;
+            default:                return 0;
+        }
+    }
+    clocking_mode_t get_clocking_mode() {
+        return AD9361_XTAL_N_CLK_PATH;
+    }
+    digital_interface_mode_t get_digital_interface_mode() {
+        return AD9361_DDR_FDD_LVCMOS;
+    }
+    digital_interface_delays_t get_digital_interface_timing() {
+        digital_interface_delays_t delays;
+        delays.rx_clk_delay = 0;
+        delays.rx_data_delay = 0;
+        delays.tx_clk_delay = 0;
+        delays.tx_data_delay = 0;
+        return delays;
+    }
+};
+
+class mock_ad9361_io : public ad9361_io
+{
+public:
+    typedef boost::shared_ptr<mock_ad9361_io> sptr;
+
+    /*!
+     * \param busy_reads number of status reads before a calibration
+     *                   completes or a PLL reports lock
+     */
+    mock_ad9361_io(size_t busy_reads) :
+        _busy_reads(busy_reads), _cal_reads(0), _stuck_cal_bits(0)
+    {
+        _regs[0x037] = 0x08; // device ID
+    }
+
+    uint8_t peek8(uint32_t reg)
+    {
+        switch (reg) {
+        case 0x016: // calibration control, bits self-clear when done
+            if (_cal_reads++ >= _busy_reads) {
+                _regs[reg] &= _stuck_cal_bits;
+            }
+            return _regs[reg];
+        case 0x05e: // BBPLL lock
+        case 0x244: // RX charge pump cal done
+        case 0x284: // TX charge pump cal done
+            return (_cal_reads++ >= _busy_reads) ? 0x80 : 0x00;
+        case 0x247: // RX PLL lock
+        case 0x287: // TX PLL lock
+            return (_cal_reads++ >= _busy_reads) ? 0x02 : 0x00;
+        case 0x00C: // AuxADC valid
+            return 0x02;
+        default:
+            return _regs[reg];
+        }
+    }
+
+    void poke8(uint32_t reg, uint8_t val)
+    {
+        switch (reg) {
+        case 0x014: // ENSM control
+            if (val & 0x20) {
+                _regs[0x017] = 0x0A; // FDD
+            } else if (val & 0x01) {
+                _regs[0x017] = 0x05; // ALERT
+            } else {
+                _regs[0x017] = 0x00; // SLEEP / WAIT
+            }
+            break;
+        case 0x016: // starting a calibration
+            _cal_reads = 0;
+            break;
+        case 0x23d: // starting a charge pump cal
+        case 0x27d:
+        case 0x03f: // starting a BBPLL cal
+        case 0x005: // retuning the synthesizers
+            _cal_reads = 0;
+            break;
+        }
+        _regs[reg] = val;
+        _pokes[reg]++;
+    }
+
+    //! Number of writes to a register so far
+    size_t get_poke_count(uint32_t reg)
+    {
+        return _pokes[reg];
+    }
+
+    //! Calibrations selected by mask never complete
+    void set_stuck_cal_bits(uint8_t mask)
+    {
+        _stuck_cal_bits = mask;
+    }
+
+private:
+    std::map<uint32_t, uint8_t> _regs;
+    std::map<uint32_t, size_t> _pokes;
+    const size_t _busy_reads;
+    size_t _cal_reads;
+    uint8_t _stuck_cal_bits;
+};
+
+static double seconds_since(const boost::posix_time::ptime &start)
+{
+    return (boost::posix_time::microsec_clock::universal_time() - start).total_microseconds() / 1e6;
+}
+
+BOOST_AUTO_TEST_CASE(test_ad9361_status_polling){
+    mock_ad9361_io::sptr io = boost::make_shared<mock_ad9361_io>(3);
+    ad9361_device_t device(boost::make_shared<mock_ad9361_params>(), io);
+
+    boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+    device.initialize();
+    std::cout << boost::format("AD9361 initialize(): %.1f ms") % (seconds_since(start) * 1e3) << std::endl;
+
+    start = boost::posix_time::microsec_clock::universal_time();
+    device.set_clock_rate(30.72e6);
+    std::cout << boost::format("AD9361 set_clock_rate(): %.1f ms") % (seconds_since(start) * 1e3) << std::endl;
+
+    start = boost::posix_time::microsec_clock::universal_time();
+    device.tune(ad9361_device_t::RX, 2.4e9);
+    std::cout << boost::format("AD9361 tune(): %.1f ms") % (seconds_since(start) * 1e3) << std::endl;
+
+    //Every polled step must have been recorded
+    const ad9361_device_t::step_timing_t timing = device.get_step_timing();
+    static const char *steps[] = {
+        "BBPLL lock", "RX charge pump cal", "TX charge pump cal",
+        "RX baseband filter cal", "TX baseband filter cal",
+        "baseband DC offset cal", "RF DC offset cal",
+        "RX quadrature cal", "TX quadrature cal",
+        "RX PLL lock", "TX PLL lock", "ENSM to ALERT"
+    };
+    BOOST_FOREACH(const char *step, steps) {
+        BOOST_CHECK_MESSAGE(timing.count(step), step);
+    }
+    BOOST_FOREACH(const ad9361_device_t::step_timing_t::value_type &step, timing) {
+        std::cout << boost::format("    %-24s %8.3f ms") % step.first % (step.second * 1e3) << std::endl;
+        //A few polls of the mock take far less than the old fixed sleeps
+        BOOST_CHECK_LT(step.second, 0.05);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_ad9361_cal_timeout){
+    mock_ad9361_io::sptr io = boost::make_shared<mock_ad9361_io>(0);
+    ad9361_device_t device(boost::make_shared<mock_ad9361_params>(), io);
+    device.initialize();
+
+    //The TX quadrature cal never completes: the failure is reported once
+    //its timeout expires
+    io->set_stuck_cal_bits(0x10);
+    const boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+    BOOST_CHECK_THROW(device.tune(ad9361_device_t::TX, 2.4e9), uhd::runtime_error);
+    BOOST_CHECK_GE(seconds_since(start), 1.0);
+    BOOST_CHECK_GE(device.get_step_timing()["TX quadrature cal"], 1.0);
+}
+
+BOOST_AUTO_TEST_CASE(test_ad9361_cached_clock_config){
+    mock_ad9361_io::sptr io = boost::make_shared<mock_ad9361_io>(0);
+    ad9361_device_t device(boost::make_shared<mock_ad9361_params>(), io);
+    device.initialize();
+
+    //Both rates use the same FIR tap sets, so switching between them must
+    //not reprogram the filters (0x0f5: RX FIR config register)
+    const double rate_a = device.set_clock_rate(30.72e6);
+    const size_t fir_writes = io->get_poke_count(0x0f5);
+    const double rate_b = device.set_clock_rate(15.36e6);
+    BOOST_CHECK_CLOSE(rate_b, 15.36e6, 1e-3);
+    BOOST_CHECK_EQUAL(io->get_poke_count(0x0f5), fir_writes);
+
+    //Switching back reuses the cached configuration
+    BOOST_CHECK_EQUAL(device.set_clock_rate(30.72e6), rate_a);
+    BOOST_CHECK_EQUAL(io->get_poke_count(0x0f5), fir_writes);
+
+    //Setting the same bandwidth again (e.g. for the second channel) skips
+    //the analog filter calibration (0x1f8: RX BB filter tune divider)
+    const double bw = device.set_bw_filter(ad9361_device_t::RX, 20e6);
+    const size_t cal_writes = io->get_poke_count(0x1f8);
+    BOOST_CHECK_EQUAL(device.set_bw_filter(ad9361_device_t::RX, 20e6), bw);
+    BOOST_CHECK_EQUAL(io->get_poke_count(0x1f8), cal_writes);
+    device.set_bw_filter(ad9361_device_t::RX, 10e6);
+    BOOST_CHECK_EQUAL(io->get_poke_count(0x1f8), cal_writes + 1);
+}
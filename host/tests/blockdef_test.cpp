@@ -22,6 +22,7 @@
 #include <boost/test/unit_test.hpp>
 #include <boost/format.hpp>
 #include <boost/foreach.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
 #include <uhd/rfnoc/blockdef.hpp>
 
 using namespace uhd::rfnoc;
@@ -92,3 +93,33 @@ BOOST_AUTO_TEST_CASE(test_regs) {
     BOOST_CHECK_EQUAL(user_regs["RB_MAGNITUDE_OUT"], 1);
 }
 
+
+BOOST_AUTO_TEST_CASE(test_lookup_repeated) {
+    static const size_t NUM_ITERS = 100;
+    // One lookup per block, as done when initializing a device with 10 blocks
+    const std::vector<uint64_t> noc_ids = boost::assign::list_of<uint64_t>
+        (0)(0xFF70000000000000)(0xF112000000000001)(0xF1F0000000000000)
+        (0xD053000000000000)(0xDDC0000000000000)(0xD0C0000000000000)
+        (0x0246000000000000)(0x5166311000000000)(0xADD0000000000000)
+    ;
+
+    const boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+    for (size_t n = 0; n < NUM_ITERS; n++) {
+        BOOST_FOREACH(const uint64_t noc_id, noc_ids) {
+            BOOST_REQUIRE(blockdef::make_from_noc_id(noc_id));
+        }
+    }
+    const double lookup_ms = (boost::posix_time::microsec_clock::universal_time() - start).total_microseconds() / 1e3 / NUM_ITERS;
+    std::cout << boost::format("Block definitions for 10 blocks: %.3f ms") % lookup_ms << std::endl;
+
+    // Each lookup returns a separate instance for the requested NoC ID
+    blockdef::sptr fir0 = blockdef::make_from_noc_id(0xF112000000000001);
+    blockdef::sptr fir1 = blockdef::make_from_noc_id(0xF112000000000001);
+    BOOST_CHECK(fir0 != fir1);
+    BOOST_CHECK_EQUAL(fir0->get_name(), "FIR");
+    BOOST_CHECK_EQUAL(fir1->noc_id(), 0xF112000000000001);
+
+    // Misses are remembered, too
+    BOOST_CHECK(not blockdef::make_from_noc_id(0x0123456789ABCDEF));
+    BOOST_CHECK(not blockdef::make_from_noc_id(0x0123456789ABCDEF));
+}
@@ -18,6 +18,8 @@
 #include <boost/test/unit_test.hpp>
 #include <uhd/types/dict.hpp>
 #include <boost/assign/list_of.hpp>
+#include <boost/lexical_cast.hpp>
+#include <vector>
 
 BOOST_AUTO_TEST_CASE(test_dict_init){
     uhd::dict<int, int> d;
@@ -95,3 +97,110 @@ BOOST_AUTO_TEST_CASE(test_dict_update)
 }
 
 
+
+BOOST_AUTO_TEST_CASE(test_dict_large)
+{
+    //Enough items for the keys to be indexed
+    uhd::dict<std::string, int> d;
+    for (int i = 0; i < 100; i++) {
+        d[boost::lexical_cast<std::string>(i)] = i;
+    }
+    BOOST_CHECK_EQUAL(d.size(), size_t(100));
+    BOOST_CHECK_EQUAL(d["42"], 42);
+    BOOST_CHECK_EQUAL(d.get("100", -1), -1);
+    BOOST_CHECK(not d.has_key("100"));
+
+    //Insertion order is kept, also after a pop
+    BOOST_CHECK_EQUAL(d.pop("0"), 0);
+    BOOST_CHECK_EQUAL(d.keys().front(), "1");
+    BOOST_CHECK_EQUAL(d.vals().back(), 99);
+    d["0"] = 0;
+    BOOST_CHECK_EQUAL(d.keys().back(), "0");
+    BOOST_CHECK(d.has_key("0"));
+
+    //References to values stay valid as items are added
+    int &val = d["42"];
+    for (int i = 100; i < 200; i++) {
+        d[boost::lexical_cast<std::string>(i)] = i;
+    }
+    val = -42;
+    BOOST_CHECK_EQUAL(d["42"], -42);
+
+    //Copies are independent
+    uhd::dict<std::string, int> d2 = d;
+    d2["42"] = 42;
+    d2.pop("43");
+    BOOST_CHECK_EQUAL(d["42"], -42);
+    BOOST_CHECK(d.has_key("43"));
+    BOOST_CHECK_EQUAL(d2["42"], 42);
+    BOOST_CHECK(not d2.has_key("43"));
+    d = d2;
+    BOOST_CHECK_EQUAL(d["42"], 42);
+    BOOST_CHECK(not d.has_key("43"));
+    BOOST_CHECK_EQUAL(d.size(), size_t(199));
+
+    //Pops down to a small dict fall back to the linear search
+    for (int i = 0; i < 195; i++) {
+        d.pop(d.keys().front());
+    }
+    BOOST_CHECK_EQUAL(d.size(), size_t(4));
+    BOOST_CHECK_EQUAL(d["199"], 199);
+    BOOST_CHECK(not d.has_key("42"));
+}
+
+BOOST_AUTO_TEST_CASE(test_dict_large_duplicates)
+{
+    //Like a linear search, the first of duplicate keys wins until it is popped
+    std::vector<std::pair<int, int> > items;
+    for (int i = 0; i < 20; i++) {
+        items.push_back(std::make_pair(i%10, i));
+    }
+    uhd::dict<int, int> d(items.begin(), items.end());
+    BOOST_CHECK_EQUAL(d[3], 3);
+    BOOST_CHECK_EQUAL(d.pop(3), 3);
+    BOOST_CHECK_EQUAL(d[3], 13);
+    BOOST_CHECK_EQUAL(d.pop(3), 13);
+    BOOST_CHECK(not d.has_key(3));
+    BOOST_CHECK_EQUAL(d[4], 4);
+}
+
+enum test_enum_t { ENUM_A, ENUM_B, ENUM_C };
+
+BOOST_AUTO_TEST_CASE(test_dict_enum_keys)
+{
+    uhd::dict<test_enum_t, std::string> d = boost::assign::map_list_of
+        (ENUM_C, "c")
+        (ENUM_A, "a")
+    ;
+    BOOST_CHECK_EQUAL(d[ENUM_A], "a");
+    BOOST_CHECK(not d.has_key(ENUM_B));
+    BOOST_CHECK(d.keys()[0] == ENUM_C);
+}
+
+//! A key type without a hash_value() overload
+struct test_key_t
+{
+    int value;
+    bool operator==(const test_key_t &rhs) const { return value == rhs.value; }
+};
+
+static std::ostream &operator<<(std::ostream &os, const test_key_t &key)
+{
+    return os << key.value;
+}
+
+BOOST_AUTO_TEST_CASE(test_dict_unhashable_keys)
+{
+    //Keys which cannot be hashed are searched linearly at any size
+    BOOST_CHECK(not uhd::dict_key_hashable<test_key_t>::value);
+    uhd::dict<test_key_t, int> d;
+    for (int i = 0; i < 20; i++) {
+        test_key_t key = {i};
+        d[key] = i;
+    }
+    test_key_t key = {13};
+    BOOST_CHECK_EQUAL(d[key], 13);
+    BOOST_CHECK_EQUAL(d.pop(key), 13);
+    BOOST_CHECK(not d.has_key(key));
+    BOOST_CHECK_EQUAL(d.size(), size_t(19));
+}
@@ -0,0 +1,258 @@
+//
+// Copyright 2016 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <boost/test/unit_test.hpp>
+#include "eeprom_cache.hpp"
+#include <uhd/exception.hpp>
+#include <uhd/utils/paths.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/make_shared.hpp>
+
+using namespace uhd;
+using namespace uhd::usrp;
+namespace fs = boost::filesystem;
+
+static const uint16_t EEPROM_ADDR = 0x50;
+static const size_t EEPROM_LEN = 48;
+static const size_t ID_LEN = 4;
+static const size_t CHECKSUM_OFFSET = 31;
+static const size_t CACHED_LEN = CHECKSUM_OFFSET + 1;
+static const size_t CHECK_LEN = ID_LEN + 1;
+
+/***********************************************************************
+ * An EEPROM which counts the bytes read from it, and whose writers keep
+ * the checksum up to date
+ **********************************************************************/
+class mock_eeprom : public i2c_iface
+{
+public:
+    typedef boost::shared_ptr<mock_eeprom> sptr;
+
+    mock_eeprom(uint8_t serial) : _bytes(EEPROM_LEN), _num_read(0), _last_offset(0)
+    {
+        for (size_t i = 0; i < EEPROM_LEN; i++) {
+            _bytes[i] = uint8_t(i);
+        }
+        _bytes[0] = serial;
+        update_checksum();
+    }
+
+    void write_i2c(uint16_t, const byte_vector_t &)
+    {
+        throw uhd::not_implemented_error("mock_eeprom");
+    }
+
+    byte_vector_t read_i2c(uint16_t, size_t)
+    {
+        throw uhd::not_implemented_error("mock_eeprom");
+    }
+
+    void write_eeprom(uint16_t addr, uint16_t offset, const byte_vector_t &buf)
+    {
+        BOOST_REQUIRE_EQUAL(addr, EEPROM_ADDR);
+        std::copy(buf.begin(), buf.end(), _bytes.begin() + offset);
+        update_checksum();
+    }
+
+    byte_vector_t read_eeprom(uint16_t addr, uint16_t offset, size_t num_bytes)
+    {
+        BOOST_REQUIRE_EQUAL(addr, EEPROM_ADDR);
+        _num_read += num_bytes;
+        _last_offset = offset;
+        return byte_vector_t(_bytes.begin() + offset, _bytes.begin() + offset + num_bytes);
+    }
+
+    //! Change the contents behind the back of the cache
+    void poke(size_t offset, uint8_t value)
+    {
+        _bytes.at(offset) = value;
+        update_checksum();
+    }
+
+    byte_vector_t get_bytes(size_t num_bytes = CACHED_LEN) const
+    {
+        return byte_vector_t(_bytes.begin(), _bytes.begin() + num_bytes);
+    }
+
+    uint16_t get_last_offset(void) const
+    {
+        return _last_offset;
+    }
+
+    size_t get_num_read(void)
+    {
+        const size_t num_read = _num_read;
+        _num_read = 0;
+        return num_read;
+    }
+
+private:
+    //! The negative sum of the bytes before the checksum
+    void update_checksum(void)
+    {
+        int sum = 0;
+        for (size_t i = 0; i < CHECKSUM_OFFSET; i++) {
+            sum -= int(_bytes[i]);
+        }
+        _bytes[CHECKSUM_OFFSET] = uint8_t(sum);
+    }
+
+    byte_vector_t _bytes;
+    size_t _num_read;
+    uint16_t _last_offset;
+};
+
+struct cache_file_fixture
+{
+    cache_file_fixture(void) :
+        path(fs::unique_path(fs::path(uhd::get_tmp_path()) / "eeprom_cache_test_%%%%%%%%" / "eeprom"))
+    {
+        /* NOP */
+    }
+
+    ~cache_file_fixture(void)
+    {
+        boost::system::error_code ec;
+        fs::remove_all(path.parent_path(), ec);
+    }
+
+    const fs::path path;
+};
+
+static i2c_iface::sptr make_iface(
+    eeprom_cache::sptr cache, i2c_iface::sptr eeprom, const std::string &tag, eeprom_cache::mode_t mode
+){
+    return cache->make_iface(eeprom, tag, ID_LEN, CHECKSUM_OFFSET, mode);
+}
+
+static byte_vector_t read_all(i2c_iface::sptr iface)
+{
+    return iface->read_eeprom(EEPROM_ADDR, 0, CACHED_LEN);
+}
+
+BOOST_FIXTURE_TEST_CASE(test_eeprom_cache_reads, cache_file_fixture){
+    mock_eeprom::sptr eeprom = boost::make_shared<mock_eeprom>(1);
+    eeprom_cache::sptr cache = eeprom_cache::make(path.string());
+    i2c_iface::sptr iface = make_iface(cache, eeprom, "test", eeprom_cache::CACHE_ON);
+
+    //The first read fills the cache with one read of the whole range,
+    //later ones only read the board ID and the checksum
+    BOOST_CHECK(read_all(iface) == eeprom->get_bytes());
+    BOOST_CHECK_EQUAL(eeprom->get_num_read(), CHECK_LEN + CACHED_LEN);
+    BOOST_CHECK_EQUAL(eeprom->get_last_offset(), 0);
+    BOOST_CHECK(read_all(iface) == eeprom->get_bytes());
+    BOOST_CHECK_EQUAL(eeprom->get_num_read(), CHECK_LEN);
+
+    //The contents are on disk for the next process
+    eeprom_cache::sptr reloaded = eeprom_cache::make(path.string());
+    BOOST_CHECK_EQUAL(reloaded->size(), size_t(1));
+    iface = make_iface(reloaded, eeprom, "test", eeprom_cache::CACHE_ON);
+    BOOST_CHECK(read_all(iface) == eeprom->get_bytes());
+    BOOST_CHECK_EQUAL(eeprom->get_num_read(), CHECK_LEN);
+
+    //Another board or other images do not use the cached contents
+    mock_eeprom::sptr other = boost::make_shared<mock_eeprom>(2);
+    BOOST_CHECK(read_all(make_iface(reloaded, other, "test", eeprom_cache::CACHE_ON)) == other->get_bytes());
+    BOOST_CHECK_EQUAL(other->get_num_read(), CHECK_LEN + CACHED_LEN);
+    BOOST_CHECK(read_all(make_iface(reloaded, eeprom, "other", eeprom_cache::CACHE_ON)) == eeprom->get_bytes());
+    BOOST_CHECK_EQUAL(eeprom->get_num_read(), CHECK_LEN + CACHED_LEN);
+    BOOST_CHECK_EQUAL(reloaded->size(), size_t(3));
+
+    //Reads no longer than the board ID and checksum always go to the EEPROM
+    BOOST_CHECK_EQUAL(iface->read_eeprom(EEPROM_ADDR, 2, 1).at(0), 2);
+    BOOST_CHECK_EQUAL(iface->read_eeprom(EEPROM_ADDR, 2, 1).at(0), 2);
+    BOOST_CHECK_EQUAL(eeprom->get_num_read(), size_t(2));
+
+    //So do reads of bytes which the checksum does not cover
+    BOOST_CHECK(iface->read_eeprom(EEPROM_ADDR, 0, EEPROM_LEN) == eeprom->get_bytes(EEPROM_LEN));
+    BOOST_CHECK(iface->read_eeprom(EEPROM_ADDR, 0, EEPROM_LEN) == eeprom->get_bytes(EEPROM_LEN));
+    BOOST_CHECK_EQUAL(eeprom->get_num_read(), 2*EEPROM_LEN);
+    BOOST_CHECK_EQUAL(reloaded->size(), size_t(3));
+}
+
+BOOST_FIXTURE_TEST_CASE(test_eeprom_cache_invalidate, cache_file_fixture){
+    mock_eeprom::sptr eeprom = boost::make_shared<mock_eeprom>(1);
+    eeprom_cache::sptr cache = eeprom_cache::make(path.string());
+    i2c_iface::sptr iface = make_iface(cache, eeprom, "test", eeprom_cache::CACHE_ON);
+    read_all(iface);
+    read_all(make_iface(cache, eeprom, "other", eeprom_cache::CACHE_ON));
+    BOOST_CHECK_EQUAL(cache->size(), size_t(2));
+
+    //Writes drop the cached contents of their tag
+    iface->write_eeprom(EEPROM_ADDR, 20, byte_vector_t(1, 0x55));
+    BOOST_CHECK_EQUAL(cache->size(), size_t(1));
+    BOOST_CHECK_EQUAL(read_all(iface).at(20), 0x55);
+
+    //Changes made behind the back of the cache change the checksum,
+    //so the contents are read again
+    eeprom->poke(20, 0x66);
+    eeprom->get_num_read();
+    BOOST_CHECK_EQUAL(read_all(iface).at(20), 0x66);
+    BOOST_CHECK_EQUAL(eeprom->get_num_read(), CHECK_LEN + CACHED_LEN);
+    BOOST_CHECK_EQUAL(read_all(iface).at(20), 0x66);
+    BOOST_CHECK_EQUAL(eeprom->get_num_read(), CHECK_LEN);
+
+    //A refresh reads all contents again
+    i2c_iface::sptr refresh = make_iface(cache, eeprom, "test", eeprom_cache::CACHE_REFRESH);
+    BOOST_CHECK(read_all(refresh) == eeprom->get_bytes());
+    BOOST_CHECK_EQUAL(eeprom->get_num_read(), CHECK_LEN + CACHED_LEN);
+
+    //Without the cache, reads go to the EEPROM but writes still invalidate
+    const size_t num_cached = cache->size();
+    i2c_iface::sptr uncached = make_iface(cache, eeprom, "test", eeprom_cache::CACHE_OFF);
+    BOOST_CHECK(read_all(uncached) == eeprom->get_bytes());
+    BOOST_CHECK_EQUAL(eeprom->get_num_read(), CACHED_LEN);
+    uncached->write_eeprom(EEPROM_ADDR, 0, byte_vector_t(1, 1));
+    BOOST_CHECK_LT(cache->size(), num_cached);
+
+    cache->clear();
+    BOOST_CHECK_EQUAL(cache->size(), size_t(0));
+    BOOST_CHECK(not fs::exists(path));
+}
+
+BOOST_FIXTURE_TEST_CASE(test_eeprom_cache_shared_file, cache_file_fixture){
+    //Two caches on one file, as two processes would have
+    mock_eeprom::sptr eeprom1 = boost::make_shared<mock_eeprom>(1);
+    mock_eeprom::sptr eeprom2 = boost::make_shared<mock_eeprom>(2);
+    eeprom_cache::sptr cache1 = eeprom_cache::make(path.string());
+    eeprom_cache::sptr cache2 = eeprom_cache::make(path.string());
+    BOOST_CHECK_EQUAL(cache1->size(), size_t(0));
+
+    //Neither cache overwrites the entries the other one added
+    read_all(make_iface(cache1, eeprom1, "test", eeprom_cache::CACHE_ON));
+    read_all(make_iface(cache2, eeprom2, "test", eeprom_cache::CACHE_ON));
+    read_all(make_iface(cache1, eeprom1, "other", eeprom_cache::CACHE_ON));
+    BOOST_CHECK_EQUAL(cache1->size(), size_t(3));
+    BOOST_CHECK_EQUAL(cache2->size(), size_t(3));
+
+    //Invalidations made by one cache are seen by the other one
+    cache2->invalidate("test");
+    BOOST_CHECK_EQUAL(cache1->size(), size_t(1));
+    eeprom1->get_num_read();
+    read_all(make_iface(cache1, eeprom1, "test", eeprom_cache::CACHE_ON));
+    BOOST_CHECK_EQUAL(eeprom1->get_num_read(), CHECK_LEN + CACHED_LEN);
+}
+
+BOOST_AUTO_TEST_CASE(test_eeprom_cache_mode){
+    BOOST_CHECK_EQUAL(eeprom_cache::get_mode(device_addr_t("addr=192.168.10.2")), eeprom_cache::CACHE_OFF);
+    BOOST_CHECK_EQUAL(eeprom_cache::get_mode(device_addr_t("addr=192.168.10.2,eeprom_cache")), eeprom_cache::CACHE_ON);
+    BOOST_CHECK_EQUAL(eeprom_cache::get_mode(device_addr_t("eeprom_cache=on")), eeprom_cache::CACHE_ON);
+    BOOST_CHECK_EQUAL(eeprom_cache::get_mode(device_addr_t("eeprom_cache=off")), eeprom_cache::CACHE_OFF);
+    BOOST_CHECK_EQUAL(eeprom_cache::get_mode(device_addr_t("eeprom_cache=refresh")), eeprom_cache::CACHE_REFRESH);
+    BOOST_CHECK_THROW(eeprom_cache::get_mode(device_addr_t("eeprom_cache=0")), uhd::value_error);
+    BOOST_CHECK_THROW(eeprom_cache::get_mode(device_addr_t("eeprom_cache=1")), uhd::value_error);
+}
@@ -21,7 +21,13 @@
 #include "../lib/experts/expert_container.hpp"
 #include "../lib/experts/expert_factory.hpp"
 #include <uhd/property_tree.hpp>
+#include <uhd/exception.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/thread.hpp>
 #include <fstream>
+#include <iostream>
+#include <vector>
 
 using namespace uhd::experts;
 
@@ -254,3 +260,273 @@ BOOST_AUTO_TEST_CASE(test_experts){
     container->resolve_to("Consume_G");
     VALIDATE_ALL_DEPENDENCIES
 }
+
+//=============================================================================
+// A frontend-like graph for the resolve benchmark: per channel, a frequency
+// expert feeds a gain expert, and a shared settings expert reads all channels
+//=============================================================================
+
+class bench_freq_worker_t : public worker_node_t {
+public:
+    bench_freq_worker_t(const node_retriever_t& db, const std::string& ch, boost::shared_ptr<size_t> count)
+    : worker_node_t(ch + "/freq_expert"),
+      _desired(db, ch + "/freq/desired"), _coerced(db, ch + "/freq/coerced"),
+      _lo_freq(db, ch + "/lo_freq"), _count(count)
+    {
+        bind_accessor(_desired);
+        bind_accessor(_coerced);
+        bind_accessor(_lo_freq);
+    }
+
+private:
+    void resolve() {
+        (*_count)++;
+        _coerced = _desired.get();
+        _lo_freq = _desired.get() + 10e6;
+    }
+
+    data_reader_t<double> _desired;
+    data_writer_t<double> _coerced;
+    data_writer_t<double> _lo_freq;
+    boost::shared_ptr<size_t> _count;
+};
+
+class bench_gain_worker_t : public worker_node_t {
+public:
+    bench_gain_worker_t(const node_retriever_t& db, const std::string& ch, boost::shared_ptr<size_t> count)
+    : worker_node_t(ch + "/gain_expert"),
+      _gain(db, ch + "/gain"), _lo_freq(db, ch + "/lo_freq"),
+      _setting(db, ch + "/gain_setting"), _count(count)
+    {
+        bind_accessor(_gain);
+        bind_accessor(_lo_freq);
+        bind_accessor(_setting);
+    }
+
+private:
+    void resolve() {
+        (*_count)++;
+        _setting = _gain.get() + (_lo_freq.get() > 3e9 ? 3.0 : 0.0);
+    }
+
+    data_reader_t<double> _gain;
+    data_reader_t<double> _lo_freq;
+    data_writer_t<double> _setting;
+    boost::shared_ptr<size_t> _count;
+};
+
+class bench_settings_worker_t : public worker_node_t {
+public:
+    bench_settings_worker_t(const node_retriever_t& db, size_t num_chans, boost::shared_ptr<size_t> count)
+    : worker_node_t("settings_expert"), _commits(db, "commits"), _count(count)
+    {
+        for (size_t i = 0; i < num_chans; i++) {
+            const std::string ch = str(boost::format("ch%d") % i);
+            _inputs.push_back(boost::shared_ptr< data_reader_t<double> >(
+                new data_reader_t<double>(db, ch + "/lo_freq")));
+            _inputs.push_back(boost::shared_ptr< data_reader_t<double> >(
+                new data_reader_t<double>(db, ch + "/gain_setting")));
+        }
+        for (size_t i = 0; i < _inputs.size(); i++) {
+            bind_accessor(*_inputs[i]);
+        }
+        bind_accessor(_commits);
+    }
+
+private:
+    void resolve() {
+        (*_count)++;
+        _commits = _commits.get() + 1;
+    }
+
+    std::vector< boost::shared_ptr< data_reader_t<double> > > _inputs;
+    data_writer_t<int> _commits;
+    boost::shared_ptr<size_t> _count;
+};
+
+static const size_t BENCH_NUM_CHANS = 16;
+
+static void make_bench_graph(
+    expert_container::sptr container,
+    uhd::property_tree::sptr tree,
+    boost::shared_ptr<size_t> count,
+    auto_resolve_mode_t freq_resolve_mode
+) {
+    for (size_t i = 0; i < BENCH_NUM_CHANS; i++) {
+        const std::string ch = str(boost::format("ch%d") % i);
+        expert_factory::add_dual_prop_node<double>(container, tree, ch + "/freq", 1e9, freq_resolve_mode);
+        expert_factory::add_prop_node<double>(container, tree, ch + "/gain", 0.0);
+        expert_factory::add_data_node<double>(container, ch + "/lo_freq", 0.0);
+        expert_factory::add_data_node<double>(container, ch + "/gain_setting", 0.0);
+    }
+    expert_factory::add_data_node<int>(container, "commits", 0);
+    for (size_t i = 0; i < BENCH_NUM_CHANS; i++) {
+        const std::string ch = str(boost::format("ch%d") % i);
+        expert_factory::add_worker_node<bench_freq_worker_t>(container, container->node_retriever(), ch, count);
+        expert_factory::add_worker_node<bench_gain_worker_t>(container, container->node_retriever(), ch, count);
+    }
+    expert_factory::add_worker_node<bench_settings_worker_t>(container, container->node_retriever(), BENCH_NUM_CHANS, count);
+    container->resolve_all();
+}
+
+BOOST_AUTO_TEST_CASE(test_experts_incremental_resolve){
+    static const size_t NUM_ITERS = 1000;
+
+    expert_container::sptr container = expert_factory::create_container("bench");
+    uhd::property_tree::sptr tree = uhd::property_tree::make();
+    boost::shared_ptr<size_t> count = boost::make_shared<size_t>(0);
+    make_bench_graph(container, tree, count, AUTO_RESOLVE_ON_READ_WRITE);
+
+    //A retune of one channel only runs the experts of that channel and the
+    //shared settings expert, whether triggered by the write or by the read
+    *count = 0;
+    tree->access<double>("ch0/freq").set(2.4e9);
+    BOOST_CHECK_EQUAL(*count, size_t(3));
+    BOOST_CHECK_EQUAL(tree->access<double>("ch0/freq").get(), 2.4e9);
+    BOOST_CHECK_EQUAL(*count, size_t(3));
+
+    //A read only resolves what the read value depends on: the pending gain
+    //change on channel 1 is applied by the next write-triggered resolve
+    tree->access<double>("ch1/gain").set(10.0);
+    *count = 0;
+    BOOST_CHECK_EQUAL(tree->access<double>("ch0/freq").get(), 2.4e9);
+    BOOST_CHECK_EQUAL(*count, size_t(0));
+    tree->access<double>("ch0/freq").set(2.5e9);
+    BOOST_CHECK_EQUAL(*count, size_t(4));
+
+    //Benchmark: worker invocations and time per retune (write + read back)
+    *count = 0;
+    boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+    for (size_t n = 0; n < NUM_ITERS; n++) {
+        tree->access<double>("ch3/freq").set(1e9 + (n % 2 + 1) * 1e6);
+        tree->access<double>("ch3/freq").get();
+    }
+    const double incr_us = (boost::posix_time::microsec_clock::universal_time() - start).total_microseconds() / double(NUM_ITERS);
+    const double incr_count = double(*count) / NUM_ITERS;
+
+    //The same retunes on a graph that is fully resolved after every write
+    //and before every read
+    expert_container::sptr full_container = expert_factory::create_container("bench_full");
+    uhd::property_tree::sptr full_tree = uhd::property_tree::make();
+    boost::shared_ptr<size_t> full_count = boost::make_shared<size_t>(0);
+    make_bench_graph(full_container, full_tree, full_count, AUTO_RESOLVE_OFF);
+    *full_count = 0;
+    start = boost::posix_time::microsec_clock::universal_time();
+    for (size_t n = 0; n < NUM_ITERS; n++) {
+        full_tree->access<double>("ch3/freq").set(1e9 + (n % 2 + 1) * 1e6);
+        full_container->resolve_all();
+        full_container->resolve_all();
+        full_tree->access<double>("ch3/freq").get();
+    }
+    const double full_us = (boost::posix_time::microsec_clock::universal_time() - start).total_microseconds() / double(NUM_ITERS);
+
+    std::cout << boost::format("Expert graph with %d workers, per retune: incremental resolve %.1f workers, %.2f us; "
+                               "full resolve %.1f workers, %.2f us")
+                 % (BENCH_NUM_CHANS * 2 + 1) % incr_count % incr_us % (double(*full_count) / NUM_ITERS) % full_us << std::endl;
+    BOOST_CHECK_EQUAL(incr_count, 3.0);
+}
+
+//=============================================================================
+// Independent per-channel workers that take a while to finish, as if they
+// were programming hardware, followed by a worker that reads all channels
+//=============================================================================
+
+class slow_tune_worker_t : public worker_node_t {
+public:
+    slow_tune_worker_t(const node_retriever_t& db, const std::string& ch)
+    : worker_node_t(ch + "/tune_expert"), _freq(db, ch + "/freq"), _lo_freq(db, ch + "/lo_freq")
+    {
+        bind_accessor(_freq);
+        bind_accessor(_lo_freq);
+    }
+
+private:
+    void resolve() {
+        if (_freq.get() < 0) {
+            throw uhd::value_error("invalid frequency for " + get_name());
+        }
+        boost::this_thread::sleep(boost::posix_time::milliseconds(20));
+        _lo_freq = _freq.get() + 10e6;
+    }
+
+    data_reader_t<double> _freq;
+    data_writer_t<double> _lo_freq;
+};
+
+class lo_sum_worker_t : public worker_node_t {
+public:
+    lo_sum_worker_t(const node_retriever_t& db, size_t num_chans)
+    : worker_node_t("lo_sum_expert"), _sum(db, "lo_sum")
+    {
+        for (size_t i = 0; i < num_chans; i++) {
+            _lo_freqs.push_back(boost::shared_ptr< data_reader_t<double> >(
+                new data_reader_t<double>(db, str(boost::format("ch%d/lo_freq") % i))));
+            bind_accessor(*_lo_freqs.back());
+        }
+        bind_accessor(_sum);
+    }
+
+private:
+    void resolve() {
+        double sum = 0.0;
+        for (size_t i = 0; i < _lo_freqs.size(); i++) {
+            sum += _lo_freqs[i]->get();
+        }
+        _sum = sum;
+    }
+
+    std::vector< boost::shared_ptr< data_reader_t<double> > > _lo_freqs;
+    data_writer_t<double> _sum;
+};
+
+static double time_slow_tune(expert_container::sptr container, uhd::property_tree::sptr tree, size_t num_chans)
+{
+    for (size_t i = 0; i < num_chans; i++) {
+        const std::string ch = str(boost::format("ch%d") % i);
+        expert_factory::add_prop_node<double>(container, tree, ch + "/freq", 1e9);
+        expert_factory::add_data_node<double>(container, ch + "/lo_freq", 0.0);
+        expert_factory::add_worker_node<slow_tune_worker_t>(container, container->node_retriever(), ch);
+    }
+    expert_factory::add_data_node<double>(container, "lo_sum", 0.0);
+    expert_factory::add_worker_node<lo_sum_worker_t>(container, container->node_retriever(), num_chans);
+    container->resolve_all();
+
+    //Retune all channels at once
+    for (size_t i = 0; i < num_chans; i++) {
+        tree->access<double>(str(boost::format("ch%d/freq") % i)).set(2e9 + i * 1e6);
+    }
+    const boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+    container->resolve_all();
+    return (boost::posix_time::microsec_clock::universal_time() - start).total_microseconds() / 1e3;
+}
+
+BOOST_AUTO_TEST_CASE(test_experts_parallel_workers){
+    static const size_t NUM_CHANS = 4;
+
+    expert_container::sptr serial = expert_factory::create_container("serial");
+    uhd::property_tree::sptr serial_tree = uhd::property_tree::make();
+    const double serial_ms = time_slow_tune(serial, serial_tree, NUM_CHANS);
+
+    expert_container::sptr parallel = expert_factory::create_container("parallel", NUM_CHANS);
+    uhd::property_tree::sptr parallel_tree = uhd::property_tree::make();
+    const double parallel_ms = time_slow_tune(parallel, parallel_tree, NUM_CHANS);
+
+    std::cout << boost::format("Retune of %d channels: %.1f ms sequential, %.1f ms with parallel workers")
+                 % NUM_CHANS % serial_ms % parallel_ms << std::endl;
+    BOOST_CHECK_LT(parallel_ms, serial_ms / 2);
+
+    //The shared worker ran after all the channel workers
+    const double expected_sum = NUM_CHANS * (2e9 + 10e6) + (NUM_CHANS * (NUM_CHANS - 1) / 2) * 1e6;
+    BOOST_CHECK_EQUAL(dynamic_cast<const data_node_t<double>&>(serial->node_retriever().lookup("lo_sum")).get(), expected_sum);
+    BOOST_CHECK_EQUAL(dynamic_cast<const data_node_t<double>&>(parallel->node_retriever().lookup("lo_sum")).get(), expected_sum);
+
+    //Errors from workers on the pool reach the caller, and the nodes they
+    //did not consume stay dirty
+    parallel_tree->access<double>("ch2/freq").set(-1.0);
+    BOOST_CHECK_THROW(parallel->resolve_all(), uhd::value_error);
+    BOOST_CHECK(parallel->node_retriever().lookup("ch2/freq").is_dirty());
+    parallel_tree->access<double>("ch2/freq").set(3e9);
+    parallel->resolve_all();
+    BOOST_CHECK(not parallel->node_retriever().lookup("ch2/freq").is_dirty());
+    BOOST_CHECK_EQUAL(dynamic_cast<const data_node_t<double>&>(parallel->node_retriever().lookup("ch2/lo_freq")).get(), 3e9 + 10e6);
+}
@@ -0,0 +1,121 @@
+//
+// Copyright 2016 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <boost/test/unit_test.hpp>
+#include <uhd/utils/log.hpp>
+#include <uhd/utils/paths.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/bind.hpp>
+#include <boost/format.hpp>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+namespace pt = boost::posix_time;
+
+static const size_t NUM_THREADS = 4;
+static const size_t NUM_ENTRIES = 250;
+
+static void log_entries(const std::string &marker, size_t thread)
+{
+    for (size_t n = 0; n < NUM_ENTRIES; n++) {
+        UHD_LOGV(never) << marker << " " << thread << " " << n;
+    }
+}
+
+static size_t num_evaluated = 0;
+
+static std::string expensive_operand(void)
+{
+    num_evaluated++;
+    return std::string(100, 'x');
+}
+
+BOOST_AUTO_TEST_CASE(test_log_threads){
+    //never is the most verbose level: only skip if logging was turned down
+    if (not uhd::_log::log::enabled(uhd::_log::never)) return;
+
+    const std::string marker = str(boost::format("log_test_%s") % pt::to_iso_string(pt::microsec_clock::universal_time()));
+    boost::thread_group threads;
+    for (size_t i = 0; i < NUM_THREADS; i++) {
+        threads.create_thread(boost::bind(&log_entries, marker, i));
+    }
+    threads.join_all();
+    uhd::_log::flush();
+
+    //every entry is in the file after the flush, in order per thread
+    const std::string log_path = (boost::filesystem::path(uhd::get_tmp_path()) / "uhd.log").string();
+    std::ifstream log_file(log_path.c_str());
+    BOOST_REQUIRE(log_file.is_open());
+    std::vector<size_t> next(NUM_THREADS, 0);
+    std::string line;
+    while (std::getline(log_file, line)) {
+        if (line.compare(0, marker.size(), marker) != 0) continue;
+        std::istringstream fields(line.substr(marker.size()));
+        size_t thread = 0, n = 0;
+        fields >> thread >> n;
+        BOOST_REQUIRE_LT(thread, NUM_THREADS);
+        BOOST_CHECK_EQUAL(n, next[thread]);
+        next[thread] = n + 1;
+    }
+    for (size_t i = 0; i < NUM_THREADS; i++) {
+        BOOST_CHECK_EQUAL(next[i], NUM_ENTRIES);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_log_long_entries){
+    if (not uhd::_log::log::enabled(uhd::_log::never)) return;
+
+    //an entry spans several slots of the ring, a very long one is truncated
+    const std::string marker = str(boost::format("log_test_long_%s") % pt::to_iso_string(pt::microsec_clock::universal_time()));
+    UHD_LOGV(never) << marker << std::string(1000, 'a') << "end";
+    UHD_LOGV(never) << marker << std::string(10000, 'b') << "end";
+    uhd::_log::flush();
+
+    const std::string log_path = (boost::filesystem::path(uhd::get_tmp_path()) / "uhd.log").string();
+    std::ifstream log_file(log_path.c_str());
+    BOOST_REQUIRE(log_file.is_open());
+    std::vector<std::string> lines;
+    std::string line;
+    while (std::getline(log_file, line)) {
+        if (line.compare(0, marker.size(), marker) == 0) lines.push_back(line);
+    }
+    BOOST_REQUIRE_EQUAL(lines.size(), size_t(2));
+    BOOST_CHECK_EQUAL(lines[0], marker + std::string(1000, 'a') + "end");
+    BOOST_CHECK_LT(lines[1].size(), size_t(4096));
+    BOOST_CHECK_EQUAL(lines[1].find("end"), std::string::npos);
+}
+
+BOOST_AUTO_TEST_CASE(test_log_filtered_cost){
+    static const size_t NUM_ITERS = 100000;
+
+    //always is the least verbose level, so it is only recorded at level always
+    if (uhd::_log::log::enabled(uhd::_log::always)) return;
+
+    const pt::ptime start = pt::microsec_clock::universal_time();
+    for (size_t n = 0; n < NUM_ITERS; n++) {
+        UHD_LOGV(always) << expensive_operand() << n;
+    }
+    const double filtered_ns = (pt::microsec_clock::universal_time() - start).total_nanoseconds() / double(NUM_ITERS);
+
+    //filtered statements do not evaluate their operands
+    BOOST_CHECK_EQUAL(num_evaluated, size_t(0));
+    std::cout << boost::format("Filtered log statement: %.1f ns") % filtered_ns << std::endl;
+}
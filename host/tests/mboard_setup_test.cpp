@@ -0,0 +1,123 @@
+//
+// Copyright 2016 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <boost/test/unit_test.hpp>
+#include "mboard_setup.hpp"
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/lexical_cast.hpp>
+#include <stdexcept>
+
+using namespace uhd;
+using namespace uhd::usrp;
+
+static const size_t NUM_MBOARDS = 4;
+
+//! Records which motherboards were set up and whether their setups overlapped
+struct setup_log_t
+{
+    setup_log_t(void): num_entered(0), num_overlapped(0), done(NUM_MBOARDS, false) {}
+
+    //! Waits until all motherboards are inside their setup at the same time
+    void setup(const size_t mb_i, const device_addr_t &dev_addr)
+    {
+        boost::mutex::scoped_lock lock(mutex);
+        BOOST_CHECK_EQUAL(dev_addr["serial"], boost::lexical_cast<std::string>(mb_i));
+        num_entered++;
+        cond.notify_all();
+        //setups which run one after another give up after the deadline
+        const boost::system_time deadline = boost::get_system_time() + boost::posix_time::seconds(10);
+        while (num_entered < NUM_MBOARDS) {
+            if (not cond.timed_wait(lock, deadline)) break;
+        }
+        if (num_entered == NUM_MBOARDS) num_overlapped++;
+        done[mb_i] = true;
+    }
+
+    //! Fails for all motherboards but the one with serial 0, which is slow
+    void fail(const size_t mb_i, const device_addr_t &dev_addr)
+    {
+        const std::string serial = dev_addr["serial"];
+        if (serial == "0") {
+            boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+            done[mb_i] = true;
+            return;
+        }
+        if (serial == "1") throw uhd::value_error("mboard 1");
+        if (serial == "2") throw uhd::key_error("mboard 2");
+        throw std::runtime_error("mboard 3");
+    }
+
+    boost::mutex mutex;
+    boost::condition_variable cond;
+    size_t num_entered;
+    size_t num_overlapped;
+    std::vector<bool> done;
+};
+
+static device_addrs_t make_device_args(const size_t num_mboards)
+{
+    device_addrs_t device_args;
+    for (size_t i = 0; i < num_mboards; i++) {
+        device_addr_t dev_addr;
+        dev_addr["serial"] = boost::lexical_cast<std::string>(i);
+        device_args.push_back(dev_addr);
+    }
+    return device_args;
+}
+
+BOOST_AUTO_TEST_CASE(test_setup_mboards_concurrent){
+    setup_log_t log;
+    setup_mboards(boost::bind(&setup_log_t::setup, &log, _1, _2), make_device_args(NUM_MBOARDS));
+    BOOST_CHECK_EQUAL(log.num_entered, NUM_MBOARDS);
+    BOOST_CHECK_EQUAL(log.num_overlapped, NUM_MBOARDS);
+    for (size_t i = 0; i < NUM_MBOARDS; i++) {
+        BOOST_CHECK(log.done[i]);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_setup_mboards_error){
+    //The error of the first failing motherboard is thrown once all are done
+    setup_log_t log;
+    BOOST_CHECK_THROW(
+        setup_mboards(boost::bind(&setup_log_t::fail, &log, _1, _2), make_device_args(NUM_MBOARDS)),
+        uhd::value_error
+    );
+    BOOST_CHECK(log.done[0]);
+
+    //Other exceptions are turned into a uhd::runtime_error: serials 0 and 3
+    device_addrs_t device_args = make_device_args(NUM_MBOARDS);
+    device_args.erase(device_args.begin() + 1, device_args.begin() + 3);
+    BOOST_CHECK_THROW(
+        setup_mboards(boost::bind(&setup_log_t::fail, &log, _1, _2), device_args),
+        uhd::runtime_error
+    );
+}
+
+static void record_thread_id(boost::thread::id *id, const size_t, const device_addr_t &)
+{
+    *id = boost::this_thread::get_id();
+}
+
+BOOST_AUTO_TEST_CASE(test_setup_mboards_single){
+    //A single motherboard is set up in the calling thread
+    const boost::thread::id caller = boost::this_thread::get_id();
+    boost::thread::id setup_thread;
+    setup_mboards(boost::bind(&record_thread_id, &setup_thread, _1, _2), make_device_args(1));
+    BOOST_CHECK(setup_thread == caller);
+}
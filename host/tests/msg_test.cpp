@@ -17,6 +17,10 @@
 
 #include <boost/test/unit_test.hpp>
 #include <uhd/utils/msg.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/format.hpp>
 #include <iostream>
 
 BOOST_AUTO_TEST_CASE(test_messages){
@@ -38,3 +42,44 @@ BOOST_AUTO_TEST_CASE(test_messages){
     UHD_VAR(x);
     std::cerr << "---end print test ---" << std::endl;
 }
+
+/***********************************************************************
+ * A slow handler that records the fast-path messages it gets
+ **********************************************************************/
+static boost::mutex fastpath_mutex;
+static std::string fastpath_msgs;
+
+static void slow_fastpath_handler(uhd::msg::type_t type, const std::string &msg){
+    if (type != uhd::msg::fastpath) return;
+    boost::this_thread::sleep(boost::posix_time::milliseconds(50));
+    boost::mutex::scoped_lock lock(fastpath_mutex);
+    fastpath_msgs += msg;
+}
+
+BOOST_AUTO_TEST_CASE(test_fastpath_events){
+    static const size_t NUM_EVENTS = 10000;
+    uhd::msg::register_handler(&slow_fastpath_handler);
+    const size_t num_overflows = uhd::msg::get_fastpath_count('O');
+    const size_t num_underflows = uhd::msg::get_fastpath_count('U');
+
+    //posting must not wait for the handler, however slow it is
+    const boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+    for (size_t n = 0; n < NUM_EVENTS; n++) {
+        uhd::msg::post_fastpath('O');
+    }
+    const double post_ns = (boost::posix_time::microsec_clock::universal_time() - start).total_nanoseconds() / double(NUM_EVENTS);
+    std::cout << boost::format("Fast-path event: %.1f ns") % post_ns << std::endl;
+    BOOST_CHECK_LT(post_ns, 50e3);
+
+    uhd::msg::flush_fastpath();
+    UHD_MSG(fastpath) << "U";
+    uhd::msg::flush_fastpath();
+    BOOST_CHECK_EQUAL(uhd::msg::get_fastpath_count('O'), num_overflows + NUM_EVENTS);
+    BOOST_CHECK_EQUAL(uhd::msg::get_fastpath_count('U'), num_underflows + 1);
+
+    //events are reported in order, the excess of a burst is dropped
+    boost::mutex::scoped_lock lock(fastpath_mutex);
+    BOOST_CHECK(not fastpath_msgs.empty());
+    BOOST_CHECK_LT(fastpath_msgs.size(), NUM_EVENTS);
+    BOOST_CHECK_EQUAL(fastpath_msgs.find_first_not_of('O'), fastpath_msgs.size() - 1);
+}
@@ -0,0 +1,253 @@
+//
+// Copyright 2016 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <boost/test/unit_test.hpp>
+#include <uhd/device.hpp>
+#include <uhd/exception.hpp>
+#include <uhd/property_tree.hpp>
+#include <uhd/types/ranges.hpp>
+#include <uhd/types/time_spec.hpp>
+#include <uhd/usrp/multi_usrp.hpp>
+#include <uhd/usrp/subdev_spec.hpp>
+#include <uhd/utils/atomic.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/format.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <iostream>
+
+using namespace uhd;
+using namespace uhd::usrp;
+
+static const size_t NUM_MBOARDS = 2;
+static const size_t NUM_CHANS_PER_MBOARD = 2;
+
+/***********************************************************************
+ * A device with a property tree laid out like that of a USRP but
+ * without any hardware behind it
+ **********************************************************************/
+class bench_device : public uhd::device
+{
+public:
+    bench_device(void)
+    {
+        _type = device::USRP;
+        _tree = property_tree::make();
+        for (size_t mb = 0; mb < NUM_MBOARDS; mb++) {
+            const fs_path mb_path = fs_path("/mboards") / mb;
+            _tree->create<std::string>(mb_path / "name").set("Bench");
+            _tree->create<double>(mb_path / "tick_rate").set(200e6);
+            _tree->create<time_spec_t>(mb_path / "time/now").set(time_spec_t(0.0));
+            _tree->create<subdev_spec_t>(mb_path / "rx_subdev_spec").set(subdev_spec_t("A:0 A:1"));
+            _tree->create<double>(mb_path / "rx_codecs/A/gains/digital/value").set(0.0);
+            _tree->create<meta_range_t>(mb_path / "rx_codecs/A/gains/digital/range").set(meta_range_t(0.0, 6.0, 0.5));
+            for (size_t ch = 0; ch < NUM_CHANS_PER_MBOARD; ch++) {
+                const fs_path fe_path = mb_path / "dboards/A/rx_frontends" / ch;
+                _tree->create<std::string>(fe_path / "name").set("Bench RX");
+                _tree->create<double>(fe_path / "freq/value").set(1e9);
+                _tree->create<std::string>(fe_path / "antenna/value").set("RX2");
+                _tree->create<double>(fe_path / "gains/PGA/value").set(0.0);
+                _tree->create<meta_range_t>(fe_path / "gains/PGA/range").set(meta_range_t(0.0, 31.5, 0.5));
+                const fs_path dsp_path = mb_path / "rx_dsps" / ch;
+                _tree->create<double>(dsp_path / "rate/value").set(1e6);
+                _tree->create<double>(dsp_path / "freq/value").set(0.0);
+            }
+        }
+    }
+
+    rx_streamer::sptr get_rx_stream(const stream_args_t &)
+    {
+        throw uhd::not_implemented_error("bench device cannot stream");
+    }
+
+    tx_streamer::sptr get_tx_stream(const stream_args_t &)
+    {
+        throw uhd::not_implemented_error("bench device cannot stream");
+    }
+
+    bool recv_async_msg(async_metadata_t &, double)
+    {
+        return false;
+    }
+};
+
+static device_addrs_t bench_device_find(const device_addr_t &hint)
+{
+    device_addrs_t addrs;
+    if (hint.has_key("type") and hint["type"] == "bench") {
+        addrs.push_back(device_addr_t("type=bench"));
+    }
+    return addrs;
+}
+
+static device::sptr bench_device_make(const device_addr_t &)
+{
+    return device::sptr(new bench_device());
+}
+
+static multi_usrp::sptr make_bench_usrp(void)
+{
+    static bool registered = false;
+    if (not registered) {
+        device::register_device(&bench_device_find, &bench_device_make, device::USRP);
+        registered = true;
+    }
+    return multi_usrp::make(device_addr_t("type=bench"));
+}
+
+//! A finder which waits until a second one is running at the same time
+static boost::mutex overlap_find_mutex;
+static boost::condition_variable overlap_find_cond;
+static size_t num_overlap_finds = 0;
+static size_t num_overlapped_finds = 0;
+static device_addrs_t overlap_device_find(const device_addr_t &hint)
+{
+    device_addrs_t addrs;
+    if (hint.has_key("type") and hint["type"] == "overlap") {
+        boost::mutex::scoped_lock lock(overlap_find_mutex);
+        num_overlap_finds++;
+        overlap_find_cond.notify_all();
+        //finders which run one after another give up after the deadline
+        const boost::system_time deadline = boost::get_system_time() + boost::posix_time::seconds(10);
+        while (num_overlap_finds < 2) {
+            if (not overlap_find_cond.timed_wait(lock, deadline)) break;
+        }
+        if (num_overlap_finds >= 2) num_overlapped_finds++;
+        addrs.push_back(device_addr_t("type=overlap"));
+    }
+    return addrs;
+}
+
+//! A finder which counts how many of its kind run at the same time
+static uhd::atomic_uint32_t num_usb_finds;
+static uhd::atomic_uint32_t num_overlapping_usb_finds;
+static device_addrs_t usb_device_find(const device_addr_t &hint)
+{
+    device_addrs_t addrs;
+    if (hint.has_key("type") and hint["type"] == "usb") {
+        if (num_usb_finds.inc() != 0) num_overlapping_usb_finds.inc();
+        boost::this_thread::sleep(boost::posix_time::milliseconds(50));
+        num_usb_finds.dec();
+        addrs.push_back(device_addr_t("type=usb"));
+    }
+    return addrs;
+}
+
+static double us_since(const boost::posix_time::ptime &start, size_t num_calls)
+{
+    return (boost::posix_time::microsec_clock::universal_time() - start).total_microseconds() / double(num_calls);
+}
+
+BOOST_AUTO_TEST_CASE(test_multi_usrp_bench_device){
+    multi_usrp::sptr usrp = make_bench_usrp();
+    BOOST_CHECK_EQUAL(usrp->get_num_mboards(), NUM_MBOARDS);
+    BOOST_CHECK_EQUAL(usrp->get_rx_num_channels(), NUM_MBOARDS * NUM_CHANS_PER_MBOARD);
+
+    //Settings of the last channel end up on the second motherboard
+    const size_t chan = usrp->get_rx_num_channels() - 1;
+    usrp->set_rx_antenna("TX/RX", chan);
+    usrp->set_rx_gain(20.0, chan);
+    BOOST_CHECK_EQUAL(usrp->get_rx_antenna(chan), "TX/RX");
+    BOOST_CHECK_EQUAL(usrp->get_rx_gain(chan), 20.0);
+    BOOST_CHECK_EQUAL(usrp->get_rx_antenna(0), "RX2");
+    BOOST_CHECK_EQUAL(
+        usrp->get_device()->get_tree()->access<std::string>("/mboards/1/dboards/A/rx_frontends/1/antenna/value").get(),
+        "TX/RX");
+    BOOST_CHECK_EQUAL(usrp->get_rx_freq(chan), 1e9);
+    BOOST_CHECK_THROW(usrp->get_rx_antenna(chan + 1), uhd::index_error);
+}
+
+BOOST_AUTO_TEST_CASE(test_multi_usrp_get_set_benchmark){
+    static const size_t NUM_ITERS = 2000;
+    multi_usrp::sptr usrp = make_bench_usrp();
+    const size_t num_chans = usrp->get_rx_num_channels();
+
+    boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+    for (size_t n = 0; n < NUM_ITERS; n++) {
+        usrp->get_master_clock_rate(n % NUM_MBOARDS);
+        usrp->get_time_now(n % NUM_MBOARDS);
+    }
+    const double mb_us = us_since(start, NUM_ITERS * 2);
+
+    start = boost::posix_time::microsec_clock::universal_time();
+    for (size_t n = 0; n < NUM_ITERS; n++) {
+        usrp->set_rx_antenna((n % 2)? "RX2" : "TX/RX", n % num_chans);
+        usrp->get_rx_antenna(n % num_chans);
+        usrp->get_rx_rate(n % num_chans);
+        usrp->get_rx_freq(n % num_chans);
+    }
+    const double chan_us = us_since(start, NUM_ITERS * 4);
+
+    start = boost::posix_time::microsec_clock::universal_time();
+    for (size_t n = 0; n < NUM_ITERS; n++) {
+        usrp->set_rx_gain(double(n % 20), n % num_chans);
+        usrp->get_rx_gain(n % num_chans);
+    }
+    const double gain_us = us_since(start, NUM_ITERS * 2);
+
+    //The same kind of access through the property tree directly: by path
+    //and through a handle that was looked up once
+    property_tree::sptr tree = usrp->get_device()->get_tree();
+    const fs_path ant_path = "/mboards/1/dboards/A/rx_frontends/1/antenna/value";
+    start = boost::posix_time::microsec_clock::universal_time();
+    for (size_t n = 0; n < NUM_ITERS; n++) {
+        tree->access<std::string>(ant_path).set((n % 2)? "RX2" : "TX/RX");
+        tree->access<std::string>(ant_path).get();
+    }
+    const double path_us = us_since(start, NUM_ITERS * 2);
+
+    property<std::string>::sptr ant = tree->get_handle<std::string>(ant_path);
+    start = boost::posix_time::microsec_clock::universal_time();
+    for (size_t n = 0; n < NUM_ITERS; n++) {
+        ant->set((n % 2)? "RX2" : "TX/RX");
+        ant->get();
+    }
+    const double handle_us = us_since(start, NUM_ITERS * 2);
+
+    std::cout << boost::format(
+        "multi_usrp per call: mboard getters %.2f us, channel get/set %.2f us, gain get/set %.2f us\n"
+        "property tree per call: access by path %.3f us, access by handle %.3f us"
+    ) % mb_us % chan_us % gain_us % path_us % handle_us << std::endl;
+    BOOST_CHECK_EQUAL(ant->get(), tree->access<std::string>(ant_path).get());
+}
+
+BOOST_AUTO_TEST_CASE(test_device_find_concurrent){
+    //Two device types which find the same device
+    device::register_device(&overlap_device_find, &bench_device_make, device::USRP, true);
+    device::register_device(&overlap_device_find, &bench_device_make, device::CLOCK, true);
+
+    //Both finders are inside the call at the same time, and the device is reported once
+    const device_addrs_t addrs = device::find(device_addr_t("type=overlap"), device::ANY);
+    BOOST_REQUIRE_EQUAL(addrs.size(), size_t(1));
+    BOOST_CHECK_EQUAL(addrs[0]["type"], "overlap");
+    boost::mutex::scoped_lock lock(overlap_find_mutex);
+    BOOST_CHECK_EQUAL(num_overlap_finds, size_t(2));
+    BOOST_CHECK_EQUAL(num_overlapped_finds, size_t(2));
+}
+
+BOOST_AUTO_TEST_CASE(test_device_find_serial){
+    //Finders which are not registered as concurrent run one after another
+    device::register_device(&usb_device_find, &bench_device_make, device::USRP);
+    device::register_device(&usb_device_find, &bench_device_make, device::CLOCK);
+    device::register_device(&overlap_device_find, &bench_device_make, device::USRP, true);
+
+    const device_addrs_t addrs = device::find(device_addr_t("type=usb"), device::ANY);
+    BOOST_REQUIRE_EQUAL(addrs.size(), size_t(1));
+    BOOST_CHECK_EQUAL(addrs[0]["type"], "usb");
+    BOOST_CHECK_EQUAL(num_overlapping_usb_finds.read(), uint32_t(0));
+}
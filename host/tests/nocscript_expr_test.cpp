@@ -80,6 +80,13 @@ BOOST_AUTO_TEST_CASE(test_literals)
                                   result.begin(), result.end());
     BOOST_REQUIRE_THROW(literal_int_vec.get_bool(), uhd::type_error);
     BOOST_REQUIRE_THROW(literal_int_vec.get_int(), uhd::type_error);
+
+    // Literals created from C++ values (e.g. function return values)
+    BOOST_CHECK_EQUAL(expression_literal(5).to_bool(), true);
+    BOOST_CHECK_EQUAL(expression_literal(0).to_bool(), false);
+    BOOST_CHECK_EQUAL(expression_literal(0.5).to_bool(), true);
+    BOOST_CHECK_EQUAL(expression_literal(0.0).to_bool(), false);
+    BOOST_CHECK_EQUAL(expression_literal("0x10", expression::TYPE_INT).to_bool(), true);
 }
 
 
@@ -402,6 +409,15 @@ BOOST_AUTO_TEST_CASE(test_function_expression)
     f4.add(boost::make_shared<expression_function>(f3));
 
     BOOST_CHECK_EQUAL(f4.eval().get_int(), 20);
+    // The functions are only looked up once, evaluating again gives the same result
+    BOOST_CHECK_EQUAL(f4.eval().get_int(), 20);
+
+    // Changing the arguments changes the signature
+    expression_function f5("ADD", ft);
+    f5.add(E(2));
+    BOOST_CHECK_THROW(f5.eval(), uhd::syntax_error);
+    f5.add(E(3));
+    BOOST_CHECK_EQUAL(f5.eval(), expression_literal(5));
 }
 
 BOOST_AUTO_TEST_CASE(test_function_expression_laziness)
@@ -430,6 +446,10 @@ BOOST_AUTO_TEST_CASE(test_function_expression_laziness)
 
     BOOST_CHECK(not f1->eval().get_bool());
     BOOST_CHECK_EQUAL(and_counter, 2);
+
+    and_counter = 0;
+    BOOST_CHECK(not f1->eval().get_bool());
+    BOOST_CHECK_EQUAL(and_counter, 2);
 }
 
 BOOST_AUTO_TEST_CASE(test_sptrs)
@@ -24,6 +24,8 @@
 #include <boost/foreach.hpp>
 #include <boost/bind.hpp>
 #include <boost/make_shared.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/format.hpp>
 #include <algorithm>
 #include <iostream>
 
@@ -165,3 +167,41 @@ BOOST_AUTO_TEST_CASE(test_multi_commmand)
     BOOST_CHECK_EQUAL(dummy_false_counter, 3);
 }
 
+
+BOOST_AUTO_TEST_CASE(test_reuse)
+{
+    static const size_t NUM_ITERS = 100;
+    const std::string line("GE($spp, 16) AND LE($spp, 4096) AND IS_PWR_OF_2($spp)");
+
+    // The first parser tokenizes the code, the second one (as used by
+    // another block instance) reuses the tokens
+    SETUP_FT_AND_PARSER();
+    boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+    expression::sptr e = p->create_expr_tree(line);
+    const double first_us = (boost::posix_time::microsec_clock::universal_time() - start).total_microseconds();
+
+    parser::sptr p2 = parser::make(
+            function_table::make(),
+            boost::bind(&variable_get_type, _1),
+            boost::bind(&variable_get_value, _1)
+    );
+    start = boost::posix_time::microsec_clock::universal_time();
+    for (size_t i = 0; i < NUM_ITERS; i++) {
+        p2->create_expr_tree(line);
+    }
+    const double cached_us = (boost::posix_time::microsec_clock::universal_time() - start).total_microseconds() / double(NUM_ITERS);
+
+    // A tree can be evaluated any number of times
+    start = boost::posix_time::microsec_clock::universal_time();
+    for (size_t i = 0; i < NUM_ITERS; i++) {
+        BOOST_REQUIRE(e->eval().get_bool());
+    }
+    const double eval_us = (boost::posix_time::microsec_clock::universal_time() - start).total_microseconds() / double(NUM_ITERS);
+    std::cout << boost::format("Parsing: %.1f us first, %.1f us cached; eval: %.2f us") % first_us % cached_us % eval_us << std::endl;
+
+    // Errors are detected the same way with cached tokens
+    BOOST_REQUIRE_THROW(p->create_expr_tree("ADD(1,, 2)"), uhd::syntax_error);
+    BOOST_REQUIRE_THROW(p2->create_expr_tree("ADD(1,, 2)"), uhd::syntax_error);
+    BOOST_REQUIRE_THROW(p2->create_expr_tree("ADD(1, ?)"), uhd::syntax_error);
+    BOOST_REQUIRE_THROW(p2->create_expr_tree("ADD(1, ?)"), uhd::syntax_error);
+}
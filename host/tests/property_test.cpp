@@ -18,6 +18,10 @@
 #include <boost/test/unit_test.hpp>
 #include <uhd/property_tree.hpp>
 #include <boost/bind.hpp>
+#include <boost/foreach.hpp>
+#include <boost/format.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
 #include <exception>
 #include <iostream>
 
@@ -225,6 +229,143 @@ BOOST_AUTO_TEST_CASE(test_prop_subtree){
 
 }
 
+BOOST_AUTO_TEST_CASE(test_prop_tree_list_order){
+    uhd::property_tree::sptr tree = uhd::property_tree::make();
+    static const char *names[] = {"rx_dsps", "tick_rate", "dboards", "0", "10", "1"};
+    BOOST_FOREACH(const char *name, names) {
+        tree->create<int>(uhd::fs_path("/mboards/0") / name);
+    }
+
+    //Listing returns the entries in the order of creation
+    std::vector<std::string> dirs = tree->list("/mboards/0");
+    BOOST_CHECK_EQUAL_COLLECTIONS(dirs.begin(), dirs.end(), names, names + 6);
+
+    //Removed entries are not listed or found, even after an earlier lookup
+    BOOST_CHECK(tree->exists("/mboards/0/dboards"));
+    tree->remove("/mboards/0/dboards");
+    BOOST_CHECK(not tree->exists("/mboards/0/dboards"));
+    BOOST_CHECK_THROW(tree->access<int>("/mboards/0/dboards"), uhd::lookup_error);
+    dirs = tree->list("/mboards/0");
+    BOOST_CHECK_EQUAL(dirs.size(), size_t(5));
+    BOOST_CHECK_EQUAL(dirs[2], "0");
+
+    //A re-created entry is appended
+    tree->create<int>("/mboards/0/dboards");
+    BOOST_CHECK_EQUAL(tree->list("/mboards/0").back(), "dboards");
+}
+
+BOOST_AUTO_TEST_CASE(test_prop_handle){
+    uhd::property_tree::sptr tree = uhd::property_tree::make();
+    tree->create<int>("/mboards/0/tick_rate").set(42);
+
+    uhd::property<int>::sptr handle = tree->get_handle<int>("/mboards/0/tick_rate");
+    BOOST_CHECK_EQUAL(handle->get(), 42);
+    handle->set(34);
+    BOOST_CHECK_EQUAL(tree->access<int>("/mboards/0/tick_rate").get(), 34);
+
+    //Equivalent spellings of a path and subtrees lead to the same property
+    BOOST_CHECK_EQUAL(tree->get_handle<int>("mboards//0/tick_rate/"), handle);
+    BOOST_CHECK_EQUAL(tree->subtree("/mboards/0")->get_handle<int>("tick_rate"), handle);
+    BOOST_CHECK_THROW(tree->get_handle<int>("/mboards/1/tick_rate"), uhd::lookup_error);
+
+    //The handle and a reference from access() outlive the removal of the property
+    uhd::property<int> &prop = tree->access<int>("/mboards/0/tick_rate");
+    tree->remove("/mboards/0");
+    BOOST_CHECK_EQUAL(handle->get(), 34);
+    BOOST_CHECK_EQUAL(prop.get(), 34);
+    BOOST_CHECK(not tree->exists("/mboards/0/tick_rate"));
+}
+
+//! Polls the properties of all motherboards, as a sensor or time thread would
+static void poll_mboards(uhd::property_tree::sptr tree, size_t num_mboards, size_t num_iters, size_t *num_errors)
+{
+    for (size_t n = 0; n < num_iters; n++) {
+        const uhd::fs_path mb_path = uhd::fs_path("/mboards") / (n % num_mboards);
+        try {
+            tree->access<int>(mb_path / "time/now").get();
+            if (not tree->exists(mb_path / "sensors/temp")) (*num_errors)++;
+            if (tree->list(mb_path / "sensors").empty()) (*num_errors)++;
+            //The hot-plugged motherboard comes and goes: its properties are
+            //set before it is marked ready, and a handle keeps the property
+            //alive if it is removed from the tree in the meantime
+            if (tree->exists("/mboards/hotplug/ready")) try {
+                tree->get_handle<int>("/mboards/hotplug/time/now")->get();
+            } catch (const uhd::lookup_error &) {
+                /* removed at the moment */
+            }
+        } catch (const std::exception &) {
+            (*num_errors)++;
+        }
+    }
+}
+
+//! Adds and removes a motherboard while the others are being polled
+static void hotplug_mboard(uhd::property_tree::sptr tree, size_t num_iters)
+{
+    for (size_t n = 0; n < num_iters; n++) {
+        tree->create<int>("/mboards/hotplug/time/now").set(int(n));
+        tree->create<int>("/mboards/hotplug/sensors/temp").set(25);
+        tree->create<int>("/mboards/hotplug/ready");
+        boost::this_thread::yield();
+        tree->remove("/mboards/hotplug");
+    }
+}
+
+static double time_polling(uhd::property_tree::sptr tree, size_t num_mboards, size_t num_threads, size_t num_iters, size_t *num_errors)
+{
+    std::vector<size_t> errors(num_threads, 0);
+    const boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+    boost::thread_group threads;
+    for (size_t i = 0; i < num_threads; i++) {
+        threads.create_thread(boost::bind(&poll_mboards, tree, num_mboards, num_iters, &errors[i]));
+    }
+    threads.join_all();
+    const double secs = (boost::posix_time::microsec_clock::universal_time() - start).total_microseconds() / 1e6;
+    BOOST_FOREACH(const size_t e, errors) {
+        *num_errors += e;
+    }
+    return (num_threads * num_iters * 4) / secs;
+}
+
+BOOST_AUTO_TEST_CASE(test_prop_tree_concurrent_access){
+    static const size_t NUM_MBOARDS = 8;
+    static const size_t NUM_THREADS = 4;
+    static const size_t NUM_ITERS = 20000;
+
+    uhd::property_tree::sptr tree = uhd::property_tree::make();
+    for (size_t mb = 0; mb < NUM_MBOARDS; mb++) {
+        const uhd::fs_path mb_path = uhd::fs_path("/mboards") / mb;
+        tree->create<int>(mb_path / "time/now").set(int(mb));
+        tree->create<int>(mb_path / "sensors/temp").set(25);
+    }
+
+    //Lookup throughput with one and several polling threads
+    size_t num_errors = 0;
+    const double single_rate = time_polling(tree, NUM_MBOARDS, 1, NUM_ITERS, &num_errors);
+    const double multi_rate = time_polling(tree, NUM_MBOARDS, NUM_THREADS, NUM_ITERS, &num_errors);
+    std::cout << boost::format("Property tree lookups: %.2f M/s with 1 thread, %.2f M/s with %d threads")
+                 % (single_rate / 1e6) % (multi_rate / 1e6) % NUM_THREADS << std::endl;
+    BOOST_CHECK_EQUAL(num_errors, size_t(0));
+
+    //Structural changes while polling
+    boost::thread_group threads;
+    std::vector<size_t> errors(NUM_THREADS, 0);
+    for (size_t i = 0; i < NUM_THREADS; i++) {
+        threads.create_thread(boost::bind(&poll_mboards, tree, NUM_MBOARDS, NUM_ITERS, &errors[i]));
+    }
+    threads.create_thread(boost::bind(&hotplug_mboard, tree, NUM_ITERS / 10));
+    threads.join_all();
+    BOOST_FOREACH(const size_t e, errors) {
+        BOOST_CHECK_EQUAL(e, size_t(0));
+    }
+
+    //The tree is intact afterwards
+    BOOST_CHECK(not tree->exists("/mboards/hotplug"));
+    BOOST_CHECK_EQUAL(tree->list("/mboards").size(), NUM_MBOARDS);
+    for (size_t mb = 0; mb < NUM_MBOARDS; mb++) {
+        BOOST_CHECK_EQUAL(tree->access<int>(uhd::fs_path("/mboards") / mb / "time/now").get(), int(mb));
+    }
+}
 
 BOOST_AUTO_TEST_CASE(test_prop_operators)
 {
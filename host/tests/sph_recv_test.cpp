@@ -19,9 +19,16 @@
 #include "../lib/transport/super_recv_packet_handler.hpp"
 #include <boost/shared_array.hpp>
 #include <boost/bind.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/format.hpp>
+#include <uhd/transport/chdr.hpp>
 #include <complex>
 #include <vector>
 #include <list>
+#ifdef __linux__
+#include "../lib/transport/readiness_fd.hpp"
+#include <poll.h>
+#endif
 
 #define BOOST_CHECK_TS_CLOSE(a, b) \
     BOOST_CHECK_CLOSE((a).get_real_secs(), (b).get_real_secs(), 0.001)
@@ -82,10 +89,29 @@ public:
         if (_end == "little"){
             uhd::transport::vrt::if_hdr_pack_le(reinterpret_cast<uint32_t *>(_mems.back().get()), ifpi);
         }
+        if (_end == "chdr_big"){
+            uhd::transport::vrt::chdr::if_hdr_pack_be(reinterpret_cast<uint32_t *>(_mems.back().get()), ifpi);
+        }
+        if (_end == "chdr_little"){
+            uhd::transport::vrt::chdr::if_hdr_pack_le(reinterpret_cast<uint32_t *>(_mems.back().get()), ifpi);
+        }
         (reinterpret_cast<uint32_t *>(_mems.back().get()) + ifpi.num_header_words32)[0] = optional_msg_word | uhd::byteswap(optional_msg_word);
         _lens.push_back(ifpi.num_packet_words32*sizeof(uint32_t));
     }
 
+    //! Push a packet with a payload of samples counting up from first_samp
+    void push_back_counting_packet(
+        uhd::transport::vrt::if_packet_info_t &ifpi,
+        const size_t first_samp
+    ){
+        this->push_back_packet(ifpi);
+        uint32_t *payload = reinterpret_cast<uint32_t *>(_mems.back().get()) + ifpi.num_header_words32;
+        for (size_t i = 0; i < ifpi.num_payload_words32; i++){
+            const uint32_t samp = uint16_t(first_samp + i);
+            payload[i] = uhd::htowx((samp << 16) | samp);
+        }
+    }
+
     uhd::transport::managed_recv_buffer::sptr get_recv_buff(double){
         if (!io_status) throw uhd::io_error("IO error exception"); //simulate an IO error
         if (_mems.empty()) return uhd::transport::managed_recv_buffer::sptr(); //timeout
@@ -96,6 +122,10 @@ public:
         return mrb;
     }
 
+    bool empty(void) const{
+        return _mems.empty();
+    }
+
 private:
     std::list<boost::shared_array<char> > _mems;
     std::list<size_t> _lens;
@@ -104,6 +134,75 @@ private:
     bool io_status;
 };
 
+/***********************************************************************
+ * A transport which packs CHDR packets on demand, for benchmarks
+ **********************************************************************/
+class streaming_recv_xport_class : public uhd::transport::zero_copy_if{
+public:
+    streaming_recv_xport_class(const size_t spp, const double tick_rate, const double samp_rate):
+        _slot(0), _ticks_per_pkt(spp*size_t(tick_rate/samp_rate))
+    {
+        for (size_t i = 0; i < NUM_SLOTS; i++){
+            _mems.push_back(boost::shared_array<char>(new char[(spp + 4)*sizeof(uint32_t)]()));
+            _mrbs.push_back(boost::shared_ptr<dummy_mrb>(new dummy_mrb()));
+        }
+        _ifpi.link_type = uhd::transport::vrt::if_packet_info_t::LINK_TYPE_CHDR;
+        _ifpi.packet_type = uhd::transport::vrt::if_packet_info_t::PACKET_TYPE_DATA;
+        _ifpi.num_payload_words32 = spp;
+        _ifpi.num_payload_bytes = spp*sizeof(uint32_t);
+        _ifpi.packet_count = 0;
+        _ifpi.sob = false;
+        _ifpi.eob = false;
+        _ifpi.has_sid = true;
+        _ifpi.sid = 0;
+        _ifpi.has_cid = false;
+        _ifpi.has_tsi = false;
+        _ifpi.has_tsf = true;
+        _ifpi.tsf = 0;
+        _ifpi.has_tlr = false;
+    }
+
+    uhd::transport::managed_recv_buffer::sptr get_recv_buff(double){
+        char *mem = _mems[_slot].get();
+        uhd::transport::vrt::chdr::if_hdr_pack_le(reinterpret_cast<uint32_t *>(mem), _ifpi);
+        uhd::transport::managed_recv_buffer::sptr mrb = _mrbs[_slot]->get_new(
+            _mems[_slot], _ifpi.num_packet_words32*sizeof(uint32_t)
+        );
+        _ifpi.packet_count = (_ifpi.packet_count + 1) & 0xfff;
+        _ifpi.tsf += _ticks_per_pkt;
+        _slot = (_slot + 1) % NUM_SLOTS;
+        return mrb;
+    }
+
+    size_t get_num_recv_frames(void) const{
+        return NUM_SLOTS;
+    }
+
+    size_t get_recv_frame_size(void) const{
+        return (_ifpi.num_payload_words32 + 4)*sizeof(uint32_t);
+    }
+
+    uhd::transport::managed_send_buffer::sptr get_send_buff(double){
+        return uhd::transport::managed_send_buffer::sptr();
+    }
+
+    size_t get_num_send_frames(void) const{
+        return 0;
+    }
+
+    size_t get_send_frame_size(void) const{
+        return 0;
+    }
+
+private:
+    static const size_t NUM_SLOTS = 4;
+    std::vector<boost::shared_array<char> > _mems;
+    std::vector<boost::shared_ptr<dummy_mrb> > _mrbs;
+    size_t _slot;
+    const size_t _ticks_per_pkt;
+    uhd::transport::vrt::if_packet_info_t _ifpi;
+};
+
 ////////////////////////////////////////////////////////////////////////
 BOOST_AUTO_TEST_CASE(test_sph_recv_one_channel_normal){
 ////////////////////////////////////////////////////////////////////////
@@ -161,6 +260,7 @@ BOOST_AUTO_TEST_CASE(test_sph_recv_one_channel_normal){
         BOOST_CHECK(not metadata.more_fragments);
         BOOST_CHECK(metadata.has_time_spec);
         BOOST_CHECK_TS_CLOSE(metadata.time_spec, uhd::time_spec_t::from_ticks(num_accum_samps, SAMP_RATE));
+        BOOST_CHECK_EQUAL(metadata.time_ticks.get_ticks(), (long long)(num_accum_samps*size_t(TICK_RATE/SAMP_RATE)));
         BOOST_CHECK_EQUAL(num_samps_ret, 10 + i%10);
         num_accum_samps += num_samps_ret;
     }
@@ -239,6 +339,7 @@ BOOST_AUTO_TEST_CASE(test_sph_recv_one_channel_sequence_error){
             BOOST_REQUIRE(metadata.error_code == uhd::rx_metadata_t::ERROR_CODE_OVERFLOW);
             BOOST_REQUIRE(metadata.out_of_sequence == true);
             BOOST_CHECK_TS_CLOSE(metadata.time_spec, uhd::time_spec_t::from_ticks(num_accum_samps, SAMP_RATE));
+            BOOST_CHECK_EQUAL(metadata.time_ticks.get_ticks(), (long long)(num_accum_samps*size_t(TICK_RATE/SAMP_RATE)));
             num_accum_samps += 10 + i%10;
         }
         else{
@@ -795,6 +896,7 @@ BOOST_AUTO_TEST_CASE(test_sph_recv_multi_channel_fragment){
         BOOST_CHECK_EQUAL(metadata.fragment_offset, 10UL);
         BOOST_CHECK(metadata.has_time_spec);
         BOOST_CHECK_TS_CLOSE(metadata.time_spec, uhd::time_spec_t::from_ticks(num_accum_samps, SAMP_RATE));
+        BOOST_CHECK_EQUAL(metadata.time_ticks.get_ticks(), (long long)(num_accum_samps*size_t(TICK_RATE/SAMP_RATE)));
         BOOST_CHECK_EQUAL(num_samps_ret, i%10);
         num_accum_samps += num_samps_ret;
     }
@@ -815,3 +917,591 @@ BOOST_AUTO_TEST_CASE(test_sph_recv_multi_channel_fragment){
 
     BOOST_REQUIRE_THROW(handler.recv(buffs, NUM_SAMPS_PER_BUFF, metadata, 1.0, true), uhd::io_error);
 }
+
+////////////////////////////////////////////////////////////////////////
+BOOST_AUTO_TEST_CASE(test_sph_recv_multi_channel_zero_copy){
+////////////////////////////////////////////////////////////////////////
+    uhd::convert::id_type id;
+    id.input_format = "sc16_item32_le";
+    id.num_inputs = 1;
+    id.output_format = "sc16";
+    id.num_outputs = 1;
+
+    uhd::transport::vrt::if_packet_info_t ifpi;
+    ifpi.packet_type = uhd::transport::vrt::if_packet_info_t::PACKET_TYPE_DATA;
+    ifpi.num_payload_words32 = 0;
+    ifpi.packet_count = 0;
+    ifpi.sob = true;
+    ifpi.eob = false;
+    ifpi.has_sid = false;
+    ifpi.has_cid = false;
+    ifpi.has_tsi = true;
+    ifpi.has_tsf = true;
+    ifpi.tsi = 0;
+    ifpi.tsf = 0;
+    ifpi.has_tlr = false;
+
+    static const double TICK_RATE = 100e6;
+    static const double SAMP_RATE = 10e6;
+    static const size_t NUM_PKTS_TO_TEST = 30;
+    static const size_t NUM_SAMPS_PER_BUFF = 4;
+    static const size_t NCHANNELS = 4;
+
+    std::vector<dummy_recv_xport_class> dummy_recv_xports(NCHANNELS, dummy_recv_xport_class("little"));
+
+    //generate a bunch of packets, the first sample marks the packet
+    for (size_t i = 0; i < NUM_PKTS_TO_TEST; i++){
+        ifpi.num_payload_words32 = 10 + i%10;
+        for (size_t ch = 0; ch < NCHANNELS; ch++){
+            dummy_recv_xports[ch].push_back_packet(ifpi, uint32_t(i));
+        }
+        ifpi.packet_count++;
+        ifpi.tsf += ifpi.num_payload_words32*size_t(TICK_RATE/SAMP_RATE);
+    }
+
+    //create the super receive packet handler
+    uhd::transport::sph::recv_packet_handler handler(NCHANNELS);
+    handler.set_vrt_unpacker(&uhd::transport::vrt::if_hdr_unpack_le);
+    handler.set_tick_rate(TICK_RATE);
+    handler.set_samp_rate(SAMP_RATE);
+    for (size_t ch = 0; ch < NCHANNELS; ch++){
+        handler.set_xport_chan_get_buff(ch, boost::bind(&dummy_recv_xport_class::get_recv_buff, &dummy_recv_xports[ch], _1));
+    }
+    handler.set_converter(id);
+
+    //check the received packets, every other one starts with a copying receive
+    size_t num_accum_samps = 0;
+    std::complex<short> mem[NUM_SAMPS_PER_BUFF*NCHANNELS];
+    std::vector<std::complex<short> *> buffs(NCHANNELS);
+    for (size_t ch = 0; ch < NCHANNELS; ch++){
+        buffs[ch] = &mem[ch*NUM_SAMPS_PER_BUFF];
+    }
+    uhd::rx_zero_copy_buffs_t zc_buffs;
+    uhd::rx_metadata_t metadata;
+    for (size_t i = 0; i < NUM_PKTS_TO_TEST; i++){
+        std::cout << "data check " << i << std::endl;
+        const size_t num_pkt_samps = 10 + i%10;
+        size_t num_offset_samps = 0;
+        if (i % 2){
+            num_offset_samps = handler.recv(
+                buffs, NUM_SAMPS_PER_BUFF, metadata, 1.0, true
+            );
+            BOOST_CHECK_EQUAL(num_offset_samps, NUM_SAMPS_PER_BUFF);
+            BOOST_CHECK(metadata.more_fragments);
+            num_accum_samps += num_offset_samps;
+        }
+
+        size_t num_samps_ret = handler.recv_zero_copy(zc_buffs, metadata, 1.0);
+        BOOST_CHECK_EQUAL(metadata.error_code, uhd::rx_metadata_t::ERROR_CODE_NONE);
+        BOOST_CHECK(not metadata.more_fragments);
+        BOOST_CHECK_EQUAL(metadata.fragment_offset, num_offset_samps);
+        BOOST_CHECK(metadata.has_time_spec);
+        BOOST_CHECK_TS_CLOSE(metadata.time_spec, uhd::time_spec_t::from_ticks(num_accum_samps, SAMP_RATE));
+        BOOST_CHECK_EQUAL(num_samps_ret, num_pkt_samps - num_offset_samps);
+        BOOST_CHECK_EQUAL(zc_buffs.nsamps_per_buff, num_samps_ret);
+        BOOST_CHECK_EQUAL(zc_buffs.format, "sc16_item32_le");
+        BOOST_REQUIRE_EQUAL(zc_buffs.buffs.size(), NCHANNELS);
+        BOOST_REQUIRE_EQUAL(zc_buffs.managed_buffs.size(), NCHANNELS);
+        for (size_t ch = 0; ch < NCHANNELS; ch++){
+            //the samples are in the payload, after those the copying receive took
+            const uint32_t *payload = reinterpret_cast<const uint32_t *>(zc_buffs.buffs[ch]) - num_offset_samps;
+            BOOST_CHECK(zc_buffs.managed_buffs[ch]);
+            BOOST_CHECK_EQUAL(payload[0], uint32_t(i) | uhd::byteswap(uint32_t(i)));
+        }
+        num_accum_samps += num_samps_ret;
+    }
+
+    //subsequent receives should be a timeout, without buffers
+    for (size_t i = 0; i < 3; i++){
+        std::cout << "timeout check " << i << std::endl;
+        BOOST_CHECK_EQUAL(handler.recv_zero_copy(zc_buffs, metadata, 1.0), 0UL);
+        BOOST_CHECK_EQUAL(metadata.error_code, uhd::rx_metadata_t::ERROR_CODE_TIMEOUT);
+        BOOST_CHECK(zc_buffs.buffs.empty());
+        BOOST_CHECK(zc_buffs.managed_buffs.empty());
+    }
+
+    //simulate the transport failing
+    for (size_t ch = 0; ch < NCHANNELS; ch++){
+        dummy_recv_xports[ch].set_io_status(false);
+    }
+
+    BOOST_REQUIRE_THROW(handler.recv_zero_copy(zc_buffs, metadata, 1.0), uhd::io_error);
+}
+
+////////////////////////////////////////////////////////////////////////
+BOOST_AUTO_TEST_CASE(test_sph_recv_multi_channel_chdr){
+////////////////////////////////////////////////////////////////////////
+    static const char *ENDS[] = {"chdr_big", "chdr_little"};
+    static const double TICK_RATE = 100e6;
+    static const double SAMP_RATE = 10e6;
+    static const size_t NUM_PKTS_TO_TEST = 30;
+    static const size_t NUM_SAMPS_PER_BUFF = 20;
+    static const size_t NCHANNELS = 4;
+    static const uint64_t START_TICKS = 1000;
+
+    for (size_t e = 0; e < 2; e++){
+        const std::string end(ENDS[e]);
+        uhd::convert::id_type id;
+        id.input_format = (end == "chdr_big")? "sc16_item32_be" : "sc16_item32_le";
+        id.num_inputs = 1;
+        id.output_format = "fc32";
+        id.num_outputs = 1;
+
+        uhd::transport::vrt::if_packet_info_t ifpi;
+        ifpi.link_type = uhd::transport::vrt::if_packet_info_t::LINK_TYPE_CHDR;
+        ifpi.packet_type = uhd::transport::vrt::if_packet_info_t::PACKET_TYPE_DATA;
+        ifpi.num_payload_words32 = 0;
+        ifpi.packet_count = 0;
+        ifpi.sob = false;
+        ifpi.eob = false;
+        ifpi.has_sid = true;
+        ifpi.sid = 0;
+        ifpi.has_cid = false;
+        ifpi.has_tsi = false;
+        ifpi.has_tsf = true;
+        ifpi.tsf = 0;
+        ifpi.has_tlr = false;
+
+        std::vector<dummy_recv_xport_class> dummy_recv_xports(NCHANNELS, dummy_recv_xport_class(end));
+
+        //channel 3 starts one packet early, so that the first set must be aligned
+        ifpi.num_payload_words32 = 10;
+        ifpi.num_payload_bytes = 10*sizeof(uint32_t);
+        dummy_recv_xports[3].push_back_packet(ifpi);
+
+        //generate a bunch of packets, the last one ends the burst
+        ifpi.tsf = START_TICKS;
+        for (size_t i = 0; i < NUM_PKTS_TO_TEST; i++){
+            ifpi.num_payload_words32 = 10 + i%10;
+            ifpi.num_payload_bytes = ifpi.num_payload_words32*sizeof(uint32_t);
+            ifpi.eob = (i == NUM_PKTS_TO_TEST - 1);
+            for (size_t ch = 0; ch < NCHANNELS; ch++){
+                if (i == NUM_PKTS_TO_TEST/2 and ch == 2){
+                    continue; //simulates a lost packet
+                }
+                ifpi.packet_count = (ch == 3)? i + 1 : i;
+                dummy_recv_xports[ch].push_back_packet(ifpi);
+            }
+            ifpi.tsf += ifpi.num_payload_words32*size_t(TICK_RATE/SAMP_RATE);
+        }
+
+        //create the super receive packet handler
+        uhd::transport::sph::recv_packet_handler handler(NCHANNELS);
+        if (end == "chdr_big"){
+            handler.set_vrt_unpacker(&uhd::transport::vrt::chdr::if_hdr_unpack_be);
+        }
+        else{
+            handler.set_vrt_unpacker(&uhd::transport::vrt::chdr::if_hdr_unpack_le);
+        }
+        handler.set_tick_rate(TICK_RATE);
+        handler.set_samp_rate(SAMP_RATE);
+        for (size_t ch = 0; ch < NCHANNELS; ch++){
+            handler.set_xport_chan_get_buff(ch, boost::bind(&dummy_recv_xport_class::get_recv_buff, &dummy_recv_xports[ch], _1));
+        }
+        handler.set_converter(id);
+
+        //check the received packets
+        size_t num_accum_samps = 0;
+        std::complex<float> mem[NUM_SAMPS_PER_BUFF*NCHANNELS];
+        std::vector<std::complex<float> *> buffs(NCHANNELS);
+        for (size_t ch = 0; ch < NCHANNELS; ch++){
+            buffs[ch] = &mem[ch*NUM_SAMPS_PER_BUFF];
+        }
+        uhd::rx_metadata_t metadata;
+        for (size_t i = 0; i < NUM_PKTS_TO_TEST; i++){
+            std::cout << "data check " << i << std::endl;
+            size_t num_samps_ret = handler.recv(
+                buffs, NUM_SAMPS_PER_BUFF, metadata, 1.0, true
+            );
+            const long long ticks = START_TICKS + num_accum_samps*size_t(TICK_RATE/SAMP_RATE);
+            if (i == NUM_PKTS_TO_TEST/2){
+                //must get the soft overflow here
+                BOOST_REQUIRE(metadata.error_code == uhd::rx_metadata_t::ERROR_CODE_OVERFLOW);
+                BOOST_REQUIRE(metadata.out_of_sequence == true);
+                BOOST_CHECK_EQUAL(metadata.time_ticks.get_ticks(), ticks);
+                num_accum_samps += 10 + i%10;
+            }
+            else{
+                BOOST_CHECK_EQUAL(metadata.error_code, uhd::rx_metadata_t::ERROR_CODE_NONE);
+                BOOST_CHECK(not metadata.more_fragments);
+                BOOST_CHECK(metadata.has_time_spec);
+                BOOST_CHECK_EQUAL(metadata.time_ticks.get_ticks(), ticks);
+                BOOST_CHECK_TS_CLOSE(metadata.time_spec, uhd::time_spec_t::from_ticks(ticks, TICK_RATE));
+                BOOST_CHECK_EQUAL(metadata.end_of_burst, i == NUM_PKTS_TO_TEST - 1);
+                BOOST_CHECK_EQUAL(num_samps_ret, 10 + i%10);
+                num_accum_samps += num_samps_ret;
+            }
+        }
+
+        //subsequent receives should be a timeout
+        for (size_t i = 0; i < 3; i++){
+            std::cout << "timeout check " << i << std::endl;
+            handler.recv(
+                buffs, NUM_SAMPS_PER_BUFF, metadata, 1.0, true
+            );
+            BOOST_CHECK_EQUAL(metadata.error_code, uhd::rx_metadata_t::ERROR_CODE_TIMEOUT);
+        }
+
+        //the early packet and the lost packet misaligned the channels
+        const uhd::rx_alignment_stats_t &stats = handler.get_alignment_stats();
+        BOOST_CHECK_EQUAL(stats.num_alignments, 2UL);
+        BOOST_CHECK_EQUAL(stats.num_restarts, 1UL);
+        BOOST_CHECK_EQUAL(stats.num_dropped_packets, 4UL);
+        BOOST_CHECK_EQUAL(stats.num_failures, 0UL);
+        BOOST_CHECK_EQUAL(stats.max_offset_ticks, (long long)(START_TICKS));
+    }
+}
+
+////////////////////////////////////////////////////////////////////////
+BOOST_AUTO_TEST_CASE(test_sph_recv_multi_channel_staggered){
+////////////////////////////////////////////////////////////////////////
+    uhd::convert::id_type id;
+    id.input_format = "sc16_item32_be";
+    id.num_inputs = 1;
+    id.output_format = "fc32";
+    id.num_outputs = 1;
+
+    uhd::transport::vrt::if_packet_info_t ifpi;
+    ifpi.packet_type = uhd::transport::vrt::if_packet_info_t::PACKET_TYPE_DATA;
+    ifpi.num_payload_words32 = 10;
+    ifpi.packet_count = 0;
+    ifpi.sob = true;
+    ifpi.eob = false;
+    ifpi.has_sid = false;
+    ifpi.has_cid = false;
+    ifpi.has_tsi = true;
+    ifpi.has_tsf = true;
+    ifpi.tsi = 0;
+    ifpi.tsf = 0;
+    ifpi.has_tlr = false;
+
+    static const double TICK_RATE = 100e6;
+    static const double SAMP_RATE = 10e6;
+    static const size_t NUM_PKTS_TO_TEST = 10;
+    static const size_t NUM_SAMPS_PER_BUFF = 20;
+    static const size_t NCHANNELS = 16;
+    static const size_t TICKS_PER_PKT = 10*size_t(TICK_RATE/SAMP_RATE);
+
+    std::vector<dummy_recv_xport_class> dummy_recv_xports(NCHANNELS, dummy_recv_xport_class("big"));
+
+    //each channel starts a different number of packets early,
+    //so that the first channel is the latest and all others are behind
+    for (size_t ch = 0; ch < NCHANNELS; ch++){
+        ifpi.packet_count = 0;
+        ifpi.tsf = (NCHANNELS - ch)*TICKS_PER_PKT;
+        for (size_t i = 0; i < ch + NUM_PKTS_TO_TEST; i++){
+            dummy_recv_xports[ch].push_back_packet(ifpi);
+            ifpi.packet_count++;
+            ifpi.tsf += TICKS_PER_PKT;
+        }
+    }
+
+    //create the super receive packet streamer
+    uhd::transport::sph::recv_packet_streamer handler(NUM_SAMPS_PER_BUFF);
+    handler.resize(NCHANNELS);
+    handler.set_vrt_unpacker(&uhd::transport::vrt::if_hdr_unpack_be);
+    handler.set_tick_rate(TICK_RATE);
+    handler.set_samp_rate(SAMP_RATE);
+    for (size_t ch = 0; ch < NCHANNELS; ch++){
+        handler.set_xport_chan_get_buff(ch, boost::bind(&dummy_recv_xport_class::get_recv_buff, &dummy_recv_xports[ch], _1));
+    }
+    handler.set_converter(id);
+
+    //check the received packets
+    std::complex<float> mem[NUM_SAMPS_PER_BUFF*NCHANNELS];
+    std::vector<std::complex<float> *> buffs(NCHANNELS);
+    for (size_t ch = 0; ch < NCHANNELS; ch++){
+        buffs[ch] = &mem[ch*NUM_SAMPS_PER_BUFF];
+    }
+    uhd::rx_metadata_t metadata;
+    for (size_t i = 0; i < NUM_PKTS_TO_TEST; i++){
+        std::cout << "data check " << i << std::endl;
+        size_t num_samps_ret = handler.recv(
+            buffs, NUM_SAMPS_PER_BUFF, metadata, 1.0, true
+        );
+        BOOST_CHECK_EQUAL(metadata.error_code, uhd::rx_metadata_t::ERROR_CODE_NONE);
+        BOOST_CHECK_EQUAL(metadata.time_ticks.get_ticks(), (long long)((NCHANNELS + i)*TICKS_PER_PKT));
+        BOOST_CHECK_EQUAL(num_samps_ret, 10UL);
+    }
+
+    //only the early packets were dropped, on the way to the start time of the first channel
+    const uhd::rx_streamer &streamer = handler;
+    const uhd::rx_alignment_stats_t stats = streamer.get_alignment_stats();
+    BOOST_CHECK_EQUAL(stats.num_alignments, 1UL);
+    BOOST_CHECK_EQUAL(stats.num_restarts, 0UL);
+    BOOST_CHECK_EQUAL(stats.num_dropped_packets, NCHANNELS*(NCHANNELS - 1)/2);
+    BOOST_CHECK_EQUAL(stats.num_failures, 0UL);
+    BOOST_CHECK_EQUAL(stats.max_offset_ticks, (long long)((NCHANNELS - 1)*TICKS_PER_PKT));
+
+    //subsequent receives should be a timeout
+    handler.recv(buffs, NUM_SAMPS_PER_BUFF, metadata, 1.0, true);
+    BOOST_CHECK_EQUAL(metadata.error_code, uhd::rx_metadata_t::ERROR_CODE_TIMEOUT);
+}
+
+////////////////////////////////////////////////////////////////////////
+BOOST_AUTO_TEST_CASE(test_sph_recv_one_channel_multi_packet){
+////////////////////////////////////////////////////////////////////////
+    uhd::convert::id_type id;
+    id.input_format = "sc16_item32_le";
+    id.num_inputs = 1;
+    id.output_format = "sc16";
+    id.num_outputs = 1;
+
+    dummy_recv_xport_class dummy_recv_xport("little");
+    uhd::transport::vrt::if_packet_info_t ifpi;
+    ifpi.packet_type = uhd::transport::vrt::if_packet_info_t::PACKET_TYPE_DATA;
+    ifpi.num_payload_words32 = 0;
+    ifpi.packet_count = 0;
+    ifpi.sob = true;
+    ifpi.eob = false;
+    ifpi.has_sid = false;
+    ifpi.has_cid = false;
+    ifpi.has_tsi = true;
+    ifpi.has_tsf = true;
+    ifpi.tsi = 0;
+    ifpi.tsf = 0;
+    ifpi.has_tlr = false;
+
+    static const double TICK_RATE = 100e6;
+    static const double SAMP_RATE = 10e6;
+    static const size_t NUM_PKTS_TO_TEST = 30;
+
+    //generate a bunch of packets, several for each receive
+    size_t num_samps = 0;
+    for (size_t i = 0; i < NUM_PKTS_TO_TEST; i++){
+        ifpi.num_payload_words32 = 10 + i%10;
+        dummy_recv_xport.push_back_counting_packet(ifpi, num_samps);
+        num_samps += ifpi.num_payload_words32;
+        ifpi.packet_count++;
+        ifpi.tsf += ifpi.num_payload_words32*size_t(TICK_RATE/SAMP_RATE);
+    }
+
+    //create the super receive packet handler
+    uhd::transport::sph::recv_packet_handler handler(1);
+    handler.set_vrt_unpacker(&uhd::transport::vrt::if_hdr_unpack_le);
+    handler.set_tick_rate(TICK_RATE);
+    handler.set_samp_rate(SAMP_RATE);
+    handler.set_xport_chan_get_buff(0, boost::bind(&dummy_recv_xport_class::get_recv_buff, &dummy_recv_xport, _1));
+    handler.set_converter(id);
+
+    //receive full buffers which end in the middle of a packet
+    std::vector<std::complex<short> > buff(101);
+    uhd::rx_metadata_t metadata;
+    size_t num_accum_samps = 0;
+    while (num_accum_samps < num_samps){
+        std::cout << "data check " << num_accum_samps << std::endl;
+        const size_t num_samps_ret = handler.recv(
+            &buff.front(), buff.size(), metadata, 1.0, false
+        );
+        BOOST_CHECK_EQUAL(metadata.error_code, uhd::rx_metadata_t::ERROR_CODE_NONE);
+        BOOST_CHECK_EQUAL(metadata.time_ticks.get_ticks(), (long long)(num_accum_samps*size_t(TICK_RATE/SAMP_RATE)));
+        BOOST_REQUIRE_EQUAL(num_samps_ret, std::min(buff.size(), num_samps - num_accum_samps));
+        for (size_t i = 0; i < num_samps_ret; i++){
+            const short samp = short(uint16_t(num_accum_samps + i));
+            BOOST_REQUIRE_EQUAL(buff[i], std::complex<short>(samp, samp));
+        }
+        num_accum_samps += num_samps_ret;
+    }
+
+    //subsequent receives should be a timeout
+    handler.recv(&buff.front(), buff.size(), metadata, 1.0, false);
+    BOOST_CHECK_EQUAL(metadata.error_code, uhd::rx_metadata_t::ERROR_CODE_TIMEOUT);
+}
+
+#ifdef __linux__
+/***********************************************************************
+ * A transport with a descriptor which is readable while it has packets,
+ * like the socket of a UDP transport
+ **********************************************************************/
+class fd_recv_xport_class : public uhd::transport::zero_copy_if{
+public:
+    fd_recv_xport_class(void):
+        _xport("little"), _fd(uhd::transport::readiness_fd::make())
+    {
+        /* NOP */
+    }
+
+    void push_back_counting_packet(
+        uhd::transport::vrt::if_packet_info_t &ifpi,
+        const size_t first_samp
+    ){
+        _xport.push_back_counting_packet(ifpi, first_samp);
+        _fd->set();
+    }
+
+    uhd::transport::managed_recv_buffer::sptr get_recv_buff(double timeout){
+        uhd::transport::managed_recv_buffer::sptr mrb = _xport.get_recv_buff(timeout);
+        if (_xport.empty()) _fd->clear();
+        return mrb;
+    }
+
+    size_t get_num_recv_frames(void) const{return 1;}
+    size_t get_recv_frame_size(void) const{return 1000;}
+    uhd::transport::managed_send_buffer::sptr get_send_buff(double){
+        return uhd::transport::managed_send_buffer::sptr();
+    }
+    size_t get_num_send_frames(void) const{return 0;}
+    size_t get_send_frame_size(void) const{return 0;}
+
+    int get_recv_fd(void) const{
+        return _fd->get();
+    }
+
+private:
+    dummy_recv_xport_class _xport;
+    uhd::transport::readiness_fd::sptr _fd;
+};
+
+//! Is the descriptor readable right now?
+static bool is_readable(const int fd){
+    pollfd pfd = pollfd();
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    return ::poll(&pfd, 1, 0) == 1;
+}
+
+////////////////////////////////////////////////////////////////////////
+BOOST_AUTO_TEST_CASE(test_sph_recv_get_fd){
+////////////////////////////////////////////////////////////////////////
+    uhd::convert::id_type id;
+    id.input_format = "sc16_item32_le";
+    id.num_inputs = 1;
+    id.output_format = "sc16";
+    id.num_outputs = 1;
+
+    uhd::transport::vrt::if_packet_info_t ifpi;
+    ifpi.packet_type = uhd::transport::vrt::if_packet_info_t::PACKET_TYPE_DATA;
+    ifpi.num_payload_words32 = 10;
+    ifpi.packet_count = 0;
+    ifpi.sob = true;
+    ifpi.eob = false;
+    ifpi.has_sid = false;
+    ifpi.has_cid = false;
+    ifpi.has_tsi = true;
+    ifpi.has_tsf = true;
+    ifpi.tsi = 0;
+    ifpi.tsf = 0;
+    ifpi.has_tlr = false;
+
+    //create the super receive packet handler
+    uhd::transport::sph::recv_packet_handler handler(1);
+    handler.set_vrt_unpacker(&uhd::transport::vrt::if_hdr_unpack_le);
+    handler.set_tick_rate(10e6);
+    handler.set_samp_rate(10e6);
+    handler.set_converter(id);
+
+    //a getter function has no descriptor
+    dummy_recv_xport_class dummy_recv_xport("little");
+    handler.set_xport_chan_get_buff(0, boost::bind(&dummy_recv_xport_class::get_recv_buff, &dummy_recv_xport, _1));
+    BOOST_CHECK_THROW(handler.get_fd(), uhd::not_implemented_error);
+
+    boost::shared_ptr<fd_recv_xport_class> xport(new fd_recv_xport_class());
+    handler.set_xport_chan_recv_xport(0, xport);
+    const int fd = handler.get_fd();
+    BOOST_CHECK(not is_readable(fd));
+
+    //readable while the transport has packets
+    for (size_t i = 0; i < 2; i++){
+        xport->push_back_counting_packet(ifpi, i*10);
+        ifpi.packet_count++;
+        ifpi.tsf += 10;
+    }
+    BOOST_CHECK(is_readable(fd));
+
+    //and while the handler holds the rest of a packet
+    std::vector<std::complex<short> > buff(15);
+    uhd::rx_metadata_t metadata;
+    BOOST_CHECK_EQUAL(handler.recv(&buff.front(), buff.size(), metadata, 0.0, false), 15UL);
+    BOOST_CHECK(is_readable(fd));
+    BOOST_CHECK_EQUAL(handler.recv(&buff.front(), buff.size(), metadata, 0.0, false), 5UL);
+    BOOST_CHECK(not is_readable(fd));
+
+    //the receive times out while it is not readable
+    handler.recv(&buff.front(), buff.size(), metadata, 0.0, false);
+    BOOST_CHECK_EQUAL(metadata.error_code, uhd::rx_metadata_t::ERROR_CODE_TIMEOUT);
+    BOOST_CHECK(not is_readable(fd));
+}
+#endif
+
+/***********************************************************************
+ * The CHDR unpacker behind a function the handler does not know,
+ * so that the generic path is benchmarked
+ **********************************************************************/
+static void generic_chdr_if_hdr_unpack_le(
+    const uint32_t *packet_buff, uhd::transport::vrt::if_packet_info_t &if_packet_info
+){
+    uhd::transport::vrt::chdr::if_hdr_unpack_le(packet_buff, if_packet_info);
+}
+
+//! Receive packets of streaming transports, get the time per packet in ns
+static double benchmark_recv(
+    const size_t nchans, const std::string &output_format, const bool specialized
+){
+    static const double TICK_RATE = 200e6;
+    static const double SAMP_RATE = 200e6;
+    static const size_t SPP = 364;
+    static const size_t NUM_PKTS_TO_TEST = 20000;
+
+    uhd::convert::id_type id;
+    id.input_format = "sc16_item32_le";
+    id.num_inputs = 1;
+    id.output_format = output_format;
+    id.num_outputs = 1;
+
+    uhd::transport::sph::recv_packet_handler handler(nchans);
+    handler.set_tick_rate(TICK_RATE);
+    handler.set_samp_rate(SAMP_RATE);
+    std::vector<uhd::transport::zero_copy_if::sptr> xports;
+    for (size_t ch = 0; ch < nchans; ch++){
+        xports.push_back(uhd::transport::zero_copy_if::sptr(
+            new streaming_recv_xport_class(SPP, TICK_RATE, SAMP_RATE)
+        ));
+        //the specialized paths call the transport and the CHDR unpacker directly,
+        //the generic path calls through a getter function and the unpacker's pointer
+        if (specialized){
+            handler.set_xport_chan_recv_xport(ch, xports.back());
+        }
+        else{
+            handler.set_xport_chan_get_buff(ch, boost::bind(&uhd::transport::zero_copy_if::get_recv_buff, xports.back(), _1));
+        }
+    }
+    handler.set_vrt_unpacker((specialized)?
+        &uhd::transport::vrt::chdr::if_hdr_unpack_le : &generic_chdr_if_hdr_unpack_le
+    );
+    handler.set_converter(id);
+
+    std::vector<std::complex<float> > mem(SPP*nchans);
+    std::vector<std::complex<float> *> buffs(nchans);
+    for (size_t ch = 0; ch < nchans; ch++){
+        buffs[ch] = &mem[ch*SPP];
+    }
+    uhd::rx_metadata_t metadata;
+    size_t num_errors = 0;
+    const boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+    for (size_t i = 0; i < NUM_PKTS_TO_TEST; i++){
+        handler.recv(buffs, SPP, metadata, 1.0, true);
+        if (metadata.error_code != uhd::rx_metadata_t::ERROR_CODE_NONE) num_errors++;
+    }
+    const double ns = (boost::posix_time::microsec_clock::universal_time() - start).total_nanoseconds() / double(NUM_PKTS_TO_TEST);
+
+    BOOST_CHECK_EQUAL(num_errors, 0UL);
+    BOOST_CHECK_EQUAL(metadata.time_spec.to_ticks(SAMP_RATE), (long long)((NUM_PKTS_TO_TEST - 1)*SPP));
+    return ns;
+}
+
+////////////////////////////////////////////////////////////////////////
+BOOST_AUTO_TEST_CASE(test_sph_recv_benchmark){
+////////////////////////////////////////////////////////////////////////
+    static const char *OUTPUT_FORMATS[] = {"sc16", "fc32"};
+
+    //1, 2 and 4 channels take the specialized paths, 3 channels the generic one
+    for (size_t nchans = 1; nchans <= 4; nchans++){
+        for (size_t fmt = 0; fmt < 2; fmt++){
+            const double generic_ns = benchmark_recv(nchans, OUTPUT_FORMATS[fmt], false);
+            const double specialized_ns = benchmark_recv(nchans, OUTPUT_FORMATS[fmt], true);
+            std::cout << boost::format(
+                "recv() of %u channel(s) to %s: %.0f ns/packet, %.0f ns/packet on the generic path"
+            ) % nchans % OUTPUT_FORMATS[fmt] % specialized_ns % generic_ns << std::endl;
+        }
+    }
+}
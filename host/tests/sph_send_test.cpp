@@ -19,9 +19,18 @@
 #include "../lib/transport/super_send_packet_handler.hpp"
 #include <boost/shared_array.hpp>
 #include <boost/bind.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/format.hpp>
+#include <uhd/transport/chdr.hpp>
+#include <uhd/transport/bounded_buffer.hpp>
+#include <algorithm>
 #include <complex>
 #include <vector>
 #include <list>
+#ifdef __linux__
+#include "../lib/transport/readiness_fd.hpp"
+#include <poll.h>
+#endif
 
 #define BOOST_CHECK_TS_CLOSE(a, b) \
     BOOST_CHECK_CLOSE((a).get_real_secs(), (b).get_real_secs(), 0.001)
@@ -54,7 +63,8 @@ public:
     }
 
     void pop_front_packet(
-        uhd::transport::vrt::if_packet_info_t &ifpi
+        uhd::transport::vrt::if_packet_info_t &ifpi,
+        std::vector<uint32_t> *payload = NULL
     ){
         ifpi.num_packet_words32 = _lens.front()/sizeof(uint32_t);
         if (_end == "big"){
@@ -63,6 +73,16 @@ public:
         if (_end == "little"){
             uhd::transport::vrt::if_hdr_unpack_le(reinterpret_cast<uint32_t *>(_mems.front().get()), ifpi);
         }
+        if (_end == "chdr_big"){
+            uhd::transport::vrt::chdr::if_hdr_unpack_be(reinterpret_cast<uint32_t *>(_mems.front().get()), ifpi);
+        }
+        if (_end == "chdr_little"){
+            uhd::transport::vrt::chdr::if_hdr_unpack_le(reinterpret_cast<uint32_t *>(_mems.front().get()), ifpi);
+        }
+        if (payload != NULL){
+            const uint32_t *words = reinterpret_cast<uint32_t *>(_mems.front().get()) + ifpi.num_header_words32;
+            payload->assign(words, words + ifpi.num_payload_words32);
+        }
         _mems.pop_front();
         _lens.pop_front();
     }
@@ -75,6 +95,10 @@ public:
         return mrb;
     }
 
+    size_t get_num_buffs(void) const{
+        return _msbs.size();
+    }
+
 private:
     std::list<boost::shared_array<char> > _mems;
     std::list<size_t> _lens;
@@ -82,6 +106,40 @@ private:
     std::string _end;
 };
 
+/***********************************************************************
+ * A transport which reuses one buffer, for benchmarks
+ **********************************************************************/
+class reusing_send_xport_class : public uhd::transport::managed_send_buffer{
+public:
+    reusing_send_xport_class(void): _mem(2000/sizeof(uint32_t))
+    {
+        /* NOP */
+    }
+
+    reusing_send_xport_class(const reusing_send_xport_class &other):
+        uhd::transport::managed_send_buffer(), _mem(other._mem)
+    {
+        /* NOP */
+    }
+
+    void release(void){
+        //NOP
+    }
+
+    uhd::transport::managed_send_buffer::sptr get_send_buff(double){
+        return make(this, &_mem.front(), _mem.size()*sizeof(uint32_t));
+    }
+
+    //! Unpack the header of the last packet
+    void get_last_packet(uhd::transport::vrt::if_packet_info_t &ifpi){
+        ifpi.num_packet_words32 = _mem.size();
+        uhd::transport::vrt::chdr::if_hdr_unpack_le(&_mem.front(), ifpi);
+    }
+
+private:
+    std::vector<uint32_t> _mem;
+};
+
 ////////////////////////////////////////////////////////////////////////
 BOOST_AUTO_TEST_CASE(test_sph_send_one_channel_one_packet_mode){
 ////////////////////////////////////////////////////////////////////////
@@ -190,3 +248,349 @@ BOOST_AUTO_TEST_CASE(test_sph_send_one_channel_full_buffer_mode){
         num_accum_samps += ifpi.num_payload_words32;
     }
 }
+
+////////////////////////////////////////////////////////////////////////
+BOOST_AUTO_TEST_CASE(test_sph_send_multi_channel_zero_copy){
+////////////////////////////////////////////////////////////////////////
+    uhd::convert::id_type id;
+    id.input_format = "sc16";
+    id.num_inputs = 1;
+    id.output_format = "sc16_item32_le";
+    id.num_outputs = 1;
+
+    static const double TICK_RATE = 100e6;
+    static const double SAMP_RATE = 10e6;
+    static const size_t NUM_PKTS_TO_TEST = 30;
+    static const size_t NCHANNELS = 2;
+
+    std::vector<dummy_send_xport_class> dummy_send_xports(NCHANNELS, dummy_send_xport_class("little"));
+
+    //create the super send packet handler
+    uhd::transport::sph::send_packet_handler handler(NCHANNELS);
+    handler.set_vrt_packer(&uhd::transport::vrt::if_hdr_pack_le);
+    handler.set_tick_rate(TICK_RATE);
+    handler.set_samp_rate(SAMP_RATE);
+    for (size_t ch = 0; ch < NCHANNELS; ch++){
+        handler.set_xport_chan_get_buff(ch, boost::bind(&dummy_send_xport_class::get_send_buff, &dummy_send_xports[ch], _1));
+    }
+    handler.set_converter(id);
+    handler.set_max_samples_per_packet(20);
+
+    //a start of burst without samples applies to the next packet
+    uhd::tx_zero_copy_buffs_t buffs;
+    uhd::tx_metadata_t metadata;
+    metadata.start_of_burst = true;
+    metadata.has_time_spec = true;
+    metadata.time_spec = uhd::time_spec_t(0.0);
+    BOOST_CHECK_EQUAL(handler.get_zero_copy_buffs(buffs, 1.0), 20UL);
+    BOOST_CHECK_EQUAL(handler.send_zero_copy(buffs, 0, metadata), 0UL);
+    BOOST_CHECK_EQUAL(buffs.buffs.size(), NCHANNELS);
+    metadata = uhd::tx_metadata_t();
+
+    //fill the samples in place, the first word of each packet marks it
+    for (size_t i = 0; i < NUM_PKTS_TO_TEST; i++){
+        if (i != 0) BOOST_CHECK_EQUAL(handler.get_zero_copy_buffs(buffs, 1.0), 20UL);
+        BOOST_REQUIRE_EQUAL(buffs.buffs.size(), NCHANNELS);
+        BOOST_CHECK_EQUAL(buffs.format, "sc16_item32_le");
+        const size_t nsamps = 10 + i%10;
+        for (size_t ch = 0; ch < NCHANNELS; ch++){
+            uint32_t *samps = static_cast<uint32_t *>(buffs.buffs[ch]);
+            std::fill(samps, samps + nsamps, uint32_t(i*NCHANNELS + ch));
+        }
+        metadata.end_of_burst = (i == NUM_PKTS_TO_TEST-1);
+        BOOST_CHECK_EQUAL(handler.send_zero_copy(buffs, nsamps, metadata), nsamps);
+        BOOST_CHECK(buffs.managed_buffs.empty());
+    }
+    BOOST_CHECK_THROW(handler.send_zero_copy(buffs, 1, metadata), uhd::value_error);
+
+    //check the sent packets
+    uhd::transport::vrt::if_packet_info_t ifpi;
+    std::vector<uint32_t> payload;
+    for (size_t i = 0; i < NUM_PKTS_TO_TEST; i++){
+        std::cout << "data check " << i << std::endl;
+        for (size_t ch = 0; ch < NCHANNELS; ch++){
+            dummy_send_xports[ch].pop_front_packet(ifpi, &payload);
+            BOOST_CHECK_EQUAL(ifpi.num_payload_words32, 10+i%10);
+            BOOST_CHECK_EQUAL(ifpi.packet_count, i%16);
+            BOOST_CHECK_EQUAL(ifpi.has_tsf, i == 0);
+            if (i == 0) BOOST_CHECK_EQUAL(ifpi.tsf, 0UL);
+            BOOST_CHECK_EQUAL(ifpi.sob, i == 0);
+            BOOST_CHECK_EQUAL(ifpi.eob, i == NUM_PKTS_TO_TEST-1);
+            BOOST_CHECK(payload == std::vector<uint32_t>(10+i%10, uint32_t(i*NCHANNELS + ch)));
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////
+BOOST_AUTO_TEST_CASE(test_sph_send_zero_copy_release){
+////////////////////////////////////////////////////////////////////////
+    uhd::convert::id_type id;
+    id.input_format = "sc16";
+    id.num_inputs = 1;
+    id.output_format = "sc16_item32_le";
+    id.num_outputs = 1;
+
+    static const size_t NCHANNELS = 2;
+
+    std::vector<dummy_send_xport_class> dummy_send_xports(NCHANNELS, dummy_send_xport_class("little"));
+
+    //create the super send packet handler
+    uhd::transport::sph::send_packet_handler handler(NCHANNELS);
+    handler.set_vrt_packer(&uhd::transport::vrt::if_hdr_pack_le);
+    handler.set_tick_rate(100e6);
+    handler.set_samp_rate(10e6);
+    for (size_t ch = 0; ch < NCHANNELS; ch++){
+        handler.set_xport_chan_get_buff(ch, boost::bind(&dummy_send_xport_class::get_send_buff, &dummy_send_xports[ch], _1));
+    }
+    handler.set_converter(id);
+    handler.set_max_samples_per_packet(20);
+
+    uhd::tx_zero_copy_buffs_t buffs0, buffs1;
+    BOOST_CHECK_EQUAL(handler.get_zero_copy_buffs(buffs0, 1.0), 20UL);
+    BOOST_CHECK_EQUAL(handler.get_zero_copy_buffs(buffs1, 1.0), 20UL);
+    const std::vector<void *> ptrs0 = buffs0.buffs;
+
+    //buffers which are given back are handed out again
+    handler.release_zero_copy_buffs(buffs0);
+    BOOST_CHECK(buffs0.managed_buffs.empty());
+    BOOST_CHECK(buffs0.buffs.empty());
+    BOOST_CHECK_EQUAL(handler.get_zero_copy_buffs(buffs0, 1.0), 20UL);
+    BOOST_CHECK(buffs0.buffs == ptrs0);
+
+    //so are the buffers of a set which is filled again
+    BOOST_CHECK_EQUAL(handler.get_zero_copy_buffs(buffs0, 1.0), 20UL);
+    BOOST_CHECK(buffs0.buffs == ptrs0);
+    for (size_t ch = 0; ch < NCHANNELS; ch++){
+        BOOST_CHECK_EQUAL(dummy_send_xports[ch].get_num_buffs(), 2UL);
+    }
+
+    //the buffers of a set and its copy are kept once
+    const uhd::tx_zero_copy_buffs_t copy1 = buffs1;
+    handler.release_zero_copy_buffs(buffs1);
+    buffs1 = copy1;
+    handler.release_zero_copy_buffs(buffs1);
+    handler.release_zero_copy_buffs(buffs0);
+
+    //send() uses the buffers which were not sent before new ones
+    std::vector<std::complex<int16_t> > samps(10);
+    std::vector<const void *> samps_buffs(NCHANNELS, &samps.front());
+    uhd::tx_metadata_t metadata;
+    for (size_t i = 0; i < 3; i++){
+        BOOST_CHECK_EQUAL(handler.send(samps_buffs, samps.size(), metadata, 1.0), samps.size());
+        for (size_t ch = 0; ch < NCHANNELS; ch++){
+            BOOST_CHECK_EQUAL(dummy_send_xports[ch].get_num_buffs(), (i < 2)? 2UL : 3UL);
+        }
+    }
+
+    //the frames went out in the order in which they were given back
+    uhd::transport::vrt::if_packet_info_t ifpi;
+    for (size_t ch = 0; ch < NCHANNELS; ch++){
+        for (size_t i = 0; i < 3; i++){
+            dummy_send_xports[ch].pop_front_packet(ifpi);
+            BOOST_CHECK_EQUAL(ifpi.packet_count, (i == 0)? 1UL : (i == 1)? 0UL : 2UL);
+            BOOST_CHECK_EQUAL(ifpi.num_payload_words32, samps.size());
+        }
+    }
+}
+
+#ifdef __linux__
+//! Is the descriptor readable right now?
+static bool is_readable(const int fd){
+    pollfd pfd = pollfd();
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    return ::poll(&pfd, 1, 0) == 1;
+}
+
+//! Get the descriptor of a readiness descriptor, to hand it to the handler
+static int get_readiness_fd(uhd::transport::readiness_fd::sptr fd){
+    return fd->get();
+}
+
+////////////////////////////////////////////////////////////////////////
+BOOST_AUTO_TEST_CASE(test_sph_send_get_fd){
+////////////////////////////////////////////////////////////////////////
+    typedef uhd::transport::bounded_buffer<uhd::async_metadata_t> async_md_type;
+    async_md_type async_md(10);
+
+    //create the super send packet handler
+    uhd::transport::sph::send_packet_handler handler(1);
+    handler.set_async_receiver(boost::bind(&async_md_type::pop_with_timed_wait, &async_md, _1, _2));
+    BOOST_CHECK_THROW(handler.get_fd(), uhd::not_implemented_error);
+
+    //a descriptor for the room in the transport, and one for async messages
+    uhd::transport::readiness_fd::sptr space_fd = uhd::transport::readiness_fd::make();
+    uhd::transport::readiness_fd::sptr async_fd = uhd::transport::readiness_fd::make();
+    handler.set_async_fd(async_fd);
+    BOOST_CHECK_THROW(handler.get_fd(), uhd::not_implemented_error);
+    handler.set_xport_chan_get_fd(0, boost::bind(&get_readiness_fd, space_fd));
+    const int fd = handler.get_fd();
+    BOOST_CHECK(not is_readable(fd));
+
+    //readable when the transport has room
+    space_fd->set();
+    BOOST_CHECK(is_readable(fd));
+    space_fd->clear();
+    BOOST_CHECK(not is_readable(fd));
+
+    //and while async messages are queued, like the device queues them
+    uhd::async_metadata_t metadata;
+    for (size_t i = 0; i < 2; i++){
+        metadata.event_code = uhd::async_metadata_t::EVENT_CODE_UNDERFLOW;
+        async_md.push_with_pop_on_full(metadata);
+        async_fd->set();
+    }
+    BOOST_CHECK(is_readable(fd));
+    for (size_t i = 0; i < 2; i++){
+        BOOST_CHECK(handler.recv_async_msg(metadata, 0.0));
+        BOOST_CHECK(is_readable(fd));
+    }
+    BOOST_CHECK(not handler.recv_async_msg(metadata, 0.0));
+    BOOST_CHECK(not is_readable(fd));
+}
+#endif
+
+////////////////////////////////////////////////////////////////////////
+BOOST_AUTO_TEST_CASE(test_sph_send_multi_channel_chdr){
+////////////////////////////////////////////////////////////////////////
+    static const double TICK_RATE = 100e6;
+    static const double SAMP_RATE = 10e6;
+    static const size_t NCHANNELS = 2;
+    static const char *ENDS[] = {"chdr_big", "chdr_little"};
+
+    //the headers in a burst: the time, the length or the end of burst
+    //change now and then, so that the handler packs the whole header
+    static const size_t NUM_SENDS = 9;
+    static const size_t nsamps[NUM_SENDS] =       {60,   20,   20,   20,   15,   15,   15,    15,    10};
+    static const bool has_time_spec[NUM_SENDS] = {true, true, true, true, true, true, false, false, false};
+
+    for (size_t e = 0; e < 2; e++){
+        uhd::convert::id_type id;
+        id.input_format = "sc16";
+        id.num_inputs = 1;
+        id.output_format = (e == 0)? "sc16_item32_be" : "sc16_item32_le";
+        id.num_outputs = 1;
+
+        std::vector<dummy_send_xport_class> dummy_send_xports(NCHANNELS, dummy_send_xport_class(ENDS[e]));
+
+        //create the super send packet handler
+        uhd::transport::sph::send_packet_handler handler(NCHANNELS);
+        handler.set_vrt_packer((e == 0)?
+            &uhd::transport::vrt::chdr::if_hdr_pack_be : &uhd::transport::vrt::chdr::if_hdr_pack_le
+        );
+        handler.set_tick_rate(TICK_RATE);
+        handler.set_samp_rate(SAMP_RATE);
+        for (size_t ch = 0; ch < NCHANNELS; ch++){
+            handler.set_xport_chan_get_buff(ch, boost::bind(&dummy_send_xport_class::get_send_buff, &dummy_send_xports[ch], _1));
+            handler.set_xport_chan_sid(ch, true, uint32_t(0x100 + ch));
+        }
+        handler.set_converter(id);
+        handler.set_max_samples_per_packet(20);
+
+        //every byte of a sample marks the packet and the channel
+        uhd::tx_metadata_t metadata;
+        size_t num_accum_samps = 0;
+        size_t num_pkts = 0;
+        std::vector<std::vector<std::complex<short> > > buffs(NCHANNELS);
+        std::vector<size_t> pkt_nsamps, pkt_accum_samps;
+        std::vector<bool> pkt_has_tsf;
+        for (size_t i = 0; i < NUM_SENDS; i++){
+            std::vector<const void *> buff_ptrs;
+            for (size_t ch = 0; ch < NCHANNELS; ch++){
+                buffs[ch].clear();
+                for (size_t n = 0; n < nsamps[i]; n++){
+                    const short marker = short(0x0101*((num_pkts + n/20)*NCHANNELS + ch + 1));
+                    buffs[ch].push_back(std::complex<short>(marker, marker));
+                }
+                buff_ptrs.push_back(&buffs[ch].front());
+            }
+            metadata.start_of_burst = (i == 0);
+            metadata.end_of_burst = (i == NUM_SENDS-1);
+            metadata.has_time_spec = has_time_spec[i];
+            metadata.time_spec = uhd::time_spec_t::from_ticks(num_accum_samps, SAMP_RATE);
+            BOOST_CHECK_EQUAL(handler.send(buff_ptrs, nsamps[i], metadata, 1.0), nsamps[i]);
+            for (size_t n = 0; n < nsamps[i]; n += 20){
+                pkt_nsamps.push_back(std::min<size_t>(20, nsamps[i] - n));
+                pkt_accum_samps.push_back(num_accum_samps + n);
+                pkt_has_tsf.push_back(has_time_spec[i]);
+                num_pkts++;
+            }
+            num_accum_samps += nsamps[i];
+        }
+
+        //check the sent packets
+        uhd::transport::vrt::if_packet_info_t ifpi;
+        std::vector<uint32_t> payload;
+        for (size_t i = 0; i < num_pkts; i++){
+            std::cout << "data check " << i << std::endl;
+            for (size_t ch = 0; ch < NCHANNELS; ch++){
+                dummy_send_xports[ch].pop_front_packet(ifpi, &payload);
+                BOOST_CHECK_EQUAL(ifpi.num_payload_words32, pkt_nsamps[i]);
+                BOOST_CHECK_EQUAL(ifpi.packet_count, i);
+                BOOST_CHECK_EQUAL(ifpi.sid, uint32_t(0x100 + ch));
+                BOOST_CHECK_EQUAL(ifpi.has_tsf, pkt_has_tsf[i]);
+                if (ifpi.has_tsf) BOOST_CHECK_EQUAL(ifpi.tsf, pkt_accum_samps[i]*TICK_RATE/SAMP_RATE);
+                BOOST_CHECK_EQUAL(ifpi.eob, i == num_pkts-1);
+                BOOST_CHECK(payload == std::vector<uint32_t>(pkt_nsamps[i], uint32_t(0x01010101*(i*NCHANNELS + ch + 1))));
+            }
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////
+BOOST_AUTO_TEST_CASE(test_sph_send_benchmark){
+////////////////////////////////////////////////////////////////////////
+    static const double TICK_RATE = 200e6;
+    static const double SAMP_RATE = 200e6;
+    static const size_t SPP = 16; //small packets, so that the per-packet overhead shows
+    static const size_t NUM_PKTS_TO_TEST = 100000;
+
+    for (size_t nchans = 1; nchans <= 4; nchans *= 2){
+        for (size_t timed = 0; timed < 2; timed++){
+            uhd::convert::id_type id;
+            id.input_format = "sc16";
+            id.num_inputs = 1;
+            id.output_format = "sc16_item32_le";
+            id.num_outputs = 1;
+
+            std::vector<reusing_send_xport_class> xports(nchans);
+            uhd::transport::sph::send_packet_handler handler(nchans);
+            handler.set_vrt_packer(&uhd::transport::vrt::chdr::if_hdr_pack_le);
+            handler.set_tick_rate(TICK_RATE);
+            handler.set_samp_rate(SAMP_RATE);
+            for (size_t ch = 0; ch < nchans; ch++){
+                handler.set_xport_chan_get_buff(ch, boost::bind(&reusing_send_xport_class::get_send_buff, &xports[ch], _1));
+                handler.set_xport_chan_sid(ch, true, uint32_t(ch));
+            }
+            handler.set_converter(id);
+            handler.set_max_samples_per_packet(SPP);
+
+            //a timed stream has a time spec on every packet
+            std::vector<std::complex<short> > mem(SPP*nchans);
+            std::vector<const void *> buffs(nchans);
+            for (size_t ch = 0; ch < nchans; ch++){
+                buffs[ch] = &mem[ch*SPP];
+            }
+            uhd::tx_metadata_t metadata;
+            metadata.has_time_spec = true;
+            metadata.time_spec = uhd::time_spec_t(1.0);
+            const boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+            for (size_t i = 0; i < NUM_PKTS_TO_TEST; i++){
+                metadata.start_of_burst = (i == 0);
+                handler.send(buffs, SPP, metadata, 1.0);
+                metadata.has_time_spec = timed != 0;
+                metadata.time_spec += uhd::time_spec_t::from_ticks(SPP, SAMP_RATE);
+            }
+            const double ns = (boost::posix_time::microsec_clock::universal_time() - start).total_nanoseconds() / double(NUM_PKTS_TO_TEST);
+
+            uhd::transport::vrt::if_packet_info_t ifpi;
+            xports[nchans-1].get_last_packet(ifpi);
+            BOOST_CHECK_EQUAL(ifpi.packet_count, (NUM_PKTS_TO_TEST-1) & 0xfff);
+            BOOST_CHECK_EQUAL(ifpi.sid, uint32_t(nchans-1));
+            BOOST_CHECK_EQUAL(ifpi.has_tsf, timed != 0);
+            if (timed) BOOST_CHECK_EQUAL(ifpi.tsf, uint64_t(TICK_RATE) + (NUM_PKTS_TO_TEST-1)*SPP);
+            std::cout << boost::format("send() of %u channel(s)%s: %.0f ns/packet")
+                % nchans % (timed? " with time" : "") % ns << std::endl;
+        }
+    }
+}
@@ -0,0 +1,379 @@
+//
+// Copyright 2016 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <boost/test/unit_test.hpp>
+#include <uhd/stream_engine.hpp>
+#include <uhd/exception.hpp>
+#include <boost/bind.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <complex>
+#include <vector>
+#ifndef UHD_PLATFORM_WIN32
+#include <poll.h>
+#endif
+
+using namespace uhd;
+
+static const size_t NUM_CHANS = 2;
+static const size_t SPP = 100;
+
+/***********************************************************************
+ * A streamer which counts up the samples of each channel, and times out
+ * (or reports another error) after a given number of packets
+ **********************************************************************/
+class counting_rx_streamer : public rx_streamer
+{
+public:
+    typedef boost::shared_ptr<counting_rx_streamer> sptr;
+
+    counting_rx_streamer(
+        const size_t num_pkts,
+        const rx_metadata_t::error_code_t dry_error_code = rx_metadata_t::ERROR_CODE_TIMEOUT
+    ) :
+        _num_pkts(num_pkts), _dry_error_code(dry_error_code), _num_recv_calls(0), _next_samp(0)
+    {
+        /* NOP */
+    }
+
+    size_t get_num_channels(void) const
+    {
+        return NUM_CHANS;
+    }
+
+    size_t get_max_num_samps(void) const
+    {
+        return SPP;
+    }
+
+    size_t recv(
+        const buffs_type &buffs,
+        const size_t nsamps_per_buff,
+        rx_metadata_t &metadata,
+        const double timeout,
+        const bool
+    ){
+        boost::mutex::scoped_lock lock(_mutex);
+        _num_recv_calls++;
+        metadata.reset();
+        if (_next_samp >= _num_pkts*SPP){
+            lock.unlock();
+            boost::this_thread::sleep(boost::posix_time::microseconds(long(timeout*1e6)));
+            metadata.error_code = _dry_error_code;
+            return 0;
+        }
+        const size_t nsamps = std::min(nsamps_per_buff, SPP);
+        for (size_t ch = 0; ch < NUM_CHANS; ch++){
+            std::complex<short> *samps = reinterpret_cast<std::complex<short> *>(buffs[ch]);
+            for (size_t i = 0; i < nsamps; i++){
+                samps[i] = std::complex<short>(short(_next_samp + i), short(ch));
+            }
+        }
+        metadata.has_time_spec = true;
+        metadata.time_spec = time_spec_t::from_ticks(_next_samp, 1e6);
+        _next_samp += nsamps;
+        return nsamps;
+    }
+
+    void issue_stream_cmd(const stream_cmd_t &)
+    {
+        /* NOP */
+    }
+
+    size_t get_num_recv_calls(void)
+    {
+        boost::mutex::scoped_lock lock(_mutex);
+        return _num_recv_calls;
+    }
+
+private:
+    boost::mutex _mutex;
+    const size_t _num_pkts;
+    const rx_metadata_t::error_code_t _dry_error_code;
+    size_t _num_recv_calls;
+    size_t _next_samp;
+};
+
+/***********************************************************************
+ * A streamer which throws once it ran dry
+ **********************************************************************/
+class failing_rx_streamer : public counting_rx_streamer
+{
+public:
+    failing_rx_streamer(const size_t num_pkts) : counting_rx_streamer(num_pkts)
+    {
+        /* NOP */
+    }
+
+    size_t recv(
+        const buffs_type &buffs,
+        const size_t nsamps_per_buff,
+        rx_metadata_t &metadata,
+        const double timeout,
+        const bool one_packet
+    ){
+        const size_t nsamps = counting_rx_streamer::recv(buffs, nsamps_per_buff, metadata, timeout, one_packet);
+        if (nsamps == 0) throw uhd::io_error("failing_rx_streamer");
+        return nsamps;
+    }
+};
+
+/***********************************************************************
+ * An application which checks the samples and may hold on to them
+ **********************************************************************/
+struct recording_app
+{
+    recording_app(void) : hold(false), num_samps(0), num_timeouts(0), in_order(true)
+    {
+        /* NOP */
+    }
+
+    void handle_samps(rx_stream_engine::buffer_sptr buff)
+    {
+        boost::mutex::scoped_lock lock(mutex);
+        const std::complex<short> *samps = reinterpret_cast<const std::complex<short> *>(buff->buffs[1]);
+        in_order = in_order
+            and buff->buffs.size() == NUM_CHANS
+            and buff->metadata.time_spec.to_ticks(1e6) == (long long)(num_samps)
+            and samps[0] == std::complex<short>(short(num_samps), 1);
+        num_samps += buff->nsamps_per_buff;
+        if (hold) held.push_back(buff);
+    }
+
+    void handle_event(const rx_metadata_t &metadata)
+    {
+        boost::mutex::scoped_lock lock(mutex);
+        if (metadata.error_code == rx_metadata_t::ERROR_CODE_TIMEOUT) num_timeouts++;
+    }
+
+    size_t get_num_timeouts(void)
+    {
+        boost::mutex::scoped_lock lock(mutex);
+        return num_timeouts;
+    }
+
+    boost::mutex mutex;
+    bool hold;
+    std::vector<rx_stream_engine::buffer_sptr> held;
+    size_t num_samps;
+    size_t num_timeouts;
+    bool in_order;
+};
+
+static rx_stream_engine::sptr make_engine(
+    counting_rx_streamer::sptr streamer,
+    recording_app &app,
+    const rx_stream_engine::args_type &args
+){
+    return rx_stream_engine::make(
+        streamer, "sc16",
+        boost::bind(&recording_app::handle_samps, &app, _1),
+        boost::bind(&recording_app::handle_event, &app, _1),
+        args
+    );
+}
+
+//! Wait until the streamer ran dry and the engine reported it
+static void wait_for_timeout(recording_app &app)
+{
+    for (size_t i = 0; i < 500 and app.get_num_timeouts() == 0; i++){
+        boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+    }
+    BOOST_REQUIRE_GT(app.get_num_timeouts(), 0UL);
+}
+
+BOOST_AUTO_TEST_CASE(test_rx_stream_engine_callbacks){
+    static const size_t NUM_PKTS = 200;
+    counting_rx_streamer::sptr streamer = boost::make_shared<counting_rx_streamer>(NUM_PKTS);
+    recording_app app;
+    rx_stream_engine::args_type args;
+    args.timeout = 0.01;
+    args.num_buffs = 4;
+    rx_stream_engine::sptr engine = make_engine(streamer, app, args);
+    wait_for_timeout(app);
+
+    //every sample arrives in order, through a pool of a few buffers
+    BOOST_CHECK_EQUAL(engine->get_num_recvd_samps(), NUM_PKTS*SPP);
+    engine.reset();
+    BOOST_CHECK(app.in_order);
+    BOOST_CHECK_EQUAL(app.num_samps, NUM_PKTS*SPP);
+}
+
+BOOST_AUTO_TEST_CASE(test_rx_stream_engine_block){
+    static const size_t NUM_BUFFS = 4;
+    counting_rx_streamer::sptr streamer = boost::make_shared<counting_rx_streamer>(100);
+    recording_app app;
+    app.hold = true;
+    rx_stream_engine::args_type args;
+    args.timeout = 0.01;
+    args.num_buffs = NUM_BUFFS;
+    args.nsamps_per_buff = SPP/2;
+    rx_stream_engine::sptr engine = make_engine(streamer, app, args);
+
+    //the engine stops receiving while the application holds all buffers
+    boost::this_thread::sleep(boost::posix_time::milliseconds(100));
+    BOOST_CHECK_EQUAL(streamer->get_num_recv_calls(), NUM_BUFFS);
+    BOOST_CHECK_EQUAL(engine->get_num_recvd_samps(), NUM_BUFFS*SPP/2);
+    BOOST_CHECK_EQUAL(engine->get_num_dropped_samps(), 0UL);
+
+    //and goes on when they return
+    {
+        boost::mutex::scoped_lock lock(app.mutex);
+        app.hold = false;
+        app.held.clear();
+    }
+    wait_for_timeout(app);
+    BOOST_CHECK(app.in_order);
+    BOOST_CHECK_EQUAL(engine->get_num_recvd_samps(), 100*SPP);
+}
+
+BOOST_AUTO_TEST_CASE(test_rx_stream_engine_drop){
+    static const size_t NUM_BUFFS = 4;
+    static const size_t NUM_PKTS = 100;
+    counting_rx_streamer::sptr streamer = boost::make_shared<counting_rx_streamer>(NUM_PKTS);
+    recording_app app;
+    app.hold = true;
+    rx_stream_engine::args_type args;
+    args.timeout = 0.01;
+    args.num_buffs = NUM_BUFFS;
+    args.backpressure = rx_stream_engine::BACKPRESSURE_DROP;
+    rx_stream_engine::sptr engine = make_engine(streamer, app, args);
+
+    //the engine keeps receiving while the application holds all buffers
+    wait_for_timeout(app);
+    BOOST_CHECK(app.in_order);
+    BOOST_CHECK_EQUAL(app.held.size(), NUM_BUFFS);
+    BOOST_CHECK_EQUAL(engine->get_num_recvd_samps(), NUM_BUFFS*SPP);
+    BOOST_CHECK_EQUAL(engine->get_num_dropped_samps(), (NUM_PKTS - NUM_BUFFS)*SPP);
+}
+
+#ifndef UHD_PLATFORM_WIN32
+static bool fd_readable(const int fd)
+{
+    pollfd pfd;
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    return ::poll(&pfd, 1, 0) == 1 and (pfd.revents & POLLIN);
+}
+
+BOOST_AUTO_TEST_CASE(test_rx_stream_engine_queue_fd){
+    static const size_t NUM_BUFFS = 4;
+    static const size_t NUM_PKTS = 10;
+    counting_rx_streamer::sptr streamer = boost::make_shared<counting_rx_streamer>(NUM_PKTS);
+    rx_stream_engine::args_type args;
+    args.timeout = 0.01;
+    args.num_buffs = NUM_BUFFS;
+    rx_stream_engine::sptr engine = rx_stream_engine::make(
+        streamer, "sc16", rx_stream_engine::data_callback_type(),
+        rx_stream_engine::event_callback_type(), args
+    );
+
+    //the descriptor is readable once the engine queued all buffers of the pool
+    const int fd = engine->get_fd();
+    pollfd pfd;
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    BOOST_REQUIRE_EQUAL(::poll(&pfd, 1, 5000), 1);
+    for (size_t i = 0; i < 500 and engine->get_num_recvd_samps() < NUM_BUFFS*SPP; i++){
+        boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+    }
+    BOOST_CHECK_EQUAL(engine->get_num_recvd_samps(), NUM_BUFFS*SPP);
+
+    //taking the buffers lets the engine receive the rest
+    std::vector<rx_stream_engine::buffer_sptr> held;
+    rx_stream_engine::buffer_sptr buff;
+    size_t num_popped = 0;
+    while (num_popped < NUM_PKTS and engine->pop_buff(buff, 1.0)){
+        BOOST_CHECK_EQUAL(buff->metadata.time_spec.to_ticks(1e6), (long long)(num_popped*SPP));
+        num_popped++;
+        held.push_back(buff);
+        buff.reset();
+        if (held.size() == NUM_BUFFS) held.clear();
+    }
+    BOOST_CHECK_EQUAL(num_popped, NUM_PKTS);
+    BOOST_CHECK_EQUAL(engine->get_num_recvd_samps(), NUM_PKTS*SPP);
+
+    //the queue is empty, and timeouts are not queued
+    BOOST_CHECK(not fd_readable(fd));
+    BOOST_CHECK(not engine->pop_buff(buff, 0.05));
+    BOOST_CHECK(not fd_readable(fd));
+}
+#endif
+
+static rx_stream_engine::sptr make_queue_engine(
+    rx_streamer::sptr streamer,
+    const rx_stream_engine::args_type &args
+){
+    return rx_stream_engine::make(
+        streamer, "sc16", rx_stream_engine::data_callback_type(),
+        rx_stream_engine::event_callback_type(), args
+    );
+}
+
+BOOST_AUTO_TEST_CASE(test_rx_stream_engine_queue_events){
+    static const size_t NUM_BUFFS = 4;
+    counting_rx_streamer::sptr streamer = boost::make_shared<counting_rx_streamer>(
+        0, rx_metadata_t::ERROR_CODE_OVERFLOW
+    );
+    rx_stream_engine::args_type args;
+    args.timeout = 0.001;
+    args.num_buffs = NUM_BUFFS;
+    rx_stream_engine::sptr engine = make_queue_engine(streamer, args);
+    for (size_t i = 0; i < 500 and streamer->get_num_recv_calls() < 4*NUM_BUFFS; i++){
+        boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+    }
+
+    //no more events are queued than there are buffers,
+    //while the application holds them the others are dropped
+    std::vector<rx_stream_engine::buffer_sptr> held;
+    rx_stream_engine::buffer_sptr buff;
+    while (held.size() <= NUM_BUFFS and engine->pop_buff(buff, 0.05)){
+        BOOST_CHECK_EQUAL(buff->metadata.error_code, rx_metadata_t::ERROR_CODE_OVERFLOW);
+        BOOST_CHECK_EQUAL(buff->nsamps_per_buff, 0UL);
+        held.push_back(buff);
+    }
+    BOOST_CHECK_EQUAL(held.size(), NUM_BUFFS);
+
+    //returned buffers take new events
+    held.clear();
+    BOOST_CHECK(engine->pop_buff(buff, 1.0));
+    BOOST_CHECK_EQUAL(buff->metadata.error_code, rx_metadata_t::ERROR_CODE_OVERFLOW);
+}
+
+BOOST_AUTO_TEST_CASE(test_rx_stream_engine_error){
+    static const size_t NUM_PKTS = 2;
+    rx_streamer::sptr streamer = boost::make_shared<failing_rx_streamer>(NUM_PKTS);
+    rx_stream_engine::args_type args;
+    args.timeout = 0.01;
+    rx_stream_engine::sptr engine = make_queue_engine(streamer, args);
+
+    //the buffers queued before the error come first
+    rx_stream_engine::buffer_sptr buff;
+    for (size_t i = 0; i < NUM_PKTS; i++){
+        BOOST_REQUIRE(engine->pop_buff(buff, 1.0));
+        BOOST_CHECK_EQUAL(buff->nsamps_per_buff, SPP);
+    }
+
+    //then the error which stopped the engine, instead of timeouts
+    BOOST_CHECK_THROW(engine->pop_buff(buff, 1.0), uhd::io_error);
+#ifndef UHD_PLATFORM_WIN32
+    BOOST_CHECK(fd_readable(engine->get_fd()));
+#endif
+    BOOST_CHECK_THROW(engine->pop_buff(buff, 0.0), uhd::io_error);
+}
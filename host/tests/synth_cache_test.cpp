@@ -0,0 +1,209 @@
+//
+// Copyright 2016 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <boost/test/unit_test.hpp>
+#include "settings_cache.hpp"
+#include "adf435x.hpp"
+#include "adf5355.hpp"
+#include "max287x.hpp"
+#include <boost/bind.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/format.hpp>
+#include <iostream>
+#include <vector>
+
+using namespace uhd::usrp;
+
+static void null_write(std::vector<uint32_t>)
+{
+    /* NOP */
+}
+
+//! Records every register write of a synthesizer
+struct reg_log_t
+{
+    void write(std::vector<uint32_t> regs)
+    {
+        writes.push_back(regs);
+    }
+
+    std::vector<std::vector<uint32_t> > writes;
+};
+
+//! Checks that two synthesizers wrote the same registers
+static void check_same_writes(const reg_log_t &lhs, const reg_log_t &rhs)
+{
+    BOOST_REQUIRE_EQUAL(lhs.writes.size(), rhs.writes.size());
+    for (size_t i = 0; i < lhs.writes.size(); i++) {
+        BOOST_CHECK_EQUAL_COLLECTIONS(
+            lhs.writes[i].begin(), lhs.writes[i].end(),
+            rhs.writes[i].begin(), rhs.writes[i].end());
+    }
+}
+
+//! A sweep of LO frequencies as used by a scanning receiver
+static std::vector<double> make_sweep(double start, double stop, double step)
+{
+    std::vector<double> freqs;
+    for (double freq = start; freq <= stop; freq += step) {
+        freqs.push_back(freq);
+    }
+    return freqs;
+}
+
+struct test_key_t
+{
+    int value;
+    bool operator==(const test_key_t &rhs) const { return value == rhs.value; }
+};
+
+static size_t hash_value(const test_key_t &key)
+{
+    return boost::hash<int>()(key.value);
+}
+
+static test_key_t make_key(int value)
+{
+    test_key_t key;
+    key.value = value;
+    return key;
+}
+
+BOOST_AUTO_TEST_CASE(test_settings_cache_lru){
+    settings_cache<test_key_t, double> cache(2);
+    double value = 0.0;
+
+    BOOST_CHECK(not cache.lookup(make_key(1), value));
+    cache.store(make_key(1), 1.0);
+    cache.store(make_key(2), 2.0);
+    BOOST_CHECK(cache.lookup(make_key(1), value));
+    BOOST_CHECK_EQUAL(value, 1.0);
+
+    //2 is now the least recently used entry and gets evicted
+    cache.store(make_key(3), 3.0);
+    BOOST_CHECK_EQUAL(cache.size(), size_t(2));
+    BOOST_CHECK(not cache.lookup(make_key(2), value));
+    BOOST_CHECK(cache.lookup(make_key(1), value));
+    BOOST_CHECK(cache.lookup(make_key(3), value));
+    BOOST_CHECK_EQUAL(value, 3.0);
+    BOOST_CHECK_EQUAL(cache.get_hits(), size_t(3));
+    BOOST_CHECK_EQUAL(cache.get_misses(), size_t(2));
+
+    cache.set_capacity(1);
+    BOOST_CHECK_EQUAL(cache.size(), size_t(1));
+    cache.clear();
+    BOOST_CHECK_EQUAL(cache.size(), size_t(0));
+}
+
+BOOST_AUTO_TEST_CASE(test_adf435x_cached_tune){
+    reg_log_t cold_log, warm_log;
+    adf435x_iface::sptr cold = adf435x_iface::make_adf4351(boost::bind(&reg_log_t::write, &cold_log, _1));
+    cold->set_reference_freq(50e6);
+    cold->set_prescaler(adf435x_iface::PRESCALER_8_9);
+    adf435x_iface::sptr warm = adf435x_iface::make_adf4351(boost::bind(&reg_log_t::write, &warm_log, _1));
+    warm->set_reference_freq(50e6);
+    warm->set_prescaler(adf435x_iface::PRESCALER_8_9);
+
+    const std::vector<double> freqs = make_sweep(400e6, 4.4e9, 1.234e6);
+
+    //The first pass starts cold and fills the cache, the second one must
+    //return the same frequencies and write the same registers
+    cold->clear_frequency_cache();
+    std::vector<double> actual;
+    BOOST_FOREACH(const double freq, freqs) {
+        actual.push_back(cold->set_frequency(freq, false, true));
+    }
+    warm->prime_frequency_cache(freqs, false);
+    for (size_t i = 0; i < freqs.size(); i++) {
+        BOOST_CHECK_EQUAL(warm->set_frequency(freqs[i], false, true), actual[i]);
+        BOOST_CHECK_CLOSE(actual[i], freqs[i], 1e-3);
+    }
+    check_same_writes(cold_log, warm_log);
+
+    //A different reference must not reuse the cached settings
+    warm->set_reference_freq(25e6);
+    BOOST_CHECK_CLOSE(warm->set_frequency(freqs[0], false), freqs[0], 1e-3);
+}
+
+BOOST_AUTO_TEST_CASE(test_max287x_cached_tune){
+    reg_log_t cold_log, warm_log;
+    max287x_iface::sptr cold = max287x_iface::make<max2871>(boost::bind(&reg_log_t::write, &cold_log, _1));
+    max287x_iface::sptr warm = max287x_iface::make<max2871>(boost::bind(&reg_log_t::write, &warm_log, _1));
+    const std::vector<double> freqs = make_sweep(500e6, 6e9, 5.678e6);
+
+    cold->clear_frequency_cache();
+    std::vector<double> actual;
+    BOOST_FOREACH(const double freq, freqs) {
+        actual.push_back(cold->set_frequency(freq, 50e6, 50e6, false));
+        cold->commit();
+    }
+    warm->prime_frequency_cache(freqs, 50e6, 50e6, false);
+    for (size_t i = 0; i < freqs.size(); i++) {
+        BOOST_CHECK_EQUAL(warm->set_frequency(freqs[i], 50e6, 50e6, false), actual[i]);
+        warm->commit();
+        BOOST_CHECK_CLOSE(actual[i], freqs[i], 1e-3);
+    }
+    check_same_writes(cold_log, warm_log);
+}
+
+BOOST_AUTO_TEST_CASE(test_adf5355_cached_tune){
+    reg_log_t cold_log, warm_log;
+    adf5355_iface::sptr cold = adf5355_iface::make(boost::bind(&reg_log_t::write, &cold_log, _1));
+    cold->set_reference_freq(100e6);
+    adf5355_iface::sptr warm = adf5355_iface::make(boost::bind(&reg_log_t::write, &warm_log, _1));
+    warm->set_reference_freq(100e6);
+    const std::vector<double> freqs = make_sweep(1e9, 6e9, 7.89e6);
+
+    cold->clear_frequency_cache();
+    std::vector<double> actual;
+    BOOST_FOREACH(const double freq, freqs) {
+        actual.push_back(cold->set_frequency(freq, 100e3, true));
+    }
+    warm->prime_frequency_cache(freqs, 100e3);
+    for (size_t i = 0; i < freqs.size(); i++) {
+        BOOST_CHECK_EQUAL(warm->set_frequency(freqs[i], 100e3, true), actual[i]);
+    }
+    check_same_writes(cold_log, warm_log);
+    BOOST_CHECK_THROW(warm->prime_frequency_cache(std::vector<double>(1, 10e9), 100e3), uhd::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(test_synth_cache_benchmark){
+    static const size_t NUM_SWEEPS = 20;
+
+    //Fine steps over the full range, so that every frequency misses in the first sweep
+    const std::vector<double> freqs = make_sweep(137.5e6, 4.4e9, 3.3e6);
+    adf435x_iface::sptr synth = adf435x_iface::make_adf4350(&null_write);
+    synth->set_reference_freq(10e6);
+    synth->set_prescaler(adf435x_iface::PRESCALER_4_5);
+    synth->clear_frequency_cache();
+
+    boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+    BOOST_FOREACH(const double freq, freqs) {
+        synth->set_frequency(freq, true);
+    }
+    const double cold_ns = (boost::posix_time::microsec_clock::universal_time() - start).total_nanoseconds() / double(freqs.size());
+
+    start = boost::posix_time::microsec_clock::universal_time();
+    for (size_t n = 0; n < NUM_SWEEPS; n++) {
+        BOOST_FOREACH(const double freq, freqs) {
+            synth->set_frequency(freq, true);
+        }
+    }
+    const double warm_ns = (boost::posix_time::microsec_clock::universal_time() - start).total_nanoseconds() / double(freqs.size() * NUM_SWEEPS);
+
+    std::cout << boost::format("ADF4350 set_frequency(): %.0f ns/call uncached, %.0f ns/call cached") % cold_ns % warm_ns << std::endl;
+}
@@ -0,0 +1,91 @@
+//
+// Copyright 2016 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <boost/test/unit_test.hpp>
+#include <uhd/types/time_ticks.hpp>
+#include <uhd/exception.hpp>
+#include <iostream>
+
+using uhd::time_ticks_t;
+using uhd::time_spec_t;
+
+BOOST_AUTO_TEST_CASE(test_time_ticks_rate){
+    std::cout << "Testing time ticks rate..." << std::endl;
+
+    const time_ticks_t integer = time_ticks_t::from_tick_rate(0, 200e6);
+    BOOST_CHECK_EQUAL(integer.get_rate_num(), 200000000);
+    BOOST_CHECK_EQUAL(integer.get_rate_den(), 1);
+
+    const time_ticks_t third = time_ticks_t::from_tick_rate(0, 200e6/3);
+    BOOST_CHECK_EQUAL(third.get_rate_num(), 200000000);
+    BOOST_CHECK_EQUAL(third.get_rate_den(), 3);
+
+    const time_ticks_t reduced(0, 400, 6);
+    BOOST_CHECK_EQUAL(reduced.get_rate_num(), 200);
+    BOOST_CHECK_EQUAL(reduced.get_rate_den(), 3);
+    BOOST_CHECK_CLOSE(reduced.get_tick_rate(), 200.0/3, 1e-12);
+
+    BOOST_CHECK_THROW(time_ticks_t(0, 0), uhd::value_error);
+    BOOST_CHECK_THROW(time_ticks_t::from_tick_rate(0, -1.0), uhd::value_error);
+}
+
+BOOST_AUTO_TEST_CASE(test_time_ticks_to_time_spec){
+    std::cout << "Testing time ticks conversion..." << std::endl;
+
+    //three days at 200 MHz, plus one tick
+    const long long ticks = 3*24*3600*200000000LL + 1;
+    const time_spec_t time = time_ticks_t(ticks, 200000000).to_time_spec();
+    BOOST_CHECK_EQUAL(time.get_full_secs(), 3*24*3600);
+    BOOST_CHECK_CLOSE(time.get_frac_secs(), 5e-9, 1e-6);
+    BOOST_CHECK_EQUAL(time.to_ticks(200e6), ticks);
+
+    //rates which are not whole numbers
+    const time_spec_t third = time_ticks_t(200000000LL*10 + 1, 200000000, 3).to_time_spec();
+    BOOST_CHECK_EQUAL(third.get_full_secs(), 30);
+    BOOST_CHECK_CLOSE(third.get_frac_secs(), 1.5e-8, 1e-6);
+
+    //negative times round the whole seconds down
+    const time_spec_t negative = time_ticks_t(-1, 100).to_time_spec();
+    BOOST_CHECK_EQUAL(negative.get_full_secs(), -1);
+    BOOST_CHECK_CLOSE(negative.get_frac_secs(), 0.99, 1e-9);
+}
+
+BOOST_AUTO_TEST_CASE(test_time_ticks_accumulate){
+    std::cout << "Testing time ticks accumulation..." << std::endl;
+
+    //add a packet worth of ticks many times, time_spec_t rounds each step
+    static const double RATE = 184.32e6;
+    static const long long STEP = 1996;
+    time_ticks_t ticks = time_ticks_t::from_tick_rate(0, RATE);
+    for (size_t i = 0; i < 1000000; i++){
+        ticks += STEP;
+    }
+    BOOST_CHECK_EQUAL(ticks.get_ticks(), STEP*1000000);
+    BOOST_CHECK_EQUAL(ticks.to_time_spec().to_ticks(RATE), STEP*1000000);
+}
+
+BOOST_AUTO_TEST_CASE(test_time_ticks_compare){
+    std::cout << "Testing time ticks compare..." << std::endl;
+
+    BOOST_CHECK(time_ticks_t(10, 100) == time_ticks_t(10, 100));
+    BOOST_CHECK(time_ticks_t(11, 100) > time_ticks_t(10, 100));
+    BOOST_CHECK(time_ticks_t(10, 100) < time_ticks_t(11, 100));
+
+    //different rates compare the times
+    BOOST_CHECK(time_ticks_t(10, 100) == time_ticks_t(20, 200));
+    BOOST_CHECK(time_ticks_t(10, 100) < time_ticks_t(21, 200));
+}